@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""
+Run the Joy benchmark suite on the Python evaluator and the C backend.
+
+Each benchmarks/*.joy file is a self-contained workload whose header
+declares how much work it does:
+
+    (* ops: 57313 -- binrec activations for 22 fib *)
+
+Every run happens in a fresh process, started by the small peak_rss.c
+launcher so that peak RSS is the workload's own.  The Python time covers
+Evaluator.run only, not interpreter start-up; the C time is the whole
+compiled program, built once per workload.  The best of --repeat runs is
+reported.  Results go to stdout (or --output) as JSON, with a table on
+stderr; --baseline compares against an earlier result and exits 1 if any
+workload slowed down by more than --threshold.
+"""
+
+import argparse
+import json
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+# Add src to path
+sys.path.insert(0, str(Path(__file__).parent.parent / "src"))
+
+BENCH_DIR = Path(__file__).parent
+BACKENDS = ("python", "c")
+OPS_PATTERN = re.compile(r"\(\*\s*ops:\s*(\d+)")
+
+
+def workloads(names: list[str]) -> list[Path]:
+    """The workload files to run, all of them if no names are given."""
+    found = {p.stem: p for p in sorted(BENCH_DIR.glob("*.joy"))}
+    unknown = [n for n in names if n not in found]
+    if unknown:
+        sys.exit(f"Unknown workload: {', '.join(unknown)}")
+    return [found[n] for n in names] if names else list(found.values())
+
+
+def declared_ops(path: Path) -> int:
+    match = OPS_PATTERN.search(path.read_text())
+    if not match:
+        sys.exit(f"{path.name}: missing '(* ops: N ... *)' header")
+    return int(match.group(1))
+
+
+def build_launcher(build_dir: Path) -> Path:
+    """Compile peak_rss.c, which runs a command and reports its peak RSS."""
+    from pyjoy.backends.c.builder import CBuilder
+
+    launcher = build_dir / "peak_rss"
+    source = BENCH_DIR / "peak_rss.c"
+    cmd = [CBuilder().compiler, "-O2", str(source), "-o", str(launcher)]
+    subprocess.run(cmd, check=True)
+    return launcher
+
+
+def run_child(launcher: Path, cmd: list[str]) -> tuple[float, int, str]:
+    """Run cmd to completion; return wall seconds, peak RSS in KB, stderr."""
+    start = time.perf_counter()
+    proc = subprocess.run(
+        [str(launcher), *cmd], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE
+    )
+    seconds = time.perf_counter() - start
+    stderr, _, rss = proc.stderr.decode(errors="replace").rpartition("peak_rss_kb:")
+    if proc.returncode != 0:
+        raise RuntimeError(f"{' '.join(cmd)} exited {proc.returncode}\n{stderr}")
+    return seconds, int(rss), stderr
+
+
+def evaluate(path: str) -> None:
+    """Child mode: run one workload on the Python evaluator, report its time."""
+    from pyjoy import Evaluator
+
+    source = Path(path).read_text()
+    evaluator = Evaluator()
+    start = time.perf_counter()
+    evaluator.run(source)
+    sys.stdout.flush()
+    print(f"seconds: {time.perf_counter() - start}", file=sys.stderr)
+
+
+def measure(
+    path: Path, backend: str, repeat: int, build_dir: Path, launcher: Path
+) -> dict:
+    """Best time, peak RSS and throughput of one workload on one backend."""
+    ops = declared_ops(path)
+    result: dict = {}
+    if backend == "python":
+        cmd = [sys.executable, __file__, "--evaluate", str(path)]
+    else:
+        from pyjoy.backends.c import compile_joy_to_c
+
+        start = time.perf_counter()
+        built = compile_joy_to_c(
+            path.read_text(),
+            output_dir=build_dir / path.stem,
+            target_name=path.stem,
+            source_path=path,
+        )
+        result["compile_seconds"] = round(time.perf_counter() - start, 4)
+        cmd = [str(built["executable"])]
+
+    best, peak = float("inf"), 0
+    for _ in range(repeat):
+        seconds, rss, stderr = run_child(launcher, cmd)
+        if backend == "python":
+            seconds = float(stderr.rsplit("seconds:", 1)[1])
+        best, peak = min(best, seconds), max(peak, rss)
+
+    result.update(
+        seconds=round(best, 6),
+        peak_rss_kb=peak,
+        ops=ops,
+        ops_per_sec=round(ops / best, 1),
+    )
+    return result
+
+
+def compare(results: dict, baseline: dict, threshold: float) -> list[str]:
+    """Workloads slower than the baseline by more than threshold."""
+    slower = []
+    for name, backends in results.items():
+        for backend, now in backends.items():
+            before = baseline.get(name, {}).get(backend)
+            if not before:
+                continue
+            ratio = now["seconds"] / before["seconds"]
+            now["baseline_ratio"] = round(ratio, 3)
+            if ratio > 1 + threshold:
+                slower.append(f"{name} ({backend}): {ratio:.2f}x baseline")
+    return slower
+
+
+def report(results: dict) -> None:
+    print(f"{'workload':<12} {'backend':<7} {'seconds':>10} {'ops/sec':>14} "
+          f"{'rss KB':>9} {'vs base':>8}", file=sys.stderr)
+    for name, backends in results.items():
+        for backend, r in backends.items():
+            ratio = f"{r['baseline_ratio']:.2f}x" if "baseline_ratio" in r else ""
+            print(f"{name:<12} {backend:<7} {r['seconds']:>10.4f} "
+                  f"{r['ops_per_sec']:>14,.0f} {r['peak_rss_kb']:>9} {ratio:>8}",
+                  file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0].strip())
+    parser.add_argument("names", nargs="*", help="Workloads to run (default: all)")
+    parser.add_argument("-b", "--backend", choices=(*BACKENDS, "both"),
+                        default="both", help="Backend to measure (default: both)")
+    parser.add_argument("-r", "--repeat", type=int, default=5,
+                        help="Runs per workload; the best is kept (default: 5)")
+    parser.add_argument("-o", "--output", metavar="FILE",
+                        help="Write the JSON results here instead of stdout")
+    parser.add_argument("--baseline", metavar="FILE",
+                        help="Compare against results saved by an earlier run")
+    parser.add_argument("--threshold", type=float, default=0.25,
+                        help="Slowdown over the baseline that fails (default: 0.25)")
+    parser.add_argument("--evaluate", metavar="FILE", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.evaluate:
+        evaluate(args.evaluate)
+        return 0
+
+    backends = BACKENDS if args.backend == "both" else (args.backend,)
+    results: dict = {}
+    paths = workloads(args.names)
+    with tempfile.TemporaryDirectory() as tmp:
+        build_dir = Path(tmp)
+        launcher = build_launcher(build_dir)
+        for path in paths:
+            results[path.stem] = {
+                backend: measure(path, backend, args.repeat, build_dir, launcher)
+                for backend in backends
+            }
+
+    slower = []
+    if args.baseline:
+        baseline = json.loads(Path(args.baseline).read_text())
+        slower = compare(results, baseline["results"], args.threshold)
+    report(results)
+
+    document = {
+        "machine": platform.machine(),
+        "system": platform.system(),
+        "python": platform.python_version(),
+        "results": results,
+    }
+    text = json.dumps(document, indent=2) + "\n"
+    if args.output:
+        Path(args.output).write_text(text)
+    else:
+        sys.stdout.write(text)
+
+    for line in slower:
+        print(f"Regression: {line}", file=sys.stderr)
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
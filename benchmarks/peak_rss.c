@@ -0,0 +1,45 @@
+/**
+ * peak_rss.c - Run a command and report its peak resident set size
+ *
+ * Linux carries a process's high-water RSS across exec, so a workload
+ * forked straight from the (much larger) Python harness would report the
+ * harness's footprint.  This launcher is small, forks the command from
+ * itself, and writes "peak_rss_kb: N" to stderr once it exits.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s command [args...]\n", argv[0]);
+        return 2;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 2;
+    }
+    if (pid == 0) {
+        execvp(argv[1], argv + 1);
+        perror(argv[1]);
+        _exit(127);
+    }
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return 2;
+    }
+#ifdef __APPLE__
+    long kb = usage.ru_maxrss / 1024;   /* bytes on macOS */
+#else
+    long kb = usage.ru_maxrss;
+#endif
+    fprintf(stderr, "peak_rss_kb: %ld\n", kb);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
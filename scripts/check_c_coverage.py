@@ -3,7 +3,6 @@
 Check Joy primitives coverage in the C backend.
 """
 
-import re
 import sys
 from pathlib import Path
 
@@ -15,19 +14,14 @@ from pyjoy.primitives import check_coverage, coverage_report, PRIMITIVES, SECTIO
 
 def get_c_backend_primitives() -> set:
     """Extract primitive names from C backend."""
-    c_file = Path(__file__).parent.parent / 'src' / 'pyjoy' / 'backends' / 'c' / 'runtime' / 'joy_primitives.c'
+    from pyjoy.backends.c.converter import PRIMITIVES_HEADER, primitive_functions
 
-    if not c_file.exists():
-        print(f"Error: {c_file} not found")
+    if not PRIMITIVES_HEADER.exists():
+        print(f"Error: {PRIMITIVES_HEADER} not found")
         sys.exit(1)
 
-    content = c_file.read_text()
-
-    # Find all joy_dict_define_primitive calls
-    pattern = r'joy_dict_define_primitive\(d,\s*"([^"]+)"'
-    matches = re.findall(pattern, content)
-
-    return set(matches)
+    # Every builtin is an X(name, fn) entry in JOY_PRIMITIVE_TABLE
+    return set(primitive_functions())
 
 
 def main():
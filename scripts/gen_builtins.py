@@ -0,0 +1,21 @@
+#!/usr/bin/env python3
+"""
+Regenerate the C runtime's builtin perfect hash (joy_builtins.h).
+"""
+
+import sys
+from pathlib import Path
+
+# Add src to path
+sys.path.insert(0, str(Path(__file__).parent.parent / 'src'))
+
+from pyjoy.backends.c.builtins import BUILTINS_HEADER, builtins_header
+
+
+def main():
+    BUILTINS_HEADER.write_text(builtins_header())
+    print(f"Wrote {BUILTINS_HEADER}")
+
+
+if __name__ == '__main__':
+    main()
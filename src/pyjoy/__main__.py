@@ -87,6 +87,25 @@ def create_parser() -> argparse.ArgumentParser:
         action="store_true",
         help="Compile and run the program",
     )
+    compile_parser.add_argument(
+        "-O",
+        dest="optimize",
+        type=int,
+        choices=range(4),
+        default=2,
+        metavar="LEVEL",
+        help="Optimization level 0-3 (default: 2)",
+    )
+    compile_parser.add_argument(
+        "--profile",
+        action="store_true",
+        help="Build with per-word profiling, reported to stderr at exit",
+    )
+    compile_parser.add_argument(
+        "--lto",
+        action="store_true",
+        help="Optimize the runtime together with the program at link time",
+    )
 
     # test subcommand
     test_parser = subparsers.add_parser(
@@ -191,6 +210,9 @@ def cmd_compile(args: argparse.Namespace) -> int:
             target_name=target_name,
             compile_executable=not args.no_compile,
             source_path=source_path,
+            optimize=args.optimize,
+            profile=args.profile,
+            lto=args.lto,
         )
 
         print(f"Generated: {result['c_file']}")
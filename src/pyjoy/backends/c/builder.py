@@ -3,29 +3,59 @@ pyjoy.backends.c.builder - Builds Joy programs compiled to C.
 
 This module provides functionality to compile C code generated by
 the emitter into executable binaries.
+
+The runtime is compiled once per compiler and flags into a cached
+libjoyrt.a, and each program is cached by a hash of its C source, the
+flags and the runtime, so rebuilding an unchanged program only copies
+it out of the cache (see pyjoy.cache).
 """
 
 from __future__ import annotations
 
+import os
 import shutil
 import subprocess
 import sys
+import tempfile
+import threading
 from pathlib import Path
 from typing import Any
 
+from ...cache import cache_dir as default_cache_dir
+from ...cache import content_key
+from ...types import JoyQuotation
+
+# `cc --version` by compiler, for cache keys
+_compiler_ids: dict[str, str] = {}
+
 
 class CBuilder:
     """
     Builds Joy programs compiled to C.
 
     Handles compilation of generated C code using gcc or clang,
-    including the Joy runtime library.
+    including the Joy runtime library.  With lto=True the runtime and
+    programs are built with -flto, so the runtime is optimized together
+    with each program at link time.
     """
 
-    def __init__(self) -> None:
+    def __init__(
+        self,
+        cache_dir: str | Path | None = None,
+        cache: bool = True,
+        lto: bool = False,
+    ) -> None:
         self.runtime_dir = Path(__file__).parent / "runtime"
         self.compiler = self._find_compiler()
-        self.compile_flags = ["-Wall", "-Wextra", "-std=c11", "-O2"]
+        # The optimization level comes only from build_flags
+        self.compile_flags = ["-Wall", "-Wextra", "-std=c11", "-pthread"]
+        self.lto = lto
+        if not cache:
+            self.cache_dir = None
+        elif cache_dir is not None:
+            self.cache_dir = Path(cache_dir)
+        else:
+            self.cache_dir = default_cache_dir()
 
     def _find_compiler(self) -> str:
         """Find an available C compiler."""
@@ -42,12 +72,147 @@ class CBuilder:
         """Get the runtime header files."""
         return list(self.runtime_dir.glob("*.h"))
 
+    def build_flags(
+        self,
+        debug: bool = False,
+        optimize: int = 2,
+        profile: bool = False,
+        shared: bool = False,
+    ) -> list[str]:
+        """Compiler flags for the runtime and a program built with them."""
+        flags = list(self.compile_flags)
+        if debug:
+            flags.append("-g")
+        flags.append(f"-O{optimize}")
+        if profile:
+            flags.append("-DJOY_PROFILE")
+        if self.lto:
+            flags.append("-flto")
+        if shared:
+            flags.append("-fPIC")
+        return flags
+
+    def runtime_library(self, flags: list[str]) -> Path | None:
+        """
+        The runtime compiled with flags, as a cached libjoyrt.a with its
+        object files beside it.  Built on first use; None when caching
+        is off or there is no archiver.
+
+        Raises:
+            RuntimeError: If the runtime fails to compile
+        """
+        archiver = self._find_archiver()
+        if self.cache_dir is None or archiver is None:
+            return None
+
+        files = sorted(self.get_runtime_sources() + self.get_runtime_headers())
+        key = content_key(
+            self._compiler_id(),
+            *flags,
+            *(part for f in files for part in (f.name, f.read_bytes())),
+        )
+        directory = self.cache_dir / "c" / f"runtime-{key[:24]}"
+        library = directory / "libjoyrt.a"
+        if library.exists():
+            return library
+
+        directory.parent.mkdir(parents=True, exist_ok=True)
+        build = Path(tempfile.mkdtemp(prefix=".build-", dir=directory.parent))
+        try:
+            sources = [str(p) for p in self.get_runtime_sources()]
+            self._run(
+                [self.compiler, *flags, f"-I{self.runtime_dir}", "-c", *sources],
+                cwd=build,
+            )
+            objects = sorted(p.name for p in build.glob("*.o"))
+            self._run([archiver, "rcs", library.name, *objects], cwd=build)
+            try:
+                os.rename(build, directory)
+            except OSError:
+                if not library.exists():
+                    raise
+                # Another process finished the same build first
+        finally:
+            shutil.rmtree(build, ignore_errors=True)
+        return library
+
+    def _find_archiver(self) -> str | None:
+        """ar, or the compiler's LTO-aware wrapper (gcc-ar) when using LTO."""
+        names = [f"{self.compiler}-ar", "llvm-ar", "ar"] if self.lto else ["ar"]
+        for name in names:
+            if shutil.which(name):
+                return name
+        return None
+
+    def _compiler_id(self) -> str:
+        if self.compiler not in _compiler_ids:
+            result = subprocess.run(
+                [self.compiler, "--version"], capture_output=True, text=True
+            )
+            _compiler_ids[self.compiler] = (
+                f"{shutil.which(self.compiler)}\n{result.stdout}"
+            )
+        return _compiler_ids[self.compiler]
+
+    def _run(self, cmd: list[str], cwd: Path | None = None) -> None:
+        result = subprocess.run(cmd, capture_output=True, text=True, cwd=cwd)
+        if result.returncode != 0:
+            raise RuntimeError(f"Compilation failed:\n{result.stderr}")
+
+    def _build(
+        self, source: Path, output: Path, flags: list[str], shared: bool = False
+    ) -> Path:
+        """Compile source against the runtime, through the caches if on."""
+        library = self.runtime_library(flags)
+        if library is None:
+            runtime = [str(p) for p in self.get_runtime_sources()]
+        elif shared:
+            # Every object: the host calls into joy_embed.c, which the
+            # program itself never references
+            runtime = [str(p) for p in sorted(library.parent.glob("*.o"))]
+        else:
+            runtime = [str(library)]
+        link = ["-shared"] if shared else []
+
+        def compile_to(target: Path) -> None:
+            # Libraries after the program's source (GCC resolves in order)
+            cmd = [self.compiler, *flags, *link, f"-I{self.runtime_dir}"]
+            cmd += [str(source), *runtime, "-o", str(target), "-lm"]
+            self._run(cmd)
+
+        if library is None:
+            compile_to(output)
+            return output
+
+        key = content_key(
+            self._compiler_id(),
+            *flags,
+            *link,
+            library.parent.name,
+            source.read_bytes(),
+        )
+        cached = library.parent.parent / "programs" / f"{key[:32]}{output.suffix}"
+        if not cached.exists():
+            cached.parent.mkdir(parents=True, exist_ok=True)
+            partial = cached.with_name(
+                f".{cached.name}.{os.getpid()}.{threading.get_ident()}"
+            )
+            try:
+                compile_to(partial)
+                os.replace(partial, cached)
+            finally:
+                partial.unlink(missing_ok=True)
+        output.unlink(missing_ok=True)
+        shutil.copy2(cached, output)
+        return output
+
     def compile(
         self,
         source_file: str | Path,
         output_file: str | Path | None = None,
         debug: bool = False,
         optimize: int = 2,
+        profile: bool = False,
     ) -> Path:
         """
         Compile a Joy C program to an executable.
@@ -57,6 +222,8 @@ class CBuilder:
             output_file: Path for the output executable (default: source stem)
             debug: Include debug symbols
             optimize: Optimization level (0-3)
+            profile: Build with per-word profiling (JOY_PROFILE); the
+                program reports to stderr at exit (see joy_profile.c)
 
         Returns:
             Path to the compiled executable
@@ -77,40 +244,47 @@ class CBuilder:
         if sys.platform == "win32" and output.suffix != ".exe":
             output = output.with_suffix(".exe")
 
-        # Build compilation command
-        cmd = [self.compiler]
-
-        # Add flags
-        cmd.extend(self.compile_flags)
-
-        if debug:
-            cmd.append("-g")
-
-        cmd.append(f"-O{optimize}")
+        return self._build(source, output, self.build_flags(debug, optimize, profile))
 
-        # Add include path for runtime
-        cmd.append(f"-I{self.runtime_dir}")
-
-        # Add runtime sources
-        cmd.extend(str(p) for p in self.get_runtime_sources())
-
-        # Add main source
-        cmd.append(str(source))
+    def compile_shared(
+        self,
+        source_file: str | Path,
+        output_file: str | Path | None = None,
+        optimize: int = 2,
+    ) -> Path:
+        """
+        Compile a Joy C program emitted with CEmitter.emit_library into a
+        shared library, for loading in-process (see native.py).
 
-        # Output
-        cmd.extend(["-o", str(output)])
+        Args:
+            source_file: Path to the generated C source
+            output_file: Path for the library (default: source stem with
+                the platform's shared library suffix)
+            optimize: Optimization level (0-3)
 
-        # Add math library AFTER sources (GCC requires libraries after objects)
-        cmd.append("-lm")
+        Returns:
+            Path to the shared library
 
-        # Run compilation
-        result = subprocess.run(cmd, capture_output=True, text=True)
+        Raises:
+            RuntimeError: If compilation fails
+        """
+        source = Path(source_file)
+        if not source.exists():
+            raise FileNotFoundError(f"Source file not found: {source}")
 
-        if result.returncode != 0:
-            error_msg = f"Compilation failed:\n{result.stderr}"
-            raise RuntimeError(error_msg)
+        if sys.platform == "win32":
+            suffix = ".dll"
+        elif sys.platform == "darwin":
+            suffix = ".dylib"
+        else:
+            suffix = ".so"
+        if output_file is None:
+            output = source.with_suffix(suffix)
+        else:
+            output = Path(output_file)
 
-        return output
+        flags = self.build_flags(optimize=optimize, shared=True)
+        return self._build(source, output, flags, shared=True)
 
     def compile_and_run(
         self,
@@ -151,6 +325,7 @@ class CBuilder:
         self,
         source_file: str | Path,
         target_name: str = "joy_program",
+        profile: bool = False,
     ) -> str:
         """
         Generate a Makefile for building a Joy C program.
@@ -158,19 +333,21 @@ class CBuilder:
         Args:
             source_file: Path to the generated C source
             target_name: Name of the target executable
+            profile: Build with per-word profiling (JOY_PROFILE)
 
         Returns:
             Makefile contents as a string
         """
         source = Path(source_file).name
         runtime_sources = " ".join(p.name for p in self.get_runtime_sources())
+        flags = self.build_flags(profile=profile)
 
         makefile = f"""\
 # Makefile for Joy program
 # Generated by pyjoy C backend
 
 CC = {self.compiler}
-CFLAGS = {" ".join(self.compile_flags)}
+CFLAGS = {" ".join(flags)}
 LDFLAGS = -lm
 
 RUNTIME_DIR = {self.runtime_dir}
@@ -200,6 +377,7 @@ run: $(TARGET)
         output_dir: str | Path,
         source_file: str | Path,
         target_name: str = "joy_program",
+        profile: bool = False,
     ) -> Path:
         """
         Save a Makefile to a directory.
@@ -208,6 +386,7 @@ run: $(TARGET)
             output_dir: Directory to save the Makefile
             source_file: Path to the generated C source
             target_name: Name of the target executable
+            profile: Build with per-word profiling (JOY_PROFILE)
 
         Returns:
             Path to the generated Makefile
@@ -216,7 +395,7 @@ run: $(TARGET)
         output.mkdir(parents=True, exist_ok=True)
 
         makefile_path = output / "Makefile"
-        makefile_content = self.generate_makefile(source_file, target_name)
+        makefile_content = self.generate_makefile(source_file, target_name, profile)
         makefile_path.write_text(makefile_content)
 
         return makefile_path
@@ -240,18 +419,20 @@ run: $(TARGET)
             shutil.copy2(hdr, dst)
 
 
-def _load_stdlib_source() -> str:
-    """Load stdlib Joy source files (inilib.joy, agglib.joy)."""
+def _load_stdlib_terms() -> tuple[Any, ...]:
+    """Parsed stdlib (inilib.joy, agglib.joy) terms, via the parse cache."""
+    from ...parser import parse_file
+
     stdlib_dir = Path(__file__).parent.parent.parent / "stdlib"
     libs = ["inilib.joy", "agglib.joy"]
-    sources = []
+    terms: list[Any] = []
 
     for lib in libs:
         lib_path = stdlib_dir / lib
         if lib_path.exists():
-            sources.append(lib_path.read_text())
+            terms.extend(parse_file(lib_path).program.terms)
 
-    return "\n".join(sources)
+    return tuple(terms)
 
 
 def compile_joy_to_c(
@@ -261,6 +442,9 @@ def compile_joy_to_c(
     compile_executable: bool = True,
     source_path: str | Path | None = None,
     load_stdlib: bool = False,
+    optimize: int = 2,
+    profile: bool = False,
+    lto: bool = False,
 ) -> dict[str, Any]:
     """
     High-level function to compile Joy source to C.
@@ -272,6 +456,12 @@ def compile_joy_to_c(
         compile_executable: Whether to compile the C code
         source_path: Path to the source file (for resolving includes)
         load_stdlib: Whether to load stdlib definitions (default: True)
+        optimize: Optimization level (0-3) for both the Joy optimizer
+            (1: folding, no-op removal, superinstructions; 2: also
+            inlining) and the C compiler
+        profile: Build with per-word profiling: calls, time, allocations
+            and stack depth per word, reported to stderr at exit
+        lto: Build the runtime and program with link-time optimization
 
     Returns:
         Dictionary with:
@@ -282,13 +472,9 @@ def compile_joy_to_c(
     """
     from .converter import JoyToCConverter
     from .emitter import CEmitter
+    from .optimizer import optimize_program
     from .preprocessor import preprocess_includes
 
-    # Optionally prepend stdlib definitions
-    if load_stdlib:
-        stdlib_source = _load_stdlib_source()
-        source = stdlib_source + "\n" + source
-
     # Parse and preprocess (expands includes)
     if source_path:
         parse_result = preprocess_includes(source, source_path=source_path)
@@ -298,12 +484,19 @@ def compile_joy_to_c(
         parser = Parser()
         parse_result = parser.parse_full(source)
 
+    # Optionally prepend the stdlib definitions, parsed once and cached
+    program = parse_result.program
+    if load_stdlib:
+        program = JoyQuotation(_load_stdlib_terms() + program.terms)
+
     # Convert to C representation (definitions are handled inline)
     converter = JoyToCConverter()
-    c_program = converter.convert(parse_result.program)
+    c_program = converter.convert(program)
+    # Profiling keeps definitions as calls, so each shows up in the report
+    optimize_program(c_program, min(optimize, 1) if profile else optimize)
 
     # Emit C code
-    emitter = CEmitter()
+    emitter = CEmitter(profile=profile)
     c_source = emitter.emit(c_program)
 
     result: dict[str, Any] = {"c_source": c_source}
@@ -318,17 +511,19 @@ def compile_joy_to_c(
         result["c_file"] = c_file
 
         # Build
-        builder = CBuilder()
+        builder = CBuilder(lto=lto)
 
         # Copy runtime
         builder.copy_runtime(output)
 
         # Generate Makefile
-        makefile = builder.save_makefile(output, c_file, target_name)
+        makefile = builder.save_makefile(output, c_file, target_name, profile)
         result["makefile"] = makefile
 
         if compile_executable:
-            executable = builder.compile(c_file, output / target_name)
+            executable = builder.compile(
+                c_file, output / target_name, optimize=optimize, profile=profile
+            )
             result["executable"] = executable
 
     return result
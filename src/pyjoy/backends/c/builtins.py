@@ -0,0 +1,137 @@
+"""
+pyjoy.backends.c.builtins - Perfect hash table for the C runtime's builtins.
+
+Generates runtime/joy_builtins.h, which lets the runtime find a builtin
+word with one hash probe into read-only tables instead of registering
+every primitive in the dictionary at startup.  The hash matches the
+runtime's symbol hash (djb2, truncated to 32 bits), so a lookup reuses
+the hash cached in the interned symbol.
+
+Regenerate after editing JOY_PRIMITIVE_TABLE:
+
+    python scripts/gen_builtins.py
+"""
+
+from __future__ import annotations
+
+from pathlib import Path
+
+from .converter import primitive_functions
+
+BUILTINS_HEADER = Path(__file__).parent / "runtime" / "joy_builtins.h"
+
+MASK32 = 0xFFFFFFFF
+MAX_SEED = 0xFFFF
+
+
+def symbol_hash(name: str) -> int:
+    """djb2 over the name's bytes as C `char`s, keeping the low 32 bits."""
+    h = 5381
+    for byte in name.encode():
+        c = byte - 256 if byte > 127 else byte
+        h = (h * 33 + c) & MASK32
+    return h
+
+
+def mix32(x: int) -> int:
+    """The murmur3 finalizer; mirrors joy_builtin_mix in joy_builtins.h."""
+    x ^= x >> 16
+    x = (x * 0x85EBCA6B) & MASK32
+    x ^= x >> 13
+    x = (x * 0xC2B2AE35) & MASK32
+    x ^= x >> 16
+    return x
+
+
+def unescape(name: str) -> str:
+    """Undo the C string escapes used for names in joy_primitives.h."""
+    return name.encode().decode("unicode_escape")
+
+
+def build_table(names: list[str]) -> tuple[list[int], list[int]]:
+    """
+    Hash-and-displace: split keys into buckets by their low hash bits, then
+    give each bucket (largest first) the smallest seed that sends all of
+    its keys to free slots.  Returns (seeds, slots) where slots[i] is the
+    index into names of the word stored at slot i, or -1.
+    """
+    slot_count = 1
+    while slot_count < len(names):
+        slot_count *= 2
+    bucket_count = max(1, slot_count // 4)
+
+    hashes = [symbol_hash(name) for name in names]
+    buckets: list[list[int]] = [[] for _ in range(bucket_count)]
+    for index, h in enumerate(hashes):
+        buckets[h & (bucket_count - 1)].append(index)
+
+    seeds = [0] * bucket_count
+    slots = [-1] * slot_count
+    order = sorted(range(bucket_count), key=lambda b: -len(buckets[b]))
+    for bucket in order:
+        members = buckets[bucket]
+        if not members:
+            continue
+        for seed in range(MAX_SEED + 1):
+            taken = [mix32(hashes[i] ^ seed) & (slot_count - 1) for i in members]
+            if len(set(taken)) == len(taken) and all(slots[s] < 0 for s in taken):
+                break
+        else:
+            raise ValueError(f"no perfect hash seed for bucket {bucket}")
+        seeds[bucket] = seed
+        for index, slot in zip(members, taken):
+            slots[slot] = index
+    return seeds, slots
+
+
+def _format_array(values: list[int], per_line: int) -> str:
+    lines = []
+    for start in range(0, len(values), per_line):
+        chunk = values[start : start + per_line]
+        lines.append("    " + ", ".join(str(v) for v in chunk) + ",")
+    return "\n".join(lines)
+
+
+def builtins_header() -> str:
+    """Render joy_builtins.h for the current JOY_PRIMITIVE_TABLE."""
+    names = [unescape(name) for name in primitive_functions()]
+    seeds, slots = build_table(names)
+
+    return f"""\
+/**
+ * joy_builtins.h - Perfect hash over JOY_PRIMITIVE_TABLE
+ *
+ * Generated by scripts/gen_builtins.py; do not edit.  A builtin's slot
+ * is joy_builtin_mix(hash ^ seed[hash & (BUCKETS - 1)]) & (SLOTS - 1),
+ * where hash is the low 32 bits of its symbol hash.  joy_builtin_slots
+ * holds the word's position in JOY_PRIMITIVE_TABLE, or -1.
+ */
+
+#ifndef JOY_BUILTINS_H
+#define JOY_BUILTINS_H
+
+#include <stdint.h>
+
+#define JOY_BUILTIN_COUNT {len(names)}
+#define JOY_BUILTIN_SLOTS {len(slots)}
+#define JOY_BUILTIN_BUCKETS {len(seeds)}
+
+static inline uint32_t joy_builtin_mix(uint32_t x) {{
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}}
+
+static const uint16_t joy_builtin_seeds[JOY_BUILTIN_BUCKETS] = {{
+{_format_array(seeds, 12)}
+}};
+
+static const int16_t joy_builtin_slots[JOY_BUILTIN_SLOTS] = {{
+{_format_array(slots, 16)}
+}};
+
+#endif /* JOY_BUILTINS_H */
+"""
@@ -7,11 +7,25 @@ be emitted as C code.
 
 from __future__ import annotations
 
+import re
 from dataclasses import dataclass, field
-from typing import Any
+from functools import cache
+from pathlib import Path
+from typing import Any, Iterable
 
 from ...parser import Definition
 from ...types import JoyQuotation, JoyType, JoyValue
+from .kernels import CKernel, infer_kernels
+
+
+PRIMITIVES_HEADER = Path(__file__).parent / "runtime" / "joy_primitives.h"
+
+
+@cache
+def primitive_functions() -> dict[str, str]:
+    """Map each builtin Joy word to its C function, from joy_primitives.h."""
+    text = PRIMITIVES_HEADER.read_text()
+    return dict(re.findall(r'X\("((?:[^"\\]|\\.)*)", (prim_\w+)\)', text))
 
 
 @dataclass
@@ -31,6 +45,8 @@ class CValue:
     # "quotation", "symbol", "define"
     type: str
     value: Any
+    # For symbols whose binding is known statically: the C function to call
+    c_name: str | None = None
 
     def to_c_init(self) -> str:
         """Generate C initializer for this value."""
@@ -105,6 +121,7 @@ class CDefinition:
     name: str  # Joy word name
     c_name: str  # C function name
     body: CQuotation  # Body as quotation
+    kernels: list[CKernel] = field(default_factory=list)  # unboxed fast paths
 
 
 @dataclass
@@ -114,6 +131,8 @@ class CProgram:
     quotations: list[CQuotation] = field(default_factory=list)
     definitions: list[CDefinition] = field(default_factory=list)
     main_body: CQuotation | None = None
+    # Words a host calls by name, kept however unused (see native.py)
+    roots: set[str] = field(default_factory=set)
 
     def add_quotation(self, quotation: CQuotation) -> None:
         """Add a quotation to the program."""
@@ -124,6 +143,61 @@ class CProgram:
         self.definitions.append(definition)
 
 
+# Builtins that reach definitions by a name computed at run time
+REFLECTIVE_WORDS = frozenset({"intern", "body", "undefs"})
+
+
+def eliminate_dead_definitions(program: CProgram) -> CProgram:
+    """
+    Drop the definitions and quotations a program can never run, in place.
+
+    Liveness starts at the main body and program.roots and follows each
+    symbol, by name, into every definition of that name, and into every
+    quotation and list literal, since any of them may be executed.  Going
+    by name keeps all versions of a redefined word.  If live code uses a
+    reflective builtin (REFLECTIVE_WORDS) nothing is dropped.
+    """
+    if program.main_body is None:
+        return program
+
+    defines: dict[str, list[CDefine]] = {}
+    for term in program.main_body.terms:
+        if term.type == "define":
+            defines.setdefault(term.value.name, []).append(term.value)
+
+    live_names: set[str] = set()
+    live_quotations: set[int] = set()
+    pending = [t for t in program.main_body.terms if t.type != "define"]
+    pending.extend(CValue(type="symbol", value=name) for name in program.roots)
+    while pending:
+        term = pending.pop()
+        if term.type == "symbol":
+            if term.value in REFLECTIVE_WORDS:
+                return program
+            if term.value not in live_names:
+                live_names.add(term.value)
+                for define in defines.get(term.value, ()):
+                    pending.extend(define.body.terms)
+        elif term.type == "quotation":
+            if id(term.value) not in live_quotations:
+                live_quotations.add(id(term.value))
+                pending.extend(term.value.terms)
+        elif term.type == "list":
+            pending.extend(term.value)
+
+    live_c_names = {
+        define.c_name for name in live_names for define in defines.get(name, ())
+    }
+    program.main_body.terms = [
+        t
+        for t in program.main_body.terms
+        if t.type != "define" or t.value.c_name in live_c_names
+    ]
+    program.definitions = [d for d in program.definitions if d.c_name in live_c_names]
+    program.quotations = [q for q in program.quotations if id(q) in live_quotations]
+    return program
+
+
 class JoyToCConverter:
     """
     Converts Joy AST to C representation.
@@ -198,29 +272,80 @@ class JoyToCConverter:
         return name or "_unnamed"
 
     def convert(
-        self, program: JoyQuotation, definitions: dict[str, JoyQuotation] | None = None
+        self,
+        program: JoyQuotation,
+        definitions: dict[str, JoyQuotation] | None = None,
+        roots: Iterable[str] = (),
     ) -> CProgram:
         """
         Convert a Joy program to C representation.
 
+        Definitions the program can never reach (eliminate_dead_definitions)
+        are left out, so unused stdlib words cost nothing.
+
         Args:
             program: The main program as a quotation
             definitions: User-defined words (name -> body) - deprecated, ignored
+            roots: Words to keep even if the program never uses them
 
         Returns:
             CProgram ready for C emission
         """
         self._quotation_counter = 0
         self._definition_versions = {}
-        self._program = CProgram()
+        self._program = CProgram(roots=set(roots))
 
         # Convert main program (definitions are processed inline)
         self._program.main_body = self._convert_quotation(
             program, "_main_program", process_defines=True
         )
+        self._bind_direct_calls(self._program.main_body)
+        eliminate_dead_definitions(self._program)
+
+        by_c_name = {d.c_name: d for d in self._program.definitions}
+        for definition in self._program.definitions:
+            definition.kernels = infer_kernels(definition, by_c_name)
 
         return self._program
 
+    def _bind_direct_calls(self, main_body: CQuotation) -> None:
+        """
+        Mark symbols whose binding can never change for direct calls.
+
+        A builtin qualifies if the program never defines its name. A user
+        word qualifies if it is defined exactly once and its definition is
+        registered before the call can run: earlier in the main body, or
+        no later than the definition whose body makes the call. Symbols
+        inside quotation literals are bound by the same rule, since a
+        literal runs no earlier than the point where it is pushed; the
+        symbol itself stays in the quotation's data.
+        """
+        primitives = primitive_functions()
+        defined = self._definition_versions
+        registered: dict[str, str] = {}
+
+        def bind(term: CValue) -> None:
+            if term.type == "quotation" and isinstance(term.value, CQuotation):
+                for nested in term.value.terms:
+                    bind(nested)
+                return
+            if term.type != "symbol":
+                return
+            if term.value in registered:
+                term.c_name = registered[term.value]
+            elif term.value in primitives and term.value not in defined:
+                term.c_name = primitives[term.value]
+
+        for term in main_body.terms:
+            if term.type == "define":
+                c_define = term.value
+                if defined[c_define.name] == 1:
+                    registered[c_define.name] = c_define.c_name
+                for body_term in c_define.body.terms:
+                    bind(body_term)
+            else:
+                bind(term)
+
     def _convert_definition(self, name: str, body: JoyQuotation) -> CDefinition:
         """Convert a Joy definition to C with versioned function name."""
         # Get or create version counter for this name
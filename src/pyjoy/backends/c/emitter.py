@@ -9,7 +9,43 @@ from __future__ import annotations
 from pathlib import Path
 from textwrap import dedent
 
-from .converter import CDefine, CDefinition, CProgram, CQuotation, CValue
+from .converter import (
+    CDefine,
+    CDefinition,
+    CProgram,
+    CQuotation,
+    CValue,
+    primitive_functions,
+)
+from .kernels import BOXERS, C_TYPES, CKernel
+
+# Combinators compiled to C control flow when their quotation arguments
+# are literal, with the number of trailing quotation arguments
+NATIVE_COMBINATORS = {
+    "ifte": 3,
+    "branch": 2,
+    "times": 1,
+    "while": 2,
+    "step": 1,
+    "map": 1,
+    "fold": 1,
+}
+
+# Builtins with fast paths for numeric aggregates (joy_vector.c)
+VECTOR_OPS = {
+    "+": "JOY_OP_ADD",
+    "-": "JOY_OP_SUB",
+    "*": "JOY_OP_MUL",
+    "/": "JOY_OP_DIV",
+    "max": "JOY_OP_MAX",
+    "min": "JOY_OP_MIN",
+    "<": "JOY_OP_LT",
+    ">": "JOY_OP_GT",
+    "<=": "JOY_OP_LE",
+    ">=": "JOY_OP_GE",
+    "=": "JOY_OP_EQ",
+    "!=": "JOY_OP_NE",
+}
 
 
 class CEmitter:
@@ -17,34 +53,48 @@ class CEmitter:
     Emits C code from converted Joy programs.
 
     Generates standalone C source files that can be compiled with the
-    Joy runtime library.
+    Joy runtime library.  With profile=True every definition and every
+    direct builtin call is bracketed by joy_profile_enter/leave, for
+    builds with JOY_PROFILE defined (see joy_profile.c).
     """
 
-    def __init__(self) -> None:
+    def __init__(self, profile: bool = False) -> None:
         self.runtime_dir = Path(__file__).parent / "runtime"
+        self.profile = profile
+        self._definitions: set[str] = set()
         self._indent_level = 0
+        self._reaches: dict[str, set[str]] = {}
+        self._current: CDefinition | None = None
+        self._blocks = 0
 
-    def emit(self, program: CProgram) -> str:
+    def emit(self, program: CProgram, library: bool = False) -> str:
         """
         Emit C code for a complete program.
 
         Args:
             program: CProgram from the converter
+            library: Emit joy_library_open/close in place of main, for
+                a shared library driven through joy_embed.c
 
         Returns:
             Complete C source code as a string
         """
         lines: list[str] = []
+        self._reaches = self._call_graph(program)
+        self._definitions = {defn.c_name for defn in program.definitions}
+        self._blocks = 0
 
         # Header
         lines.append(self._emit_header())
         lines.append("")
 
-        # Forward declarations for quotations
+        # Forward declarations for quotations.  Each thread builds its own
+        # (parallel workers via joy_set_worker_hooks), as values are not
+        # shared between contexts.
         if program.quotations:
             lines.append("/* Forward declarations for quotations */")
             for quot in program.quotations:
-                lines.append(f"static JoyQuotation* {quot.name} = NULL;")
+                lines.append(f"static _Thread_local JoyQuotation* {quot.name} = NULL;")
             lines.append("")
 
         # Emit quotation initializers
@@ -55,6 +105,11 @@ class CEmitter:
                 lines.append(self._emit_quotation_init(quot))
             lines.append("}")
             lines.append("")
+            lines.append("static void free_quotations(void) {")
+            for quot in program.quotations:
+                lines.append(f"    if ({quot.name}) joy_quotation_free({quot.name});")
+            lines.append("}")
+            lines.append("")
 
         # Emit user definitions (functions only, registration happens inline)
         if program.definitions:
@@ -72,7 +127,10 @@ class CEmitter:
         lines.append("")
 
         # Emit main function
-        lines.append(self._emit_main(program))
+        if library:
+            lines.append(self._emit_library_entry(program))
+        else:
+            lines.append(self._emit_main(program))
 
         return "\n".join(lines)
 
@@ -89,6 +147,7 @@ class CEmitter:
             #include <string.h>
             #include <math.h>
             #include "joy_runtime.h"
+            #include "joy_primitives.h"
         """)
 
     def _emit_quotation_init(self, quotation: CQuotation) -> str:
@@ -169,7 +228,7 @@ class CEmitter:
             if isinstance(value.value, CQuotation):
                 return (
                     f"(JoyValue){{.type = JOY_QUOTATION, "
-                    f".data.quotation = joy_quotation_copy({value.value.name})}}"
+                    f".data.quotation = joy_quotation_retain({value.value.name})}}"
                 )
             else:
                 return "joy_quotation_empty()"
@@ -186,20 +245,76 @@ class CEmitter:
 
     def _emit_definition(self, defn: CDefinition) -> str:
         """Emit a user-defined word as a C function."""
+        # A profiled word runs its final call itself rather than leaving it
+        # to the caller, so the time is charged to the word
+        c_name = f"{defn.c_name}_body" if self.profile else defn.c_name
         lines = []
-        lines.append(f"static void {defn.c_name}(JoyContext* ctx) {{")
-        lines.append(self._emit_quotation_execution(defn.body, "    "))
+        lines.append(f"static void {c_name}(JoyContext* ctx) {{")
+        for kernel in defn.kernels:
+            lines.append(self._emit_kernel(kernel, "    "))
+        self._current = defn
+        lines.append(
+            self._emit_quotation_execution(defn.body, "    ", tail=not self.profile)
+        )
+        self._current = None
         lines.append("}")
+        if self.profile:
+            lines.append("")
+            lines.append(f"static void {defn.c_name}(JoyContext* ctx) {{")
+            lines.append(f'    joy_profile_enter(ctx, "{defn.name}");')
+            lines.append(f"    {c_name}(ctx);")
+            lines.append("    joy_profile_leave(ctx);")
+            lines.append("}")
+        return "\n".join(lines)
+
+    def _emit_kernel(self, kernel: CKernel, indent_str: str = "") -> str:
+        """Emit an unboxed kernel, guarded by a check of its input types."""
+        inner = indent_str + "    "
+        c_type = C_TYPES[kernel.input_type]
+        field_name = "integer" if kernel.input_type == "int" else "floating"
+        lines = [
+            f"{indent_str}/* {c_type} kernel: {kernel.arity} in, "
+            f"{len(kernel.outputs)} out */",
+            f"{indent_str}if (joy_stack_top_are(ctx->stack, {kernel.arity}, "
+            f"{kernel.input_tag})) {{",
+        ]
+        for index in range(kernel.arity):
+            lines.append(
+                f"{inner}{c_type} a{index} = "
+                f"joy_stack_pop(ctx->stack).data.{field_name};"
+            )
+        lines.extend(f"{inner}{statement}" for statement in kernel.body)
+        for type_, expr in kernel.outputs:
+            lines.append(f"{inner}joy_stack_push(ctx->stack, {BOXERS[type_]}({expr}));")
+        lines.append(f"{inner}return;")
+        lines.append(f"{indent_str}}}")
         return "\n".join(lines)
 
     def _emit_quotation_execution(
-        self, quotation: CQuotation, indent_str: str = ""
+        self, quotation: CQuotation, indent_str: str = "", tail: bool = False
     ) -> str:
-        """Emit code to execute a quotation inline."""
+        """
+        Emit code to execute a quotation inline.
+
+        A call may leave a tail (see joy_execute_tail) that must run before
+        the next term.  With tail=True the final call leaves it to the
+        caller, so a word ending in a combinator does not nest on the C
+        stack.
+        """
         lines = []
+        terms = self._group_native(quotation.terms)
+        last = len(terms) - 1
+
+        for index, term in enumerate(terms):
+            finish_tail = not (tail and index == last)
+            if isinstance(term, tuple):
+                # A combinator over literal quotations, as C control flow
+                name, quotations = term
+                lines.append(
+                    self._emit_native(name, quotations, indent_str, not finish_tail)
+                )
 
-        for term in quotation.terms:
-            if term.type == "define":
+            elif term.type == "define":
                 # Register a user-defined word at this point in the program
                 c_define = term.value
                 if isinstance(c_define, CDefine):
@@ -208,16 +323,29 @@ class CEmitter:
                         f'ctx->dictionary, "{c_define.name}", {c_define.c_name});'
                     )
 
+            elif term.type == "symbol" and term.c_name:
+                # Call a word whose binding the converter resolved statically
+                if self.profile and term.c_name not in self._definitions:
+                    lines.append(f'{indent_str}joy_profile_enter(ctx, "{term.value}");')
+                    lines.append(f"{indent_str}{term.c_name}(ctx);")
+                    lines.append(f"{indent_str}joy_profile_leave(ctx);")
+                else:
+                    lines.append(f"{indent_str}{term.c_name}(ctx);")
+                if finish_tail:
+                    lines.append(f"{indent_str}joy_run_tail(ctx);")
+
             elif term.type == "symbol":
-                # Execute the symbol
-                lines.append(f'{indent_str}joy_execute_symbol(ctx, "{term.value}");')
+                # Execute the symbol through a cached call site
+                lines.append(f'{indent_str}JOY_CALL(ctx, "{term.value}");')
+                if finish_tail:
+                    lines.append(f"{indent_str}joy_run_tail(ctx);")
 
             elif term.type == "quotation":
                 # Push the quotation onto the stack
                 if isinstance(term.value, CQuotation):
                     qval = (
                         f"(JoyValue){{.type = JOY_QUOTATION, "
-                        f".data.quotation = joy_quotation_copy({term.value.name})}}"
+                        f".data.quotation = joy_quotation_retain({term.value.name})}}"
                     )
                     lines.append(f"{indent_str}joy_stack_push(ctx->stack, {qval});")
                 else:
@@ -230,21 +358,250 @@ class CEmitter:
 
         return "\n".join(lines)
 
+    def _group_native(
+        self, terms: list[CValue]
+    ) -> list[CValue | tuple[str, list[CQuotation]]]:
+        """Replace quotation literals and their combinator with one group."""
+        primitives = primitive_functions()
+        result: list[CValue | tuple[str, list[CQuotation]]] = []
+        for term in terms:
+            count = NATIVE_COMBINATORS.get(term.value) if term.type == "symbol" else None
+            if count is None or term.c_name != primitives.get(term.value):
+                result.append(term)
+                continue
+            args = result[len(result) - count :] if len(result) >= count else []
+            quotations = [
+                arg.value
+                for arg in args
+                if isinstance(arg, CValue)
+                and arg.type == "quotation"
+                and isinstance(arg.value, CQuotation)
+            ]
+            if len(quotations) != count or self._may_recurse(quotations):
+                result.append(term)
+                continue
+            del result[len(result) - count :]
+            result.append((term.value, quotations))
+        return result
+
+    def _may_recurse(self, quotations: list[CQuotation]) -> bool:
+        """
+        Whether running these bodies could call the definition being emitted.
+
+        Inlined bodies call words directly on the C stack, so a recursive
+        word keeps the runtime combinator, whose tail call runs on the
+        engine's heap frames instead.
+        """
+        if self._current is None:
+            return False
+        name = self._current.name
+        for symbol in self._symbols(quotations):
+            if symbol == name or name in self._reaches.get(symbol, ()):
+                return True
+        return False
+
+    def _symbols(self, quotations: list[CQuotation]) -> set[str]:
+        """Every symbol in the quotations, including nested literals."""
+        found: set[str] = set()
+        pending = list(quotations)
+        while pending:
+            for term in pending.pop().terms:
+                if term.type == "symbol":
+                    found.add(term.value)
+                elif term.type == "quotation" and isinstance(term.value, CQuotation):
+                    pending.append(term.value)
+        return found
+
+    def _call_graph(self, program: CProgram) -> dict[str, set[str]]:
+        """Map each defined name to every name its definitions can reach."""
+        direct: dict[str, set[str]] = {}
+        for defn in program.definitions:
+            direct.setdefault(defn.name, set()).update(self._symbols([defn.body]))
+        reaches: dict[str, set[str]] = {}
+        for name in direct:
+            seen: set[str] = set()
+            pending = list(direct[name])
+            while pending:
+                callee = pending.pop()
+                if callee not in seen:
+                    seen.add(callee)
+                    pending.extend(direct.get(callee, ()))
+            reaches[name] = seen
+        return reaches
+
+    def _emit_native(
+        self, name: str, quotations: list[CQuotation], indent_str: str, tail: bool
+    ) -> str:
+        """Emit a combinator over literal quotations as a C block."""
+        n = self._blocks
+        self._blocks += 1
+        inner = indent_str + "    "
+        body = indent_str + "        "
+
+        def run(quotation: CQuotation, at: str, in_tail: bool = False) -> list[str]:
+            code = self._emit_quotation_execution(quotation, at, tail=in_tail)
+            return [code] if code else []
+
+        def test(quotation: CQuotation, var: str, at: str) -> list[str]:
+            # Run a predicate on a checkpoint and keep only its verdict
+            return [
+                f"{at}JoyCheckpoint saved_{n};",
+                f"{at}joy_stack_checkpoint(ctx->stack, &saved_{n});",
+                *run(quotation, at),
+                f"{at}bool {var} = joy_stack_pop_truthy(ctx->stack);",
+                f"{at}joy_stack_restore(ctx->stack, &saved_{n});",
+            ]
+
+        lines = [f"{indent_str}{{ /* {name} */"]
+        if name == "ifte":
+            cond, then, otherwise = quotations
+            lines += test(cond, f"cond_{n}", inner)
+            lines.append(f"{inner}if (cond_{n}) {{")
+            lines += run(then, body, tail)
+            lines.append(f"{inner}}} else {{")
+            lines += run(otherwise, body, tail)
+            lines.append(f"{inner}}}")
+
+        elif name == "branch":
+            then, otherwise = quotations
+            lines.append(f"{inner}if (joy_stack_pop_truthy(ctx->stack)) {{")
+            lines += run(then, body, tail)
+            lines.append(f"{inner}}} else {{")
+            lines += run(otherwise, body, tail)
+            lines.append(f"{inner}}}")
+
+        elif name == "times":
+            lines.append(f"{inner}JoyValue count_{n} = joy_stack_pop(ctx->stack);")
+            lines.append(
+                f"{inner}if (count_{n}.type != JOY_INTEGER) "
+                f'joy_error_type("times", "JOY_INTEGER", count_{n}.type);'
+            )
+            lines.append(
+                f"{inner}for (int64_t i_{n} = 0; i_{n} < count_{n}.data.integer; "
+                f"i_{n}++) {{"
+            )
+            lines += run(quotations[0], body)
+            lines.append(f"{inner}}}")
+
+        elif name == "while":
+            cond, loop = quotations
+            lines.append(f"{inner}for (;;) {{")
+            lines += test(cond, f"cont_{n}", body)
+            lines.append(f"{body}if (!cont_{n}) break;")
+            lines += run(loop, body)
+            lines.append(f"{inner}}}")
+
+        else:
+            # A numeric aggregate may take a kernel instead of the loop
+            vector = self._vector_call(name, quotations[0])
+            if vector:
+                lines.append(f"{inner}if (!{vector}) {{")
+                inner, body = body, body + "    "
+
+            # A lazy sequence is mapped lazily, or stepped by the runtime
+            # word without holding it whole
+            lazy = inner if name in ("step", "map") else None
+            if lazy:
+                qval = (
+                    f"(JoyValue){{.type = JOY_QUOTATION, "
+                    f".data.quotation = joy_quotation_retain({quotations[0].name})}}"
+                )
+                lines.append(f"{inner}if (joy_stack_top_are(ctx->stack, 1, JOY_LAZY)) {{")
+                if name == "map":
+                    lines.append(f"{body}JoyValue seq_{n} = joy_stack_pop(ctx->stack);")
+                    lines.append(
+                        f"{body}joy_stack_push(ctx->stack, joy_lazy_map(seq_{n}, {qval}));"
+                    )
+                else:
+                    lines.append(f"{body}joy_stack_push(ctx->stack, {qval});")
+                    lines.append(f"{body}{primitive_functions()[name]}(ctx);")
+                lines.append(f"{inner}}} else {{")
+                inner, body = body, body + "    "
+
+            # step, map and fold walk an aggregate held for the whole loop
+            if name == "fold":
+                lines.append(f"{inner}JoyValue init_{n} = joy_stack_pop(ctx->stack);")
+            lines.append(f"{inner}JoyValue agg_{n} = joy_stack_pop(ctx->stack);")
+            lines.append(f"{inner}size_t len_{n};")
+            lines.append(
+                f"{inner}JoyValue* items_{n} = "
+                f'joy_aggregate_items(&agg_{n}, &len_{n}, "{name}");'
+            )
+            if name == "fold":
+                lines.append(f"{inner}joy_stack_push(ctx->stack, init_{n});")
+            if name == "map":
+                lines.append(f"{inner}JoyList* result_{n} = joy_list_new(len_{n});")
+            lines.append(f"{inner}for (size_t i_{n} = 0; i_{n} < len_{n}; i_{n}++) {{")
+            lines.append(
+                f"{body}joy_stack_push(ctx->stack, joy_value_copy(items_{n}[i_{n}]));"
+            )
+            lines += run(quotations[0], body)
+            if name == "map":
+                lines.append(
+                    f"{body}joy_list_push(result_{n}, joy_stack_pop(ctx->stack));"
+                )
+            lines.append(f"{inner}}}")
+            lines.append(f"{inner}joy_value_free(&agg_{n});")
+            if name == "map":
+                lines.append(
+                    f"{inner}joy_stack_push(ctx->stack, "
+                    f"(JoyValue){{.type = JOY_LIST, .data.list = result_{n}}});"
+                )
+            if lazy:
+                lines.append(f"{lazy}}}")
+            if vector:
+                lines.append(f"{indent_str}    }}")
+
+        lines.append(f"{indent_str}}}")
+        return "\n".join(lines)
+
+    def _vector_call(self, name: str, quotation: CQuotation) -> str | None:
+        """The kernel call for [op] fold or [N op] map, if the body is one."""
+        terms = quotation.terms
+        if name not in ("map", "fold") or not terms:
+            return None
+        word = terms[-1]
+        if word.type != "symbol" or word.value not in VECTOR_OPS:
+            return None
+        if word.c_name != primitive_functions().get(word.value):
+            return None
+        op = VECTOR_OPS[word.value]
+        if name == "fold":
+            # Only arithmetic folds: a comparison's boolean is not a number
+            if len(terms) != 1 or word.value in ("<", ">", "<=", ">=", "=", "!="):
+                return None
+            return f"joy_vector_fold(ctx, {op})"
+        if len(terms) != 2 or terms[0].type not in ("integer", "float"):
+            return None
+        return f"joy_vector_map(ctx, {op}, {self._emit_value_init(terms[0])})"
+
     def _emit_main(self, program: CProgram) -> str:
         """Emit the main function."""
         has_quotations = bool(program.quotations)
 
         lines = []
         lines.append("int main(int argc, char* argv[]) {")
+        lines.append("    /* One run per input line on worker contexts (joy_batch.c) */")
+        lines.append('    if (argc > 1 && strncmp(argv[1], "--batch", 7) == 0 &&')
+        lines.append("        (argv[1][7] == '\\0' || argv[1][7] == '=')) {")
+        hooks = (
+            "init_quotations, free_quotations" if has_quotations else "NULL, NULL"
+        )
+        lines.append(
+            f"        return joy_batch_main(argc, argv, run_program, {hooks});"
+        )
+        lines.append("    }")
+        lines.append("")
         lines.append("    /* Initialize context */")
         lines.append("    JoyContext* ctx = joy_context_new();")
         lines.append("    joy_runtime_init(ctx);")
-        lines.append("    joy_set_argv(argc, argv);")
+        lines.append("    joy_set_argv(ctx, argc, argv);")
         lines.append("")
 
         if has_quotations:
             lines.append("    /* Initialize quotations */")
             lines.append("    init_quotations();")
+            lines.append("    joy_set_worker_hooks(init_quotations, free_quotations);")
             lines.append("")
 
         # Note: User definitions are registered inline in run_program()
@@ -253,24 +610,58 @@ class CEmitter:
         lines.append("    /* Run program */")
         lines.append("    run_program(ctx);")
         lines.append("")
-        lines.append("    /* Print final stack */")
-        lines.append("    joy_stack_print(ctx->stack);")
+        lines.append("    /* Print final stack unless autoput was turned off */")
+        lines.append("    if (ctx->autoput) joy_stack_print(ctx->stack);")
+        lines.append('    if (getenv("JOY_MEMSTATS")) joy_memory_report();')
         lines.append("")
-        lines.append("    /* Cleanup */")
-        lines.append("    joy_context_free(ctx);")
-
+        # Quotations live in the context's allocator, so free them first
         if has_quotations:
-            lines.append("")
             lines.append("    /* Free quotations */")
-            for quot in program.quotations:
-                lines.append(f"    if ({quot.name}) joy_quotation_free({quot.name});")
+            lines.append("    free_quotations();")
+            lines.append("")
 
+        lines.append("    /* Cleanup */")
+        lines.append("    joy_context_free(ctx);")
         lines.append("")
         lines.append("    return 0;")
         lines.append("}")
 
         return "\n".join(lines)
 
+    def emit_library(self, program: CProgram) -> str:
+        """Emit C code for a program built as a shared library."""
+        return self.emit(program, library=True)
+
+    def _emit_library_entry(self, program: CProgram) -> str:
+        """
+        Emit joy_library_open/close.  Opening runs the program, so its
+        definitions are registered, and returns the context for the host;
+        the quotations belong to the thread that opened it.  Integer
+        overflow raises in a library, so the host can redo the call.
+        """
+        has_quotations = bool(program.quotations)
+
+        lines = []
+        lines.append("JoyContext* joy_library_open(void) {")
+        lines.append("    joy_overflow_checked = true;")
+        lines.append("    JoyContext* ctx = joy_context_new();")
+        lines.append("    joy_runtime_init(ctx);")
+        if has_quotations:
+            lines.append("    init_quotations();")
+            lines.append("    joy_set_worker_hooks(init_quotations, free_quotations);")
+        lines.append("    run_program(ctx);")
+        lines.append("    return ctx;")
+        lines.append("}")
+        lines.append("")
+        lines.append("void joy_library_close(JoyContext* ctx) {")
+        lines.append("    joy_allocator_use(ctx->allocator);")
+        if has_quotations:
+            lines.append("    free_quotations();")
+        lines.append("    joy_context_free(ctx);")
+        lines.append("}")
+
+        return "\n".join(lines)
+
     def emit_to_file(self, program: CProgram, output_path: str | Path) -> None:
         """
         Emit C code to a file.
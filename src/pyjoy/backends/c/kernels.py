@@ -0,0 +1,230 @@
+"""
+pyjoy.backends.c.kernels - Unboxed numeric kernels for user definitions.
+
+Infers the stack effect of a definition body by running it symbolically
+over C locals.  When every term is a number, a stack shuffle, an
+arithmetic or comparison builtin, or a call to another such definition,
+the body becomes straight-line C on int64_t/double variables.  The
+emitter guards each kernel with one type check of its inputs and falls
+back to the boxed body otherwise, so kernels need no REQUIRE or
+EXPECT_TYPE checks of their own.
+"""
+
+from __future__ import annotations
+
+import math
+from dataclasses import dataclass, field
+from typing import TYPE_CHECKING
+
+if TYPE_CHECKING:
+    from .converter import CDefinition, CQuotation
+
+INT64_MIN = -9223372036854775808
+INT64_MAX = 9223372036854775807
+
+# C type and boxing constructor for each kernel value type
+C_TYPES = {"int": "int64_t", "float": "double", "bool": "bool"}
+BOXERS = {"int": "joy_integer", "float": "joy_float", "bool": "joy_boolean"}
+
+# Runtime type tag a kernel's inputs are checked against
+INPUT_TAGS = {"int": "JOY_INTEGER", "float": "JOY_FLOAT"}
+
+# Shuffles as (inputs, outputs): inputs bottom to top, outputs index them
+SHUFFLES: dict[str, tuple[int, tuple[int, ...]]] = {
+    "id": (0, ()),
+    "dup": (1, (0, 0)),
+    "dup2": (2, (0, 1, 0, 1)),
+    "pop": (1, ()),
+    "swap": (2, (1, 0)),
+    "over": (2, (0, 1, 0)),
+    "rollup": (3, (2, 0, 1)),
+    "rolldown": (3, (1, 2, 0)),
+    "rotate": (3, (2, 1, 0)),
+    "dupd": (2, (0, 0, 1)),
+    "swapd": (3, (1, 0, 2)),
+    "popd": (2, (1,)),
+}
+
+# Binary operators that promote to double when either side is a float;
+# on integers they go through the runtime's overflow-checked helpers
+ARITHMETIC = {"+": "+", "-": "-", "*": "*"}
+INT_ARITHMETIC = {"+": "joy_int_add", "-": "joy_int_sub", "*": "joy_int_mul"}
+# Compared as doubles, like the boxed runtime and the optimizer's folding,
+# so integers past 2**53 give the same answer at every optimization level
+COMPARISONS = {"<": "<", ">": ">", "<=": "<=", ">=": ">=", "=": "==", "!=": "!="}
+MATH_FUNCTIONS = {"sqrt", "sin", "cos", "tan", "exp", "log"}
+
+
+class NotNumeric(Exception):
+    """The body leaves the numeric subset; no kernel for this input type."""
+
+
+@dataclass
+class CKernel:
+    """Straight-line C for a definition whose inputs share one numeric type."""
+
+    input_type: str  # "int" or "float"
+    arity: int  # values popped
+    body: list[str] = field(default_factory=list)  # C statements
+    outputs: list[tuple[str, str]] = field(default_factory=list)  # (type, expr), bottom first
+
+    @property
+    def input_tag(self) -> str:
+        return INPUT_TAGS[self.input_type]
+
+
+class _Interpreter:
+    """Runs a body over symbolic (type, C expression) stack entries."""
+
+    def __init__(self, input_type: str, definitions: dict[str, CDefinition]) -> None:
+        self.input_type = input_type
+        self.definitions = definitions
+        self.stack: list[tuple[str, str]] = []
+        self.arity = 0
+        self.body: list[str] = []
+        self.temps = 0
+        self.active: set[str] = set()
+
+    def pop(self) -> tuple[str, str]:
+        if self.stack:
+            return self.stack.pop()
+        # Reaching below the known stack discovers another input
+        value = (self.input_type, f"a{self.arity}")
+        self.arity += 1
+        return value
+
+    def temp(self, type_: str, expr: str) -> tuple[str, str]:
+        name = f"t{self.temps}"
+        self.temps += 1
+        self.body.append(f"{C_TYPES[type_]} {name} = {expr};")
+        return (type_, name)
+
+    def run(self, quotation: CQuotation) -> None:
+        for term in quotation.terms:
+            if term.type == "integer" and INT64_MIN < term.value <= INT64_MAX:
+                self.stack.append(("int", f"INT64_C({term.value})"))
+            elif term.type in ("integer", "float"):
+                self.stack.append(("float", _float_literal(float(term.value))))
+            elif term.type == "boolean":
+                self.stack.append(("bool", "true" if term.value else "false"))
+            elif term.type == "symbol":
+                self.call(term)
+            else:
+                raise NotNumeric(term.type)
+
+    def call(self, term) -> None:
+        name = term.value
+        if name in SHUFFLES:
+            count, order = SHUFFLES[name]
+            args = [self.pop() for _ in range(count)][::-1]
+            self.stack.extend(args[i] for i in order)
+        elif name in ARITHMETIC:
+            b, a = self.numeric(), self.numeric()
+            if a[0] == b[0] == "int":
+                expr = f'{INT_ARITHMETIC[name]}({a[1]}, {b[1]}, "{name}")'
+                self.stack.append(self.temp("int", expr))
+            else:
+                self.stack.append(self.temp("float", f"{a[1]} {ARITHMETIC[name]} {b[1]}"))
+        elif name == "/":
+            b, a = self.numeric(), self.numeric()
+            type_ = "int" if a[0] == b[0] == "int" else "float"
+            zero = "0" if type_ == "int" else "0.0"
+            self.body.append(f'if ({b[1]} == {zero}) joy_error("Division by zero");')
+            if type_ == "int":
+                expr = f'joy_int_div({a[1]}, {b[1]}, "/")'
+            else:
+                expr = f"{a[1]} / {b[1]}"
+            self.stack.append(self.temp(type_, expr))
+        elif name == "rem":
+            b, a = self.integer(), self.integer()
+            self.body.append(f'if ({b[1]} == 0) joy_error("Division by zero");')
+            self.stack.append(self.temp("int", f"joy_int_rem({a[1]}, {b[1]})"))
+        elif name in ("max", "min"):
+            b, a = self.numeric(), self.numeric()
+            type_ = "int" if a[0] == b[0] == "int" else "float"
+            op = ">" if name == "max" else "<"
+            self.stack.append(
+                self.temp(type_, f"{a[1]} {op} {b[1]} ? {a[1]} : {b[1]}")
+            )
+        elif name in COMPARISONS:
+            b, a = self.numeric(), self.numeric()
+            expr = f"(double){a[1]} {COMPARISONS[name]} (double){b[1]}"
+            self.stack.append(self.temp("bool", expr))
+        elif name in ("succ", "pred"):
+            a = self.integer()
+            helper = "joy_int_add" if name == "succ" else "joy_int_sub"
+            self.stack.append(self.temp("int", f'{helper}({a[1]}, 1, "{name}")'))
+        elif name == "neg":
+            a = self.numeric()
+            expr = f'joy_int_sub(0, {a[1]}, "neg")' if a[0] == "int" else f"-{a[1]}"
+            self.stack.append(self.temp(a[0], expr))
+        elif name == "abs":
+            a = self.numeric()
+            if a[0] == "int":
+                expr = f'{a[1]} < 0 ? joy_int_sub(0, {a[1]}, "abs") : {a[1]}'
+            else:
+                expr = f"fabs({a[1]})"
+            self.stack.append(self.temp(a[0], expr))
+        elif name in MATH_FUNCTIONS:
+            a = self.numeric()
+            self.stack.append(self.temp("float", f"{name}((double){a[1]})"))
+        elif term.c_name and term.c_name in self.definitions:
+            # A statically bound user word: inline its body
+            if term.c_name in self.active:
+                raise NotNumeric(name)
+            self.active.add(term.c_name)
+            self.run(self.definitions[term.c_name].body)
+            self.active.discard(term.c_name)
+        else:
+            raise NotNumeric(name)
+
+    def numeric(self) -> tuple[str, str]:
+        value = self.pop()
+        if value[0] not in ("int", "float"):
+            raise NotNumeric(value[0])
+        return value
+
+    def integer(self) -> tuple[str, str]:
+        value = self.pop()
+        if value[0] != "int":
+            raise NotNumeric(value[0])
+        return value
+
+
+def _float_literal(value: float) -> str:
+    if math.isnan(value):
+        return "NAN"
+    if math.isinf(value):
+        return "INFINITY" if value > 0 else "(-INFINITY)"
+    return repr(value) if value >= 0 else f"({value!r})"
+
+
+def infer_kernels(
+    definition: CDefinition, definitions: dict[str, CDefinition]
+) -> list[CKernel]:
+    """
+    Build the unboxed kernels for a definition, at most one per input type.
+
+    definitions maps C function names to the definitions a statically
+    bound call may inline.  A body that takes no inputs gets no kernel:
+    its boxed form already does no type dispatch worth removing.
+    """
+    kernels = []
+    for input_type in ("int", "float"):
+        interp = _Interpreter(input_type, definitions)
+        interp.active.add(definition.c_name)
+        try:
+            interp.run(definition.body)
+        except NotNumeric:
+            continue
+        if interp.arity == 0:
+            break
+        kernels.append(
+            CKernel(
+                input_type=input_type,
+                arity=interp.arity,
+                body=interp.body,
+                outputs=interp.stack,
+            )
+        )
+    return kernels
@@ -0,0 +1,420 @@
+"""
+pyjoy.backends.c.native - Run compiled Joy definitions inside the evaluator.
+
+NativeLibrary compiles definitions, with every definition they reach,
+into a shared library linked with the C runtime and loads it with
+ctypes.  Calling one of its words copies the evaluator's stack into the
+library's context, runs the word there, and copies the stack back, so
+the word runs at C speed while the caller stays in Python.
+
+Accelerator attaches libraries to an Evaluator (Evaluator.accelerate):
+words named up front, or definitions called `hot` times when hot
+detection is on, are compiled and then dispatched natively.  A native
+word falls back to its Python definition once any definition it was
+compiled from changes.
+
+Native words run with the C backend's semantics, except that integers
+stay unbounded: a call that meets an integer past 64 bits, on the stack
+or from its own arithmetic, is run again by the Python definition from
+the same stack.  The whole stack crosses the boundary on every call, so
+they pay off for words that do real work per call.  Their output goes to
+the process's stdout, not to sys.stdout.  A library must be called from
+the thread that loaded it.
+"""
+
+from __future__ import annotations
+
+import ctypes
+import sys
+import tempfile
+import threading
+from collections import Counter
+from pathlib import Path
+from typing import TYPE_CHECKING, Any, Iterable, Mapping
+
+from ...errors import JoyError, JoyTypeError
+from ...parser import Definition
+from ...types import JoyQuotation, JoyType, JoyValue, joy_to_python, python_to_joy
+from .builder import CBuilder
+from .converter import JoyToCConverter, primitive_functions
+from .emitter import CEmitter
+from .optimizer import optimize_program
+
+if TYPE_CHECKING:
+    from ...evaluator import Evaluator
+
+# C JoyType tags, in joy_runtime.h order
+C_INTEGER, C_FLOAT, C_BOOLEAN, C_CHAR, C_STRING = range(5)
+C_LIST, C_SET, C_QUOTATION, C_SYMBOL, C_FILE, C_LAZY = range(5, 11)
+C_TYPE_NAMES = [
+    "INTEGER", "FLOAT", "BOOLEAN", "CHAR", "STRING", "LIST", "SET",
+    "QUOTATION", "SYMBOL", "FILE", "LAZY",
+]
+
+INT64_MIN, INT64_MAX = -(2**63), 2**63 - 1
+
+
+class NativeError(JoyError):
+    """A word could not be compiled, marshalled or run natively."""
+
+
+class NativeOverflow(NativeError):
+    """A call needed an integer that does not fit in 64 bits."""
+
+
+def reachable_definitions(
+    definitions: Mapping[str, JoyQuotation], names: Iterable[str]
+) -> dict[str, JoyQuotation]:
+    """
+    The definitions names need, with every definition those reach.
+
+    Raises:
+        NativeError: If a name is not a definition, or something reached
+            has no C equivalent (a Python-only builtin, an undefined word,
+            Python interop, a file or object literal)
+    """
+    from ...evaluator import get_primitive
+
+    c_builtins = primitive_functions()
+    reached: dict[str, JoyQuotation] = {}
+    pending = []
+    for name in names:
+        if name not in definitions or get_primitive(name) is not None:
+            raise NativeError(f"native: {name} is not a user definition")
+        pending.append(name)
+
+    def visit(term: Any, owner: str) -> None:
+        if isinstance(term, JoyQuotation):
+            for inner in term.terms:
+                visit(inner, owner)
+        elif isinstance(term, JoyValue) and term.type == JoyType.SYMBOL:
+            visit(term.value, owner)
+        elif isinstance(term, JoyValue):
+            if term.type in (JoyType.FILE, JoyType.OBJECT):
+                raise NativeError(
+                    f"native: {owner} holds a {term.type.name} value"
+                )
+            if term.type == JoyType.QUOTATION:
+                visit(term.value, owner)
+            elif term.type == JoyType.LIST:
+                for inner in term.value:
+                    visit(inner, owner)
+        elif isinstance(term, str):
+            if get_primitive(term) is not None:
+                if term not in c_builtins:
+                    raise NativeError(
+                        f"native: {owner} uses {term}, not in the C runtime"
+                    )
+            elif term in definitions:
+                if term not in reached:
+                    pending.append(term)
+            else:
+                raise NativeError(f"native: {owner} uses undefined word {term}")
+        else:
+            raise NativeError(f"native: {owner} uses Python interop")
+
+    while pending:
+        name = pending.pop()
+        if name in reached:
+            continue
+        reached[name] = definitions[name]
+        visit(reached[name], name)
+    return reached
+
+
+class NativeLibrary:
+    """Definitions compiled into a shared library and loaded in-process."""
+
+    def __init__(
+        self,
+        definitions: Mapping[str, JoyQuotation],
+        build_dir: str | Path | None = None,
+        optimize: int = 2,
+    ) -> None:
+        """
+        Compile and load definitions (all of them, as from
+        reachable_definitions).
+
+        Args:
+            definitions: Words to compile, name -> body
+            build_dir: Where to build (default: a temporary directory,
+                removed by close)
+            optimize: Optimization level for the Joy optimizer and the C
+                compiler, as for compile_joy_to_c
+        """
+        self.names = frozenset(definitions)
+        self.thread = threading.get_ident()
+        self._tmpdir = None if build_dir else tempfile.TemporaryDirectory()
+        output = Path(build_dir or self._tmpdir.name)
+        output.mkdir(parents=True, exist_ok=True)
+
+        program = JoyQuotation(
+            tuple(Definition(name, body) for name, body in definitions.items())
+        )
+        c_program = JoyToCConverter().convert(program, roots=definitions)
+        optimize_program(c_program, optimize)
+        c_file = output / "joy_native.c"
+        c_file.write_text(CEmitter().emit_library(c_program))
+
+        builder = CBuilder()
+        self.path = builder.compile_shared(c_file, optimize=optimize)
+        self._lib = ctypes.CDLL(str(self.path))
+        self._bind()
+        self._ctx = self._lib.joy_library_open()
+
+    def _bind(self) -> None:
+        lib = self._lib
+        ctx, size, cstr = ctypes.c_void_p, ctypes.c_size_t, ctypes.c_char_p
+        i64 = ctypes.c_int64
+        signatures = {
+            "joy_library_open": (ctx, []),
+            "joy_library_close": (None, [ctx]),
+            "joy_embed_push_integer": (None, [ctx, i64]),
+            "joy_embed_push_float": (None, [ctx, ctypes.c_double]),
+            "joy_embed_push_boolean": (None, [ctx, ctypes.c_int]),
+            "joy_embed_push_char": (None, [ctx, ctypes.c_int]),
+            "joy_embed_push_string": (None, [ctx, cstr, size]),
+            "joy_embed_push_symbol": (None, [ctx, cstr]),
+            "joy_embed_push_set": (None, [ctx, ctypes.POINTER(i64), size]),
+            "joy_embed_wrap": (None, [ctx, size, ctypes.c_int]),
+            "joy_embed_call": (ctypes.c_bool, [ctx, cstr]),
+            "joy_embed_error": (cstr, []),
+            "joy_embed_overflowed": (ctypes.c_bool, []),
+            "joy_embed_depth": (size, [ctx]),
+            "joy_embed_type": (ctypes.c_int, [ctx]),
+            "joy_embed_drop": (None, [ctx]),
+            "joy_embed_integer": (i64, [ctx]),
+            "joy_embed_float": (ctypes.c_double, [ctx]),
+            "joy_embed_boolean": (ctypes.c_int, [ctx]),
+            "joy_embed_char": (ctypes.c_int, [ctx]),
+            "joy_embed_chars": (cstr, [ctx]),
+            "joy_embed_set": (size, [ctx, ctypes.POINTER(i64), size]),
+            "joy_embed_unwrap": (size, [ctx]),
+        }
+        for name, (restype, argtypes) in signatures.items():
+            fn = getattr(lib, name)
+            fn.restype = restype
+            fn.argtypes = argtypes
+
+    def call(self, name: str, stack: Any, strict: bool = True) -> None:
+        """
+        Run word name on stack (a JoyStack, or a PythonStack if not strict).
+
+        The stack is replaced by the result.  If the word fails, the stack
+        is left as it was and NativeError carries the runtime's message;
+        NativeOverflow if it failed for want of a wider integer.
+        """
+        if threading.get_ident() != self.thread:
+            raise NativeError(f"native: {name} called from another thread")
+        if self._ctx is None:
+            raise NativeError(f"native: {name} called after close")
+        lib, ctx = self._lib, self._ctx
+        try:
+            for item in stack.items():
+                self._push(python_to_joy(item))
+        except JoyError:
+            self._reopen()
+            raise
+
+        sys.stdout.flush()
+        if not lib.joy_embed_call(ctx, name.encode()):
+            message = lib.joy_embed_error().decode(errors="replace")
+            overflowed = lib.joy_embed_overflowed()
+            self._reopen()
+            raise (NativeOverflow if overflowed else NativeError)(message)
+
+        try:
+            results = [self._pop() for _ in range(lib.joy_embed_depth(ctx))]
+        except JoyError:
+            self._reopen()
+            raise
+        stack.clear()
+        for value in reversed(results):
+            if strict:
+                stack.push_value(value)
+            else:
+                stack.push(joy_to_python(value))
+
+    def close(self) -> None:
+        """Free the library's context; its words can no longer be called."""
+        if self._ctx is not None:
+            self._lib.joy_library_close(self._ctx)
+            self._ctx = None
+        if self._tmpdir is not None:
+            self._tmpdir.cleanup()
+            self._tmpdir = None
+
+    def _reopen(self) -> None:
+        """Start over with a fresh context after a failure mid-call."""
+        self._lib.joy_library_close(self._ctx)
+        self._ctx = self._lib.joy_library_open()
+
+    # ---------- Marshalling ----------
+
+    def _push(self, value: JoyValue) -> None:
+        lib, ctx, t = self._lib, self._ctx, value.type
+        if t == JoyType.INTEGER:
+            if not INT64_MIN <= value.value <= INT64_MAX:
+                raise NativeOverflow(f"native: {value.value} does not fit in 64 bits")
+            lib.joy_embed_push_integer(ctx, value.value)
+        elif t == JoyType.FLOAT:
+            lib.joy_embed_push_float(ctx, value.value)
+        elif t == JoyType.BOOLEAN:
+            lib.joy_embed_push_boolean(ctx, value.value)
+        elif t == JoyType.CHAR:
+            if ord(value.value) > 255:
+                raise NativeError(f"native: char {value.value!r} is not a byte")
+            lib.joy_embed_push_char(ctx, ord(value.value))
+        elif t == JoyType.STRING:
+            data = value.value.encode(errors="surrogateescape")
+            lib.joy_embed_push_string(ctx, data, len(data))
+        elif t == JoyType.SYMBOL:
+            lib.joy_embed_push_symbol(ctx, value.value.encode())
+        elif t == JoyType.SET:
+            members = sorted(value.value)
+            array = (ctypes.c_int64 * len(members))(*members)
+            lib.joy_embed_push_set(ctx, array, len(members))
+        elif t == JoyType.LIST:
+            for item in value.value:
+                self._push(python_to_joy(item))
+            lib.joy_embed_wrap(ctx, len(value.value), 0)
+        elif t == JoyType.QUOTATION:
+            self._push_quotation(value.value)
+        else:
+            raise JoyTypeError("native", "value C can hold", t.name)
+
+    def _push_quotation(self, quotation: JoyQuotation) -> None:
+        for term in quotation.terms:
+            if isinstance(term, str):
+                self._lib.joy_embed_push_symbol(self._ctx, term.encode())
+            elif isinstance(term, JoyQuotation):
+                self._push_quotation(term)
+            elif isinstance(term, JoyValue):
+                self._push(term)
+            else:
+                raise NativeError("native: quotation holds Python interop")
+        self._lib.joy_embed_wrap(self._ctx, len(quotation.terms), 1)
+
+    def _pop(self) -> JoyValue:
+        """Take the top value off the library's stack."""
+        lib, ctx = self._lib, self._ctx
+        t = lib.joy_embed_type(ctx)
+        if t == C_LIST:
+            items = [self._pop() for _ in range(lib.joy_embed_unwrap(ctx))]
+            return JoyValue.list(tuple(reversed(items)))
+        if t == C_QUOTATION:
+            return JoyValue.quotation(self._pop_quotation())
+        if t == C_INTEGER:
+            value = JoyValue.integer(lib.joy_embed_integer(ctx))
+        elif t == C_FLOAT:
+            value = JoyValue.floating(lib.joy_embed_float(ctx))
+        elif t == C_BOOLEAN:
+            value = JoyValue.boolean(bool(lib.joy_embed_boolean(ctx)))
+        elif t == C_CHAR:
+            value = JoyValue.char(chr(lib.joy_embed_char(ctx)))
+        elif t == C_STRING:
+            chars = lib.joy_embed_chars(ctx)
+            value = JoyValue.string(chars.decode(errors="surrogateescape"))
+        elif t == C_SYMBOL:
+            value = JoyValue.symbol(lib.joy_embed_chars(ctx).decode())
+        elif t == C_SET:
+            count = lib.joy_embed_set(ctx, None, 0)
+            array = (ctypes.c_int64 * count)()
+            lib.joy_embed_set(ctx, array, count)
+            value = JoyValue(JoyType.SET, frozenset(array))
+        else:
+            raise NativeError(
+                f"native: a {C_TYPE_NAMES[t]} cannot return to Python"
+            )
+        lib.joy_embed_drop(ctx)
+        return value
+
+    def _pop_quotation(self) -> JoyQuotation:
+        terms = []
+        for _ in range(self._lib.joy_embed_unwrap(self._ctx)):
+            t = self._lib.joy_embed_type(self._ctx)
+            if t == C_SYMBOL:
+                terms.append(self._lib.joy_embed_chars(self._ctx).decode())
+                self._lib.joy_embed_drop(self._ctx)
+            elif t == C_QUOTATION:
+                terms.append(self._pop_quotation())
+            else:
+                terms.append(self._pop())
+        return JoyQuotation(tuple(reversed(terms)))
+
+
+class NativeWord:
+    """A definition dispatched to a NativeLibrary while its sources hold."""
+
+    def __init__(
+        self,
+        accelerator: Accelerator,
+        library: NativeLibrary,
+        name: str,
+        sources: Mapping[str, JoyQuotation],
+    ) -> None:
+        self.accelerator = accelerator
+        self.library = library
+        self.name = name
+        self.sources = dict(sources)
+        self.epoch = accelerator.evaluator.definitions.epoch
+
+    def __call__(self) -> None:
+        evaluator = self.accelerator.evaluator
+        definitions = evaluator.definitions
+        if definitions.epoch is not self.epoch:
+            sources = self.sources.items()
+            if any(definitions.get(n) is not body for n, body in sources):
+                # Recompiled from Python now, as before acceleration
+                evaluator.native.pop(self.name, None)
+                evaluator._execute_symbol(self.name)
+                return
+            self.epoch = definitions.epoch
+        try:
+            self.library.call(self.name, evaluator.ctx.stack, evaluator.strict)
+        except NativeOverflow:
+            # The stack is as it was; Python's integers do not overflow
+            evaluator.execute(definitions[self.name])
+
+
+class Accelerator:
+    """Compiles an Evaluator's definitions to native words (see module doc)."""
+
+    def __init__(
+        self, evaluator: Evaluator, hot: int | None = None, optimize: int = 2
+    ) -> None:
+        self.evaluator = evaluator
+        self.hot = hot
+        self.optimize = optimize
+        self.calls: Counter[str] = Counter()
+        self.rejected: dict[str, str] = {}  # name -> why it stays in Python
+        self.libraries: list[NativeLibrary] = []
+
+    def compile(self, names: Iterable[str]) -> NativeLibrary:
+        """Compile names into one library and dispatch them natively."""
+        names = list(names)
+        sources = reachable_definitions(self.evaluator.definitions, names)
+        library = NativeLibrary(sources, optimize=self.optimize)
+        self.libraries.append(library)
+        for name in names:
+            self.evaluator.native[name] = NativeWord(self, library, name, sources)
+        # Quotations compiled before now bound the Python definitions
+        self.evaluator.definitions.touch()
+        return library
+
+    def called(self, name: str) -> None:
+        """Count a call of a Python definition, compiling it once it is hot."""
+        self.calls[name] += 1
+        if self.calls[name] == self.hot and name not in self.rejected:
+            try:
+                self.compile([name])
+            except NativeError as e:
+                self.rejected[name] = str(e)
+
+    def close(self) -> None:
+        """Drop every native word and free the libraries."""
+        self.evaluator.native.clear()
+        self.evaluator.definitions.touch()
+        for library in self.libraries:
+            library.close()
+        self.libraries.clear()
@@ -0,0 +1,303 @@
+"""
+pyjoy.backends.c.optimizer - Peephole optimizer for converted programs.
+
+Rewrites the term lists of a CProgram's main body and definition bodies
+between JoyToCConverter.convert and CEmitter.emit:
+
+- level 1 folds literal arithmetic and comparisons, drops no-op
+  sequences (swap swap, dup pop, [] concat) and fuses common pairs
+  into superinstructions (dup *, swap cons, 0 =, 1 -, 1 +);
+- level 2 also inlines small non-recursive user definitions first, so
+  the other rewrites see through them, then drops the definitions no
+  longer called anywhere (eliminate_dead_definitions).
+
+Only symbols the converter bound statically (term.c_name) are touched:
+a late-bound word may be redefined, so its meaning is not known here.
+Quotation literals are data until executed and are left alone.
+"""
+
+from __future__ import annotations
+
+import math
+from dataclasses import replace
+
+from .converter import (
+    CDefinition,
+    CProgram,
+    CQuotation,
+    CValue,
+    eliminate_dead_definitions,
+    primitive_functions,
+)
+
+INT64_MIN = -9223372036854775808
+INT64_MAX = 9223372036854775807
+
+# Largest definition body inlined at a call site, in terms
+INLINE_LIMIT = 8
+
+LITERAL_TYPES = ("integer", "float", "boolean", "char", "string")
+
+# Shuffles as (inputs, outputs): inputs bottom to top, outputs index them
+SHUFFLES: dict[str, tuple[int, tuple[int, ...]]] = {
+    "id": (0, ()),
+    "dup": (1, (0, 0)),
+    "pop": (1, ()),
+    "swap": (2, (1, 0)),
+    "over": (2, (0, 1, 0)),
+    "dupd": (2, (0, 0, 1)),
+    "popd": (2, (1,)),
+    "rollup": (3, (2, 0, 1)),
+    "rolldown": (3, (1, 2, 0)),
+    "rotate": (3, (2, 1, 0)),
+}
+
+# Adjacent builtins that together do nothing
+NO_OPS = {("swap", "swap"), ("dup", "pop")}
+
+# Superinstructions: a literal (or None) and a word, or two words
+FUSED: dict[tuple[object, str], tuple[str, str]] = {
+    ("dup", "*"): ("dup *", "prim_dup_mul"),
+    ("swap", "cons"): ("swons", "prim_swons"),
+    (0, "="): ("0 =", "prim_eq_zero"),
+    (1, "-"): ("1 -", "prim_dec"),
+    (1, "+"): ("1 +", "prim_inc"),
+}
+
+
+def optimize_program(program: CProgram, level: int = 2) -> CProgram:
+    """Optimize a program's executable term lists in place and return it."""
+    if level <= 0:
+        return program
+
+    # Define terms share their definition's body, so they see the rewrite
+    optimizer = _Optimizer(program, level)
+    for definition in program.definitions:
+        optimizer.optimize(definition.body)
+    if program.main_body:
+        optimizer.optimize(program.main_body)
+    if level >= 2:
+        eliminate_dead_definitions(program)
+    return program
+
+
+class _Optimizer:
+    def __init__(self, program: CProgram, level: int) -> None:
+        self.level = level
+        self.primitives = primitive_functions()
+        self.definitions: dict[str, CDefinition] = {
+            d.c_name: d for d in program.definitions
+        }
+        # Bodies as converted: inlining expands these, not the fused forms
+        self.bodies = {d.c_name: list(d.body.terms) for d in program.definitions}
+        # Inlined form of each definition body, or None if it stays a call
+        self.expansions: dict[str, list[CValue] | None] = {}
+
+    def optimize(self, quotation: CQuotation) -> None:
+        terms = quotation.terms
+        if self.level >= 2:
+            terms = self._inline(terms)
+        while True:
+            rewritten = self._fuse(self._peephole(terms))
+            if rewritten == terms:
+                break
+            terms = rewritten
+        quotation.terms = terms
+
+    def _builtin(self, term: CValue) -> str | None:
+        """The name of a statically bound builtin, or None."""
+        if term.type != "symbol" or not term.c_name:
+            return None
+        if self.primitives.get(term.value) != term.c_name:
+            return None
+        return term.value
+
+    def _inline(self, terms: list[CValue]) -> list[CValue]:
+        result: list[CValue] = []
+        for term in terms:
+            expansion = None
+            if term.type == "symbol" and term.c_name in self.definitions:
+                expansion = self._expand(term.c_name)
+            if expansion is None:
+                result.append(term)
+            else:
+                result.extend(replace(t) for t in expansion)
+        return result
+
+    def _expand(self, c_name: str) -> list[CValue] | None:
+        """A definition's fully inlined body if it is small enough."""
+        if c_name not in self.expansions:
+            # Recursion reaches this entry while it is still None
+            self.expansions[c_name] = None
+            body = self._inline(self.bodies[c_name])
+            if len(body) <= INLINE_LIMIT and not self._calls(body, c_name):
+                self.expansions[c_name] = body
+        return self.expansions[c_name]
+
+    def _calls(self, terms: list[CValue], c_name: str) -> bool:
+        return any(t.type == "symbol" and t.c_name == c_name for t in terms)
+
+    def _peephole(self, terms: list[CValue]) -> list[CValue]:
+        """Fold literals and drop no-ops, treating the output as a stack."""
+        result: list[CValue] = []
+        for term in terms:
+            name = self._builtin(term)
+            if name is None:
+                result.append(term)
+                continue
+
+            previous = self._builtin(result[-1]) if result else None
+            if (previous, name) in NO_OPS:
+                result.pop()
+                continue
+            if name == "concat" and result and _is_empty_quotation(result[-1]):
+                result.pop()
+                continue
+
+            folded = self._fold(name, result)
+            if folded is None:
+                result.append(term)
+            else:
+                count, values = folded
+                del result[len(result) - count :]
+                result.extend(values)
+        return result
+
+    def _fold(self, name: str, result: list[CValue]) -> tuple[int, list[CValue]] | None:
+        """Evaluate name over trailing literals: (terms consumed, terms produced)."""
+        literals = 0
+        while literals < len(result) and result[-1 - literals].type in LITERAL_TYPES:
+            literals += 1
+
+        if name in SHUFFLES:
+            count, order = SHUFFLES[name]
+            if literals < count:
+                return None
+            args = result[len(result) - count :]
+            return count, [replace(args[i]) for i in order]
+
+        if name in UNARY and literals >= 1:
+            value = UNARY[name](result[-1])
+            return None if value is None else (1, [value])
+
+        if name in BINARY and literals >= 2:
+            value = BINARY[name](result[-2], result[-1])
+            return None if value is None else (2, [value])
+
+        return None
+
+    def _fuse(self, terms: list[CValue]) -> list[CValue]:
+        result: list[CValue] = []
+        for term in terms:
+            name = self._builtin(term)
+            if name is not None and result:
+                previous = result[-1]
+                key = previous.value if previous.type == "integer" else self._builtin(previous)
+                if (key, name) in FUSED:
+                    value, c_name = FUSED[(key, name)]
+                    result[-1] = CValue(type="symbol", value=value, c_name=c_name)
+                    continue
+            result.append(term)
+        return result
+
+
+def _is_empty_quotation(term: CValue) -> bool:
+    return (
+        term.type == "quotation"
+        and isinstance(term.value, CQuotation)
+        and not term.value.terms
+    )
+
+
+def _number(term: CValue) -> int | float | None:
+    if term.type in ("integer", "float"):
+        return term.value
+    return None
+
+
+def _literal(value: int | float | bool) -> CValue | None:
+    """A literal term for a folded result, or None if C would not agree."""
+    if isinstance(value, bool):
+        return CValue(type="boolean", value=value)
+    if isinstance(value, int):
+        if not INT64_MIN <= value <= INT64_MAX:
+            return None
+        return CValue(type="integer", value=value)
+    if math.isnan(value) or math.isinf(value):
+        return None
+    return CValue(type="float", value=value)
+
+
+def _arithmetic(op):
+    """Fold a binary numeric op; ints stay ints, any float makes a float."""
+
+    def fold(a: CValue, b: CValue) -> CValue | None:
+        x, y = _number(a), _number(b)
+        if x is None or y is None:
+            return None
+        if a.type == "float" or b.type == "float":
+            x, y = float(x), float(y)
+        result = op(x, y)
+        return None if result is None else _literal(result)
+
+    return fold
+
+
+def _comparison(op):
+    """Fold a numeric comparison; the runtime compares as doubles."""
+
+    def fold(a: CValue, b: CValue) -> CValue | None:
+        x, y = _number(a), _number(b)
+        if x is None or y is None:
+            return None
+        return _literal(op(float(x), float(y)))
+
+    return fold
+
+
+def _divide(x, y):
+    if y == 0:
+        return None
+    if isinstance(x, float):
+        return x / y
+    quotient = abs(x) // abs(y)
+    return quotient if (x < 0) == (y < 0) else -quotient
+
+
+def _remainder(x, y):
+    if isinstance(x, float) or y == 0:
+        return None
+    return x - y * _divide(x, y)
+
+
+def _unary(op, types: tuple[str, ...] = ("integer", "float")):
+    def fold(a: CValue) -> CValue | None:
+        if a.type not in types:
+            return None
+        return _literal(op(a.value))
+
+    return fold
+
+
+BINARY = {
+    "+": _arithmetic(lambda x, y: x + y),
+    "-": _arithmetic(lambda x, y: x - y),
+    "*": _arithmetic(lambda x, y: x * y),
+    "/": _arithmetic(_divide),
+    "rem": _arithmetic(_remainder),
+    "max": _arithmetic(lambda x, y: x if x > y else y),
+    "min": _arithmetic(lambda x, y: x if x < y else y),
+    "<": _comparison(lambda x, y: x < y),
+    ">": _comparison(lambda x, y: x > y),
+    "<=": _comparison(lambda x, y: x <= y),
+    ">=": _comparison(lambda x, y: x >= y),
+    "=": _comparison(lambda x, y: x == y),
+    "!=": _comparison(lambda x, y: x != y),
+}
+
+UNARY = {
+    "neg": _unary(lambda x: -x),
+    "abs": _unary(abs),
+    "succ": _unary(lambda x: x + 1, ("integer",)),
+    "pred": _unary(lambda x: x - 1, ("integer",)),
+}
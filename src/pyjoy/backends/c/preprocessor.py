@@ -14,7 +14,7 @@ from pathlib import Path
 from typing import Any, List, Set
 
 from ...errors import JoySyntaxError
-from ...parser import Definition, Parser, ParseResult
+from ...parser import Definition, Parser, ParseResult, parse_file
 from ...types import JoyQuotation, JoyType, JoyValue
 
 
@@ -189,9 +189,7 @@ class IncludePreprocessor:
 
         try:
             # Read and parse the included file
-            source = include_path.read_text()
-            parser = Parser()
-            result = parser.parse_full(source)
+            result = parse_file(include_path)
 
             # Recursively process includes in the included file
             new_base = include_path.parent
@@ -235,9 +233,7 @@ class IncludePreprocessor:
 
         try:
             # Read and parse the included file
-            source = include_path.read_text()
-            parser = Parser()
-            result = parser.parse_full(source)
+            result = parse_file(include_path)
 
             # Return definitions from the included file
             # Nested includes are handled when definitions are processed
@@ -0,0 +1,255 @@
+/**
+ * joy_batch.c - Running a compiled program once per input record
+ *
+ * A generated main given `--batch[=N] [FILE [ARGS...]]` reads FILE, or
+ * stdin when it is absent or "-", and runs the program once for every
+ * line, with the line (less its newline) pushed as a string.  N worker
+ * threads (default: joy_parallel_threads) each keep one context and the
+ * program's quotation globals for the whole batch, and ready the context
+ * with joy_context_reset between records, so a record costs a run and
+ * not a process.  The program sees ARGS through argc/argv.
+ *
+ * Each run's output, with its final stack under autoput, is captured and
+ * written to stdout in input order as soon as every earlier record's has
+ * been, so a client feeding a pipe one line at a time gets its answers
+ * back as they are ready.  A record whose run fails reports
+ * "record N: message" on stderr, its context is replaced, and the batch
+ * carries on; the exit status is 1 if any record failed.  quit ends just
+ * the record it runs in.
+ */
+
+/* Enable POSIX functions like open_memstream and getline */
+#define _POSIX_C_SOURCE 200809L
+
+#include "joy_runtime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define JOY_BATCH_MAX_THREADS 64
+
+/* Records read but not yet written, per worker */
+#define JOY_BATCH_SLOTS_PER_THREAD 4
+
+typedef struct {
+    char* record;       /* owned until a worker takes it */
+    size_t length;
+    char* output;       /* captured by the worker that ran it */
+    size_t output_length;
+    bool done;
+    bool failed;
+    char message[256];
+} JoyBatchSlot;
+
+typedef struct {
+    void (*run)(JoyContext* ctx);
+    void (*init)(void);
+    void (*fini)(void);
+    int argc;
+    char** argv;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;    /* a record was queued, or the input ended */
+    pthread_cond_t space;   /* a slot was written out */
+    JoyBatchSlot* slots;    /* ring; record i lives in slots[i % capacity] */
+    size_t capacity;
+    size_t queued;          /* records read */
+    size_t taken;           /* records claimed by a worker */
+    size_t written;         /* records whose output went out */
+    bool finished;          /* no more records are coming */
+    bool failed;            /* some record failed */
+} JoyBatch;
+
+static JoyContext* joy_batch_context(JoyBatch* batch) {
+    JoyContext* ctx = joy_context_new();
+    joy_runtime_init(ctx);
+    joy_set_argv(ctx, batch->argc, batch->argv);
+    if (batch->init) batch->init();
+    return ctx;
+}
+
+static void joy_batch_context_free(JoyBatch* batch, JoyContext* ctx) {
+    /* Quotations live in the context's allocator, so free them first */
+    joy_allocator_use(ctx->allocator);
+    if (batch->fini) batch->fini();
+    joy_context_free(ctx);
+}
+
+/* Run one record on ctx, capturing its output into slot.  Returns false
+ * if the run ended by longjmp, after which ctx must be replaced.  The
+ * trap is set before anything that can raise, the reset and the record's
+ * own string included, so a record over the memory limit fails as just
+ * that record. */
+static bool joy_batch_run(JoyBatch* batch, JoyContext* ctx, JoyBatchSlot* slot,
+                          char* record, size_t length) {
+    FILE* volatile capture = NULL;
+    JoyErrorTrap trap;
+    JoyErrorTrap* outer = joy_error_trap_set(&trap);
+    bool completed = true;
+    if (setjmp(trap.env) == 0) {
+        capture = open_memstream(&slot->output, &slot->output_length);
+        if (!capture) joy_error("Cannot capture batch output");
+        joy_context_reset(ctx);
+        joy_output_redirect(ctx->output, capture);
+        joy_stack_push(ctx->stack, joy_string_span(record, length));
+        batch->run(ctx);
+        if (ctx->autoput) joy_stack_print(ctx->stack);
+        joy_error_trap_set(outer);
+    } else {
+        joy_error_trap_set(outer);
+        completed = false;
+        slot->failed = trap.status != 0;
+        if (slot->failed) {
+            snprintf(slot->message, sizeof slot->message, "%s", trap.message);
+        }
+    }
+
+    free(record);
+    joy_output_redirect(ctx->output, stdout);
+    if (capture) fclose(capture);
+    return completed;
+}
+
+/* Write out every finished record that is next in line.  Called with
+ * the lock held. */
+static void joy_batch_drain(JoyBatch* batch) {
+    bool wrote = false;
+    while (batch->written < batch->queued) {
+        JoyBatchSlot* slot = &batch->slots[batch->written % batch->capacity];
+        if (!slot->done) break;
+        fwrite(slot->output, 1, slot->output_length, stdout);
+        if (slot->failed) {
+            fflush(stdout);
+            fprintf(stderr, "record %zu: %s\n", batch->written + 1, slot->message);
+            batch->failed = true;
+        }
+        free(slot->output);
+        memset(slot, 0, sizeof *slot);
+        batch->written++;
+        wrote = true;
+    }
+    if (wrote) {
+        fflush(stdout);
+        pthread_cond_broadcast(&batch->space);
+    }
+}
+
+static void* joy_batch_worker(void* arg) {
+    JoyBatch* batch = arg;
+    joy_parallel_serial();
+    JoyContext* ctx = joy_batch_context(batch);
+
+    pthread_mutex_lock(&batch->lock);
+    for (;;) {
+        while (batch->taken == batch->queued && !batch->finished) {
+            pthread_cond_wait(&batch->work, &batch->lock);
+        }
+        if (batch->taken == batch->queued) break;
+        JoyBatchSlot* slot = &batch->slots[batch->taken++ % batch->capacity];
+        char* record = slot->record;
+        size_t length = slot->length;
+        slot->record = NULL;
+        pthread_mutex_unlock(&batch->lock);
+
+        if (!joy_batch_run(batch, ctx, slot, record, length)) {
+            joy_batch_context_free(batch, ctx);
+            ctx = joy_batch_context(batch);
+        }
+
+        pthread_mutex_lock(&batch->lock);
+        slot->done = true;
+        joy_batch_drain(batch);
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    joy_batch_context_free(batch, ctx);
+    return NULL;
+}
+
+int joy_batch_main(int argc, char** argv, void (*run)(JoyContext* ctx),
+                   void (*init)(void), void (*fini)(void)) {
+    size_t threads = joy_parallel_threads();
+    const char* jobs = strchr(argv[1], '=');
+    if (jobs) {
+        long count = strtol(jobs + 1, NULL, 10);
+        threads = count < 1 ? 1 : (size_t)count;
+    }
+    if (threads > JOY_BATCH_MAX_THREADS) threads = JOY_BATCH_MAX_THREADS;
+
+    FILE* input = stdin;
+    if (argc > 2 && strcmp(argv[2], "-") != 0) {
+        input = fopen(argv[2], "r");
+        if (!input) {
+            perror(argv[2]);
+            return 1;
+        }
+    }
+
+    /* The program sees its own name and whatever follows FILE */
+    int rest = argc > 3 ? argc - 3 : 0;
+    char** program_argv = malloc((size_t)(rest + 1) * sizeof(char*));
+    if (!program_argv) joy_error("Out of memory");
+    program_argv[0] = argv[0];
+    for (int i = 0; i < rest; i++) program_argv[i + 1] = argv[i + 3];
+
+    JoyBatch batch = {
+        .run = run,
+        .init = init,
+        .fini = fini,
+        .argc = rest + 1,
+        .argv = program_argv,
+        .capacity = threads * JOY_BATCH_SLOTS_PER_THREAD,
+    };
+    pthread_mutex_init(&batch.lock, NULL);
+    pthread_cond_init(&batch.work, NULL);
+    pthread_cond_init(&batch.space, NULL);
+    batch.slots = calloc(batch.capacity, sizeof(JoyBatchSlot));
+    if (!batch.slots) joy_error("Out of memory");
+    if (init || fini) joy_set_worker_hooks(init, fini);
+
+    pthread_t workers[JOY_BATCH_MAX_THREADS];
+    size_t started = 0;
+    while (started < threads &&
+           pthread_create(&workers[started], NULL, joy_batch_worker, &batch) == 0) {
+        started++;
+    }
+    if (started == 0) joy_error("Cannot start batch workers");
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &line_capacity, input)) >= 0) {
+        if (length > 0 && line[length - 1] == '\n') length--;
+        char* record = malloc((size_t)length + 1);
+        if (!record) joy_error("Out of memory");
+        memcpy(record, line, (size_t)length);
+        record[length] = '\0';
+
+        pthread_mutex_lock(&batch.lock);
+        while (batch.queued - batch.written == batch.capacity) {
+            pthread_cond_wait(&batch.space, &batch.lock);
+        }
+        JoyBatchSlot* slot = &batch.slots[batch.queued % batch.capacity];
+        slot->record = record;
+        slot->length = (size_t)length;
+        batch.queued++;
+        pthread_cond_signal(&batch.work);
+        pthread_mutex_unlock(&batch.lock);
+    }
+    free(line);
+    if (input != stdin) fclose(input);
+
+    pthread_mutex_lock(&batch.lock);
+    batch.finished = true;
+    pthread_cond_broadcast(&batch.work);
+    pthread_mutex_unlock(&batch.lock);
+    for (size_t i = 0; i < started; i++) pthread_join(workers[i], NULL);
+
+    free(batch.slots);
+    free(program_argv);
+    pthread_cond_destroy(&batch.space);
+    pthread_cond_destroy(&batch.work);
+    pthread_mutex_destroy(&batch.lock);
+    return batch.failed ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * joy_builtins.h - Perfect hash over JOY_PRIMITIVE_TABLE
+ *
+ * Generated by scripts/gen_builtins.py; do not edit.  A builtin's slot
+ * is joy_builtin_mix(hash ^ seed[hash & (BUCKETS - 1)]) & (SLOTS - 1),
+ * where hash is the low 32 bits of its symbol hash.  joy_builtin_slots
+ * holds the word's position in JOY_PRIMITIVE_TABLE, or -1.
+ */
+
+#ifndef JOY_BUILTINS_H
+#define JOY_BUILTINS_H
+
+#include <stdint.h>
+
+#define JOY_BUILTIN_COUNT 227
+#define JOY_BUILTIN_SLOTS 256
+#define JOY_BUILTIN_BUCKETS 64
+
+static inline uint32_t joy_builtin_mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+static const uint16_t joy_builtin_seeds[JOY_BUILTIN_BUCKETS] = {
+    18, 7, 17, 2, 52, 98, 16, 10, 0, 3, 0, 33,
+    40, 81, 6, 13, 0, 6, 28, 1, 1, 0, 0, 1,
+    10, 2, 5, 0, 0, 50, 0, 0, 0, 15, 0, 3,
+    13, 0, 25, 18, 2, 30, 1, 50, 12, 0, 28, 17,
+    9, 2, 1, 0, 3, 2, 18, 0, 23, 0, 52, 42,
+    12, 0, 0, 160,
+};
+
+static const int16_t joy_builtin_slots[JOY_BUILTIN_SLOTS] = {
+    190, 157, 163, 164, 167, 147, 35, 216, 52, -1, 140, 180, 6, 20, 74, 78,
+    -1, 106, 59, 25, 122, 86, 222, 50, 131, 221, 75, 9, 56, 72, 89, 146,
+    10, -1, 139, 169, 103, 81, 40, -1, 220, 116, 137, 125, 184, 1, 206, 210,
+    187, 61, 168, 15, -1, 44, 154, 120, -1, 173, -1, 159, 14, 204, -1, 30,
+    108, 136, 149, -1, 214, 28, -1, 68, 189, -1, 166, 201, 60, 141, 185, 203,
+    46, -1, 111, -1, 37, -1, 208, 126, 192, 47, 94, 226, 207, -1, 114, 156,
+    193, 181, 130, -1, 8, 24, 218, 13, 199, 80, 162, 179, 148, 142, 134, 51,
+    135, 32, 88, 45, 225, 12, 48, 92, 16, 153, 132, 155, 224, 63, 219, 39,
+    107, 151, 41, -1, 223, 177, 65, 83, 73, 17, -1, 36, 67, 165, 42, 58,
+    118, 21, 100, 145, -1, 7, 150, 11, 133, 105, 96, 29, 197, 209, 127, 99,
+    4, 175, 160, 2, 79, 117, 53, 144, -1, 91, 62, -1, 87, 0, 174, 84,
+    -1, 182, 200, 109, 178, 69, 213, 85, 64, 55, 143, -1, -1, 198, 217, 27,
+    123, 158, -1, 22, 194, 138, 195, 176, 54, -1, 31, 202, 172, 170, 3, 128,
+    152, -1, 90, 119, 95, 33, 5, 196, 38, 112, 171, 76, 93, 211, 43, 115,
+    71, 124, 70, 104, 102, 98, 49, -1, 19, 77, 121, 215, 97, 113, 18, 23,
+    188, 110, 191, 212, 129, -1, 57, 34, 205, 66, 161, 82, 101, 186, 183, 26,
+};
+
+#endif /* JOY_BUILTINS_H */
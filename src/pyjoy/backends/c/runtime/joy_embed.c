@@ -0,0 +1,187 @@
+/**
+ * joy_embed.c - Calling compiled Joy from a host process
+ *
+ * A Joy program built as a shared library (CBuilder.compile_shared)
+ * exports joy_library_open/close; a host such as the Python evaluator
+ * (pyjoy.backends.c.native) opens a context with it and drives that
+ * context through these functions.  Values cross one at a time: the host
+ * pushes scalars and wraps the top n values into a list or quotation,
+ * then reads results back by type, unwrapping aggregates onto the stack
+ * to read their elements.  The host owns the order; nothing here
+ * allocates anything it must free.
+ *
+ * joy_embed_call traps runtime errors instead of exiting: it returns
+ * false and leaves the message in joy_embed_error.  The context's stack
+ * and engine state are then undefined, so the host discards the context.
+ * A library's integer arithmetic raises on overflow instead of wrapping
+ * (joy_overflow_checked), and joy_embed_overflowed tells the host when
+ * that was the failure, so it can rerun the word with its own integers.
+ * Every entry point makes the context's allocator and output active on
+ * the calling thread.
+ */
+
+#include "joy_runtime.h"
+#include <stdio.h>
+#include <string.h>
+
+static _Thread_local char joy_embed_message[256];
+static _Thread_local bool joy_embed_overflow;
+
+static void joy_embed_enter(JoyContext* ctx) {
+    joy_allocator_use(ctx->allocator);
+    joy_output_use(ctx->output);
+}
+
+/* ---------- Pushing ---------- */
+
+void joy_embed_push_integer(JoyContext* ctx, int64_t value) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_integer(value));
+}
+
+void joy_embed_push_float(JoyContext* ctx, double value) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_float(value));
+}
+
+void joy_embed_push_boolean(JoyContext* ctx, int value) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_boolean(value != 0));
+}
+
+void joy_embed_push_char(JoyContext* ctx, int value) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_char((char)value));
+}
+
+void joy_embed_push_string(JoyContext* ctx, const char* chars, size_t length) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_string_span(chars, length));
+}
+
+void joy_embed_push_symbol(JoyContext* ctx, const char* name) {
+    joy_embed_enter(ctx);
+    joy_stack_push(ctx->stack, joy_symbol(name));
+}
+
+void joy_embed_push_set(JoyContext* ctx, const int64_t* members, size_t count) {
+    joy_embed_enter(ctx);
+    JoyValue set = joy_set_empty();
+    for (size_t i = 0; i < count; i++) {
+        JoyValue next = joy_set_insert(&set, members[i]);
+        joy_value_free(&set);
+        set = next;
+    }
+    joy_stack_push(ctx->stack, set);
+}
+
+/* Replace the top count values with a list (or quotation) of them, the
+ * deepest first */
+void joy_embed_wrap(JoyContext* ctx, size_t count, int quotation) {
+    joy_embed_enter(ctx);
+    JoyStack* stack = ctx->stack;
+    JoyValue* items = stack->items + stack->depth - count;
+    JoyValue v = quotation ? joy_quotation_from(items, count)
+                           : joy_list_from(items, count);
+    for (size_t i = 0; i < count; i++) {
+        JoyValue item = joy_stack_pop(stack);
+        joy_value_free(&item);
+    }
+    joy_stack_push(stack, v);
+}
+
+/* ---------- Running ---------- */
+
+bool joy_embed_call(JoyContext* ctx, const char* name) {
+    joy_embed_enter(ctx);
+    JoyErrorTrap trap;
+    JoyErrorTrap* outer = joy_error_trap_set(&trap);
+    bool ok = true;
+    joy_embed_overflow = false;
+    if (setjmp(trap.env) == 0) {
+        joy_execute_symbol(ctx, name);
+    } else {
+        ok = false;
+        joy_embed_overflow = trap.overflowed;
+        snprintf(joy_embed_message, sizeof joy_embed_message, "%s", trap.message);
+    }
+    joy_error_trap_set(outer);
+    joy_output_flush();
+    fflush(stdout);
+    return ok;
+}
+
+const char* joy_embed_error(void) {
+    return joy_embed_message;
+}
+
+/* Whether the last failed call ran out of 64-bit integers */
+bool joy_embed_overflowed(void) {
+    return joy_embed_overflow;
+}
+
+/* ---------- Reading ---------- */
+
+size_t joy_embed_depth(JoyContext* ctx) {
+    return ctx->stack->depth;
+}
+
+/* JoyType of the top value */
+int joy_embed_type(JoyContext* ctx) {
+    return (int)ctx->stack->items[ctx->stack->depth - 1].type;
+}
+
+void joy_embed_drop(JoyContext* ctx) {
+    joy_embed_enter(ctx);
+    JoyValue v = joy_stack_pop(ctx->stack);
+    joy_value_free(&v);
+}
+
+int64_t joy_embed_integer(JoyContext* ctx) {
+    return ctx->stack->items[ctx->stack->depth - 1].data.integer;
+}
+
+double joy_embed_float(JoyContext* ctx) {
+    return ctx->stack->items[ctx->stack->depth - 1].data.floating;
+}
+
+int joy_embed_boolean(JoyContext* ctx) {
+    return ctx->stack->items[ctx->stack->depth - 1].data.boolean;
+}
+
+int joy_embed_char(JoyContext* ctx) {
+    return (unsigned char)ctx->stack->items[ctx->stack->depth - 1].data.character;
+}
+
+/* Characters of the top string, or the name of the top symbol; valid
+ * until it is dropped */
+const char* joy_embed_chars(JoyContext* ctx) {
+    JoyValue* v = &ctx->stack->items[ctx->stack->depth - 1];
+    return v->type == JOY_SYMBOL ? v->data.symbol : joy_string_chars(v);
+}
+
+/* Members of the top set, in order, into members (capacity up to
+ * capacity); returns how many there are */
+size_t joy_embed_set(JoyContext* ctx, int64_t* members, size_t capacity) {
+    const JoyValue* set = &ctx->stack->items[ctx->stack->depth - 1];
+    size_t count = 0;
+    for (int64_t m = joy_set_next(set, 0); m >= 0; m = joy_set_next(set, m + 1)) {
+        if (count < capacity) members[count] = m;
+        count++;
+    }
+    return count;
+}
+
+/* Replace the top list or quotation with its elements, the first
+ * deepest; returns how many there are */
+size_t joy_embed_unwrap(JoyContext* ctx) {
+    joy_embed_enter(ctx);
+    JoyValue v = joy_stack_pop(ctx->stack);
+    JoyValue* items = v.type == JOY_LIST ? v.data.list->items : v.data.quotation->terms;
+    size_t count = v.type == JOY_LIST ? v.data.list->length : v.data.quotation->length;
+    for (size_t i = 0; i < count; i++) {
+        joy_stack_push(ctx->stack, joy_value_copy(items[i]));
+    }
+    joy_value_free(&v);
+    return count;
+}
@@ -0,0 +1,222 @@
+/**
+ * joy_io.c - Bulk file input: mapped strings and line iteration
+ *
+ * fmap pushes a whole file as one string without reading it: the
+ * string's characters are a private mapping of the file, terminated by
+ * the zero bytes the mapping guarantees past the end of the file (see
+ * joy_string_mapped).  linestep walks the lines of any string with
+ * memchr and copies each line into a line block, a mapping of its own
+ * that the lines share by reference count the way strings share a file
+ * mapping.  Once no line from a block is alive linestep refills it, so
+ * ingesting a file costs one mapping plus a block, not an allocation per
+ * line.  Lines of up to JOY_SMALL_STRING bytes are stored in their
+ * values, and lines too long for a block get their own string.
+ *
+ * Lines are not views into the file mapping itself: a runtime string
+ * ends at a zero byte, and writing one over each newline would make the
+ * kernel copy every page of the file.
+ */
+
+/* Enable MAP_ANONYMOUS alongside the POSIX functions */
+#define _DEFAULT_SOURCE
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOY_LINE_BLOCK (256 * 1024)
+
+/* A file mapping starts with a page holding this header and the file
+ * follows from the second page; a line block starts with the header and
+ * its lines follow.  Live mappings are listed in joy_mappings, so a
+ * string pointing anywhere into one finds the header that counts its
+ * references. */
+typedef struct JoyMapping {
+    size_t refcount;
+    size_t bytes;       /* whole mapping, header included */
+    bool lines;         /* a line block, whose lines are charged one by one */
+    struct JoyMapping* next;
+} JoyMapping;
+
+static JoyMapping* joy_mappings = NULL;
+static pthread_mutex_t joy_mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static JoyMapping* joy_mapping_of(const char* chars) {
+    pthread_mutex_lock(&joy_mappings_lock);
+    JoyMapping* mapping = joy_mappings;
+    while (chars <= (const char*)mapping || chars >= (const char*)mapping + mapping->bytes) {
+        mapping = mapping->next;
+    }
+    pthread_mutex_unlock(&joy_mappings_lock);
+    return mapping;
+}
+
+static void joy_mapping_add(JoyMapping* mapping, size_t bytes, bool lines) {
+    mapping->refcount = 1;
+    mapping->bytes = bytes;
+    mapping->lines = lines;
+    pthread_mutex_lock(&joy_mappings_lock);
+    mapping->next = joy_mappings;
+    joy_mappings = mapping;
+    pthread_mutex_unlock(&joy_mappings_lock);
+}
+
+static void joy_mapping_drop(JoyMapping* mapping) {
+    if (--mapping->refcount > 0) return;
+    pthread_mutex_lock(&joy_mappings_lock);
+    JoyMapping** link = &joy_mappings;
+    while (*link != mapping) link = &(*link)->next;
+    *link = mapping->next;
+    pthread_mutex_unlock(&joy_mappings_lock);
+    munmap(mapping, mapping->bytes);
+}
+
+bool joy_string_mapped(const char* path, JoyValue* out) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    /* Reserve the header page plus whole pages for the file and one more
+     * byte.  Past the end of the file the mapping reads as zero, whether
+     * that falls in the file's last page or in the reserved page after
+     * it, so the string is always terminated. */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)st.st_size;
+    size_t bytes = page + (size / page + 1) * page;
+    char* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (size > 0) {
+        if (mmap(base + page, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, bytes);
+            close(fd);
+            return false;
+        }
+        posix_madvise(base + page, size, POSIX_MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    joy_mapping_add((JoyMapping*)base, bytes, false);
+    JoyValue v = {.type = JOY_STRING, .mapped_string = true};
+    v.data.string = base + page;
+    *out = v;
+    return true;
+}
+
+static void run_quot(JoyContext* ctx, JoyValue* quot) {
+    if (quot->type == JOY_QUOTATION) {
+        joy_execute_quotation(ctx, quot->data.quotation);
+    } else if (quot->type == JOY_LIST) {
+        joy_execute_list(ctx, quot->data.list);
+    }
+}
+
+void joy_mapping_retain(const char* chars) {
+    joy_mapping_of(chars)->refcount++;
+}
+
+void joy_mapping_release(const char* chars) {
+    JoyMapping* mapping = joy_mapping_of(chars);
+    if (mapping->lines) joy_memory_credit(strlen(chars) + 1);
+    joy_mapping_drop(mapping);
+}
+
+static JoyMapping* joy_line_block_new(void) {
+    void* base = mmap(NULL, JOY_LINE_BLOCK, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) joy_error("Out of memory");
+    joy_mapping_add(base, JOY_LINE_BLOCK, true);
+    return base;
+}
+
+/* Push the lines in [line, end), running P after each.  *block is the
+ * line block being filled, if any; linestep holds one reference to it. */
+static void linestep_lines(JoyContext* ctx, JoyValue* quot, const char* line,
+                           const char* end, JoyMapping* volatile* block) {
+    char* cursor = NULL;
+    while (line < end) {
+        const char* newline = memchr(line, '\n', (size_t)(end - line));
+        const char* stop = newline ? newline : end;
+        size_t length = (size_t)(stop - line);
+        if (length <= JOY_SMALL_STRING || length >= JOY_LINE_BLOCK / 4) {
+            joy_stack_push(ctx->stack, joy_string_span(line, length));
+        } else {
+            if (!cursor || cursor + length + 1 > (char*)*block + JOY_LINE_BLOCK) {
+                /* Lines from a full block may still be alive; if not, refill it */
+                JoyMapping* full = *block;
+                if (!full || full->refcount > 1) {
+                    *block = joy_line_block_new();
+                    if (full) joy_mapping_drop(full);
+                }
+                cursor = (char*)(*block + 1);
+            }
+            /* Charged as the string of its own it would otherwise be */
+            joy_memory_reserve(length + 1);
+            memcpy(cursor, line, length);
+            cursor[length] = '\0';
+            (*block)->refcount++;
+            JoyValue v = {.type = JOY_STRING, .mapped_string = true};
+            v.data.string = cursor;
+            cursor += length + 1;
+            joy_stack_push(ctx->stack, v);
+        }
+        run_quot(ctx, quot);
+        line = stop + 1;
+    }
+}
+
+/* ---------- Primitives ---------- */
+
+void prim_fmap(JoyContext* ctx) {
+    /* P -> S : contents of the file with pathname P, mapped rather than read */
+    if (ctx->stack->depth < 1) joy_error_underflow("fmap", 1, ctx->stack->depth);
+    JoyValue path = joy_stack_pop(ctx->stack);
+    if (path.type != JOY_STRING) joy_error_type("fmap", "STRING", path.type);
+    JoyValue text;
+    if (!joy_string_mapped(joy_string_chars(&path), &text)) {
+        joy_error("fmap: cannot map file");
+    }
+    joy_value_free(&path);
+    joy_stack_push(ctx->stack, text);
+}
+
+void prim_linestep(JoyContext* ctx) {
+    /* S [P] -> ... : step, over the lines of S without their newlines */
+    if (ctx->stack->depth < 2) joy_error_underflow("linestep", 2, ctx->stack->depth);
+    JoyValue quot = joy_stack_pop(ctx->stack);
+    JoyValue text = joy_stack_pop(ctx->stack);
+    if (quot.type != JOY_QUOTATION && quot.type != JOY_LIST) {
+        joy_error_type("linestep", "QUOTATION", quot.type);
+    }
+    if (text.type != JOY_STRING) joy_error_type("linestep", "STRING", text.type);
+
+    const char* line = joy_string_chars(&text);
+    JoyMapping* volatile block = NULL;
+    JoyErrorTrap trap;
+    JoyErrorTrap* outer = joy_error_trap_set(&trap);
+    if (setjmp(trap.env) == 0) {
+        linestep_lines(ctx, &quot, line, line + strlen(line), &block);
+        joy_error_trap_set(outer);
+    } else {
+        joy_error_trap_set(outer);
+        if (block) joy_mapping_drop(block);
+        joy_value_free(&text);
+        joy_value_free(&quot);
+        joy_error_rethrow(&trap);
+    }
+    if (block) joy_mapping_drop(block);
+    joy_value_free(&text);
+    joy_value_free(&quot);
+}
@@ -0,0 +1,290 @@
+/**
+ * joy_lazy.c - Native lazy sequences
+ *
+ * A JOY_LAZY value is a generator: a reference-counted node describing
+ * how to produce the next element and the sequence after it, built by
+ * range, iterate and unfold and stacked up by map, filter and take.
+ * joy_lazy_next produces one element at a time, so first, rest, uncons,
+ * null and step never build a list and an infinite sequence costs no
+ * more than a finite one.  A node is a value like any other: the next
+ * element advances it in place only when nothing else holds it, and
+ * otherwise works on a copy, so a sequence read twice yields the same
+ * elements twice.  Quotations run with their argument on top of the
+ * caller's stack, as in map and filter.
+ */
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    JOY_LAZY_RANGE,     /* next .. last */
+    JOY_LAZY_ITERATE,   /* state, [next] */
+    JOY_LAZY_UNFOLD,    /* state, [done] [head] [next] */
+    JOY_LAZY_MAP,       /* source, [body] */
+    JOY_LAZY_FILTER,    /* source, [test] */
+    JOY_LAZY_TAKE       /* source, count left */
+} JoyLazyKind;
+
+struct JoyLazy {
+    size_t refcount;
+    JoyLazyKind kind;
+    bool advance;       /* state is the previous element's: step it first */
+    int64_t next;       /* RANGE: next element; TAKE: elements left */
+    int64_t last;       /* RANGE */
+    JoyValue state;     /* ITERATE, UNFOLD */
+    JoyLazy* source;    /* MAP, FILTER, TAKE */
+    JoyValue quots[3];
+    size_t quot_count;
+};
+
+static JoyLazy* joy_lazy_new(JoyLazyKind kind) {
+    joy_memory_charge(JOY_LAZY, sizeof(JoyLazy));
+    JoyLazy* lazy = calloc(1, sizeof(JoyLazy));
+    if (!lazy) joy_error("Out of memory");
+    lazy->refcount = 1;
+    lazy->kind = kind;
+    return lazy;
+}
+
+static JoyValue joy_lazy_value(JoyLazy* lazy) {
+    JoyValue v = {.type = JOY_LAZY};
+    v.data.lazy = lazy;
+    return v;
+}
+
+JoyLazy* joy_lazy_retain(JoyLazy* lazy) {
+    lazy->refcount++;
+    return lazy;
+}
+
+void joy_lazy_release(JoyLazy* lazy) {
+    while (lazy && --lazy->refcount == 0) {
+        JoyLazy* source = lazy->source;
+        if (lazy->kind == JOY_LAZY_ITERATE || lazy->kind == JOY_LAZY_UNFOLD) {
+            joy_value_free(&lazy->state);
+        }
+        for (size_t i = 0; i < lazy->quot_count; i++) {
+            joy_value_free(&lazy->quots[i]);
+        }
+        joy_memory_credit(sizeof(JoyLazy));
+        free(lazy);
+        lazy = source;
+    }
+}
+
+JoyLazy* joy_lazy_clone(JoyLazy* lazy) {
+    JoyLazy* clone = joy_lazy_new(lazy->kind);
+    clone->advance = lazy->advance;
+    clone->next = lazy->next;
+    clone->last = lazy->last;
+    if (lazy->kind == JOY_LAZY_ITERATE || lazy->kind == JOY_LAZY_UNFOLD) {
+        clone->state = joy_value_clone(lazy->state);
+    }
+    if (lazy->source) clone->source = joy_lazy_clone(lazy->source);
+    clone->quot_count = lazy->quot_count;
+    for (size_t i = 0; i < lazy->quot_count; i++) {
+        clone->quots[i] = joy_value_clone(lazy->quots[i]);
+    }
+    return clone;
+}
+
+/* The node behind *seq, copied first if anything else holds it, so it
+ * can be advanced in place */
+static JoyLazy* joy_lazy_own(JoyValue* seq) {
+    JoyLazy* lazy = seq->data.lazy;
+    if (lazy->refcount == 1) return lazy;
+    JoyLazy* copy = joy_lazy_new(lazy->kind);
+    copy->advance = lazy->advance;
+    copy->next = lazy->next;
+    copy->last = lazy->last;
+    if (lazy->kind == JOY_LAZY_ITERATE || lazy->kind == JOY_LAZY_UNFOLD) {
+        copy->state = joy_value_copy(lazy->state);
+    }
+    if (lazy->source) copy->source = joy_lazy_retain(lazy->source);
+    copy->quot_count = lazy->quot_count;
+    for (size_t i = 0; i < lazy->quot_count; i++) {
+        copy->quots[i] = joy_value_copy(lazy->quots[i]);
+    }
+    joy_lazy_release(lazy);
+    seq->data.lazy = copy;
+    return copy;
+}
+
+static void run_quot(JoyContext* ctx, JoyValue* quot) {
+    if (quot->type == JOY_QUOTATION) {
+        joy_execute_quotation(ctx, quot->data.quotation);
+    } else if (quot->type == JOY_LIST) {
+        joy_execute_list(ctx, quot->data.list);
+    }
+}
+
+/* quot applied to x, which it consumes */
+static JoyValue joy_lazy_apply(JoyContext* ctx, JoyValue* quot, JoyValue x) {
+    joy_stack_push(ctx->stack, x);
+    run_quot(ctx, quot);
+    if (ctx->stack->depth < 1) joy_error_underflow("lazy sequence", 1, 0);
+    return joy_stack_pop(ctx->stack);
+}
+
+static bool joy_lazy_test(JoyContext* ctx, JoyValue* quot, const JoyValue* x) {
+    JoyValue verdict = joy_lazy_apply(ctx, quot, joy_value_copy(*x));
+    bool result = joy_value_truthy(verdict);
+    joy_value_free(&verdict);
+    return result;
+}
+
+bool joy_lazy_next(JoyContext* ctx, JoyValue* seq, JoyValue* item) {
+    JoyLazy* lazy = seq->data.lazy;
+    switch (lazy->kind) {
+        case JOY_LAZY_RANGE:
+            if (lazy->next > lazy->last) return false;
+            lazy = joy_lazy_own(seq);
+            *item = joy_integer(lazy->next);
+            if (lazy->next == INT64_MAX) {
+                lazy->last = INT64_MIN;     /* done, without overflowing */
+            } else {
+                lazy->next++;
+            }
+            return true;
+
+        case JOY_LAZY_ITERATE:
+            lazy = joy_lazy_own(seq);
+            if (lazy->advance) {
+                lazy->state = joy_lazy_apply(ctx, &lazy->quots[0], lazy->state);
+            }
+            lazy->advance = true;
+            *item = joy_value_copy(lazy->state);
+            return true;
+
+        case JOY_LAZY_UNFOLD:
+            lazy = joy_lazy_own(seq);
+            if (lazy->advance) {
+                lazy->state = joy_lazy_apply(ctx, &lazy->quots[2], lazy->state);
+                lazy->advance = false;
+            }
+            if (joy_lazy_test(ctx, &lazy->quots[0], &lazy->state)) return false;
+            *item = joy_lazy_apply(ctx, &lazy->quots[1], joy_value_copy(lazy->state));
+            lazy->advance = true;
+            return true;
+
+        case JOY_LAZY_MAP: {
+            lazy = joy_lazy_own(seq);
+            JoyValue source = joy_lazy_value(lazy->source);
+            bool more = joy_lazy_next(ctx, &source, item);
+            lazy->source = source.data.lazy;
+            if (more) *item = joy_lazy_apply(ctx, &lazy->quots[0], *item);
+            return more;
+        }
+
+        case JOY_LAZY_FILTER: {
+            lazy = joy_lazy_own(seq);
+            JoyValue source = joy_lazy_value(lazy->source);
+            bool more;
+            while ((more = joy_lazy_next(ctx, &source, item))) {
+                if (joy_lazy_test(ctx, &lazy->quots[0], item)) break;
+                joy_value_free(item);
+            }
+            lazy->source = source.data.lazy;
+            return more;
+        }
+
+        case JOY_LAZY_TAKE: {
+            if (lazy->next == 0) return false;
+            lazy = joy_lazy_own(seq);
+            JoyValue source = joy_lazy_value(lazy->source);
+            bool more = joy_lazy_next(ctx, &source, item);
+            lazy->source = source.data.lazy;
+            lazy->next = more ? lazy->next - 1 : 0;
+            return more;
+        }
+    }
+    return false;
+}
+
+/* A node of kind over seq, which it takes over, and quot */
+static JoyValue joy_lazy_over(JoyLazyKind kind, JoyValue seq, JoyValue quot) {
+    JoyLazy* lazy = joy_lazy_new(kind);
+    lazy->source = seq.data.lazy;
+    lazy->quots[0] = quot;
+    lazy->quot_count = 1;
+    return joy_lazy_value(lazy);
+}
+
+JoyValue joy_lazy_map(JoyValue seq, JoyValue quot) {
+    return joy_lazy_over(JOY_LAZY_MAP, seq, quot);
+}
+
+JoyValue joy_lazy_filter(JoyValue seq, JoyValue quot) {
+    return joy_lazy_over(JOY_LAZY_FILTER, seq, quot);
+}
+
+JoyValue joy_lazy_take(JoyValue seq, int64_t count) {
+    JoyLazy* lazy = joy_lazy_new(JOY_LAZY_TAKE);
+    lazy->source = seq.data.lazy;
+    lazy->next = count;
+    return joy_lazy_value(lazy);
+}
+
+/* ---------- Primitives ---------- */
+
+static void joy_expect_quotation(JoyValue* v, const char* op) {
+    if (v->type != JOY_QUOTATION && v->type != JOY_LIST) {
+        joy_error_type(op, "QUOTATION", v->type);
+    }
+}
+
+void prim_range(JoyContext* ctx) {
+    /* I J -> Z : the integers from I up to J, lazily */
+    if (ctx->stack->depth < 2) joy_error_underflow("range", 2, ctx->stack->depth);
+    JoyValue last = joy_stack_pop(ctx->stack);
+    JoyValue first = joy_stack_pop(ctx->stack);
+    if (first.type != JOY_INTEGER) joy_error_type("range", "INTEGER", first.type);
+    if (last.type != JOY_INTEGER) joy_error_type("range", "INTEGER", last.type);
+    JoyLazy* lazy = joy_lazy_new(JOY_LAZY_RANGE);
+    lazy->next = first.data.integer;
+    lazy->last = last.data.integer;
+    joy_stack_push(ctx->stack, joy_lazy_value(lazy));
+}
+
+void prim_iterate(JoyContext* ctx) {
+    /* X [P] -> Z : the endless sequence X, P(X), P(P(X)), ... */
+    if (ctx->stack->depth < 2) joy_error_underflow("iterate", 2, ctx->stack->depth);
+    JoyValue quot = joy_stack_pop(ctx->stack);
+    JoyValue seed = joy_stack_pop(ctx->stack);
+    joy_expect_quotation(&quot, "iterate");
+    JoyLazy* lazy = joy_lazy_new(JOY_LAZY_ITERATE);
+    lazy->state = seed;
+    lazy->quots[0] = quot;
+    lazy->quot_count = 1;
+    joy_stack_push(ctx->stack, joy_lazy_value(lazy));
+}
+
+void prim_unfold(JoyContext* ctx) {
+    /* S [B] [F] [G] -> Z : F(S), then the unfolding of G(S), ending where B holds */
+    if (ctx->stack->depth < 4) joy_error_underflow("unfold", 4, ctx->stack->depth);
+    JoyLazy* lazy = joy_lazy_new(JOY_LAZY_UNFOLD);
+    for (size_t i = 3; i-- > 0; ) {
+        lazy->quots[i] = joy_stack_pop(ctx->stack);
+        joy_expect_quotation(&lazy->quots[i], "unfold");
+        lazy->quot_count++;
+    }
+    lazy->state = joy_stack_pop(ctx->stack);
+    joy_stack_push(ctx->stack, joy_lazy_value(lazy));
+}
+
+void prim_force(JoyContext* ctx) {
+    /* Z -> L : every element of Z, in a list */
+    if (ctx->stack->depth < 1) joy_error_underflow("force", 1, ctx->stack->depth);
+    JoyValue seq = joy_stack_pop(ctx->stack);
+    if (seq.type != JOY_LAZY) joy_error_type("force", "LAZY", seq.type);
+    JoyList* list = joy_list_new(8);
+    JoyValue item;
+    while (joy_lazy_next(ctx, &seq, &item)) {
+        joy_list_push(list, item);
+    }
+    joy_value_free(&seq);
+    JoyValue v = {.type = JOY_LIST, .data.list = list};
+    joy_stack_push(ctx->stack, v);
+}
@@ -0,0 +1,234 @@
+/**
+ * joy_memo.c - Memoized quotations
+ *
+ * memo runs a quotation the way unary does, on a stack holding just its
+ * argument, and keeps the result in a table on the context keyed by the
+ * quotation and the argument, so asking again costs a lookup.  A
+ * recursive definition whose body goes through memo, such as a binrec
+ * style fib or a path count, then does each subproblem once.  Keys are
+ * compared with joy_value_same and found by joy_value_hash, which a list
+ * or quotation computes once and keeps; so looking up a key costs a walk
+ * of its items only the first time it is seen.
+ *
+ * The table grows without bound unless setmemosize caps it, after which
+ * a new entry evicts the one used least recently.  Entries are the
+ * context's, like its stack: joy_context_reset empties the table, so
+ * batch records do not see each other's results.  A result holds only
+ * while the words P calls mean what they did, so the table is also
+ * emptied whenever the dictionary's epoch moves on.
+ */
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define JOY_MEMO_BUCKETS_INITIAL 64
+
+typedef struct JoyMemoEntry {
+    uint32_t hash;
+    JoyValue quot;
+    JoyValue input;
+    JoyValue result;
+    struct JoyMemoEntry* chain;     /* next in the same bucket */
+    struct JoyMemoEntry* newer;     /* recency list, newest first */
+    struct JoyMemoEntry* older;
+} JoyMemoEntry;
+
+struct JoyMemo {
+    JoyMemoEntry** buckets;
+    size_t bucket_count;            /* a power of two */
+    size_t count;
+    size_t limit;                   /* most entries kept, 0: no bound */
+    uint64_t epoch;                 /* of the dictionary the results came from */
+    JoyMemoEntry* newest;
+    JoyMemoEntry* oldest;
+};
+
+static JoyMemo* joy_memo_new(void) {
+    JoyMemo* memo = malloc(sizeof(JoyMemo));
+    if (!memo) joy_error("Out of memory");
+    memo->bucket_count = JOY_MEMO_BUCKETS_INITIAL;
+    memo->buckets = calloc(memo->bucket_count, sizeof(JoyMemoEntry*));
+    if (!memo->buckets) joy_error("Out of memory");
+    memo->count = 0;
+    memo->limit = 0;
+    memo->epoch = 0;
+    memo->newest = memo->oldest = NULL;
+    return memo;
+}
+
+static JoyMemo* joy_memo_of(JoyContext* ctx) {
+    if (!ctx->memo) ctx->memo = joy_memo_new();
+    return ctx->memo;
+}
+
+static uint32_t joy_memo_hash(const JoyValue* quot, const JoyValue* input) {
+    return joy_value_hash(quot) * 0x9E3779B1u ^ joy_value_hash(input);
+}
+
+static void joy_memo_unlink(JoyMemo* memo, JoyMemoEntry* entry) {
+    if (entry->newer) entry->newer->older = entry->older;
+    else memo->newest = entry->older;
+    if (entry->older) entry->older->newer = entry->newer;
+    else memo->oldest = entry->newer;
+}
+
+static void joy_memo_link_newest(JoyMemo* memo, JoyMemoEntry* entry) {
+    entry->newer = NULL;
+    entry->older = memo->newest;
+    if (memo->newest) memo->newest->newer = entry;
+    else memo->oldest = entry;
+    memo->newest = entry;
+}
+
+static void joy_memo_entry_free(JoyMemoEntry* entry) {
+    joy_value_free(&entry->quot);
+    joy_value_free(&entry->input);
+    joy_value_free(&entry->result);
+    joy_memory_credit(sizeof(JoyMemoEntry));
+    free(entry);
+}
+
+static void joy_memo_evict_oldest(JoyMemo* memo) {
+    JoyMemoEntry* entry = memo->oldest;
+    JoyMemoEntry** link = &memo->buckets[entry->hash & (memo->bucket_count - 1)];
+    while (*link != entry) link = &(*link)->chain;
+    *link = entry->chain;
+    joy_memo_unlink(memo, entry);
+    memo->count--;
+    joy_memo_entry_free(entry);
+}
+
+static void joy_memo_trim(JoyMemo* memo) {
+    while (memo->limit && memo->count > memo->limit) joy_memo_evict_oldest(memo);
+}
+
+static void joy_memo_grow(JoyMemo* memo) {
+    size_t bucket_count = memo->bucket_count * 2;
+    JoyMemoEntry** buckets = calloc(bucket_count, sizeof(JoyMemoEntry*));
+    if (!buckets) joy_error("Out of memory");
+    for (size_t i = 0; i < memo->bucket_count; i++) {
+        JoyMemoEntry* entry = memo->buckets[i];
+        while (entry) {
+            JoyMemoEntry* next = entry->chain;
+            JoyMemoEntry** bucket = &buckets[entry->hash & (bucket_count - 1)];
+            entry->chain = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    free(memo->buckets);
+    memo->buckets = buckets;
+    memo->bucket_count = bucket_count;
+}
+
+static JoyMemoEntry* joy_memo_find(JoyMemo* memo, uint32_t hash, const JoyValue* quot,
+                                   const JoyValue* input) {
+    JoyMemoEntry* entry = memo->buckets[hash & (memo->bucket_count - 1)];
+    for (; entry; entry = entry->chain) {
+        if (entry->hash == hash && joy_value_same(&entry->input, input) &&
+            joy_value_same(&entry->quot, quot)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* Takes over quot, input and result */
+static void joy_memo_insert(JoyMemo* memo, uint32_t hash, JoyValue quot, JoyValue input,
+                            JoyValue result) {
+    joy_memory_reserve(sizeof(JoyMemoEntry));
+    JoyMemoEntry* entry = malloc(sizeof(JoyMemoEntry));
+    if (!entry) joy_error("Out of memory");
+    entry->hash = hash;
+    entry->quot = quot;
+    entry->input = input;
+    entry->result = result;
+    if (memo->count + 1 > memo->bucket_count / 4 * 3) joy_memo_grow(memo);
+    JoyMemoEntry** bucket = &memo->buckets[hash & (memo->bucket_count - 1)];
+    entry->chain = *bucket;
+    *bucket = entry;
+    joy_memo_link_newest(memo, entry);
+    memo->count++;
+    joy_memo_trim(memo);
+}
+
+static void joy_memo_clear(JoyMemo* memo) {
+    while (memo->oldest) {
+        JoyMemoEntry* entry = memo->oldest;
+        memo->oldest = entry->newer;
+        joy_memo_entry_free(entry);
+    }
+    memo->newest = NULL;
+    memo->count = 0;
+    memset(memo->buckets, 0, memo->bucket_count * sizeof(JoyMemoEntry*));
+}
+
+void joy_memo_free(JoyMemo* memo) {
+    if (!memo) return;
+    joy_memo_clear(memo);
+    free(memo->buckets);
+    free(memo);
+}
+
+/* ---------- Primitives ---------- */
+
+void prim_memo(JoyContext* ctx) {
+    /* X [P] -> R : as X [P] unary, computed once per X and P */
+    if (ctx->stack->depth < 2) joy_error_underflow("memo", 2, ctx->stack->depth);
+    JoyValue quot = joy_stack_pop(ctx->stack);
+    JoyValue x = joy_stack_pop(ctx->stack);
+    if (quot.type != JOY_QUOTATION && quot.type != JOY_LIST) {
+        joy_error_type("memo", "QUOTATION", quot.type);
+    }
+
+    JoyMemo* memo = joy_memo_of(ctx);
+    uint64_t epoch = ctx->dictionary->epoch;
+    if (memo->epoch != epoch) {
+        joy_memo_clear(memo);
+        memo->epoch = epoch;
+    }
+    uint32_t hash = joy_memo_hash(&quot, &x);
+    JoyMemoEntry* entry = joy_memo_find(memo, hash, &quot, &x);
+    if (entry) {
+        joy_memo_unlink(memo, entry);
+        joy_memo_link_newest(memo, entry);
+        joy_stack_push(ctx->stack, joy_value_copy(entry->result));
+        joy_value_free(&quot);
+        joy_value_free(&x);
+        return;
+    }
+
+    JoyCheckpoint saved;
+    joy_stack_checkpoint(ctx->stack, &saved);
+    joy_stack_clear(ctx->stack);
+    joy_stack_push(ctx->stack, joy_value_copy(x));
+    if (quot.type == JOY_QUOTATION) {
+        joy_execute_quotation(ctx, quot.data.quotation);
+    } else {
+        joy_execute_list(ctx, quot.data.list);
+    }
+    JoyValue result = joy_stack_pop(ctx->stack);
+    joy_stack_restore(ctx->stack, &saved);
+
+    /* P may have run memo itself and grown or trimmed the table since;
+     * a result from before a redefinition is not kept */
+    if (ctx->dictionary->epoch == epoch) {
+        joy_memo_insert(memo, hash, quot, x, joy_value_copy(result));
+    } else {
+        joy_value_free(&quot);
+        joy_value_free(&x);
+    }
+    joy_stack_push(ctx->stack, result);
+}
+
+void prim_setmemosize(JoyContext* ctx) {
+    /* I -> : keep at most I memo results, dropping the least recently used (0: all) */
+    if (ctx->stack->depth < 1) joy_error_underflow("setmemosize", 1, ctx->stack->depth);
+    JoyValue v = joy_stack_pop(ctx->stack);
+    if (v.type != JOY_INTEGER) joy_error_type("setmemosize", "INTEGER", v.type);
+    JoyMemo* memo = joy_memo_of(ctx);
+    memo->limit = v.data.integer > 0 ? (size_t)v.data.integer : 0;
+    joy_memo_trim(memo);
+}
@@ -0,0 +1,205 @@
+/**
+ * joy_output.c - Buffered standard output
+ *
+ * Value printing and the print primitives write into a buffer owned by
+ * the running context, made active per thread the way its allocator is,
+ * with integers and floats formatted by hand instead of one printf per
+ * token.  The buffer goes to stdout in a single write at each newline
+ * when stdout is a terminal, once it passes JOY_OUTPUT_FLUSH bytes, and
+ * on joy_output_flush.  Everything else that reaches the terminal (stdio
+ * writes to stdout, reads from stdin, system, errors) flushes first, so
+ * output keeps its order.  Live buffers are also kept on a list, so an
+ * error that ends the process writes out what every context has
+ * buffered, not just the failing thread's.
+ */
+
+/* Enable POSIX functions like fileno and isatty */
+#define _POSIX_C_SOURCE 200809L
+
+#include "joy_runtime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define JOY_OUTPUT_FLUSH (64 * 1024)
+#define JOY_NUMBER_MAX 32       /* longest formatted integer or float */
+
+struct JoyOutput {
+    FILE* file;
+    bool interactive;           /* flush at each newline */
+    JoyOutput* next;            /* joy_outputs, under joy_outputs_lock */
+    JoyOutput* prev;
+    size_t length;
+    char buf[JOY_OUTPUT_FLUSH];
+};
+
+static _Thread_local JoyOutput* joy_active_output = NULL;
+
+/* Every live buffer, for joy_output_flush_all */
+static JoyOutput* joy_outputs = NULL;
+static pthread_mutex_t joy_outputs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+JoyOutput* joy_output_new(FILE* file) {
+    JoyOutput* out = malloc(sizeof(JoyOutput));
+    if (!out) joy_error("Out of memory");
+    out->file = file;
+    out->interactive = isatty(fileno(file));
+    out->length = 0;
+    pthread_mutex_lock(&joy_outputs_lock);
+    out->prev = NULL;
+    out->next = joy_outputs;
+    if (joy_outputs) joy_outputs->prev = out;
+    joy_outputs = out;
+    pthread_mutex_unlock(&joy_outputs_lock);
+    return out;
+}
+
+static void joy_output_drain(JoyOutput* out) {
+    if (out->length > 0) {
+        fwrite(out->buf, 1, out->length, out->file);
+        out->length = 0;
+    }
+}
+
+void joy_output_free(JoyOutput* out) {
+    if (!out) return;
+    joy_output_drain(out);
+    if (joy_active_output == out) joy_active_output = NULL;
+    pthread_mutex_lock(&joy_outputs_lock);
+    if (out->prev) out->prev->next = out->next;
+    else joy_outputs = out->next;
+    if (out->next) out->next->prev = out->prev;
+    pthread_mutex_unlock(&joy_outputs_lock);
+    free(out);
+}
+
+void joy_output_redirect(JoyOutput* out, FILE* file) {
+    joy_output_drain(out);
+    out->file = file;
+    out->interactive = isatty(fileno(file));
+}
+
+void joy_output_use(JoyOutput* out) {
+    joy_active_output = out;
+}
+
+JoyOutput* joy_output_active(void) {
+    return joy_active_output;
+}
+
+void joy_output_flush(void) {
+    if (joy_active_output) joy_output_drain(joy_active_output);
+}
+
+void joy_output_flush_all(void) {
+    /* The failing thread's own output goes first */
+    joy_output_flush();
+    pthread_mutex_lock(&joy_outputs_lock);
+    for (JoyOutput* out = joy_outputs; out; out = out->next) joy_output_drain(out);
+    pthread_mutex_unlock(&joy_outputs_lock);
+    fflush(NULL);
+}
+
+void joy_output_write(const char* bytes, size_t length) {
+    JoyOutput* out = joy_active_output;
+    if (!out) {
+        fwrite(bytes, 1, length, stdout);
+        return;
+    }
+    if (out->length + length > JOY_OUTPUT_FLUSH) {
+        joy_output_drain(out);
+        if (length >= JOY_OUTPUT_FLUSH) {
+            fwrite(bytes, 1, length, out->file);
+            return;
+        }
+    }
+    memcpy(out->buf + out->length, bytes, length);
+    out->length += length;
+    if (out->interactive && memchr(bytes, '\n', length)) {
+        joy_output_drain(out);
+    }
+}
+
+void joy_output_string(const char* s) {
+    joy_output_write(s, strlen(s));
+}
+
+void joy_output_char(char c) {
+    JoyOutput* out = joy_active_output;
+    if (!out || out->length == JOY_OUTPUT_FLUSH || (out->interactive && c == '\n')) {
+        joy_output_write(&c, 1);
+        return;
+    }
+    out->buf[out->length++] = c;
+}
+
+/* ---------- Number Formatting ---------- */
+
+static size_t joy_format_integer(char* buf, int64_t n) {
+    char digits[20];
+    size_t count = 0;
+    uint64_t u = n < 0 ? 0 - (uint64_t)n : (uint64_t)n;
+    do {
+        digits[count++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    size_t length = 0;
+    if (n < 0) buf[length++] = '-';
+    while (count) buf[length++] = digits[--count];
+    return length;
+}
+
+/* Same text as printf("%g").  Values printed without an exponent are
+ * rounded to six digits here; the rest, and any value within a hair of
+ * a rounding tie where the product below may be off by an ulp, go to
+ * snprintf. */
+static size_t joy_format_float(char* buf, double f) {
+    static const double p10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    double a = fabs(f);
+    if (a >= 1e-4 && a < 1e6) {
+        int x = (int)floor(log10(a));    /* decimal exponent */
+        if (x >= -4 && x <= 5) {
+            double m = a * p10[5 - x];
+            double whole = floor(m);
+            double frac = m - whole;
+            if (m >= 1e5 && m < 999999.5 && fabs(frac - 0.5) > 1e-6) {
+                int64_t d = (int64_t)whole + (frac > 0.5);
+                char digits[6];
+                for (int i = 5; i >= 0; i--) {
+                    digits[i] = (char)('0' + d % 10);
+                    d /= 10;
+                }
+                int keep = 6;
+                while (keep > x + 1 && keep > 1 && digits[keep - 1] == '0') keep--;
+                size_t length = 0;
+                if (f < 0) buf[length++] = '-';
+                if (x >= 0) {
+                    for (int i = 0; i < keep; i++) {
+                        if (i == x + 1) buf[length++] = '.';
+                        buf[length++] = digits[i];
+                    }
+                } else {
+                    buf[length++] = '0';
+                    buf[length++] = '.';
+                    for (int i = -1; i > x; i--) buf[length++] = '0';
+                    for (int i = 0; i < keep; i++) buf[length++] = digits[i];
+                }
+                return length;
+            }
+        }
+    }
+    return (size_t)snprintf(buf, JOY_NUMBER_MAX, "%g", f);
+}
+
+void joy_output_integer(int64_t n) {
+    char buf[JOY_NUMBER_MAX];
+    joy_output_write(buf, joy_format_integer(buf, n));
+}
+
+void joy_output_float(double f) {
+    char buf[JOY_NUMBER_MAX];
+    joy_output_write(buf, joy_format_float(buf, f));
+}
@@ -0,0 +1,559 @@
+/**
+ * joy_parallel.c - Parallel combinators on a work-stealing thread pool
+ *
+ * pmap, pfilter and pbinrec run a quotation over independent inputs on
+ * worker threads.  For each job every worker gets a JoyContext cloned
+ * from the caller's (joy_context_clone), so workers share nothing
+ * mutable: inputs are cloned in, results are cloned back out once every
+ * worker is idle, and the worker contexts are then dropped.  Each input
+ * runs on an otherwise empty stack, so the quotation should use only the
+ * value it is given and should not print; short inputs, single-threaded
+ * pools and parallel words nested inside a worker fall back to map,
+ * filter and binrec.  An error on a worker stops the job: the other
+ * workers take no more inputs, and once they are idle the first error
+ * is raised again on the calling thread, where its trap, if any, sees it.
+ */
+
+/* Enable POSIX functions like sysconf */
+#define _POSIX_C_SOURCE 200809L
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+/* Aggregates shorter than this run sequentially: a job costs a context
+ * clone per worker, more than a few cheap items are worth */
+#define JOY_PARALLEL_CUTOFF 4
+
+/* pbinrec splits its problem on the calling thread until there are this
+ * many subproblems per worker, so uneven halves still balance */
+#define JOY_PARALLEL_SPLIT 4
+
+#define JOY_PARALLEL_MAX_THREADS 64
+
+/* Runs one input on a worker context and returns its result */
+typedef JoyValue (*JoyTask)(JoyContext* ctx, JoyValue* quots, JoyValue input);
+
+/* A slice of task indices.  Its worker takes from the front; a worker
+ * whose own slice is empty steals the back half of the fullest one. */
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t end;
+} JoyRange;
+
+typedef struct {
+    JoyContext* parent;
+    JoyTask task;
+    JoyValue* quots;        /* parent's; each worker clones them */
+    size_t quot_count;
+    JoyValue* inputs;       /* parent's */
+    JoyValue* results;      /* one per input, owned by kept[worker] */
+    JoyRange* ranges;       /* one per worker */
+    JoyContext** contexts;  /* one per worker, freed by the caller */
+    JoyList** kept;
+    atomic_bool failed;     /* some worker's task raised an error */
+    JoyErrorTrap error;     /* the first one, under joy_pool.lock */
+} JoyJob;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    size_t threads;         /* 0 until the pool starts */
+    JoyJob* job;
+    uint64_t generation;    /* bumped for each job */
+    size_t active;          /* workers still on the current job */
+} JoyPool;
+
+static JoyPool joy_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static void (*joy_worker_init)(void) = NULL;
+static void (*joy_worker_fini)(void) = NULL;
+
+/* Set on pool threads, so nested parallel words run sequentially */
+static _Thread_local bool joy_in_worker = false;
+
+void joy_set_worker_hooks(void (*init)(void), void (*fini)(void)) {
+    joy_worker_init = init;
+    joy_worker_fini = fini;
+}
+
+void joy_parallel_serial(void) {
+    joy_in_worker = true;
+}
+
+size_t joy_parallel_threads(void) {
+    long count = 0;
+    const char* env = getenv("JOY_THREADS");
+    if (env && *env) {
+        count = strtol(env, NULL, 10);
+    } else {
+        count = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (count < 1) count = 1;
+    if (count > JOY_PARALLEL_MAX_THREADS) count = JOY_PARALLEL_MAX_THREADS;
+    return (size_t)count;
+}
+
+static void run_quot(JoyContext* ctx, JoyValue* quot) {
+    if (quot->type == JOY_QUOTATION) {
+        joy_execute_quotation(ctx, quot->data.quotation);
+    } else if (quot->type == JOY_LIST) {
+        joy_execute_list(ctx, quot->data.list);
+    }
+}
+
+/* ---------- Work Stealing ---------- */
+
+static bool joy_range_take(JoyRange* range, size_t* index) {
+    pthread_mutex_lock(&range->lock);
+    bool taken = range->next < range->end;
+    if (taken) *index = range->next++;
+    pthread_mutex_unlock(&range->lock);
+    return taken;
+}
+
+static size_t joy_range_left(JoyRange* range) {
+    pthread_mutex_lock(&range->lock);
+    size_t left = range->end - range->next;
+    pthread_mutex_unlock(&range->lock);
+    return left;
+}
+
+static bool joy_job_take(JoyJob* job, size_t self, size_t* index) {
+    if (atomic_load(&job->failed)) return false;
+    JoyRange* own = &job->ranges[self];
+    if (joy_range_take(own, index)) return true;
+
+    for (;;) {
+        size_t victim = self;
+        size_t most = 0;
+        for (size_t w = 0; w < joy_pool.threads; w++) {
+            size_t left = w == self ? 0 : joy_range_left(&job->ranges[w]);
+            if (left > most) {
+                most = left;
+                victim = w;
+            }
+        }
+        if (most == 0) return false;
+
+        JoyRange* range = &job->ranges[victim];
+        pthread_mutex_lock(&range->lock);
+        size_t left = range->end - range->next;
+        if (left == 0) {
+            /* Drained since we looked; look again */
+            pthread_mutex_unlock(&range->lock);
+            continue;
+        }
+        size_t end = range->end;
+        size_t split = end - (left + 1) / 2;
+        range->end = split;
+        pthread_mutex_unlock(&range->lock);
+
+        pthread_mutex_lock(&own->lock);
+        own->next = split + 1;
+        own->end = end;
+        pthread_mutex_unlock(&own->lock);
+        *index = split;
+        return true;
+    }
+}
+
+/* ---------- Pool ---------- */
+
+static void joy_worker_run(JoyJob* job, size_t self) {
+    JoyContext* ctx = joy_context_clone(job->parent);
+    if (joy_worker_init) joy_worker_init();
+
+    JoyValue quots[4];
+    for (size_t i = 0; i < job->quot_count; i++) {
+        quots[i] = joy_value_clone(job->quots[i]);
+    }
+
+    JoyList* kept = joy_list_new(8);
+    size_t index;
+    JoyErrorTrap trap;
+    JoyErrorTrap* outer = joy_error_trap_set(&trap);
+    if (setjmp(trap.env) == 0) {
+        while (joy_job_take(job, self, &index)) {
+            JoyValue result = job->task(ctx, quots, job->inputs[index]);
+            joy_stack_clear(ctx->stack);
+            /* kept owns the result; the caller reads it through results */
+            job->results[index] = result;
+            joy_list_push(kept, result);
+        }
+        joy_error_trap_set(outer);
+    } else {
+        joy_error_trap_set(outer);
+        pthread_mutex_lock(&joy_pool.lock);
+        if (!atomic_load(&job->failed)) {
+            job->error = trap;
+            atomic_store(&job->failed, true);
+        }
+        pthread_mutex_unlock(&joy_pool.lock);
+    }
+
+    for (size_t i = 0; i < job->quot_count; i++) {
+        joy_value_free(&quots[i]);
+    }
+    if (joy_worker_fini) joy_worker_fini();
+    job->contexts[self] = ctx;
+    job->kept[self] = kept;
+}
+
+static void* joy_worker_main(void* arg) {
+    size_t self = (size_t)(uintptr_t)arg;
+    uint64_t seen = 0;
+    joy_in_worker = true;
+
+    for (;;) {
+        pthread_mutex_lock(&joy_pool.lock);
+        while (joy_pool.generation == seen) {
+            pthread_cond_wait(&joy_pool.start, &joy_pool.lock);
+        }
+        seen = joy_pool.generation;
+        JoyJob* job = joy_pool.job;
+        pthread_mutex_unlock(&joy_pool.lock);
+
+        joy_worker_run(job, self);
+
+        pthread_mutex_lock(&joy_pool.lock);
+        if (--joy_pool.active == 0) {
+            pthread_cond_signal(&joy_pool.done);
+        }
+        pthread_mutex_unlock(&joy_pool.lock);
+    }
+    return NULL;
+}
+
+/* Start the workers on first use; they live until the process exits */
+static size_t joy_pool_start(void) {
+    if (joy_pool.threads > 0) return joy_pool.threads;
+    size_t threads = joy_parallel_threads();
+    for (size_t i = 0; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, joy_worker_main, (void*)(uintptr_t)i) != 0) {
+            joy_error("Cannot start worker thread");
+        }
+        pthread_detach(thread);
+    }
+    joy_pool.threads = threads;
+    return threads;
+}
+
+/* Whether a job of count inputs should go to the pool */
+static bool joy_parallel_worthwhile(size_t count) {
+    if (joy_in_worker || count < JOY_PARALLEL_CUTOFF) return false;
+    return joy_pool.threads > 0 ? joy_pool.threads > 1 : joy_parallel_threads() > 1;
+}
+
+/* Run task over inputs on the pool and clone each result into the
+ * caller's allocator.  Returns the results, which the caller frees. */
+static JoyValue* joy_parallel_run(JoyContext* ctx, JoyTask task, JoyValue* quots,
+                                  size_t quot_count, JoyValue* inputs, size_t count) {
+    size_t threads = joy_pool_start();
+
+    JoyJob job = {
+        .parent = ctx,
+        .task = task,
+        .quots = quots,
+        .quot_count = quot_count,
+        .inputs = inputs,
+        .results = calloc(count, sizeof(JoyValue)),
+        .ranges = calloc(threads, sizeof(JoyRange)),
+        .contexts = calloc(threads, sizeof(JoyContext*)),
+        .kept = calloc(threads, sizeof(JoyList*)),
+    };
+    if (!job.results || !job.ranges || !job.contexts || !job.kept) {
+        joy_error("Out of memory");
+    }
+    for (size_t w = 0; w < threads; w++) {
+        pthread_mutex_init(&job.ranges[w].lock, NULL);
+        job.ranges[w].next = count * w / threads;
+        job.ranges[w].end = count * (w + 1) / threads;
+    }
+
+    pthread_mutex_lock(&joy_pool.lock);
+    joy_pool.job = &job;
+    joy_pool.active = threads;
+    joy_pool.generation++;
+    pthread_cond_broadcast(&joy_pool.start);
+    while (joy_pool.active > 0) {
+        pthread_cond_wait(&joy_pool.done, &joy_pool.lock);
+    }
+    pthread_mutex_unlock(&joy_pool.lock);
+
+    bool failed = atomic_load(&job.failed);
+    JoyValue* results = failed ? NULL : malloc(count * sizeof(JoyValue));
+    if (!failed && !results) joy_error("Out of memory");
+    for (size_t i = 0; !failed && i < count; i++) {
+        results[i] = joy_value_clone(job.results[i]);
+    }
+
+    /* Worker values go back to their own allocators */
+    for (size_t w = 0; w < threads; w++) {
+        joy_allocator_use(job.contexts[w]->allocator);
+        joy_list_free(job.kept[w]);
+        joy_context_free(job.contexts[w]);
+        pthread_mutex_destroy(&job.ranges[w].lock);
+    }
+    joy_allocator_use(ctx->allocator);
+
+    free(job.results);
+    free(job.ranges);
+    free(job.contexts);
+    free(job.kept);
+    if (failed) joy_error_rethrow(&job.error);
+    return results;
+}
+
+/* ---------- Primitives ---------- */
+
+static JoyValue pmap_task(JoyContext* ctx, JoyValue* quots, JoyValue input) {
+    joy_stack_push(ctx->stack, joy_value_clone(input));
+    run_quot(ctx, &quots[0]);
+    return joy_stack_pop(ctx->stack);
+}
+
+static JoyValue pfilter_task(JoyContext* ctx, JoyValue* quots, JoyValue input) {
+    joy_stack_push(ctx->stack, joy_value_clone(input));
+    run_quot(ctx, &quots[0]);
+    return joy_boolean(joy_stack_pop_truthy(ctx->stack));
+}
+
+static JoyValue pbinrec_task(JoyContext* ctx, JoyValue* quots, JoyValue input) {
+    joy_stack_push(ctx->stack, joy_value_clone(input));
+    for (size_t i = 0; i < 4; i++) {
+        joy_stack_push(ctx->stack, joy_value_copy(quots[i]));
+    }
+    prim_binrec(ctx);
+    joy_run_tail(ctx);
+    return joy_stack_pop(ctx->stack);
+}
+
+void prim_pmap(JoyContext* ctx) {
+    /* A [P] -> B : map, with items run on worker threads */
+    if (ctx->stack->depth < 2) joy_error_underflow("pmap", 2, ctx->stack->depth);
+    JoyValue* agg = &ctx->stack->items[ctx->stack->depth - 2];
+    size_t count;
+    joy_aggregate_items(agg, &count, "pmap");
+    if (!joy_parallel_worthwhile(count)) {
+        prim_map(ctx);
+        return;
+    }
+
+    JoyValue quot = joy_stack_pop(ctx->stack);
+    JoyValue items = joy_stack_pop(ctx->stack);
+    JoyValue* inputs = joy_aggregate_items(&items, &count, "pmap");
+    JoyValue* results = joy_parallel_run(ctx, pmap_task, &quot, 1, inputs, count);
+
+    JoyList* list = joy_list_new(count);
+    for (size_t i = 0; i < count; i++) {
+        joy_list_push(list, results[i]);
+    }
+    free(results);
+    joy_value_free(&items);
+    joy_value_free(&quot);
+    joy_stack_push(ctx->stack, (JoyValue){.type = JOY_LIST, .data.list = list});
+}
+
+void prim_pfilter(JoyContext* ctx) {
+    /* A [P] -> B : filter, with the tests run on worker threads */
+    if (ctx->stack->depth < 2) joy_error_underflow("pfilter", 2, ctx->stack->depth);
+    JoyValue* agg = &ctx->stack->items[ctx->stack->depth - 2];
+    size_t count;
+    joy_aggregate_items(agg, &count, "pfilter");
+    if (!joy_parallel_worthwhile(count)) {
+        prim_filter(ctx);
+        return;
+    }
+
+    JoyValue quot = joy_stack_pop(ctx->stack);
+    JoyValue items = joy_stack_pop(ctx->stack);
+    JoyValue* inputs = joy_aggregate_items(&items, &count, "pfilter");
+    JoyValue* keep = joy_parallel_run(ctx, pfilter_task, &quot, 1, inputs, count);
+
+    JoyList* list = joy_list_new(count);
+    for (size_t i = 0; i < count; i++) {
+        if (keep[i].data.boolean) {
+            joy_list_push(list, joy_value_copy(inputs[i]));
+        }
+    }
+    free(keep);
+    joy_value_free(&items);
+    joy_value_free(&quot);
+    joy_stack_push(ctx->stack, (JoyValue){.type = JOY_LIST, .data.list = list});
+}
+
+/* One subproblem of a pbinrec split: an input until solved, then its
+ * result.  A split node keeps what R1 left below its two halves and
+ * combines their results with R2 on top of it, as binrec would. */
+typedef struct {
+    JoyValue value;
+    size_t first;       /* children, or 0 for none (the root is never a child) */
+    size_t second;
+    JoyValue* below;
+    size_t below_count;
+} JoySplitNode;
+
+/* What a pbinrec split has allocated.  It lives on the heap, not in the
+ * frame that calls setjmp, so the error path can still free it. */
+typedef struct {
+    JoySplitNode* nodes;
+    size_t count;
+    JoyValue* inputs;
+} JoySplit;
+
+static void joy_split_free(JoySplit* split) {
+    /* A node's below is cleared once R2 has taken its values back */
+    for (size_t i = 0; i < split->count; i++) {
+        JoySplitNode* node = &split->nodes[i];
+        if (!node->below) continue;
+        for (size_t j = 0; j < node->below_count; j++) {
+            joy_value_free(&node->below[j]);
+        }
+        free(node->below);
+    }
+    free(split->nodes);
+    free(split->inputs);
+    free(split);
+}
+
+/* Split X, solve the leaves on the pool and combine; leaves R in nodes[0] */
+static void pbinrec_run(JoyContext* ctx, JoyValue* quots, size_t threads, JoySplit* split) {
+    size_t base = ctx->stack->depth;
+
+    /* Split breadth-first on this thread.  Nodes in [next, count) are
+     * unsolved leaves; children always follow their parent. */
+    size_t capacity = 4 * JOY_PARALLEL_SPLIT * threads;
+    JoySplitNode* nodes = malloc(capacity * sizeof(JoySplitNode));
+    if (!nodes) joy_error("Out of memory");
+    split->nodes = nodes;
+    nodes[0] = (JoySplitNode){.value = joy_stack_pop(ctx->stack)};
+    base--;
+    split->count = 1;
+    size_t next = 0;
+    while (next < split->count && split->count - next < JOY_PARALLEL_SPLIT * threads) {
+        JoySplitNode* node = &nodes[next++];
+        joy_stack_push(ctx->stack, node->value);
+
+        JoyCheckpoint saved;
+        joy_stack_checkpoint(ctx->stack, &saved);
+        run_quot(ctx, &quots[0]);
+        bool is_base = joy_stack_pop_truthy(ctx->stack);
+        joy_stack_restore(ctx->stack, &saved);
+
+        if (is_base) {
+            run_quot(ctx, &quots[1]);
+            node->value = joy_stack_pop(ctx->stack);
+            continue;
+        }
+
+        run_quot(ctx, &quots[2]);
+        if (ctx->stack->depth < base + 2) {
+            joy_error_underflow("pbinrec", 2, ctx->stack->depth - base);
+        }
+        size_t count = split->count;
+        if (count + 2 > capacity) {
+            JoySplitNode* grown = realloc(nodes, capacity * 2 * sizeof(JoySplitNode));
+            if (!grown) joy_error("Out of memory");
+            capacity *= 2;
+            split->nodes = nodes = grown;
+            node = &nodes[next - 1];
+        }
+        nodes[count + 1] = (JoySplitNode){.value = joy_stack_pop(ctx->stack)};
+        nodes[count] = (JoySplitNode){.value = joy_stack_pop(ctx->stack)};
+        split->count += 2;
+        node->first = count;
+        node->second = count + 1;
+        node->below_count = ctx->stack->depth - base;
+        node->below = malloc((node->below_count + 1) * sizeof(JoyValue));
+        if (!node->below) joy_error("Out of memory");
+        for (size_t i = node->below_count; i-- > 0;) {
+            node->below[i] = joy_stack_pop(ctx->stack);
+        }
+    }
+
+    /* Solve the remaining leaves in parallel */
+    size_t leaves = split->count - next;
+    if (leaves > 0) {
+        split->inputs = malloc(leaves * sizeof(JoyValue));
+        if (!split->inputs) joy_error("Out of memory");
+        for (size_t i = 0; i < leaves; i++) {
+            split->inputs[i] = nodes[next + i].value;
+        }
+        JoyValue* results =
+            joy_parallel_run(ctx, pbinrec_task, quots, 4, split->inputs, leaves);
+        for (size_t i = 0; i < leaves; i++) {
+            joy_value_free(&nodes[next + i].value);
+            nodes[next + i].value = results[i];
+        }
+        free(results);
+        free(split->inputs);
+        split->inputs = NULL;
+    }
+
+    /* Combine bottom-up */
+    for (size_t i = split->count; i-- > 0;) {
+        JoySplitNode* node = &nodes[i];
+        if (!node->first) continue;
+        for (size_t j = 0; j < node->below_count; j++) {
+            joy_stack_push(ctx->stack, node->below[j]);
+        }
+        free(node->below);
+        node->below = NULL;
+        joy_stack_push(ctx->stack, nodes[node->first].value);
+        joy_stack_push(ctx->stack, nodes[node->second].value);
+        run_quot(ctx, &quots[3]);
+        node->value = joy_stack_pop(ctx->stack);
+    }
+}
+
+void prim_pbinrec(JoyContext* ctx) {
+    /* X [P] [T] [R1] [R2] -> R : binrec, with the subproblems below the
+     * top few levels solved on worker threads */
+    if (ctx->stack->depth < 5) joy_error_underflow("pbinrec", 5, ctx->stack->depth);
+    size_t threads = joy_pool.threads > 0 ? joy_pool.threads : joy_parallel_threads();
+    if (joy_in_worker || threads < 2) {
+        prim_binrec(ctx);
+        return;
+    }
+
+    /* quots holds P, T, R1, R2 */
+    JoyValue quots[4];
+    for (size_t i = 4; i-- > 0;) {
+        quots[i] = joy_stack_pop(ctx->stack);
+    }
+    JoySplit* split = calloc(1, sizeof(JoySplit));
+    if (!split) joy_error("Out of memory");
+
+    JoyErrorTrap trap;
+    JoyErrorTrap* outer = joy_error_trap_set(&trap);
+    if (setjmp(trap.env) == 0) {
+        pbinrec_run(ctx, quots, threads, split);
+        joy_error_trap_set(outer);
+    } else {
+        joy_error_trap_set(outer);
+        joy_split_free(split);
+        for (size_t i = 0; i < 4; i++) {
+            joy_value_free(&quots[i]);
+        }
+        joy_error_rethrow(&trap);
+    }
+
+    joy_stack_push(ctx->stack, split->nodes[0].value);
+    joy_split_free(split);
+    for (size_t i = 0; i < 4; i++) {
+        joy_value_free(&quots[i]);
+    }
+}
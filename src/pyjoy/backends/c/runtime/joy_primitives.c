@@ -6,21 +6,20 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "joy_runtime.h"
+#include "joy_primitives.h"
+#include "joy_builtins.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
 #include <inttypes.h>
-
-/* Global storage for command line arguments */
-static int joy_argc = 0;
-static char** joy_argv = NULL;
+#include <sys/stat.h>
 
 /* Function to initialize argc/argv - call from main() */
-void joy_set_argv(int argc, char** argv) {
-    joy_argc = argc;
-    joy_argv = argv;
+void joy_set_argv(JoyContext* ctx, int argc, char** argv) {
+    ctx->argc = argc;
+    ctx->argv = argv;
 }
 
 /* Helper macros */
@@ -37,23 +36,23 @@ void joy_set_argv(int argc, char** argv) {
 
 /* ---------- Stack Operations ---------- */
 
-static void prim_dup(JoyContext* ctx) {
+void prim_dup(JoyContext* ctx) {
     REQUIRE(1, "dup");
     joy_stack_dup(ctx->stack);
 }
 
-static void prim_pop(JoyContext* ctx) {
+void prim_pop(JoyContext* ctx) {
     REQUIRE(1, "pop");
     JoyValue v = POP();
     joy_value_free(&v);
 }
 
-static void prim_swap(JoyContext* ctx) {
+void prim_swap(JoyContext* ctx) {
     REQUIRE(2, "swap");
     joy_stack_swap(ctx->stack);
 }
 
-static void prim_rollup(JoyContext* ctx) {
+void prim_rollup(JoyContext* ctx) {
     /* X Y Z -> Z X Y (Y ends on top) */
     REQUIRE(3, "rollup");
     JoyValue z = POP();
@@ -64,7 +63,7 @@ static void prim_rollup(JoyContext* ctx) {
     PUSH(y);
 }
 
-static void prim_rolldown(JoyContext* ctx) {
+void prim_rolldown(JoyContext* ctx) {
     /* X Y Z -> Y Z X (X ends on top) */
     REQUIRE(3, "rolldown");
     JoyValue z = POP();
@@ -75,7 +74,7 @@ static void prim_rolldown(JoyContext* ctx) {
     PUSH(x);
 }
 
-static void prim_rotate(JoyContext* ctx) {
+void prim_rotate(JoyContext* ctx) {
     REQUIRE(3, "rotate");
     JoyValue z = POP();
     JoyValue y = POP();
@@ -85,7 +84,7 @@ static void prim_rotate(JoyContext* ctx) {
     PUSH(x);
 }
 
-static void prim_over(JoyContext* ctx) {
+void prim_over(JoyContext* ctx) {
     /* X Y -> X Y X (copy second to top) */
     REQUIRE(2, "over");
     JoyValue y = POP();
@@ -94,7 +93,7 @@ static void prim_over(JoyContext* ctx) {
     PUSH(joy_value_copy(x));
 }
 
-static void prim_dup2(JoyContext* ctx) {
+void prim_dup2(JoyContext* ctx) {
     /* X Y -> X Y X Y (duplicate top two) */
     REQUIRE(2, "dup2");
     JoyValue y = PEEK();
@@ -103,21 +102,21 @@ static void prim_dup2(JoyContext* ctx) {
     PUSH(joy_value_copy(y));
 }
 
-static void prim_dupd(JoyContext* ctx) {
+void prim_dupd(JoyContext* ctx) {
     REQUIRE(2, "dupd");
     JoyValue y = POP();
     joy_stack_dup(ctx->stack);
     PUSH(y);
 }
 
-static void prim_swapd(JoyContext* ctx) {
+void prim_swapd(JoyContext* ctx) {
     REQUIRE(3, "swapd");
     JoyValue z = POP();
     joy_stack_swap(ctx->stack);
     PUSH(z);
 }
 
-static void prim_popd(JoyContext* ctx) {
+void prim_popd(JoyContext* ctx) {
     REQUIRE(2, "popd");
     JoyValue y = POP();
     JoyValue x = POP();
@@ -125,7 +124,7 @@ static void prim_popd(JoyContext* ctx) {
     PUSH(y);
 }
 
-static void prim_rollupd(JoyContext* ctx) {
+void prim_rollupd(JoyContext* ctx) {
     /* X Y Z W -> Z X Y W : rollup under top */
     REQUIRE(4, "rollupd");
     JoyValue w = POP();
@@ -138,7 +137,7 @@ static void prim_rollupd(JoyContext* ctx) {
     PUSH(w);
 }
 
-static void prim_rolldownd(JoyContext* ctx) {
+void prim_rolldownd(JoyContext* ctx) {
     /* X Y Z W -> Y Z X W : rolldown under top */
     REQUIRE(4, "rolldownd");
     JoyValue w = POP();
@@ -151,7 +150,7 @@ static void prim_rolldownd(JoyContext* ctx) {
     PUSH(w);
 }
 
-static void prim_rotated(JoyContext* ctx) {
+void prim_rotated(JoyContext* ctx) {
     /* X Y Z W -> Z Y X W : rotate under top */
     REQUIRE(4, "rotated");
     JoyValue w = POP();
@@ -164,12 +163,12 @@ static void prim_rotated(JoyContext* ctx) {
     PUSH(w);
 }
 
-static void prim_id(JoyContext* ctx) {
+void prim_id(JoyContext* ctx) {
     /* Identity function - does nothing */
     (void)ctx;
 }
 
-static void prim_stack(JoyContext* ctx) {
+void prim_stack(JoyContext* ctx) {
     JoyValue list = joy_list_empty();
     for (size_t i = ctx->stack->depth; i > 0; i--) {
         joy_list_push(list.data.list, joy_value_copy(ctx->stack->items[i-1]));
@@ -177,7 +176,7 @@ static void prim_stack(JoyContext* ctx) {
     PUSH(list);
 }
 
-static void prim_unstack(JoyContext* ctx) {
+void prim_unstack(JoyContext* ctx) {
     REQUIRE(1, "unstack");
     JoyValue v = POP();
     joy_stack_clear(ctx->stack);
@@ -197,13 +196,13 @@ static void prim_unstack(JoyContext* ctx) {
 
 /* ---------- Arithmetic Operations ---------- */
 
-static void prim_add(JoyContext* ctx) {
+void prim_add(JoyContext* ctx) {
     REQUIRE(2, "+");
     JoyValue b = POP();
     JoyValue a = POP();
 
     if (a.type == JOY_INTEGER && b.type == JOY_INTEGER) {
-        PUSH(joy_integer(a.data.integer + b.data.integer));
+        PUSH(joy_integer(joy_int_add(a.data.integer, b.data.integer, "+")));
     } else if (a.type == JOY_FLOAT || b.type == JOY_FLOAT) {
         double av = a.type == JOY_FLOAT ? a.data.floating : (double)a.data.integer;
         double bv = b.type == JOY_FLOAT ? b.data.floating : (double)b.data.integer;
@@ -213,13 +212,13 @@ static void prim_add(JoyContext* ctx) {
     }
 }
 
-static void prim_sub(JoyContext* ctx) {
+void prim_sub(JoyContext* ctx) {
     REQUIRE(2, "-");
     JoyValue b = POP();
     JoyValue a = POP();
 
     if (a.type == JOY_INTEGER && b.type == JOY_INTEGER) {
-        PUSH(joy_integer(a.data.integer - b.data.integer));
+        PUSH(joy_integer(joy_int_sub(a.data.integer, b.data.integer, "-")));
     } else if (a.type == JOY_FLOAT || b.type == JOY_FLOAT) {
         double av = a.type == JOY_FLOAT ? a.data.floating : (double)a.data.integer;
         double bv = b.type == JOY_FLOAT ? b.data.floating : (double)b.data.integer;
@@ -229,13 +228,13 @@ static void prim_sub(JoyContext* ctx) {
     }
 }
 
-static void prim_mul(JoyContext* ctx) {
+void prim_mul(JoyContext* ctx) {
     REQUIRE(2, "*");
     JoyValue b = POP();
     JoyValue a = POP();
 
     if (a.type == JOY_INTEGER && b.type == JOY_INTEGER) {
-        PUSH(joy_integer(a.data.integer * b.data.integer));
+        PUSH(joy_integer(joy_int_mul(a.data.integer, b.data.integer, "*")));
     } else if (a.type == JOY_FLOAT || b.type == JOY_FLOAT) {
         double av = a.type == JOY_FLOAT ? a.data.floating : (double)a.data.integer;
         double bv = b.type == JOY_FLOAT ? b.data.floating : (double)b.data.integer;
@@ -245,14 +244,14 @@ static void prim_mul(JoyContext* ctx) {
     }
 }
 
-static void prim_div(JoyContext* ctx) {
+void prim_div(JoyContext* ctx) {
     REQUIRE(2, "/");
     JoyValue b = POP();
     JoyValue a = POP();
 
     if (a.type == JOY_INTEGER && b.type == JOY_INTEGER) {
         if (b.data.integer == 0) joy_error("Division by zero");
-        PUSH(joy_integer(a.data.integer / b.data.integer));
+        PUSH(joy_integer(joy_int_div(a.data.integer, b.data.integer, "/")));
     } else if (a.type == JOY_FLOAT || b.type == JOY_FLOAT) {
         double av = a.type == JOY_FLOAT ? a.data.floating : (double)a.data.integer;
         double bv = b.type == JOY_FLOAT ? b.data.floating : (double)b.data.integer;
@@ -263,17 +262,17 @@ static void prim_div(JoyContext* ctx) {
     }
 }
 
-static void prim_rem(JoyContext* ctx) {
+void prim_rem(JoyContext* ctx) {
     REQUIRE(2, "rem");
     JoyValue b = POP();
     JoyValue a = POP();
     EXPECT_TYPE(a, JOY_INTEGER, "rem");
     EXPECT_TYPE(b, JOY_INTEGER, "rem");
     if (b.data.integer == 0) joy_error("Division by zero");
-    PUSH(joy_integer(a.data.integer % b.data.integer));
+    PUSH(joy_integer(joy_int_rem(a.data.integer, b.data.integer)));
 }
 
-static void prim_divmod(JoyContext* ctx) {
+void prim_divmod(JoyContext* ctx) {
     /* N1 N2 -> Q R : integer division with remainder (quotient then remainder) */
     REQUIRE(2, "div");
     JoyValue b = POP();
@@ -281,29 +280,29 @@ static void prim_divmod(JoyContext* ctx) {
     EXPECT_TYPE(a, JOY_INTEGER, "div");
     EXPECT_TYPE(b, JOY_INTEGER, "div");
     if (b.data.integer == 0) joy_error("Division by zero");
-    PUSH(joy_integer(a.data.integer / b.data.integer));  /* quotient */
-    PUSH(joy_integer(a.data.integer % b.data.integer));  /* remainder */
+    PUSH(joy_integer(joy_int_div(a.data.integer, b.data.integer, "div")));  /* quotient */
+    PUSH(joy_integer(joy_int_rem(a.data.integer, b.data.integer)));  /* remainder */
 }
 
-static void prim_succ(JoyContext* ctx) {
+void prim_succ(JoyContext* ctx) {
     REQUIRE(1, "succ");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_INTEGER, "succ");
-    PUSH(joy_integer(v.data.integer + 1));
+    PUSH(joy_integer(joy_int_add(v.data.integer, 1, "succ")));
 }
 
-static void prim_pred(JoyContext* ctx) {
+void prim_pred(JoyContext* ctx) {
     REQUIRE(1, "pred");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_INTEGER, "pred");
-    PUSH(joy_integer(v.data.integer - 1));
+    PUSH(joy_integer(joy_int_sub(v.data.integer, 1, "pred")));
 }
 
-static void prim_abs(JoyContext* ctx) {
+void prim_abs(JoyContext* ctx) {
     REQUIRE(1, "abs");
     JoyValue v = POP();
     if (v.type == JOY_INTEGER) {
-        PUSH(joy_integer(v.data.integer < 0 ? -v.data.integer : v.data.integer));
+        PUSH(joy_integer(v.data.integer < 0 ? joy_int_sub(0, v.data.integer, "abs") : v.data.integer));
     } else if (v.type == JOY_FLOAT) {
         PUSH(joy_float(fabs(v.data.floating)));
     } else {
@@ -311,11 +310,11 @@ static void prim_abs(JoyContext* ctx) {
     }
 }
 
-static void prim_neg(JoyContext* ctx) {
+void prim_neg(JoyContext* ctx) {
     REQUIRE(1, "neg");
     JoyValue v = POP();
     if (v.type == JOY_INTEGER) {
-        PUSH(joy_integer(-v.data.integer));
+        PUSH(joy_integer(joy_int_sub(0, v.data.integer, "neg")));
     } else if (v.type == JOY_FLOAT) {
         PUSH(joy_float(-v.data.floating));
     } else {
@@ -323,7 +322,7 @@ static void prim_neg(JoyContext* ctx) {
     }
 }
 
-static void prim_sign(JoyContext* ctx) {
+void prim_sign(JoyContext* ctx) {
     REQUIRE(1, "sign");
     JoyValue v = POP();
     if (v.type == JOY_INTEGER) {
@@ -337,7 +336,7 @@ static void prim_sign(JoyContext* ctx) {
     }
 }
 
-static void prim_max(JoyContext* ctx) {
+void prim_max(JoyContext* ctx) {
     REQUIRE(2, "max");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -352,7 +351,7 @@ static void prim_max(JoyContext* ctx) {
     }
 }
 
-static void prim_min(JoyContext* ctx) {
+void prim_min(JoyContext* ctx) {
     REQUIRE(2, "min");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -369,49 +368,49 @@ static void prim_min(JoyContext* ctx) {
 
 /* ---------- Math Functions ---------- */
 
-static void prim_sin(JoyContext* ctx) {
+void prim_sin(JoyContext* ctx) {
     REQUIRE(1, "sin");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(sin(x)));
 }
 
-static void prim_cos(JoyContext* ctx) {
+void prim_cos(JoyContext* ctx) {
     REQUIRE(1, "cos");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(cos(x)));
 }
 
-static void prim_tan(JoyContext* ctx) {
+void prim_tan(JoyContext* ctx) {
     REQUIRE(1, "tan");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(tan(x)));
 }
 
-static void prim_sqrt(JoyContext* ctx) {
+void prim_sqrt(JoyContext* ctx) {
     REQUIRE(1, "sqrt");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(sqrt(x)));
 }
 
-static void prim_exp(JoyContext* ctx) {
+void prim_exp(JoyContext* ctx) {
     REQUIRE(1, "exp");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(exp(x)));
 }
 
-static void prim_log(JoyContext* ctx) {
+void prim_log(JoyContext* ctx) {
     REQUIRE(1, "log");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_float(log(x)));
 }
 
-static void prim_pow(JoyContext* ctx) {
+void prim_pow(JoyContext* ctx) {
     REQUIRE(2, "pow");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -420,21 +419,21 @@ static void prim_pow(JoyContext* ctx) {
     PUSH(joy_float(pow(av, bv)));
 }
 
-static void prim_floor(JoyContext* ctx) {
+void prim_floor(JoyContext* ctx) {
     REQUIRE(1, "floor");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_integer((int64_t)floor(x)));
 }
 
-static void prim_ceil(JoyContext* ctx) {
+void prim_ceil(JoyContext* ctx) {
     REQUIRE(1, "ceil");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
     PUSH(joy_integer((int64_t)ceil(x)));
 }
 
-static void prim_trunc(JoyContext* ctx) {
+void prim_trunc(JoyContext* ctx) {
     REQUIRE(1, "trunc");
     JoyValue v = POP();
     double x = v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
@@ -443,7 +442,7 @@ static void prim_trunc(JoyContext* ctx) {
 
 /* ---------- Comparison Operations ---------- */
 
-static void prim_eq(JoyContext* ctx) {
+void prim_eq(JoyContext* ctx) {
     REQUIRE(2, "=");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -452,7 +451,7 @@ static void prim_eq(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_neq(JoyContext* ctx) {
+void prim_neq(JoyContext* ctx) {
     REQUIRE(2, "!=");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -462,36 +461,36 @@ static void prim_neq(JoyContext* ctx) {
 }
 
 /* Helper to get comparable value (string for string/symbol, numeric otherwise) */
-static bool joy_can_compare(JoyValue a, JoyValue b, double* av, double* bv,
+static bool joy_can_compare(const JoyValue* a, const JoyValue* b, double* av, double* bv,
                             const char** as, const char** bs) {
     *as = NULL; *bs = NULL;
     /* Try numeric comparison first */
-    if (joy_numeric_value(a, av) && joy_numeric_value(b, bv)) {
+    if (joy_numeric_value(*a, av) && joy_numeric_value(*b, bv)) {
         return true;
     }
     /* String/symbol comparison */
-    if (a.type == JOY_STRING) *as = a.data.string;
-    else if (a.type == JOY_SYMBOL) *as = a.data.symbol;
-    if (b.type == JOY_STRING) *bs = b.data.string;
-    else if (b.type == JOY_SYMBOL) *bs = b.data.symbol;
+    if (a->type == JOY_STRING) *as = joy_string_chars(a);
+    else if (a->type == JOY_SYMBOL) *as = a->data.symbol;
+    if (b->type == JOY_STRING) *bs = joy_string_chars(b);
+    else if (b->type == JOY_SYMBOL) *bs = b->data.symbol;
     if (*as && *bs) return true;
     /* File comparison by pointer */
-    if (a.type == JOY_FILE && b.type == JOY_FILE) {
-        *av = (double)(uintptr_t)a.data.file;
-        *bv = (double)(uintptr_t)b.data.file;
+    if (a->type == JOY_FILE && b->type == JOY_FILE) {
+        *av = (double)(uintptr_t)a->data.file;
+        *bv = (double)(uintptr_t)b->data.file;
         return true;
     }
     return false;
 }
 
-static void prim_lt(JoyContext* ctx) {
+void prim_lt(JoyContext* ctx) {
     REQUIRE(2, "<");
     JoyValue b = POP();
     JoyValue a = POP();
     bool result = false;
     double av, bv;
     const char *as, *bs;
-    if (joy_can_compare(a, b, &av, &bv, &as, &bs)) {
+    if (joy_can_compare(&a, &b, &av, &bv, &as, &bs)) {
         if (as && bs) {
             result = strcmp(as, bs) < 0;
         } else {
@@ -503,14 +502,14 @@ static void prim_lt(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_gt(JoyContext* ctx) {
+void prim_gt(JoyContext* ctx) {
     REQUIRE(2, ">");
     JoyValue b = POP();
     JoyValue a = POP();
     bool result = false;
     double av, bv;
     const char *as, *bs;
-    if (joy_can_compare(a, b, &av, &bv, &as, &bs)) {
+    if (joy_can_compare(&a, &b, &av, &bv, &as, &bs)) {
         if (as && bs) {
             result = strcmp(as, bs) > 0;
         } else {
@@ -522,14 +521,14 @@ static void prim_gt(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_le(JoyContext* ctx) {
+void prim_le(JoyContext* ctx) {
     REQUIRE(2, "<=");
     JoyValue b = POP();
     JoyValue a = POP();
     bool result = false;
     double av, bv;
     const char *as, *bs;
-    if (joy_can_compare(a, b, &av, &bv, &as, &bs)) {
+    if (joy_can_compare(&a, &b, &av, &bv, &as, &bs)) {
         if (as && bs) {
             result = strcmp(as, bs) <= 0;
         } else {
@@ -541,14 +540,14 @@ static void prim_le(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_ge(JoyContext* ctx) {
+void prim_ge(JoyContext* ctx) {
     REQUIRE(2, ">=");
     JoyValue b = POP();
     JoyValue a = POP();
     bool result = false;
     double av, bv;
     const char *as, *bs;
-    if (joy_can_compare(a, b, &av, &bv, &as, &bs)) {
+    if (joy_can_compare(&a, &b, &av, &bv, &as, &bs)) {
         if (as && bs) {
             result = strcmp(as, bs) >= 0;
         } else {
@@ -562,14 +561,13 @@ static void prim_ge(JoyContext* ctx) {
 
 /* ---------- Logical Operations ---------- */
 
-static void prim_and(JoyContext* ctx) {
+void prim_and(JoyContext* ctx) {
     REQUIRE(2, "and");
     JoyValue b = POP();
     JoyValue a = POP();
     if (a.type == JOY_SET && b.type == JOY_SET) {
         /* Set intersection */
-        JoyValue result = {.type = JOY_SET, .data.set = a.data.set & b.data.set};
-        PUSH(result);
+        PUSH(joy_set_intersection(&a, &b));
     } else {
         /* Logical conjunction */
         PUSH(joy_boolean(joy_value_truthy(a) && joy_value_truthy(b)));
@@ -578,14 +576,13 @@ static void prim_and(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_or(JoyContext* ctx) {
+void prim_or(JoyContext* ctx) {
     REQUIRE(2, "or");
     JoyValue b = POP();
     JoyValue a = POP();
     if (a.type == JOY_SET && b.type == JOY_SET) {
         /* Set union */
-        JoyValue result = {.type = JOY_SET, .data.set = a.data.set | b.data.set};
-        PUSH(result);
+        PUSH(joy_set_union(&a, &b));
     } else {
         /* Logical disjunction */
         PUSH(joy_boolean(joy_value_truthy(a) || joy_value_truthy(b)));
@@ -594,13 +591,12 @@ static void prim_or(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_not(JoyContext* ctx) {
+void prim_not(JoyContext* ctx) {
     REQUIRE(1, "not");
     JoyValue v = POP();
     if (v.type == JOY_SET) {
         /* Bitwise complement of set */
-        JoyValue result = {.type = JOY_SET, .data.set = ~v.data.set};
-        PUSH(result);
+        PUSH(joy_set_complement(&v));
     } else {
         /* Logical negation */
         PUSH(joy_boolean(!joy_value_truthy(v)));
@@ -608,14 +604,13 @@ static void prim_not(JoyContext* ctx) {
     joy_value_free(&v);
 }
 
-static void prim_xor(JoyContext* ctx) {
+void prim_xor(JoyContext* ctx) {
     REQUIRE(2, "xor");
     JoyValue b = POP();
     JoyValue a = POP();
     if (a.type == JOY_SET && b.type == JOY_SET) {
         /* Set symmetric difference */
-        JoyValue result = {.type = JOY_SET, .data.set = a.data.set ^ b.data.set};
-        PUSH(result);
+        PUSH(joy_set_xor(&a, &b));
     } else {
         /* Logical XOR (a != b for booleans) */
         PUSH(joy_boolean(joy_value_truthy(a) != joy_value_truthy(b)));
@@ -624,7 +619,7 @@ static void prim_xor(JoyContext* ctx) {
     joy_value_free(&b);
 }
 
-static void prim_choice(JoyContext* ctx) {
+void prim_choice(JoyContext* ctx) {
     /* B T F -> X : if B then X=T else X=F */
     REQUIRE(3, "choice");
     JoyValue f = POP();
@@ -643,7 +638,7 @@ static void prim_choice(JoyContext* ctx) {
 
 /* ---------- List/Aggregate Operations ---------- */
 
-static void prim_first(JoyContext* ctx) {
+void prim_first(JoyContext* ctx) {
     REQUIRE(1, "first");
     JoyValue v = POP();
     if (v.type == JOY_LIST) {
@@ -653,15 +648,19 @@ static void prim_first(JoyContext* ctx) {
         if (v.data.quotation->length == 0) joy_error("first of empty quotation");
         PUSH(joy_value_copy(v.data.quotation->terms[0]));
     } else if (v.type == JOY_STRING) {
-        if (v.data.string[0] == '\0') joy_error("first of empty string");
-        PUSH(joy_char(v.data.string[0]));
+        if (joy_string_chars(&v)[0] == '\0') joy_error("first of empty string");
+        PUSH(joy_char(joy_string_chars(&v)[0]));
+    } else if (v.type == JOY_LAZY) {
+        JoyValue item;
+        if (!joy_lazy_next(ctx, &v, &item)) joy_error("first of empty sequence");
+        PUSH(item);
     } else {
         joy_error_type("first", "aggregate", v.type);
     }
     joy_value_free(&v);
 }
 
-static void prim_rest(JoyContext* ctx) {
+void prim_rest(JoyContext* ctx) {
     REQUIRE(1, "rest");
     JoyValue v = POP();
     if (v.type == JOY_LIST) {
@@ -669,21 +668,24 @@ static void prim_rest(JoyContext* ctx) {
         JoyValue result = {.type = JOY_LIST, .data.list = rest};
         PUSH(result);
     } else if (v.type == JOY_QUOTATION) {
-        JoyQuotation* rest = joy_quotation_new(v.data.quotation->length);
-        for (size_t i = 1; i < v.data.quotation->length; i++) {
-            joy_quotation_push(rest, joy_value_copy(v.data.quotation->terms[i]));
-        }
+        JoyQuotation* rest = joy_quotation_rest(v.data.quotation);
         JoyValue result = {.type = JOY_QUOTATION, .data.quotation = rest};
         PUSH(result);
     } else if (v.type == JOY_STRING) {
-        PUSH(joy_string(v.data.string + 1));
+        PUSH(joy_string(joy_string_chars(&v) + 1));
+    } else if (v.type == JOY_LAZY) {
+        JoyValue item;
+        if (!joy_lazy_next(ctx, &v, &item)) joy_error("rest of empty sequence");
+        joy_value_free(&item);
+        PUSH(v);
+        return;
     } else {
         joy_error_type("rest", "aggregate", v.type);
     }
     joy_value_free(&v);
 }
 
-static void prim_cons(JoyContext* ctx) {
+void prim_cons(JoyContext* ctx) {
     REQUIRE(2, "cons");
     JoyValue agg = POP();
     JoyValue item = POP();
@@ -694,45 +696,40 @@ static void prim_cons(JoyContext* ctx) {
         JoyValue v = {.type = JOY_LIST, .data.list = result};
         PUSH(v);
     } else if (agg.type == JOY_QUOTATION) {
-        JoyQuotation* result = joy_quotation_new(agg.data.quotation->length + 1);
-        joy_quotation_push(result, joy_value_copy(item));
-        for (size_t i = 0; i < agg.data.quotation->length; i++) {
-            joy_quotation_push(result, joy_value_copy(agg.data.quotation->terms[i]));
-        }
+        JoyQuotation* result = joy_quotation_cons(item, agg.data.quotation);
         joy_value_free(&item);
         joy_value_free(&agg);
         JoyValue v = {.type = JOY_QUOTATION, .data.quotation = result};
         PUSH(v);
     } else if (agg.type == JOY_SET) {
-        /* cons on set: add element (must be integer 0-63) */
+        /* cons on set: add element (members past 63 widen the set) */
         if (item.type != JOY_INTEGER) {
             joy_value_free(&item);
             joy_value_free(&agg);
             joy_error_type("cons", "INTEGER for set element", item.type);
         }
         int64_t n = item.data.integer;
-        if (n < 0 || n > 63) {
+        if (n < 0 || n >= JOY_SET_LIMIT) {
             joy_value_free(&item);
             joy_value_free(&agg);
-            joy_error("cons: set element must be 0-63");
+            joy_error("cons: set element out of range");
         }
-        uint64_t new_set = agg.data.set | (1ULL << n);
+        JoyValue v = joy_set_insert(&agg, n);
         joy_value_free(&item);
         joy_value_free(&agg);
-        JoyValue v = {.type = JOY_SET, .data.set = new_set};
         PUSH(v);
     } else {
         joy_error_type("cons", "aggregate", agg.type);
     }
 }
 
-static void prim_swons(JoyContext* ctx) {
+void prim_swons(JoyContext* ctx) {
     REQUIRE(2, "swons");
     joy_stack_swap(ctx->stack);
     prim_cons(ctx);
 }
 
-static void prim_uncons(JoyContext* ctx) {
+void prim_uncons(JoyContext* ctx) {
     REQUIRE(1, "uncons");
     JoyValue v = POP();
     if (v.type == JOY_LIST) {
@@ -746,29 +743,29 @@ static void prim_uncons(JoyContext* ctx) {
     } else if (v.type == JOY_QUOTATION) {
         if (v.data.quotation->length == 0) joy_error("uncons of empty quotation");
         JoyValue first = joy_value_copy(v.data.quotation->terms[0]);
-        JoyQuotation* rest = joy_quotation_new(v.data.quotation->length);
-        for (size_t i = 1; i < v.data.quotation->length; i++) {
-            joy_quotation_push(rest, joy_value_copy(v.data.quotation->terms[i]));
-        }
+        JoyQuotation* rest = joy_quotation_rest(v.data.quotation);
         joy_value_free(&v);
         PUSH(first);
         JoyValue rv = {.type = JOY_QUOTATION, .data.quotation = rest};
         PUSH(rv);
+    } else if (v.type == JOY_LAZY) {
+        JoyValue first;
+        if (!joy_lazy_next(ctx, &v, &first)) joy_error("uncons of empty sequence");
+        PUSH(first);
+        PUSH(v);
     } else {
         joy_error_type("uncons", "aggregate", v.type);
     }
 }
 
-static void prim_concat(JoyContext* ctx);
-
-static void prim_swoncat(JoyContext* ctx) {
+void prim_swoncat(JoyContext* ctx) {
     /* swap concat */
     REQUIRE(2, "swoncat");
     joy_stack_swap(ctx->stack);
     prim_concat(ctx);
 }
 
-static void prim_concat(JoyContext* ctx) {
+void prim_concat(JoyContext* ctx) {
     REQUIRE(2, "concat");
     JoyValue b = POP();
     JoyValue a = POP();
@@ -785,34 +782,31 @@ static void prim_concat(JoyContext* ctx) {
         JoyValue v = {.type = JOY_QUOTATION, .data.quotation = result};
         PUSH(v);
     } else if (a.type == JOY_STRING && b.type == JOY_STRING) {
-        size_t len = strlen(a.data.string) + strlen(b.data.string) + 1;
-        char* result = malloc(len);
-        strcpy(result, a.data.string);
-        strcat(result, b.data.string);
-        joy_value_free(&a);
+        /* a is ours alone (strings are copied, never shared), so grow it */
+        joy_string_append(&a, joy_string_chars(&b), joy_string_length(&b));
         joy_value_free(&b);
-        PUSH(joy_string_owned(result));
+        PUSH(a);
     } else {
         joy_error_type("concat", "aggregate", a.type);
     }
 }
 
-static void prim_size(JoyContext* ctx) {
+void prim_size(JoyContext* ctx) {
     REQUIRE(1, "size");
     JoyValue v = POP();
     size_t sz = 0;
     switch (v.type) {
         case JOY_LIST: sz = v.data.list->length; break;
         case JOY_QUOTATION: sz = v.data.quotation->length; break;
-        case JOY_STRING: sz = strlen(v.data.string); break;
-        case JOY_SET: sz = joy_set_size(v.data.set); break;
+        case JOY_STRING: sz = joy_string_length(&v); break;
+        case JOY_SET: sz = joy_set_size(&v); break;
         default: joy_error_type("size", "aggregate", v.type);
     }
     joy_value_free(&v);
     PUSH(joy_integer((int64_t)sz));
 }
 
-static void prim_at(JoyContext* ctx) {
+void prim_at(JoyContext* ctx) {
     /* A I -> X : get element at index I from aggregate A */
     REQUIRE(2, "at");
     JoyValue idx = POP();
@@ -842,11 +836,11 @@ static void prim_at(JoyContext* ctx) {
             PUSH(joy_value_copy(agg.data.quotation->terms[i]));
             break;
         case JOY_STRING:
-            if ((size_t)i >= strlen(agg.data.string)) {
+            if ((size_t)i >= joy_string_length(&agg)) {
                 joy_value_free(&agg);
                 joy_error("at: index out of bounds");
             }
-            PUSH(joy_char(agg.data.string[i]));
+            PUSH(joy_char(joy_string_chars(&agg)[i]));
             break;
         default:
             joy_value_free(&agg);
@@ -855,7 +849,7 @@ static void prim_at(JoyContext* ctx) {
     joy_value_free(&agg);
 }
 
-static void prim_drop(JoyContext* ctx) {
+void prim_drop(JoyContext* ctx) {
     /* A N -> B : drop first N elements from aggregate A */
     REQUIRE(2, "drop");
     JoyValue nv = POP();
@@ -871,51 +865,30 @@ static void prim_drop(JoyContext* ctx) {
 
     switch (agg.type) {
         case JOY_LIST: {
-            size_t start = (size_t)n < agg.data.list->length ? (size_t)n : agg.data.list->length;
-            JoyList* result = joy_list_new(agg.data.list->length - start);
-            for (size_t i = start; i < agg.data.list->length; i++) {
-                joy_list_push(result, joy_value_copy(agg.data.list->items[i]));
-            }
+            JoyList* result = joy_list_drop(agg.data.list, (size_t)n);
             joy_value_free(&agg);
             JoyValue v = {.type = JOY_LIST, .data.list = result};
             PUSH(v);
             break;
         }
         case JOY_QUOTATION: {
-            size_t start = (size_t)n < agg.data.quotation->length ? (size_t)n : agg.data.quotation->length;
-            JoyQuotation* result = joy_quotation_new(agg.data.quotation->length - start);
-            for (size_t i = start; i < agg.data.quotation->length; i++) {
-                joy_quotation_push(result, joy_value_copy(agg.data.quotation->terms[i]));
-            }
+            JoyQuotation* result = joy_quotation_drop(agg.data.quotation, (size_t)n);
             joy_value_free(&agg);
             JoyValue v = {.type = JOY_QUOTATION, .data.quotation = result};
             PUSH(v);
             break;
         }
         case JOY_STRING: {
-            size_t len = strlen(agg.data.string);
+            size_t len = joy_string_length(&agg);
             size_t start = (size_t)n < len ? (size_t)n : len;
-            char* result = strdup(agg.data.string + start);
+            PUSH(joy_string(joy_string_chars(&agg) + start));
             joy_value_free(&agg);
-            PUSH(joy_string(result));
-            free(result);
             break;
         }
         case JOY_SET: {
             /* Drop first N elements from set (in bit order) */
-            uint64_t set = agg.data.set;
-            uint64_t result = 0;
-            int count = 0;
-            for (int i = 0; i < 64; i++) {
-                if (set & (1ULL << i)) {
-                    if (count >= n) {
-                        result |= (1ULL << i);
-                    }
-                    count++;
-                }
-            }
+            JoyValue v = joy_set_range(&agg, (size_t)n, SIZE_MAX);
             joy_value_free(&agg);
-            JoyValue v = {.type = JOY_SET, .data.set = result};
             PUSH(v);
             break;
         }
@@ -925,7 +898,7 @@ static void prim_drop(JoyContext* ctx) {
     }
 }
 
-static void prim_take(JoyContext* ctx) {
+void prim_take(JoyContext* ctx) {
     /* A N -> B : take first N elements from aggregate A */
     REQUIRE(2, "take");
     JoyValue nv = POP();
@@ -941,61 +914,48 @@ static void prim_take(JoyContext* ctx) {
 
     switch (agg.type) {
         case JOY_LIST: {
-            size_t count = (size_t)n < agg.data.list->length ? (size_t)n : agg.data.list->length;
-            JoyList* result = joy_list_new(count);
-            for (size_t i = 0; i < count; i++) {
-                joy_list_push(result, joy_value_copy(agg.data.list->items[i]));
-            }
+            JoyList* result = joy_list_take(agg.data.list, (size_t)n);
             joy_value_free(&agg);
             JoyValue v = {.type = JOY_LIST, .data.list = result};
             PUSH(v);
             break;
         }
         case JOY_QUOTATION: {
-            size_t count = (size_t)n < agg.data.quotation->length ? (size_t)n : agg.data.quotation->length;
-            JoyQuotation* result = joy_quotation_new(count);
-            for (size_t i = 0; i < count; i++) {
-                joy_quotation_push(result, joy_value_copy(agg.data.quotation->terms[i]));
-            }
+            JoyQuotation* result = joy_quotation_take(agg.data.quotation, (size_t)n);
             joy_value_free(&agg);
             JoyValue v = {.type = JOY_QUOTATION, .data.quotation = result};
             PUSH(v);
             break;
         }
         case JOY_STRING: {
-            size_t len = strlen(agg.data.string);
+            size_t len = joy_string_length(&agg);
             size_t count = (size_t)n < len ? (size_t)n : len;
-            char* result = malloc(count + 1);
-            strncpy(result, agg.data.string, count);
+            JoyScratchMark mark = joy_scratch_mark(ctx->allocator);
+            char* result = joy_scratch_alloc(ctx->allocator, count + 1);
+            memcpy(result, joy_string_chars(&agg), count);
             result[count] = '\0';
             joy_value_free(&agg);
             PUSH(joy_string(result));
-            free(result);
+            joy_scratch_release(ctx->allocator, mark);
             break;
         }
         case JOY_SET: {
             /* Take first N elements from set (in bit order) */
-            uint64_t set = agg.data.set;
-            uint64_t result = 0;
-            int count = 0;
-            for (int i = 0; i < 64 && count < n; i++) {
-                if (set & (1ULL << i)) {
-                    result |= (1ULL << i);
-                    count++;
-                }
-            }
+            JoyValue v = joy_set_range(&agg, 0, (size_t)n);
             joy_value_free(&agg);
-            JoyValue v = {.type = JOY_SET, .data.set = result};
             PUSH(v);
             break;
         }
+        case JOY_LAZY:
+            PUSH(joy_lazy_take(agg, n));
+            break;
         default:
             joy_value_free(&agg);
             joy_error_type("take", "aggregate", agg.type);
     }
 }
 
-static void prim_null(JoyContext* ctx) {
+void prim_null(JoyContext* ctx) {
     REQUIRE(1, "null");
     JoyValue v = POP();
     bool is_null = false;
@@ -1005,15 +965,22 @@ static void prim_null(JoyContext* ctx) {
         case JOY_BOOLEAN: is_null = !v.data.boolean; break;
         case JOY_LIST: is_null = v.data.list->length == 0; break;
         case JOY_QUOTATION: is_null = v.data.quotation->length == 0; break;
-        case JOY_STRING: is_null = v.data.string[0] == '\0'; break;
-        case JOY_SET: is_null = v.data.set == 0; break;
+        case JOY_STRING: is_null = joy_string_chars(&v)[0] == '\0'; break;
+        case JOY_SET: is_null = !v.wide_set && v.data.set == 0; break;
+        case JOY_LAZY: {
+            /* Only producing the first element tells */
+            JoyValue item;
+            is_null = !joy_lazy_next(ctx, &v, &item);
+            if (!is_null) joy_value_free(&item);
+            break;
+        }
         default: is_null = false;
     }
     joy_value_free(&v);
     PUSH(joy_boolean(is_null));
 }
 
-static void prim_small(JoyContext* ctx) {
+void prim_small(JoyContext* ctx) {
     REQUIRE(1, "small");
     JoyValue v = POP();
     bool is_small = false;
@@ -1021,8 +988,8 @@ static void prim_small(JoyContext* ctx) {
         case JOY_INTEGER: is_small = v.data.integer <= 1 && v.data.integer >= -1; break;
         case JOY_LIST: is_small = v.data.list->length <= 1; break;
         case JOY_QUOTATION: is_small = v.data.quotation->length <= 1; break;
-        case JOY_STRING: is_small = strlen(v.data.string) <= 1; break;
-        case JOY_SET: is_small = joy_set_size(v.data.set) <= 1; break;
+        case JOY_STRING: is_small = joy_string_length(&v) <= 1; break;
+        case JOY_SET: is_small = joy_set_size(&v) <= 1; break;
         default: is_small = false;
     }
     joy_value_free(&v);
@@ -1031,53 +998,35 @@ static void prim_small(JoyContext* ctx) {
 
 /* ---------- Quotation Combinators ---------- */
 
-static void prim_i(JoyContext* ctx) {
+void prim_i(JoyContext* ctx) {
     REQUIRE(1, "i");
     JoyValue v = POP();
-    if (v.type == JOY_QUOTATION) {
-        joy_execute_quotation(ctx, v.data.quotation);
-    } else if (v.type == JOY_LIST) {
-        /* Treat list as quotation */
-        for (size_t i = 0; i < v.data.list->length; i++) {
-            joy_execute_value(ctx, v.data.list->items[i]);
-        }
-    } else {
+    /* A list runs as a quotation */
+    if (v.type != JOY_QUOTATION && v.type != JOY_LIST) {
         joy_error_type("i", "QUOTATION", v.type);
     }
-    joy_value_free(&v);
+    joy_execute_tail(ctx, v);
 }
 
-static void prim_x(JoyContext* ctx) {
+void prim_x(JoyContext* ctx) {
     /* x == dup i : duplicate quotation, then execute */
     REQUIRE(1, "x");
     JoyValue v = PEEK();
     if (v.type != JOY_QUOTATION && v.type != JOY_LIST) {
         joy_error_type("x", "QUOTATION", v.type);
     }
-    /* Push a copy (dup) */
-    PUSH(joy_value_copy(v));
-    /* Pop and execute (i) */
-    JoyValue q = POP();
-    if (q.type == JOY_QUOTATION) {
-        joy_execute_quotation(ctx, q.data.quotation);
-    } else if (q.type == JOY_LIST) {
-        for (size_t i = 0; i < q.data.list->length; i++) {
-            joy_execute_value(ctx, q.data.list->items[i]);
-        }
-    }
-    joy_value_free(&q);
+    /* Leave the quotation (dup) and run a copy of it (i) */
+    joy_execute_tail(ctx, joy_value_copy(v));
 }
 
-static void prim_dip(JoyContext* ctx) {
+void prim_dip(JoyContext* ctx) {
     REQUIRE(2, "dip");
     JoyValue quot = POP();
     JoyValue saved = POP();
     if (quot.type == JOY_QUOTATION) {
         joy_execute_quotation(ctx, quot.data.quotation);
     } else if (quot.type == JOY_LIST) {
-        for (size_t i = 0; i < quot.data.list->length; i++) {
-            joy_execute_value(ctx, quot.data.list->items[i]);
-        }
+        joy_execute_list(ctx, quot.data.list);
     } else {
         joy_error_type("dip", "QUOTATION", quot.type);
     }
@@ -1085,22 +1034,22 @@ static void prim_dip(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_ifte(JoyContext* ctx) {
+void prim_ifte(JoyContext* ctx) {
     REQUIRE(3, "ifte");
     JoyValue falseBranch = POP();
     JoyValue trueBranch = POP();
     JoyValue condition = POP();
 
     /* Save stack state */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute condition */
     if (condition.type == JOY_QUOTATION) {
         joy_execute_quotation(ctx, condition.data.quotation);
     } else if (condition.type == JOY_LIST) {
-        for (size_t i = 0; i < condition.data.list->length; i++) {
-            joy_execute_value(ctx, condition.data.list->items[i]);
-        }
+        joy_execute_list(ctx, condition.data.list);
     }
 
     /* Get result and restore stack */
@@ -1109,76 +1058,71 @@ static void prim_ifte(JoyContext* ctx) {
     joy_value_free(&result);
 
     /* Restore stack */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
-
-    /* Execute appropriate branch */
-    JoyValue branch = cond_result ? trueBranch : falseBranch;
-    if (branch.type == JOY_QUOTATION) {
-        joy_execute_quotation(ctx, branch.data.quotation);
-    } else if (branch.type == JOY_LIST) {
-        for (size_t i = 0; i < branch.data.list->length; i++) {
-            joy_execute_value(ctx, branch.data.list->items[i]);
-        }
-    }
+    joy_stack_restore(ctx->stack, &saved);
 
+    /* Run the chosen branch as a tail call */
     joy_value_free(&condition);
-    joy_value_free(&trueBranch);
-    joy_value_free(&falseBranch);
+    if (cond_result) {
+        joy_value_free(&falseBranch);
+        joy_execute_tail(ctx, trueBranch);
+    } else {
+        joy_value_free(&trueBranch);
+        joy_execute_tail(ctx, falseBranch);
+    }
 }
 
-static void prim_branch(JoyContext* ctx) {
+void prim_branch(JoyContext* ctx) {
     REQUIRE(3, "branch");
     JoyValue falseBranch = POP();
     JoyValue trueBranch = POP();
     JoyValue cond = POP();
     bool b = joy_value_truthy(cond);
     joy_value_free(&cond);
-    JoyValue branch = b ? trueBranch : falseBranch;
-    if (branch.type == JOY_QUOTATION) {
-        joy_execute_quotation(ctx, branch.data.quotation);
-    } else if (branch.type == JOY_LIST) {
-        for (size_t i = 0; i < branch.data.list->length; i++) {
-            joy_execute_value(ctx, branch.data.list->items[i]);
-        }
+    if (b) {
+        joy_value_free(&falseBranch);
+        joy_execute_tail(ctx, trueBranch);
+    } else {
+        joy_value_free(&trueBranch);
+        joy_execute_tail(ctx, falseBranch);
     }
-    joy_value_free(&trueBranch);
-    joy_value_free(&falseBranch);
 }
 
-static void prim_times(JoyContext* ctx) {
+void prim_times(JoyContext* ctx) {
     REQUIRE(2, "times");
     JoyValue quot = POP();
     JoyValue count = POP();
     EXPECT_TYPE(count, JOY_INTEGER, "times");
-    for (int64_t i = 0; i < count.data.integer; i++) {
+    if (count.data.integer <= 0) {
+        joy_value_free(&quot);
+        return;
+    }
+    for (int64_t i = 1; i < count.data.integer; i++) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
     }
-    joy_value_free(&quot);
+    /* The last run is a tail call */
+    joy_execute_tail(ctx, quot);
 }
 
-static void prim_while(JoyContext* ctx) {
+void prim_while(JoyContext* ctx) {
     REQUIRE(2, "while");
     JoyValue body = POP();
     JoyValue cond = POP();
 
     while (true) {
         /* Save stack for condition test */
-        JoyStack* saved = joy_stack_copy(ctx->stack);
+        JoyCheckpoint saved;
+
+        joy_stack_checkpoint(ctx->stack, &saved);
 
         /* Execute condition */
         if (cond.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, cond.data.quotation);
         } else if (cond.type == JOY_LIST) {
-            for (size_t i = 0; i < cond.data.list->length; i++) {
-                joy_execute_value(ctx, cond.data.list->items[i]);
-            }
+            joy_execute_list(ctx, cond.data.list);
         }
 
         JoyValue result = POP();
@@ -1186,8 +1130,7 @@ static void prim_while(JoyContext* ctx) {
         joy_value_free(&result);
 
         /* Restore stack */
-        joy_stack_free(ctx->stack);
-        ctx->stack = saved;
+        joy_stack_restore(ctx->stack, &saved);
 
         if (!cont) break;
 
@@ -1195,9 +1138,7 @@ static void prim_while(JoyContext* ctx) {
         if (body.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, body.data.quotation);
         } else if (body.type == JOY_LIST) {
-            for (size_t i = 0; i < body.data.list->length; i++) {
-                joy_execute_value(ctx, body.data.list->items[i]);
-            }
+            joy_execute_list(ctx, body.data.list);
         }
     }
 
@@ -1205,11 +1146,23 @@ static void prim_while(JoyContext* ctx) {
     joy_value_free(&body);
 }
 
-static void prim_map(JoyContext* ctx) {
+void prim_map(JoyContext* ctx) {
     REQUIRE(2, "map");
     JoyValue quot = POP();
+
+    JoyNumericOp op;
+    JoyValue operand;
+    if (joy_numeric_quotation(ctx, quot, &op, &operand) && joy_vector_map(ctx, op, operand)) {
+        joy_value_free(&quot);
+        return;
+    }
+
     JoyValue agg = POP();
 
+    if (agg.type == JOY_LAZY) {
+        PUSH(joy_lazy_map(agg, quot));
+        return;
+    }
     if (agg.type != JOY_LIST && agg.type != JOY_QUOTATION) {
         joy_error_type("map", "aggregate", agg.type);
     }
@@ -1224,9 +1177,7 @@ static void prim_map(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
         JoyValue mapped = POP();
         joy_list_push(result, mapped);
@@ -1239,7 +1190,7 @@ static void prim_map(JoyContext* ctx) {
     PUSH(rv);
 }
 
-static void prim_step(JoyContext* ctx) {
+void prim_step(JoyContext* ctx) {
     REQUIRE(2, "step");
     JoyValue quot = POP();
     JoyValue agg = POP();
@@ -1253,6 +1204,17 @@ static void prim_step(JoyContext* ctx) {
     } else if (agg.type == JOY_QUOTATION) {
         len = agg.data.quotation->length;
         items = agg.data.quotation->terms;
+    } else if (agg.type == JOY_LAZY) {
+        /* One element at a time: the sequence is never held whole */
+        JoyValue item;
+        while (joy_lazy_next(ctx, &agg, &item)) {
+            PUSH(item);
+            if (quot.type == JOY_QUOTATION) {
+                joy_execute_quotation(ctx, quot.data.quotation);
+            } else if (quot.type == JOY_LIST) {
+                joy_execute_list(ctx, quot.data.list);
+            }
+        }
     } else {
         joy_error_type("step", "aggregate", agg.type);
     }
@@ -1262,9 +1224,7 @@ static void prim_step(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
     }
 
@@ -1272,9 +1232,18 @@ static void prim_step(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_fold(JoyContext* ctx) {
+void prim_fold(JoyContext* ctx) {
     REQUIRE(3, "fold");
     JoyValue quot = POP();
+
+    JoyNumericOp op;
+    JoyValue operand;
+    if (joy_numeric_quotation(ctx, quot, &op, &operand) && operand.type == JOY_SYMBOL &&
+        joy_vector_fold(ctx, op)) {
+        joy_value_free(&quot);
+        return;
+    }
+
     JoyValue init = POP();
     JoyValue agg = POP();
 
@@ -1298,9 +1267,7 @@ static void prim_fold(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
     }
 
@@ -1308,11 +1275,23 @@ static void prim_fold(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_filter(JoyContext* ctx) {
+void prim_filter(JoyContext* ctx) {
     REQUIRE(2, "filter");
     JoyValue quot = POP();
+
+    JoyNumericOp op;
+    JoyValue operand;
+    if (joy_numeric_quotation(ctx, quot, &op, &operand) && joy_vector_filter(ctx, op, operand)) {
+        joy_value_free(&quot);
+        return;
+    }
+
     JoyValue agg = POP();
 
+    if (agg.type == JOY_LAZY) {
+        PUSH(joy_lazy_filter(agg, quot));
+        return;
+    }
     if (agg.type != JOY_LIST && agg.type != JOY_QUOTATION) {
         joy_error_type("filter", "aggregate", agg.type);
     }
@@ -1328,9 +1307,7 @@ static void prim_filter(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
         JoyValue pred = POP();
         if (joy_value_truthy(pred)) {
@@ -1348,7 +1325,7 @@ static void prim_filter(JoyContext* ctx) {
     PUSH(rv);
 }
 
-static void prim_split(JoyContext* ctx) {
+void prim_split(JoyContext* ctx) {
     /* A [B] -> A1 A2 : split aggregate A into two based on test B */
     REQUIRE(2, "split");
     JoyValue quot = POP();
@@ -1370,9 +1347,7 @@ static void prim_split(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
         JoyValue pred = POP();
         if (joy_value_truthy(pred)) {
@@ -1392,7 +1367,7 @@ static void prim_split(JoyContext* ctx) {
     PUSH(rv2);
 }
 
-static void prim_some(JoyContext* ctx) {
+void prim_some(JoyContext* ctx) {
     /* A [B] -> X : true if B holds for some element of A */
     REQUIRE(2, "some");
     JoyValue quot = POP();
@@ -1411,9 +1386,7 @@ static void prim_some(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
         JoyValue pred = POP();
         if (joy_value_truthy(pred)) {
@@ -1427,7 +1400,7 @@ static void prim_some(JoyContext* ctx) {
     PUSH(joy_boolean(found));
 }
 
-static void prim_all(JoyContext* ctx) {
+void prim_all(JoyContext* ctx) {
     /* A [B] -> X : true if B holds for all elements of A */
     REQUIRE(2, "all");
     JoyValue quot = POP();
@@ -1446,9 +1419,7 @@ static void prim_all(JoyContext* ctx) {
         if (quot.type == JOY_QUOTATION) {
             joy_execute_quotation(ctx, quot.data.quotation);
         } else if (quot.type == JOY_LIST) {
-            for (size_t j = 0; j < quot.data.list->length; j++) {
-                joy_execute_value(ctx, quot.data.list->items[j]);
-            }
+            joy_execute_list(ctx, quot.data.list);
         }
         JoyValue pred = POP();
         if (!joy_value_truthy(pred)) {
@@ -1462,7 +1433,7 @@ static void prim_all(JoyContext* ctx) {
     PUSH(joy_boolean(all_pass));
 }
 
-static void prim_enconcat(JoyContext* ctx) {
+void prim_enconcat(JoyContext* ctx) {
     /* X S T -> U : concatenate S and T with X inserted between */
     /* Equivalent to: swapd cons concat */
     REQUIRE(3, "enconcat");
@@ -1525,17 +1496,10 @@ static void prim_enconcat(JoyContext* ctx) {
             joy_value_free(&x);
             joy_error("enconcat: for strings, X must be char and T must be string");
         }
-        size_t len = strlen(s.data.string) + 1 + strlen(t.data.string) + 1;
-        char* result = malloc(len);
-        strcpy(result, s.data.string);
-        size_t slen = strlen(s.data.string);
-        result[slen] = x.data.character;
-        result[slen + 1] = '\0';
-        strcat(result, t.data.string);
-        joy_value_free(&s);
+        joy_string_append(&s, &x.data.character, 1);
+        joy_string_append(&s, joy_string_chars(&t), joy_string_length(&t));
         joy_value_free(&t);
-        joy_value_free(&x);
-        PUSH(joy_string_owned(result));
+        PUSH(s);
     } else {
         joy_value_free(&s);
         joy_value_free(&t);
@@ -1546,21 +1510,21 @@ static void prim_enconcat(JoyContext* ctx) {
 
 /* ---------- Recursion Combinators ---------- */
 
-static void binrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1, JoyValue* r2);
-
 static void execute_quot(JoyContext* ctx, JoyValue* quot) {
     if (quot->type == JOY_QUOTATION) {
         joy_execute_quotation(ctx, quot->data.quotation);
     } else if (quot->type == JOY_LIST) {
-        for (size_t i = 0; i < quot->data.list->length; i++) {
-            joy_execute_value(ctx, quot->data.list->items[i]);
-        }
+        joy_execute_list(ctx, quot->data.list);
     }
 }
 
-static void binrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1, JoyValue* r2) {
+/* With tail set, the outermost level defers its final T or R2 run */
+static void binrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1, JoyValue* r2,
+                       bool tail) {
     /* Save stack for predicate test */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute predicate */
     execute_quot(ctx, p);
@@ -1569,12 +1533,15 @@ static void binrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1,
     joy_value_free(&test_result);
 
     /* Restore stack */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
 
     if (is_base) {
         /* Base case: execute terminal */
-        execute_quot(ctx, t);
+        if (tail) {
+            joy_execute_tail(ctx, joy_value_copy(*t));
+        } else {
+            execute_quot(ctx, t);
+        }
     } else {
         /* Split into two values */
         execute_quot(ctx, r1);
@@ -1583,29 +1550,33 @@ static void binrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1,
         JoyValue first_arg = POP();
 
         /* Recurse on remaining */
-        binrec_aux(ctx, p, t, r1, r2);
+        binrec_aux(ctx, p, t, r1, r2, false);
         JoyValue first_result = POP();
 
         /* Push first arg and recurse */
         PUSH(first_arg);
-        binrec_aux(ctx, p, t, r1, r2);
+        binrec_aux(ctx, p, t, r1, r2, false);
 
         /* Push first result back */
         PUSH(first_result);
 
         /* Combine */
-        execute_quot(ctx, r2);
+        if (tail) {
+            joy_execute_tail(ctx, joy_value_copy(*r2));
+        } else {
+            execute_quot(ctx, r2);
+        }
     }
 }
 
-static void prim_binrec(JoyContext* ctx) {
+void prim_binrec(JoyContext* ctx) {
     REQUIRE(4, "binrec");
     JoyValue r2 = POP();
     JoyValue r1 = POP();
     JoyValue t = POP();
     JoyValue p = POP();
 
-    binrec_aux(ctx, &p, &t, &r1, &r2);
+    binrec_aux(ctx, &p, &t, &r1, &r2, true);
 
     joy_value_free(&p);
     joy_value_free(&t);
@@ -1613,47 +1584,52 @@ static void prim_binrec(JoyContext* ctx) {
     joy_value_free(&r2);
 }
 
-static void linrec_aux(JoyContext* ctx, JoyValue* p, JoyValue* t, JoyValue* r1, JoyValue* r2) {
-    /* Save stack for predicate test */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
-
-    /* Execute predicate */
-    execute_quot(ctx, p);
-    JoyValue test_result = POP();
-    bool is_base = joy_value_truthy(test_result);
-    joy_value_free(&test_result);
-
-    /* Restore stack */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
-
-    if (is_base) {
-        /* Base case */
-        execute_quot(ctx, t);
-    } else {
-        /* Execute r1, recurse, execute r2 */
-        execute_quot(ctx, r1);
-        linrec_aux(ctx, p, t, r1, r2);
-        execute_quot(ctx, r2);
-    }
-}
-
-static void prim_linrec(JoyContext* ctx) {
+void prim_linrec(JoyContext* ctx) {
     REQUIRE(4, "linrec");
     JoyValue r2 = POP();
     JoyValue r1 = POP();
     JoyValue t = POP();
     JoyValue p = POP();
 
-    linrec_aux(ctx, &p, &t, &r1, &r2);
+    /* Unwind the recursion: run R1 until P holds, then T, then R2 once
+     * per level.  The last of those runs is a tail call. */
+    size_t depth = 0;
+    while (1) {
+        /* Save stack for predicate test */
+        JoyCheckpoint saved;
+
+        joy_stack_checkpoint(ctx->stack, &saved);
+
+        /* Execute predicate */
+        execute_quot(ctx, &p);
+        JoyValue test_result = POP();
+        bool is_base = joy_value_truthy(test_result);
+        joy_value_free(&test_result);
+
+        /* Restore stack */
+        joy_stack_restore(ctx->stack, &saved);
+
+        if (is_base) break;
+        execute_quot(ctx, &r1);
+        depth++;
+    }
 
     joy_value_free(&p);
-    joy_value_free(&t);
     joy_value_free(&r1);
-    joy_value_free(&r2);
+    if (depth == 0) {
+        joy_value_free(&r2);
+        joy_execute_tail(ctx, t);
+        return;
+    }
+    execute_quot(ctx, &t);
+    joy_value_free(&t);
+    while (--depth > 0) {
+        execute_quot(ctx, &r2);
+    }
+    joy_execute_tail(ctx, r2);
 }
 
-static void prim_tailrec(JoyContext* ctx) {
+void prim_tailrec(JoyContext* ctx) {
     REQUIRE(3, "tailrec");
     JoyValue r1 = POP();
     JoyValue t = POP();
@@ -1661,7 +1637,9 @@ static void prim_tailrec(JoyContext* ctx) {
 
     while (1) {
         /* Save stack for predicate test */
-        JoyStack* saved = joy_stack_copy(ctx->stack);
+        JoyCheckpoint saved;
+
+        joy_stack_checkpoint(ctx->stack, &saved);
 
         /* Execute predicate */
         execute_quot(ctx, &p);
@@ -1670,11 +1648,9 @@ static void prim_tailrec(JoyContext* ctx) {
         joy_value_free(&test_result);
 
         /* Restore stack */
-        joy_stack_free(ctx->stack);
-        ctx->stack = saved;
+        joy_stack_restore(ctx->stack, &saved);
 
         if (is_base) {
-            execute_quot(ctx, &t);
             break;
         } else {
             execute_quot(ctx, &r1);
@@ -1682,11 +1658,11 @@ static void prim_tailrec(JoyContext* ctx) {
     }
 
     joy_value_free(&p);
-    joy_value_free(&t);
     joy_value_free(&r1);
+    joy_execute_tail(ctx, t);
 }
 
-static void prim_primrec(JoyContext* ctx) {
+void prim_primrec(JoyContext* ctx) {
     /* X [I] [C] primrec -> execute I for initial value, combine with 1..X using C */
     REQUIRE(3, "primrec");
     JoyValue c = POP();
@@ -1696,26 +1672,28 @@ static void prim_primrec(JoyContext* ctx) {
     /* Execute I to get initial value */
     execute_quot(ctx, &i);
 
+    /* Each combination but the last runs nested; the last is a tail call */
+    size_t runs = 0;
     if (x.type == JOY_INTEGER) {
         /* For integer: combine with 1, 2, ..., X */
         int64_t n = x.data.integer;
         for (int64_t j = 1; j <= n; j++) {
+            if (runs++) execute_quot(ctx, &c);
             PUSH(joy_integer(j));
-            execute_quot(ctx, &c);
         }
     } else if (x.type == JOY_LIST) {
         /* For aggregate: combine with each member */
         JoyList* lst = x.data.list;
         for (size_t j = 0; j < lst->length; j++) {
+            if (runs++) execute_quot(ctx, &c);
             PUSH(joy_value_copy(lst->items[j]));
-            execute_quot(ctx, &c);
         }
     } else if (x.type == JOY_STRING) {
         /* For string: combine with each character */
-        const char* s = x.data.string;
+        const char* s = joy_string_chars(&x);
         while (*s) {
+            if (runs++) execute_quot(ctx, &c);
             PUSH(joy_char(*s));
-            execute_quot(ctx, &c);
             s++;
         }
     } else {
@@ -1724,10 +1702,14 @@ static void prim_primrec(JoyContext* ctx) {
 
     joy_value_free(&x);
     joy_value_free(&i);
-    joy_value_free(&c);
+    if (runs) {
+        joy_execute_tail(ctx, c);
+    } else {
+        joy_value_free(&c);
+    }
 }
 
-static void prim_genrec(JoyContext* ctx) {
+void prim_genrec(JoyContext* ctx) {
     REQUIRE(4, "genrec");
     JoyValue r2 = POP();
     JoyValue r1 = POP();
@@ -1735,7 +1717,9 @@ static void prim_genrec(JoyContext* ctx) {
     JoyValue p = POP();
 
     /* Save stack for predicate test */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute predicate */
     execute_quot(ctx, &p);
@@ -1744,12 +1728,9 @@ static void prim_genrec(JoyContext* ctx) {
     joy_value_free(&test_result);
 
     /* Restore stack */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
 
-    if (is_base) {
-        execute_quot(ctx, &t);
-    } else {
+    if (!is_base) {
         execute_quot(ctx, &r1);
         /* Push the quotation [[P] [T] [R1] [R2] genrec] for recursion */
         JoyQuotation* rec = joy_quotation_new(5);
@@ -1760,70 +1741,81 @@ static void prim_genrec(JoyContext* ctx) {
         joy_quotation_push(rec, joy_symbol("genrec"));
         JoyValue rec_val = {.type = JOY_QUOTATION, .data.quotation = rec};
         PUSH(rec_val);
-        execute_quot(ctx, &r2);
     }
 
+    /* R2 (or T) runs as a tail call, so recursing through i does not nest */
     joy_value_free(&p);
-    joy_value_free(&t);
     joy_value_free(&r1);
-    joy_value_free(&r2);
+    if (is_base) {
+        joy_value_free(&r2);
+        joy_execute_tail(ctx, t);
+    } else {
+        joy_value_free(&t);
+        joy_execute_tail(ctx, r2);
+    }
 }
 
 /* ---------- I/O Operations ---------- */
 
-static void prim_put(JoyContext* ctx) {
+/* Console output collects in the context's buffer (joy_output.c), so it
+ * is flushed before stdio reads or writes the console itself */
+static void joy_stdio_sync(FILE* file) {
+    if (file == stdout || file == stdin) joy_output_flush();
+}
+
+void prim_put(JoyContext* ctx) {
     REQUIRE(1, "put");
     JoyValue v = POP();
     joy_value_print(v);
     joy_value_free(&v);
 }
 
-static void prim_putch(JoyContext* ctx) {
+void prim_putch(JoyContext* ctx) {
     REQUIRE(1, "putch");
     JoyValue v = POP();
     if (v.type == JOY_CHAR) {
-        putchar(v.data.character);
+        joy_output_char(v.data.character);
     } else if (v.type == JOY_INTEGER) {
-        putchar((char)v.data.integer);
+        joy_output_char((char)v.data.integer);
     } else {
         joy_error_type("putch", "CHAR or INTEGER", v.type);
     }
     joy_value_free(&v);
 }
 
-static void prim_putchars(JoyContext* ctx) {
+void prim_putchars(JoyContext* ctx) {
     REQUIRE(1, "putchars");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_STRING, "putchars");
-    printf("%s", v.data.string);
+    joy_output_string(joy_string_chars(&v));
     joy_value_free(&v);
 }
 
-static void prim_newline(JoyContext* ctx) {
+void prim_newline(JoyContext* ctx) {
     (void)ctx;
-    printf("\n");
+    joy_output_char('\n');
 }
 
-static void prim_putln(JoyContext* ctx) {
+void prim_putln(JoyContext* ctx) {
     /* Print top of stack followed by newline */
     REQUIRE(1, "putln");
     JoyValue v = POP();
     joy_value_print(v);
-    printf("\n");
+    joy_output_char('\n');
     joy_value_free(&v);
 }
 
-static void prim_dot(JoyContext* ctx) {
+void prim_dot(JoyContext* ctx) {
     /* Print top of stack with newline, or no-op if stack empty */
     if (ctx->stack->depth > 0) {
         JoyValue v = POP();
         joy_value_print(v);
-        printf("\n");
+        joy_output_char('\n');
         joy_value_free(&v);
     }
 }
 
-static void prim_setecho(JoyContext* ctx) {
+void prim_setecho(JoyContext* ctx) {
     /* I -> : set echo mode (0-3) */
     REQUIRE(1, "setecho");
     JoyValue v = POP();
@@ -1831,16 +1823,17 @@ static void prim_setecho(JoyContext* ctx) {
     ctx->echo = (int)v.data.integer;
 }
 
-static void prim_settracegc(JoyContext* ctx) {
+void prim_settracegc(JoyContext* ctx) {
+    /* I -> : set gc tracing (non-zero: gc reports allocator stats) */
     REQUIRE(1, "__settracegc");
     JoyValue v = POP();
-    joy_value_free(&v);
-    /* No-op: GC tracing not relevant for compiled code */
+    EXPECT_TYPE(v, JOY_INTEGER, "__settracegc");
+    ctx->tracegc = (int)v.data.integer;
 }
 
 /* ---------- Set Operations ---------- */
 
-static void prim_has(JoyContext* ctx) {
+void prim_has(JoyContext* ctx) {
     /* {..} X has -> B : test if X is in set */
     REQUIRE(2, "has");
     JoyValue x = POP();
@@ -1851,20 +1844,14 @@ static void prim_has(JoyContext* ctx) {
         joy_error_type("has", "INTEGER", x.type);
     }
 
-    int64_t elem = x.data.integer;
-    bool result = false;
-    if (elem >= 0 && elem < 64) {
-        result = (s.data.set & (1ULL << elem)) != 0;
-    }
-
-    PUSH(joy_boolean(result));
+    PUSH(joy_boolean(joy_set_member(&s, x.data.integer)));
     joy_value_free(&x);
     joy_value_free(&s);
 }
 
 /* ---------- Advanced Combinators ---------- */
 
-static void prim_cond(JoyContext* ctx) {
+void prim_cond(JoyContext* ctx) {
     /* [[B1 T1] [B2 T2] ... [D]] -> ... */
     REQUIRE(1, "cond");
     JoyValue clauses = POP();
@@ -1889,7 +1876,9 @@ static void prim_cond(JoyContext* ctx) {
     }
 
     /* Save stack for condition testing */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     for (size_t i = 0; i < count; i++) {
         JoyValue clause;
@@ -1922,13 +1911,11 @@ static void prim_cond(JoyContext* ctx) {
         /* Last clause is the default - execute all elements as body */
         bool is_last = (i == count - 1);
         if (is_last) {
-            joy_stack_free(ctx->stack);
-            ctx->stack = joy_stack_copy(saved);
+            joy_stack_restore(ctx->stack, &saved);
             for (size_t j = 0; j < clause_len; j++) {
                 joy_execute_value(ctx, clause_items[j]);
             }
             joy_value_free(&clause);
-            joy_stack_free(saved);
             joy_value_free(&clauses);
             return;
         }
@@ -1937,8 +1924,7 @@ static void prim_cond(JoyContext* ctx) {
         JoyValue condition = clause_items[0];
 
         /* Restore stack and test condition */
-        joy_stack_free(ctx->stack);
-        ctx->stack = joy_stack_copy(saved);
+        joy_stack_rollback(ctx->stack, &saved);
         execute_quot(ctx, &condition);
 
         JoyValue test_result = POP();
@@ -1947,13 +1933,11 @@ static void prim_cond(JoyContext* ctx) {
 
         if (passed) {
             /* Execute body on original stack (condition test is non-destructive) */
-            joy_stack_free(ctx->stack);
-            ctx->stack = joy_stack_copy(saved);
+            joy_stack_restore(ctx->stack, &saved);
             for (size_t j = 1; j < clause_len; j++) {
                 joy_execute_value(ctx, clause_items[j]);
             }
             joy_value_free(&clause);
-            joy_stack_free(saved);
             joy_value_free(&clauses);
             return;
         }
@@ -1962,19 +1946,20 @@ static void prim_cond(JoyContext* ctx) {
     }
 
     /* No clause matched - restore stack */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     joy_value_free(&clauses);
 }
 
-static void prim_infra(JoyContext* ctx) {
+void prim_infra(JoyContext* ctx) {
     /* L [P] -> L' : execute P with L as stack */
     REQUIRE(2, "infra");
     JoyValue quot = POP();
     JoyValue lst = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Replace stack with list/quotation contents (list is TOS-first, stack is bottom-first) */
     joy_stack_clear(ctx->stack);
@@ -1988,7 +1973,7 @@ static void prim_infra(JoyContext* ctx) {
             joy_stack_push(ctx->stack, joy_value_copy(lst.data.quotation->terms[i-1]));
         }
     } else {
-        joy_stack_free(saved);
+        joy_stack_restore(ctx->stack, &saved);
         joy_value_free(&quot);
         joy_value_free(&lst);
         joy_error_type("infra", "LIST or QUOTATION", lst.type);
@@ -2004,8 +1989,7 @@ static void prim_infra(JoyContext* ctx) {
     }
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
 
     JoyValue result_val;
     result_val.type = JOY_LIST;
@@ -2018,13 +2002,15 @@ static void prim_infra(JoyContext* ctx) {
 
 /* ---------- Arity Combinators ---------- */
 
-static void prim_nullary(JoyContext* ctx) {
+void prim_nullary(JoyContext* ctx) {
     /* [P] -> R : execute P, push single result (save/restore stack) */
     REQUIRE(1, "nullary");
     JoyValue quot = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute quotation */
     execute_quot(ctx, &quot);
@@ -2033,21 +2019,22 @@ static void prim_nullary(JoyContext* ctx) {
     JoyValue result = POP();
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(result);
 
     joy_value_free(&quot);
 }
 
-static void prim_unary(JoyContext* ctx) {
+void prim_unary(JoyContext* ctx) {
     /* X [P] -> R : execute P on X, push single result */
     REQUIRE(2, "unary");
     JoyValue quot = POP();
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Clear stack, push X, execute P */
     joy_stack_clear(ctx->stack);
@@ -2058,14 +2045,13 @@ static void prim_unary(JoyContext* ctx) {
     JoyValue result = POP();
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(result);
 
     joy_value_free(&quot);
 }
 
-static void prim_binary(JoyContext* ctx) {
+void prim_binary(JoyContext* ctx) {
     /* X Y [P] -> R : execute P on X Y, push single result */
     REQUIRE(3, "binary");
     JoyValue quot = POP();
@@ -2073,7 +2059,9 @@ static void prim_binary(JoyContext* ctx) {
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Clear stack, push X Y, execute P */
     joy_stack_clear(ctx->stack);
@@ -2085,14 +2073,13 @@ static void prim_binary(JoyContext* ctx) {
     JoyValue result = POP();
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(result);
 
     joy_value_free(&quot);
 }
 
-static void prim_ternary(JoyContext* ctx) {
+void prim_ternary(JoyContext* ctx) {
     /* X Y Z [P] -> R : execute P on X Y Z, push single result */
     REQUIRE(4, "ternary");
     JoyValue quot = POP();
@@ -2101,7 +2088,9 @@ static void prim_ternary(JoyContext* ctx) {
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Clear stack, push X Y Z, execute P */
     joy_stack_clear(ctx->stack);
@@ -2114,14 +2103,13 @@ static void prim_ternary(JoyContext* ctx) {
     JoyValue result = POP();
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(result);
 
     joy_value_free(&quot);
 }
 
-static void prim_unary2(JoyContext* ctx) {
+void prim_unary2(JoyContext* ctx) {
     /* X1 X2 [P] -> R1 R2 : execute P on X1 and X2 separately */
     REQUIRE(3, "unary2");
     JoyValue quot = POP();
@@ -2129,7 +2117,9 @@ static void prim_unary2(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2144,15 +2134,14 @@ static void prim_unary2(JoyContext* ctx) {
     JoyValue r2 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
 
     joy_value_free(&quot);
 }
 
-static void prim_unary3(JoyContext* ctx) {
+void prim_unary3(JoyContext* ctx) {
     /* X1 X2 X3 [P] -> R1 R2 R3 : execute P on three values */
     REQUIRE(4, "unary3");
     JoyValue quot = POP();
@@ -2161,7 +2150,9 @@ static void prim_unary3(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2182,8 +2173,7 @@ static void prim_unary3(JoyContext* ctx) {
     JoyValue r3 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
     PUSH(r3);
@@ -2191,7 +2181,7 @@ static void prim_unary3(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_unary4(JoyContext* ctx) {
+void prim_unary4(JoyContext* ctx) {
     /* X1 X2 X3 X4 [P] -> R1 R2 R3 R4 : execute P on four values */
     REQUIRE(5, "unary4");
     JoyValue quot = POP();
@@ -2201,7 +2191,9 @@ static void prim_unary4(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2228,8 +2220,7 @@ static void prim_unary4(JoyContext* ctx) {
     JoyValue r4 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
     PUSH(r3);
@@ -2238,7 +2229,7 @@ static void prim_unary4(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_cleave(JoyContext* ctx) {
+void prim_cleave(JoyContext* ctx) {
     /* X [P1] [P2] -> R1 R2 : apply two quotations to X */
     REQUIRE(3, "cleave");
     JoyValue quot2 = POP();
@@ -2246,7 +2237,9 @@ static void prim_cleave(JoyContext* ctx) {
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P1 on X */
     joy_stack_clear(ctx->stack);
@@ -2261,8 +2254,7 @@ static void prim_cleave(JoyContext* ctx) {
     JoyValue r2 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
 
@@ -2272,14 +2264,16 @@ static void prim_cleave(JoyContext* ctx) {
 
 /* ---------- Application Combinators ---------- */
 
-static void prim_app1(JoyContext* ctx) {
+void prim_app1(JoyContext* ctx) {
     /* X [P] -> R : apply P to X, return single result */
     REQUIRE(2, "app1");
     JoyValue quot = POP();
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X */
     joy_stack_clear(ctx->stack);
@@ -2288,14 +2282,13 @@ static void prim_app1(JoyContext* ctx) {
     JoyValue r = POP();
 
     /* Restore original stack and push result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r);
 
     joy_value_free(&quot);
 }
 
-static void prim_app11(JoyContext* ctx) {
+void prim_app11(JoyContext* ctx) {
     /* X Y [P] -> Y R : apply P to X, Y unchanged */
     REQUIRE(3, "app11");
     JoyValue quot = POP();
@@ -2303,7 +2296,9 @@ static void prim_app11(JoyContext* ctx) {
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X */
     joy_stack_clear(ctx->stack);
@@ -2312,15 +2307,14 @@ static void prim_app11(JoyContext* ctx) {
     JoyValue r = POP();
 
     /* Restore original stack and push Y then result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(y);
     PUSH(r);
 
     joy_value_free(&quot);
 }
 
-static void prim_app12(JoyContext* ctx) {
+void prim_app12(JoyContext* ctx) {
     /* X Y1 Y2 [P] -> Y1 Y2 R : apply P to X, Y1 Y2 unchanged */
     REQUIRE(4, "app12");
     JoyValue quot = POP();
@@ -2329,7 +2323,9 @@ static void prim_app12(JoyContext* ctx) {
     JoyValue x = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X */
     joy_stack_clear(ctx->stack);
@@ -2338,8 +2334,7 @@ static void prim_app12(JoyContext* ctx) {
     JoyValue r = POP();
 
     /* Restore original stack and push Y1, Y2, then result */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(y1);
     PUSH(y2);
     PUSH(r);
@@ -2347,7 +2342,7 @@ static void prim_app12(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_app2(JoyContext* ctx) {
+void prim_app2(JoyContext* ctx) {
     /* X1 X2 [P] -> R1 R2 : apply P to X1 and X2 separately */
     REQUIRE(3, "app2");
     JoyValue quot = POP();
@@ -2355,7 +2350,9 @@ static void prim_app2(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2370,15 +2367,14 @@ static void prim_app2(JoyContext* ctx) {
     JoyValue r2 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
 
     joy_value_free(&quot);
 }
 
-static void prim_app3(JoyContext* ctx) {
+void prim_app3(JoyContext* ctx) {
     /* X1 X2 X3 [P] -> R1 R2 R3 : apply P to three values */
     REQUIRE(4, "app3");
     JoyValue quot = POP();
@@ -2387,7 +2383,9 @@ static void prim_app3(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2408,8 +2406,7 @@ static void prim_app3(JoyContext* ctx) {
     JoyValue r3 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
     PUSH(r3);
@@ -2417,7 +2414,7 @@ static void prim_app3(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_app4(JoyContext* ctx) {
+void prim_app4(JoyContext* ctx) {
     /* X1 X2 X3 X4 [P] -> R1 R2 R3 R4 : apply P to four values */
     REQUIRE(5, "app4");
     JoyValue quot = POP();
@@ -2427,7 +2424,9 @@ static void prim_app4(JoyContext* ctx) {
     JoyValue x1 = POP();
 
     /* Save current stack */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Execute P on X1 */
     joy_stack_clear(ctx->stack);
@@ -2454,8 +2453,7 @@ static void prim_app4(JoyContext* ctx) {
     JoyValue r4 = POP();
 
     /* Restore original stack and push results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
     PUSH(r1);
     PUSH(r2);
     PUSH(r3);
@@ -2464,7 +2462,7 @@ static void prim_app4(JoyContext* ctx) {
     joy_value_free(&quot);
 }
 
-static void prim_construct(JoyContext* ctx) {
+void prim_construct(JoyContext* ctx) {
     /* [P] [[P1] [P2] ..] -> R1 R2 .. : execute P, then each Pi, collect results */
     REQUIRE(2, "construct");
     JoyValue quots = POP();  /* List of quotations */
@@ -2484,17 +2482,17 @@ static void prim_construct(JoyContext* ctx) {
     JoyValue* items = quots.type == JOY_LIST ? quots.data.list->items : quots.data.quotation->terms;
 
     /* Store results */
-    JoyValue* results = malloc(n * sizeof(JoyValue));
+    JoyScratchMark mark = joy_scratch_mark(ctx->allocator);
+    JoyValue* results = joy_scratch_alloc(ctx->allocator, n * sizeof(JoyValue));
 
     /* Save stack state after P execution */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     for (size_t i = 0; i < n; i++) {
         /* Restore stack to state after P */
-        joy_stack_clear(ctx->stack);
-        for (size_t j = 0; j < saved->depth; j++) {
-            PUSH(joy_value_copy(saved->items[j]));
-        }
+        joy_stack_rollback(ctx->stack, &saved);
 
         /* Execute Pi */
         JoyValue qi = items[i];
@@ -2505,8 +2503,7 @@ static void prim_construct(JoyContext* ctx) {
     }
 
     /* Restore original stack (before construct) and push all results */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
+    joy_stack_restore(ctx->stack, &saved);
 
     /* Clear the saved stack contents and push results */
     joy_stack_clear(ctx->stack);
@@ -2514,14 +2511,14 @@ static void prim_construct(JoyContext* ctx) {
         PUSH(results[i]);
     }
 
-    free(results);
+    joy_scratch_release(ctx->allocator, mark);
     joy_value_free(&p);
     joy_value_free(&quots);
 }
 
 /* ---------- Type Conditionals ---------- */
 
-static void prim_ifinteger(JoyContext* ctx) {
+void prim_ifinteger(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is integer, execute T, else E */
     REQUIRE(3, "ifinteger");
     JoyValue e_quot = POP();
@@ -2538,7 +2535,7 @@ static void prim_ifinteger(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_ifchar(JoyContext* ctx) {
+void prim_ifchar(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is char, execute T, else E */
     REQUIRE(3, "ifchar");
     JoyValue e_quot = POP();
@@ -2555,7 +2552,7 @@ static void prim_ifchar(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_iflogical(JoyContext* ctx) {
+void prim_iflogical(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is boolean, execute T, else E */
     REQUIRE(3, "iflogical");
     JoyValue e_quot = POP();
@@ -2572,7 +2569,7 @@ static void prim_iflogical(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_ifset(JoyContext* ctx) {
+void prim_ifset(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is set, execute T, else E */
     REQUIRE(3, "ifset");
     JoyValue e_quot = POP();
@@ -2589,7 +2586,7 @@ static void prim_ifset(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_ifstring(JoyContext* ctx) {
+void prim_ifstring(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is string, execute T, else E */
     REQUIRE(3, "ifstring");
     JoyValue e_quot = POP();
@@ -2606,7 +2603,7 @@ static void prim_ifstring(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_iflist(JoyContext* ctx) {
+void prim_iflist(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is list or quotation, execute T, else E */
     REQUIRE(3, "iflist");
     JoyValue e_quot = POP();
@@ -2623,7 +2620,7 @@ static void prim_iflist(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_iffloat(JoyContext* ctx) {
+void prim_iffloat(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is float, execute T, else E */
     REQUIRE(3, "iffloat");
     JoyValue e_quot = POP();
@@ -2640,7 +2637,7 @@ static void prim_iffloat(JoyContext* ctx) {
     joy_value_free(&e_quot);
 }
 
-static void prim_iffile(JoyContext* ctx) {
+void prim_iffile(JoyContext* ctx) {
     /* X [T] [E] -> ... : if X is file, execute T, else E */
     REQUIRE(3, "iffile");
     JoyValue e_quot = POP();
@@ -2686,7 +2683,9 @@ static void condnestrecaux(JoyContext* ctx, JoyValue* clauses) {
     if (count == 0) return;
 
     /* Save stack for condition testing */
-    JoyStack* saved = joy_stack_copy(ctx->stack);
+    JoyCheckpoint saved;
+
+    joy_stack_checkpoint(ctx->stack, &saved);
 
     /* Test B for all clauses EXCEPT the last (which is default) */
     bool matched = false;
@@ -2710,8 +2709,7 @@ static void condnestrecaux(JoyContext* ctx, JoyValue* clauses) {
         if (clause_len < 2) continue;
 
         /* Test condition B (first element) */
-        joy_stack_free(ctx->stack);
-        ctx->stack = joy_stack_copy(saved);
+        joy_stack_rollback(ctx->stack, &saved);
         execute_quot(ctx, &clause_items[0]);
 
         JoyValue test_result = POP();
@@ -2725,10 +2723,8 @@ static void condnestrecaux(JoyContext* ctx, JoyValue* clauses) {
         }
     }
 
-    /* Restore stack - ctx->stack now owns the saved memory */
-    joy_stack_free(ctx->stack);
-    ctx->stack = saved;
-    /* Note: don't free saved separately - it's now ctx->stack */
+    /* Restore stack */
+    joy_stack_restore(ctx->stack, &saved);
 
     /* Get the clause to execute */
     JoyValue clause = items[matched_idx];
@@ -2763,14 +2759,14 @@ static void condnestrecaux(JoyContext* ctx, JoyValue* clauses) {
     }
 }
 
-static void prim_condlinrec(JoyContext* ctx) {
+void prim_condlinrec(JoyContext* ctx) {
     REQUIRE(1, "condlinrec");
     JoyValue clauses = POP();
     condnestrecaux(ctx, &clauses);
     joy_value_free(&clauses);
 }
 
-static void prim_condnestrec(JoyContext* ctx) {
+void prim_condnestrec(JoyContext* ctx) {
     REQUIRE(1, "condnestrec");
     JoyValue clauses = POP();
     condnestrecaux(ctx, &clauses);
@@ -2801,7 +2797,7 @@ static void treestep_aux(JoyContext* ctx, JoyValue* t, JoyValue* p) {
     }
 }
 
-static void prim_treestep(JoyContext* ctx) {
+void prim_treestep(JoyContext* ctx) {
     /* T [P] -> ... : step through tree T, applying P to each leaf */
     REQUIRE(2, "treestep");
     JoyValue p = POP();
@@ -2839,7 +2835,7 @@ static JoyValue treerec_aux(JoyContext* ctx, JoyValue* t, JoyValue* o, JoyValue*
     }
 }
 
-static void prim_treerec(JoyContext* ctx) {
+void prim_treerec(JoyContext* ctx) {
     /* T [O] [C] -> ... : tree recursion with O for leaves, C for combining */
     REQUIRE(3, "treerec");
     JoyValue c = POP();
@@ -2884,7 +2880,7 @@ static JoyValue treegenrec_aux(JoyContext* ctx, JoyValue* t, JoyValue* o1, JoyVa
     }
 }
 
-static void prim_treegenrec(JoyContext* ctx) {
+void prim_treegenrec(JoyContext* ctx) {
     /* T [O1] [O2] [C] -> ... : general tree recursion */
     REQUIRE(4, "treegenrec");
     JoyValue c = POP();
@@ -2901,56 +2897,56 @@ static void prim_treegenrec(JoyContext* ctx) {
 
 /* ---------- Type Predicates ---------- */
 
-static void prim_integer(JoyContext* ctx) {
+void prim_integer(JoyContext* ctx) {
     REQUIRE(1, "integer");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_INTEGER));
     joy_value_free(&v);
 }
 
-static void prim_float_p(JoyContext* ctx) {
+void prim_float_p(JoyContext* ctx) {
     REQUIRE(1, "float");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_FLOAT));
     joy_value_free(&v);
 }
 
-static void prim_logical(JoyContext* ctx) {
+void prim_logical(JoyContext* ctx) {
     REQUIRE(1, "logical");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_BOOLEAN));
     joy_value_free(&v);
 }
 
-static void prim_char_p(JoyContext* ctx) {
+void prim_char_p(JoyContext* ctx) {
     REQUIRE(1, "char");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_CHAR));
     joy_value_free(&v);
 }
 
-static void prim_string_p(JoyContext* ctx) {
+void prim_string_p(JoyContext* ctx) {
     REQUIRE(1, "string");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_STRING));
     joy_value_free(&v);
 }
 
-static void prim_list(JoyContext* ctx) {
+void prim_list(JoyContext* ctx) {
     REQUIRE(1, "list");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_LIST || v.type == JOY_QUOTATION));
     joy_value_free(&v);
 }
 
-static void prim_set_p(JoyContext* ctx) {
+void prim_set_p(JoyContext* ctx) {
     REQUIRE(1, "set");
     JoyValue v = POP();
     PUSH(joy_boolean(v.type == JOY_SET));
     joy_value_free(&v);
 }
 
-static void prim_leaf(JoyContext* ctx) {
+void prim_leaf(JoyContext* ctx) {
     /* X -> B : true if X is not an aggregate (not list/quotation/set/string) */
     REQUIRE(1, "leaf");
     JoyValue v = POP();
@@ -2960,7 +2956,7 @@ static void prim_leaf(JoyContext* ctx) {
     joy_value_free(&v);
 }
 
-static void prim_file_p(JoyContext* ctx) {
+void prim_file_p(JoyContext* ctx) {
     /* F -> B : true if F is a file handle */
     REQUIRE(1, "file");
     JoyValue v = POP();
@@ -2968,14 +2964,14 @@ static void prim_file_p(JoyContext* ctx) {
     joy_value_free(&v);
 }
 
-static void prim_user(JoyContext* ctx) {
+void prim_user(JoyContext* ctx) {
     /* X -> B : true if X is a user-defined symbol (not a primitive) */
     REQUIRE(1, "user");
     JoyValue v = POP();
 
     bool result = false;
     if (v.type == JOY_SYMBOL) {
-        JoyWord* word = joy_dict_lookup(ctx->dictionary, v.data.symbol);
+        const JoyWord* word = joy_dict_lookup_symbol(ctx->dictionary, v.data.symbol);
         if (word && word->is_user) {
             result = true;
         }
@@ -2987,14 +2983,14 @@ static void prim_user(JoyContext* ctx) {
 
 /* ---------- Type Conversion ---------- */
 
-static void prim_ord(JoyContext* ctx) {
+void prim_ord(JoyContext* ctx) {
     REQUIRE(1, "ord");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_CHAR, "ord");
     PUSH(joy_integer((int64_t)(unsigned char)v.data.character));
 }
 
-static void prim_chr(JoyContext* ctx) {
+void prim_chr(JoyContext* ctx) {
     REQUIRE(1, "chr");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_INTEGER, "chr");
@@ -3003,51 +2999,51 @@ static void prim_chr(JoyContext* ctx) {
 
 /* ---------- Constants ---------- */
 
-static void prim_true(JoyContext* ctx) {
+void prim_true(JoyContext* ctx) {
     PUSH(joy_boolean(true));
 }
 
-static void prim_false(JoyContext* ctx) {
+void prim_false(JoyContext* ctx) {
     PUSH(joy_boolean(false));
 }
 
-static void prim_maxint(JoyContext* ctx) {
+void prim_maxint(JoyContext* ctx) {
     /* -> I : push maximum integer value */
     PUSH(joy_integer(INT64_MAX));
 }
 
-static void prim_setsize(JoyContext* ctx) {
+void prim_setsize(JoyContext* ctx) {
     /* -> I : push size of sets (64) */
     PUSH(joy_integer(64));
 }
 
 /* ---------- File I/O ---------- */
 
-static void prim_stdin(JoyContext* ctx) {
+void prim_stdin(JoyContext* ctx) {
     /* -> S : push standard input stream */
     PUSH(joy_file(stdin));
 }
 
-static void prim_stdout(JoyContext* ctx) {
+void prim_stdout(JoyContext* ctx) {
     /* -> S : push standard output stream */
     PUSH(joy_file(stdout));
 }
 
-static void prim_stderr(JoyContext* ctx) {
+void prim_stderr(JoyContext* ctx) {
     /* -> S : push standard error stream */
     PUSH(joy_file(stderr));
 }
 
 /* ---------- File I/O Operations ---------- */
 
-static void prim_fopen(JoyContext* ctx) {
+void prim_fopen(JoyContext* ctx) {
     /* P M -> S : open file with path P and mode M */
     REQUIRE(2, "fopen");
     JoyValue mode = POP();
     JoyValue path = POP();
     EXPECT_TYPE(path, JOY_STRING, "fopen");
     EXPECT_TYPE(mode, JOY_STRING, "fopen");
-    FILE* f = fopen(path.data.string, mode.data.string);
+    FILE* f = fopen(joy_string_chars(&path), joy_string_chars(&mode));
     joy_value_free(&path);
     joy_value_free(&mode);
     if (f) {
@@ -3058,7 +3054,7 @@ static void prim_fopen(JoyContext* ctx) {
     }
 }
 
-static void prim_fclose(JoyContext* ctx) {
+void prim_fclose(JoyContext* ctx) {
     /* S -> : close file stream */
     REQUIRE(1, "fclose");
     JoyValue v = POP();
@@ -3070,17 +3066,18 @@ static void prim_fclose(JoyContext* ctx) {
     /* Note: joy_value_free doesn't close files, so we handle it here */
 }
 
-static void prim_fflush(JoyContext* ctx) {
+void prim_fflush(JoyContext* ctx) {
     /* S -> S : flush file stream */
     REQUIRE(1, "fflush");
     JoyValue v = PEEK();
     EXPECT_TYPE(v, JOY_FILE, "fflush");
     if (v.data.file) {
+        joy_stdio_sync(v.data.file);
         fflush(v.data.file);
     }
 }
 
-static void prim_feof(JoyContext* ctx) {
+void prim_feof(JoyContext* ctx) {
     /* S -> S B : test end-of-file */
     REQUIRE(1, "feof");
     JoyValue v = PEEK();
@@ -3089,7 +3086,7 @@ static void prim_feof(JoyContext* ctx) {
     PUSH(joy_boolean(is_eof));
 }
 
-static void prim_ferror(JoyContext* ctx) {
+void prim_ferror(JoyContext* ctx) {
     /* S -> S B : test file error */
     REQUIRE(1, "ferror");
     JoyValue v = PEEK();
@@ -3098,11 +3095,12 @@ static void prim_ferror(JoyContext* ctx) {
     PUSH(joy_boolean(has_error));
 }
 
-static void prim_fgetch(JoyContext* ctx) {
+void prim_fgetch(JoyContext* ctx) {
     /* S -> S C : read character from file */
     REQUIRE(1, "fgetch");
     JoyValue v = PEEK();
     EXPECT_TYPE(v, JOY_FILE, "fgetch");
+    joy_stdio_sync(v.data.file);
     int c = v.data.file ? fgetc(v.data.file) : EOF;
     if (c == EOF) {
         PUSH(joy_integer(-1));
@@ -3111,28 +3109,21 @@ static void prim_fgetch(JoyContext* ctx) {
     }
 }
 
-static void prim_fgets(JoyContext* ctx) {
+void prim_fgets(JoyContext* ctx) {
     /* S -> S L : read line from file as string */
     REQUIRE(1, "fgets");
     JoyValue v = PEEK();
     EXPECT_TYPE(v, JOY_FILE, "fgets");
 
     char buffer[4096];
-    size_t len = 0;
-    if (v.data.file) {
-        int c;
-        while (len < sizeof(buffer) - 1 && (c = fgetc(v.data.file)) != EOF && c != '\n') {
-            buffer[len++] = (char)c;
-        }
-        if (c == '\n' && len < sizeof(buffer) - 1) {
-            buffer[len++] = '\n';
-        }
+    joy_stdio_sync(v.data.file);
+    if (!v.data.file || !fgets(buffer, sizeof(buffer), v.data.file)) {
+        buffer[0] = '\0';
     }
-    buffer[len] = '\0';
     PUSH(joy_string(buffer));
 }
 
-static void prim_fread(JoyContext* ctx) {
+void prim_fread(JoyContext* ctx) {
     /* S I -> S L : read I bytes from file as list of chars */
     REQUIRE(2, "fread");
     JoyValue count = POP();
@@ -3141,21 +3132,31 @@ static void prim_fread(JoyContext* ctx) {
     EXPECT_TYPE(count, JOY_INTEGER, "fread");
 
     size_t n = count.data.integer > 0 ? (size_t)count.data.integer : 0;
-    JoyList* chars = joy_list_new(n);
     joy_value_free(&count);
 
-    if (v.data.file && n > 0) {
-        for (size_t i = 0; i < n; i++) {
-            int c = fgetc(v.data.file);
-            if (c == EOF) break;
-            joy_list_push(chars, joy_char((char)c));
-        }
-    }
+    /* Read in one call into a buffer sized by what is left of a regular
+     * file, so a large count allocates no more than the file holds */
+    FILE* file = v.data.file;
+    joy_stdio_sync(file);
+    struct stat st;
+    long pos = file && n > 0 ? ftell(file) : -1;
+    if (pos >= 0 && fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode)) {
+        size_t left = st.st_size > pos ? (size_t)(st.st_size - pos) : 0;
+        if (left < n) n = left;
+    }
+    JoyScratchMark mark = joy_scratch_mark(ctx->allocator);
+    char* bytes = joy_scratch_alloc(ctx->allocator, n);
+    size_t got = file && n > 0 ? fread(bytes, 1, n, file) : 0;
+    JoyList* chars = joy_list_new(got);
+    for (size_t i = 0; i < got; i++) {
+        joy_list_push(chars, joy_char(bytes[i]));
+    }
+    joy_scratch_release(ctx->allocator, mark);
     JoyValue result = {.type = JOY_LIST, .data.list = chars};
     PUSH(result);
 }
 
-static void prim_fput(JoyContext* ctx) {
+void prim_fput(JoyContext* ctx) {
     /* S X -> S : write X to file */
     REQUIRE(2, "fput");
     JoyValue x = POP();
@@ -3163,6 +3164,7 @@ static void prim_fput(JoyContext* ctx) {
     EXPECT_TYPE(v, JOY_FILE, "fput");
 
     if (v.data.file) {
+        joy_stdio_sync(v.data.file);
         /* Use joy_value_print logic but to file */
         switch (x.type) {
             case JOY_INTEGER:
@@ -3178,7 +3180,7 @@ static void prim_fput(JoyContext* ctx) {
                 fputc(x.data.character, v.data.file);
                 break;
             case JOY_STRING:
-                fprintf(v.data.file, "%s", x.data.string);
+                fprintf(v.data.file, "%s", joy_string_chars(&x));
                 break;
             default:
                 /* For complex types, just indicate type */
@@ -3192,7 +3194,7 @@ static void prim_fput(JoyContext* ctx) {
     joy_value_free(&x);
 }
 
-static void prim_fputch(JoyContext* ctx) {
+void prim_fputch(JoyContext* ctx) {
     /* S C -> S : write character to file */
     REQUIRE(2, "fputch");
     JoyValue c = POP();
@@ -3201,12 +3203,13 @@ static void prim_fputch(JoyContext* ctx) {
     EXPECT_TYPE(c, JOY_CHAR, "fputch");
 
     if (v.data.file) {
+        joy_stdio_sync(v.data.file);
         fputc(c.data.character, v.data.file);
     }
     joy_value_free(&c);
 }
 
-static void prim_fputchars(JoyContext* ctx) {
+void prim_fputchars(JoyContext* ctx) {
     /* S "abc.." -> S : write characters to file */
     REQUIRE(2, "fputchars");
     JoyValue s = POP();
@@ -3215,12 +3218,13 @@ static void prim_fputchars(JoyContext* ctx) {
     EXPECT_TYPE(s, JOY_STRING, "fputchars");
 
     if (v.data.file) {
-        fputs(s.data.string, v.data.file);
+        joy_stdio_sync(v.data.file);
+        fputs(joy_string_chars(&s), v.data.file);
     }
     joy_value_free(&s);
 }
 
-static void prim_fputstring(JoyContext* ctx) {
+void prim_fputstring(JoyContext* ctx) {
     /* S "abc.." -> S : write string to file (same as fputchars) */
     REQUIRE(2, "fputstring");
     JoyValue s = POP();
@@ -3229,12 +3233,13 @@ static void prim_fputstring(JoyContext* ctx) {
     EXPECT_TYPE(s, JOY_STRING, "fputstring");
 
     if (v.data.file) {
-        fputs(s.data.string, v.data.file);
+        joy_stdio_sync(v.data.file);
+        fputs(joy_string_chars(&s), v.data.file);
     }
     joy_value_free(&s);
 }
 
-static void prim_fwrite(JoyContext* ctx) {
+void prim_fwrite(JoyContext* ctx) {
     /* S L -> S : write list L of chars to file */
     REQUIRE(2, "fwrite");
     JoyValue list = POP();
@@ -3242,6 +3247,7 @@ static void prim_fwrite(JoyContext* ctx) {
     EXPECT_TYPE(v, JOY_FILE, "fwrite");
 
     if (list.type == JOY_LIST && v.data.file) {
+        joy_stdio_sync(v.data.file);
         for (size_t i = 0; i < list.data.list->length; i++) {
             JoyValue item = list.data.list->items[i];
             if (item.type == JOY_CHAR) {
@@ -3254,7 +3260,7 @@ static void prim_fwrite(JoyContext* ctx) {
     joy_value_free(&list);
 }
 
-static void prim_fseek(JoyContext* ctx) {
+void prim_fseek(JoyContext* ctx) {
     /* S P W -> S B : seek in file, push success status */
     /* P=position, W=whence: 0=SET, 1=CUR, 2=END */
     /* C fseek returns 0 on success, non-zero on failure */
@@ -3279,7 +3285,7 @@ static void prim_fseek(JoyContext* ctx) {
     PUSH(joy_boolean(result != 0));
 }
 
-static void prim_ftell(JoyContext* ctx) {
+void prim_ftell(JoyContext* ctx) {
     /* S -> S I : get file position */
     REQUIRE(1, "ftell");
     JoyValue v = PEEK();
@@ -3289,18 +3295,18 @@ static void prim_ftell(JoyContext* ctx) {
     PUSH(joy_integer(pos));
 }
 
-static void prim_fremove(JoyContext* ctx) {
+void prim_fremove(JoyContext* ctx) {
     /* P -> B : remove file at path P */
     REQUIRE(1, "fremove");
     JoyValue path = POP();
     EXPECT_TYPE(path, JOY_STRING, "fremove");
 
-    int result = remove(path.data.string);
+    int result = remove(joy_string_chars(&path));
     joy_value_free(&path);
     PUSH(joy_boolean(result == 0));
 }
 
-static void prim_frename(JoyContext* ctx) {
+void prim_frename(JoyContext* ctx) {
     /* P1 P2 -> B : rename file from P1 to P2 */
     REQUIRE(2, "frename");
     JoyValue newpath = POP();
@@ -3308,7 +3314,7 @@ static void prim_frename(JoyContext* ctx) {
     EXPECT_TYPE(oldpath, JOY_STRING, "frename");
     EXPECT_TYPE(newpath, JOY_STRING, "frename");
 
-    int result = rename(oldpath.data.string, newpath.data.string);
+    int result = rename(joy_string_chars(&oldpath), joy_string_chars(&newpath));
     joy_value_free(&oldpath);
     joy_value_free(&newpath);
     PUSH(joy_boolean(result == 0));
@@ -3316,7 +3322,7 @@ static void prim_frename(JoyContext* ctx) {
 
 /* ---------- Additional Math Functions ---------- */
 
-static void prim_acos(JoyContext* ctx) {
+void prim_acos(JoyContext* ctx) {
     /* F -> G : arc cosine */
     REQUIRE(1, "acos");
     JoyValue v = POP();
@@ -3325,7 +3331,7 @@ static void prim_acos(JoyContext* ctx) {
     PUSH(joy_float(acos(x)));
 }
 
-static void prim_asin(JoyContext* ctx) {
+void prim_asin(JoyContext* ctx) {
     /* F -> G : arc sine */
     REQUIRE(1, "asin");
     JoyValue v = POP();
@@ -3334,7 +3340,7 @@ static void prim_asin(JoyContext* ctx) {
     PUSH(joy_float(asin(x)));
 }
 
-static void prim_atan(JoyContext* ctx) {
+void prim_atan(JoyContext* ctx) {
     /* F -> G : arc tangent */
     REQUIRE(1, "atan");
     JoyValue v = POP();
@@ -3343,7 +3349,7 @@ static void prim_atan(JoyContext* ctx) {
     PUSH(joy_float(atan(x)));
 }
 
-static void prim_atan2(JoyContext* ctx) {
+void prim_atan2(JoyContext* ctx) {
     /* F G -> H : two-argument arc tangent */
     REQUIRE(2, "atan2");
     JoyValue vb = POP();  /* TOS */
@@ -3355,7 +3361,7 @@ static void prim_atan2(JoyContext* ctx) {
     PUSH(joy_float(atan2(a, b)));  /* atan2(second, TOS) */
 }
 
-static void prim_cosh(JoyContext* ctx) {
+void prim_cosh(JoyContext* ctx) {
     /* F -> G : hyperbolic cosine */
     REQUIRE(1, "cosh");
     JoyValue v = POP();
@@ -3364,7 +3370,7 @@ static void prim_cosh(JoyContext* ctx) {
     PUSH(joy_float(cosh(x)));
 }
 
-static void prim_sinh(JoyContext* ctx) {
+void prim_sinh(JoyContext* ctx) {
     /* F -> G : hyperbolic sine */
     REQUIRE(1, "sinh");
     JoyValue v = POP();
@@ -3373,7 +3379,7 @@ static void prim_sinh(JoyContext* ctx) {
     PUSH(joy_float(sinh(x)));
 }
 
-static void prim_tanh(JoyContext* ctx) {
+void prim_tanh(JoyContext* ctx) {
     /* F -> G : hyperbolic tangent */
     REQUIRE(1, "tanh");
     JoyValue v = POP();
@@ -3382,7 +3388,7 @@ static void prim_tanh(JoyContext* ctx) {
     PUSH(joy_float(tanh(x)));
 }
 
-static void prim_log10(JoyContext* ctx) {
+void prim_log10(JoyContext* ctx) {
     /* F -> G : base-10 logarithm */
     REQUIRE(1, "log10");
     JoyValue v = POP();
@@ -3393,7 +3399,7 @@ static void prim_log10(JoyContext* ctx) {
 
 /* ---------- String Conversion ---------- */
 
-static void prim_strtol(JoyContext* ctx) {
+void prim_strtol(JoyContext* ctx) {
     /* S I -> J : convert string to integer with base I */
     REQUIRE(2, "strtol");
     JoyValue vbase = POP();
@@ -3402,51 +3408,53 @@ static void prim_strtol(JoyContext* ctx) {
     EXPECT_TYPE(vbase, JOY_INTEGER, "strtol");
 
     char* endptr;
-    long result = strtol(vstr.data.string, &endptr, (int)vbase.data.integer);
+    long result = strtol(joy_string_chars(&vstr), &endptr, (int)vbase.data.integer);
     joy_value_free(&vstr);
     joy_value_free(&vbase);
     PUSH(joy_integer(result));
 }
 
-static void prim_strtod(JoyContext* ctx) {
+void prim_strtod(JoyContext* ctx) {
     /* S -> R : convert string to float */
     REQUIRE(1, "strtod");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_STRING, "strtod");
 
     char* endptr;
-    double result = strtod(v.data.string, &endptr);
+    double result = strtod(joy_string_chars(&v), &endptr);
     joy_value_free(&v);
     PUSH(joy_float(result));
 }
 
 /* ---------- Time and Random ---------- */
 
-static void prim_time(JoyContext* ctx) {
+void prim_time(JoyContext* ctx) {
     /* -> I : push current time as seconds since epoch */
     PUSH(joy_integer((int64_t)time(NULL)));
 }
 
-static void prim_clock(JoyContext* ctx) {
+void prim_clock(JoyContext* ctx) {
     /* -> I : push processor clock ticks */
     PUSH(joy_integer((int64_t)clock()));
 }
 
-static void prim_rand(JoyContext* ctx) {
-    /* -> I : push random integer */
-    PUSH(joy_integer(rand()));
+void prim_rand(JoyContext* ctx) {
+    /* -> I : push random integer in [0, 2^31) from the context's generator
+     * (a 64-bit LCG), not the C library's process-wide rand() state */
+    ctx->rand_state = ctx->rand_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    PUSH(joy_integer((int64_t)(ctx->rand_state >> 33)));
 }
 
-static void prim_srand(JoyContext* ctx) {
+void prim_srand(JoyContext* ctx) {
     /* I -> : seed random number generator */
     REQUIRE(1, "srand");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_INTEGER, "srand");
-    srand((unsigned int)v.data.integer);
+    ctx->rand_state = (uint64_t)v.data.integer;
     joy_value_free(&v);
 }
 
-static void prim_localtime(JoyContext* ctx) {
+void prim_localtime(JoyContext* ctx) {
     /* I -> T : convert time_t to local time [year mon day hour min sec isdst yday wday] */
     REQUIRE(1, "localtime");
     JoyValue v = POP();
@@ -3478,7 +3486,7 @@ static void prim_localtime(JoyContext* ctx) {
     PUSH(rv);
 }
 
-static void prim_gmtime(JoyContext* ctx) {
+void prim_gmtime(JoyContext* ctx) {
     /* I -> T : convert time_t to UTC time [year mon day hour min sec isdst yday wday] */
     REQUIRE(1, "gmtime");
     JoyValue v = POP();
@@ -3510,7 +3518,7 @@ static void prim_gmtime(JoyContext* ctx) {
     PUSH(rv);
 }
 
-static void prim_mktime(JoyContext* ctx) {
+void prim_mktime(JoyContext* ctx) {
     /* T -> I : convert time list [year mon day hour min sec isdst yday wday] to time_t */
     REQUIRE(1, "mktime");
     JoyValue v = POP();
@@ -3521,8 +3529,7 @@ static void prim_mktime(JoyContext* ctx) {
 
     if (v.data.list->length < 9) {
         joy_value_free(&v);
-        fprintf(stderr, "Error: mktime requires list of 9 integers\n");
-        exit(1);
+        joy_error("mktime requires list of 9 integers");
     }
 
     /* Input format: [year mon day hour min sec isdst yday wday] (Python format) */
@@ -3548,7 +3555,7 @@ static void prim_mktime(JoyContext* ctx) {
     PUSH(joy_integer((int64_t)result));
 }
 
-static void prim_strftime(JoyContext* ctx) {
+void prim_strftime(JoyContext* ctx) {
     /* T S1 -> S2 : format time struct with format string */
     REQUIRE(2, "strftime");
     JoyValue fmt = POP();
@@ -3567,8 +3574,7 @@ static void prim_strftime(JoyContext* ctx) {
     if (t.data.list->length < 9) {
         joy_value_free(&t);
         joy_value_free(&fmt);
-        fprintf(stderr, "Error: strftime requires time struct with 9 elements\n");
-        exit(1);
+        joy_error("strftime requires time struct with 9 elements");
     }
 
     /* Input format: [year mon day hour min sec isdst yday wday] (Python format) */
@@ -3589,7 +3595,7 @@ static void prim_strftime(JoyContext* ctx) {
     tm.tm_wday = (int)t.data.list->items[8].data.integer;
 
     char buffer[256];
-    size_t len = strftime(buffer, sizeof(buffer), fmt.data.string, &tm);
+    size_t len = strftime(buffer, sizeof(buffer), joy_string_chars(&fmt), &tm);
 
     joy_value_free(&t);
     joy_value_free(&fmt);
@@ -3601,7 +3607,7 @@ static void prim_strftime(JoyContext* ctx) {
     }
 }
 
-static void prim_format(JoyContext* ctx) {
+void prim_format(JoyContext* ctx) {
     /* N C I J -> S : format integer N with char C, width I, precision J */
     REQUIRE(4, "format");
     JoyValue j = POP();  /* precision */
@@ -3634,7 +3640,7 @@ static void prim_format(JoyContext* ctx) {
     PUSH(joy_string(buffer));
 }
 
-static void prim_formatf(JoyContext* ctx) {
+void prim_formatf(JoyContext* ctx) {
     /* F C I J -> S : format float F with char C, width I, precision J */
     REQUIRE(4, "formatf");
     JoyValue j = POP();  /* precision */
@@ -3679,7 +3685,7 @@ static void prim_formatf(JoyContext* ctx) {
     PUSH(joy_string(buffer));
 }
 
-static void prim_opcase(JoyContext* ctx) {
+void prim_opcase(JoyContext* ctx) {
     /* X [..[X Xs]..] -> [Xs] : case with quotation result */
     REQUIRE(2, "opcase");
     JoyValue cases = POP();
@@ -3744,7 +3750,7 @@ static void prim_opcase(JoyContext* ctx) {
     PUSH(rv);
 }
 
-static void prim_case(JoyContext* ctx) {
+void prim_case(JoyContext* ctx) {
     /* X [..[X Y]..] -> Y i : case with immediate execution */
     REQUIRE(2, "case");
     JoyValue cases = POP();
@@ -3810,7 +3816,7 @@ static void prim_case(JoyContext* ctx) {
     joy_value_free(&cases);
 }
 
-static void prim_frexp(JoyContext* ctx) {
+void prim_frexp(JoyContext* ctx) {
     /* F -> G I : split float into mantissa G and exponent I */
     REQUIRE(1, "frexp");
     JoyValue v = POP();
@@ -3822,7 +3828,7 @@ static void prim_frexp(JoyContext* ctx) {
     PUSH(joy_integer(exp));
 }
 
-static void prim_ldexp(JoyContext* ctx) {
+void prim_ldexp(JoyContext* ctx) {
     /* F I -> G : multiply F by 2^I */
     REQUIRE(2, "ldexp");
     JoyValue vexp = POP();
@@ -3834,7 +3840,7 @@ static void prim_ldexp(JoyContext* ctx) {
     PUSH(joy_float(ldexp(f, (int)vexp.data.integer)));
 }
 
-static void prim_modf(JoyContext* ctx) {
+void prim_modf(JoyContext* ctx) {
     /* F -> G H : split F into integer part G and fractional part H */
     REQUIRE(1, "modf");
     JoyValue v = POP();
@@ -3848,7 +3854,7 @@ static void prim_modf(JoyContext* ctx) {
 
 /* ---------- Additional Aggregate Operations ---------- */
 
-static void prim_unswons(JoyContext* ctx) {
+void prim_unswons(JoyContext* ctx) {
     /* A -> R F : rest and first of aggregate (opposite order of uncons) */
     REQUIRE(1, "unswons");
     JoyValue v = POP();
@@ -3867,10 +3873,7 @@ static void prim_unswons(JoyContext* ctx) {
         case JOY_QUOTATION: {
             if (v.data.quotation->length == 0) joy_error("unswons of empty quotation");
             JoyValue first = joy_value_copy(v.data.quotation->terms[0]);
-            JoyQuotation* rest = joy_quotation_new(v.data.quotation->length);
-            for (size_t i = 1; i < v.data.quotation->length; i++) {
-                joy_quotation_push(rest, joy_value_copy(v.data.quotation->terms[i]));
-            }
+            JoyQuotation* rest = joy_quotation_rest(v.data.quotation);
             joy_value_free(&v);
             JoyValue rv = {.type = JOY_QUOTATION, .data.quotation = rest};
             PUSH(rv);
@@ -3878,27 +3881,19 @@ static void prim_unswons(JoyContext* ctx) {
             break;
         }
         case JOY_STRING: {
-            if (v.data.string[0] == '\0') joy_error("unswons of empty string");
-            char first = v.data.string[0];
-            char* rest = strdup(v.data.string + 1);
+            if (joy_string_chars(&v)[0] == '\0') joy_error("unswons of empty string");
+            char first = joy_string_chars(&v)[0];
+            char* rest = strdup(joy_string_chars(&v) + 1);
             joy_value_free(&v);
             PUSH(joy_string_owned(rest));
             PUSH(joy_char(first));
             break;
         }
         case JOY_SET: {
-            uint64_t set = v.data.set;
-            if (set == 0) joy_error("unswons of empty set");
-            int first = -1;
-            for (int i = 0; i < 64; i++) {
-                if (set & (1ULL << i)) {
-                    first = i;
-                    break;
-                }
-            }
-            uint64_t rest = set & ~(1ULL << first);
+            int64_t first = joy_set_next(&v, 0);
+            if (first < 0) joy_error("unswons of empty set");
+            JoyValue rv = joy_set_remove(&v, first);
             joy_value_free(&v);
-            JoyValue rv = {.type = JOY_SET, .data.set = rest};
             PUSH(rv);
             PUSH(joy_integer(first));
             break;
@@ -3909,7 +3904,7 @@ static void prim_unswons(JoyContext* ctx) {
     }
 }
 
-static void prim_of(JoyContext* ctx) {
+void prim_of(JoyContext* ctx) {
     /* I A -> X : get element at index I from aggregate A (reverse of at) */
     REQUIRE(2, "of");
     JoyValue agg = POP();
@@ -3939,28 +3934,20 @@ static void prim_of(JoyContext* ctx) {
             PUSH(joy_value_copy(agg.data.quotation->terms[i]));
             break;
         case JOY_STRING:
-            if ((size_t)i >= strlen(agg.data.string)) {
+            if ((size_t)i >= joy_string_length(&agg)) {
                 joy_value_free(&agg);
                 joy_error("of: index out of bounds");
             }
-            PUSH(joy_char(agg.data.string[i]));
+            PUSH(joy_char(joy_string_chars(&agg)[i]));
             break;
         case JOY_SET: {
-            uint64_t set = agg.data.set;
-            int count = 0;
-            for (int j = 0; j < 64; j++) {
-                if (set & (1ULL << j)) {
-                    if (count == i) {
-                        joy_value_free(&agg);
-                        PUSH(joy_integer(j));
-                        return;
-                    }
-                    count++;
-                }
-            }
+            JoyValue nth = joy_set_range(&agg, (size_t)i, (size_t)i + 1);
+            int64_t member = joy_set_next(&nth, 0);
+            joy_value_free(&nth);
             joy_value_free(&agg);
-            joy_error("of: index out of bounds");
-            break;
+            if (member < 0) joy_error("of: index out of bounds");
+            PUSH(joy_integer(member));
+            return;
         }
         default:
             joy_value_free(&agg);
@@ -3986,7 +3973,7 @@ static int joy_compare_values(JoyValue a, JoyValue b) {
 
     /* String comparison (lexicographic) */
     if (a.type == JOY_STRING && b.type == JOY_STRING) {
-        int cmp = strcmp(a.data.string, b.data.string);
+        int cmp = strcmp(joy_string_chars(&a), joy_string_chars(&b));
         if (cmp < 0) return -1;
         if (cmp > 0) return 1;
         return 0;
@@ -3994,7 +3981,7 @@ static int joy_compare_values(JoyValue a, JoyValue b) {
 
     /* Symbol comparison */
     if (a.type == JOY_SYMBOL && b.type == JOY_SYMBOL) {
-        return strcmp(a.data.symbol, b.data.symbol) == 0 ? 0 : 1;
+        return a.data.symbol == b.data.symbol ? 0 : 1;
     }
 
     /* File comparison */
@@ -4015,7 +4002,7 @@ static int joy_compare_values(JoyValue a, JoyValue b) {
     return 1;
 }
 
-static void prim_compare(JoyContext* ctx) {
+void prim_compare(JoyContext* ctx) {
     /* A B -> I : compare A and B, return -1, 0, or 1 */
     REQUIRE(2, "compare");
     JoyValue b = POP();
@@ -4026,6 +4013,219 @@ static void prim_compare(JoyContext* ctx) {
     PUSH(joy_integer(result));
 }
 
+/* ---------- Sorting ---------- */
+
+/* sort, sortby and merge order by compare and are stable: an element
+ * moves ahead of an earlier one only if compare puts it strictly below.
+ * Integers compare exactly rather than through double. */
+static inline bool joy_sort_before(const JoyValue* a, const JoyValue* b) {
+    if (a->type == JOY_INTEGER && b->type == JOY_INTEGER) {
+        return a->data.integer < b->data.integer;
+    }
+    return joy_compare_values(*a, *b) < 0;
+}
+
+typedef struct {
+    const JoyValue* key;
+    const JoyValue* item;
+} JoySortEntry;
+
+#define JOY_SORT_RUN 32
+
+/* Merge sort: insertion-sorted runs of JOY_SORT_RUN, then bottom-up
+ * passes through tmp (n entries), skipping pairs already in order */
+static void joy_sort_entries(JoySortEntry* entries, JoySortEntry* tmp, size_t n) {
+    for (size_t lo = 0; lo < n; lo += JOY_SORT_RUN) {
+        size_t hi = lo + JOY_SORT_RUN < n ? lo + JOY_SORT_RUN : n;
+        for (size_t i = lo + 1; i < hi; i++) {
+            JoySortEntry e = entries[i];
+            size_t j = i;
+            while (j > lo && joy_sort_before(e.key, entries[j - 1].key)) {
+                entries[j] = entries[j - 1];
+                j--;
+            }
+            entries[j] = e;
+        }
+    }
+
+    JoySortEntry* src = entries;
+    JoySortEntry* dst = tmp;
+    for (size_t width = JOY_SORT_RUN; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            if (mid == hi || !joy_sort_before(src[mid].key, src[mid - 1].key)) {
+                memcpy(dst + lo, src + lo, (hi - lo) * sizeof *src);
+                continue;
+            }
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                dst[k++] = joy_sort_before(src[j].key, src[i].key) ? src[j++] : src[i++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+        JoySortEntry* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != entries) memcpy(entries, src, n * sizeof *entries);
+}
+
+/* Sort agg (consumed) by the elements, or by the keys quot maps them to
+ * (each computed once, as map would), and push the result.  Strings sort
+ * their characters; sets are already in order. */
+static void joy_sort_aggregate(JoyContext* ctx, const char* op, JoyValue agg, JoyValue* quot) {
+    if (agg.type == JOY_SET) {
+        PUSH(agg);
+        return;
+    }
+
+    JoyScratchMark mark = joy_scratch_mark(ctx->allocator);
+    size_t n = 0;
+    JoyValue* items = NULL;
+    if (agg.type == JOY_STRING) {
+        const char* chars = joy_string_chars(&agg);
+        n = strlen(chars);
+        if (!quot) {
+            /* Characters compare as numbers: count them out */
+            size_t counts[256] = {0};
+            for (size_t i = 0; i < n; i++) counts[(unsigned char)chars[i]]++;
+            char* sorted = joy_scratch_alloc(ctx->allocator, n + 1);
+            size_t k = 0;
+            for (int c = 0; c < 256; c++) {
+                memset(sorted + k, c, counts[c]);
+                k += counts[c];
+            }
+            JoyValue rv = joy_string_span(sorted, n);
+            joy_scratch_release(ctx->allocator, mark);
+            joy_value_free(&agg);
+            PUSH(rv);
+            return;
+        }
+        items = joy_scratch_alloc(ctx->allocator, n * sizeof(JoyValue));
+        for (size_t i = 0; i < n; i++) items[i] = joy_char(chars[i]);
+    } else if (agg.type == JOY_LIST || agg.type == JOY_QUOTATION) {
+        n = agg.type == JOY_LIST ? agg.data.list->length : agg.data.quotation->length;
+        items = agg.type == JOY_LIST ? agg.data.list->items : agg.data.quotation->terms;
+    } else {
+        joy_error_type(op, "aggregate", agg.type);
+    }
+
+    JoySortEntry* entries = joy_scratch_alloc(ctx->allocator, 2 * n * sizeof(JoySortEntry));
+    JoyValue* keys = NULL;
+    if (quot) {
+        keys = joy_scratch_alloc(ctx->allocator, n * sizeof(JoyValue));
+        for (size_t i = 0; i < n; i++) {
+            PUSH(joy_value_copy(items[i]));
+            execute_quot(ctx, quot);
+            keys[i] = POP();
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        entries[i] = (JoySortEntry){keys ? &keys[i] : &items[i], &items[i]};
+    }
+    joy_sort_entries(entries, entries + n, n);
+
+    JoyValue rv;
+    if (agg.type == JOY_STRING) {
+        char* sorted = (char*)(entries + n);
+        for (size_t i = 0; i < n; i++) sorted[i] = entries[i].item->data.character;
+        rv = joy_string_span(sorted, n);
+    } else {
+        JoyList* list = joy_list_new(n > 8 ? n : 8);
+        for (size_t i = 0; i < n; i++) joy_list_push(list, joy_value_copy(*entries[i].item));
+        rv = (JoyValue){.type = JOY_LIST, .data.list = list};
+        if (agg.type == JOY_QUOTATION) {
+            JoyValue quotation = joy_quotation_from(list->items, n);
+            joy_value_free(&rv);
+            rv = quotation;
+        }
+    }
+
+    if (keys) {
+        for (size_t i = 0; i < n; i++) joy_value_free(&keys[i]);
+    }
+    joy_scratch_release(ctx->allocator, mark);
+    joy_value_free(&agg);
+    PUSH(rv);
+}
+
+void prim_sort(JoyContext* ctx) {
+    /* A -> B : A in ascending order (by compare, stable) */
+    REQUIRE(1, "sort");
+    JoyValue agg = POP();
+    joy_sort_aggregate(ctx, "sort", agg, NULL);
+}
+
+void prim_sortby(JoyContext* ctx) {
+    /* A [K] -> B : A in ascending order of the keys K maps its elements to */
+    REQUIRE(2, "sortby");
+    JoyValue quot = POP();
+    JoyValue agg = POP();
+    if (quot.type != JOY_QUOTATION && quot.type != JOY_LIST) {
+        joy_error_type("sortby", "QUOTATION", quot.type);
+    }
+    joy_sort_aggregate(ctx, "sortby", agg, &quot);
+    joy_value_free(&quot);
+}
+
+void prim_merge(JoyContext* ctx) {
+    /* A1 A2 -> A : merge two sorted aggregates, A1's element first on ties */
+    REQUIRE(2, "merge");
+    JoyValue b = POP();
+    JoyValue a = POP();
+
+    JoyValue rv;
+    if (a.type == JOY_SET && b.type == JOY_SET) {
+        rv = joy_set_union(&a, &b);
+    } else if (a.type == JOY_STRING && b.type == JOY_STRING) {
+        const char* x = joy_string_chars(&a);
+        const char* y = joy_string_chars(&b);
+        size_t nx = strlen(x), ny = strlen(y);
+        JoyScratchMark mark = joy_scratch_mark(ctx->allocator);
+        char* merged = joy_scratch_alloc(ctx->allocator, nx + ny + 1);
+        size_t i = 0, j = 0, k = 0;
+        while (i < nx && j < ny) {
+            merged[k++] = (unsigned char)y[j] < (unsigned char)x[i] ? y[j++] : x[i++];
+        }
+        while (i < nx) merged[k++] = x[i++];
+        while (j < ny) merged[k++] = y[j++];
+        rv = joy_string_span(merged, k);
+        joy_scratch_release(ctx->allocator, mark);
+    } else if ((a.type == JOY_LIST || a.type == JOY_QUOTATION) &&
+               (b.type == JOY_LIST || b.type == JOY_QUOTATION)) {
+        size_t nx = a.type == JOY_LIST ? a.data.list->length : a.data.quotation->length;
+        JoyValue* x = a.type == JOY_LIST ? a.data.list->items : a.data.quotation->terms;
+        size_t ny = b.type == JOY_LIST ? b.data.list->length : b.data.quotation->length;
+        JoyValue* y = b.type == JOY_LIST ? b.data.list->items : b.data.quotation->terms;
+        JoyList* list = joy_list_new(nx + ny > 8 ? nx + ny : 8);
+        size_t i = 0, j = 0;
+        while (i < nx && j < ny) {
+            const JoyValue* next = joy_sort_before(&y[j], &x[i]) ? &y[j++] : &x[i++];
+            joy_list_push(list, joy_value_copy(*next));
+        }
+        while (i < nx) joy_list_push(list, joy_value_copy(x[i++]));
+        while (j < ny) joy_list_push(list, joy_value_copy(y[j++]));
+        rv = (JoyValue){.type = JOY_LIST, .data.list = list};
+        if (a.type == JOY_QUOTATION) {
+            JoyValue quotation = joy_quotation_from(list->items, list->length);
+            joy_value_free(&rv);
+            rv = quotation;
+        }
+    } else {
+        JoyType bad = a.type == JOY_LIST || a.type == JOY_QUOTATION || a.type == JOY_STRING ||
+                              a.type == JOY_SET ? b.type : a.type;
+        joy_value_free(&a);
+        joy_value_free(&b);
+        joy_error_type("merge", "two aggregates of one kind", bad);
+    }
+
+    joy_value_free(&a);
+    joy_value_free(&b);
+    PUSH(rv);
+}
+
 /* Helper to get aggregate length (works for LIST and QUOTATION) */
 static size_t joy_aggregate_length(JoyValue v) {
     if (v.type == JOY_LIST) return v.data.list->length;
@@ -4054,11 +4254,11 @@ static bool joy_equal_values(JoyValue a, JoyValue b) {
             case JOY_CHAR:
                 return a.data.character == b.data.character;
             case JOY_STRING:
-                return strcmp(a.data.string, b.data.string) == 0;
+                return strcmp(joy_string_chars(&a), joy_string_chars(&b)) == 0;
             case JOY_SET:
-                return a.data.set == b.data.set;
+                return joy_set_equal(&a, &b);
             case JOY_SYMBOL:
-                return strcmp(a.data.symbol, b.data.symbol) == 0;
+                return a.data.symbol == b.data.symbol;
             case JOY_LIST:
                 if (a.data.list->length != b.data.list->length) return false;
                 for (size_t i = 0; i < a.data.list->length; i++) {
@@ -4099,15 +4299,15 @@ static bool joy_equal_values(JoyValue a, JoyValue b) {
 
     /* Symbol comparison */
     if (a.type == JOY_SYMBOL && b.type == JOY_SYMBOL) {
-        return strcmp(a.data.symbol, b.data.symbol) == 0;
+        return a.data.symbol == b.data.symbol;
     }
 
     /* Symbol-String comparison: symbol "foo" equals string "foo" */
     if (a.type == JOY_SYMBOL && b.type == JOY_STRING) {
-        return strcmp(a.data.symbol, b.data.string) == 0;
+        return strcmp(a.data.symbol, joy_string_chars(&b)) == 0;
     }
     if (a.type == JOY_STRING && b.type == JOY_SYMBOL) {
-        return strcmp(a.data.string, b.data.symbol) == 0;
+        return strcmp(joy_string_chars(&a), b.data.symbol) == 0;
     }
 
     /* Numeric types can be compared across types using joy_numeric_value */
@@ -4119,7 +4319,7 @@ static bool joy_equal_values(JoyValue a, JoyValue b) {
     return false;
 }
 
-static void prim_equal(JoyContext* ctx) {
+void prim_equal(JoyContext* ctx) {
     /* T U -> B : test if T and U are structurally equal */
     REQUIRE(2, "equal");
     JoyValue b = POP();
@@ -4130,7 +4330,7 @@ static void prim_equal(JoyContext* ctx) {
     PUSH(joy_boolean(result));
 }
 
-static void prim_in(JoyContext* ctx) {
+void prim_in(JoyContext* ctx) {
     /* X A -> B : test if X is a member of aggregate A */
     REQUIRE(2, "in");
     JoyValue agg = POP();
@@ -4156,17 +4356,14 @@ static void prim_in(JoyContext* ctx) {
             break;
         case JOY_STRING:
             if (x.type == JOY_CHAR) {
-                found = strchr(agg.data.string, x.data.character) != NULL;
+                found = strchr(joy_string_chars(&agg), x.data.character) != NULL;
             } else if (x.type == JOY_STRING) {
-                found = strstr(agg.data.string, x.data.string) != NULL;
+                found = strstr(joy_string_chars(&agg), joy_string_chars(&x)) != NULL;
             }
             break;
         case JOY_SET:
             if (x.type == JOY_INTEGER) {
-                int64_t n = x.data.integer;
-                if (n >= 0 && n < 64) {
-                    found = (agg.data.set & (1ULL << n)) != 0;
-                }
+                found = joy_set_member(&agg, x.data.integer);
             }
             break;
         default:
@@ -4180,7 +4377,7 @@ static void prim_in(JoyContext* ctx) {
     PUSH(joy_boolean(found));
 }
 
-static void prim_name(JoyContext* ctx) {
+void prim_name(JoyContext* ctx) {
     /* sym -> "sym" : convert symbol to its name string, or type name for non-symbols */
     REQUIRE(1, "name");
     JoyValue v = POP();
@@ -4234,23 +4431,23 @@ static void prim_name(JoyContext* ctx) {
     }
 }
 
-static void prim_intern(JoyContext* ctx) {
+void prim_intern(JoyContext* ctx) {
     /* "sym" -> sym : convert string to symbol */
     REQUIRE(1, "intern");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_STRING, "intern");
-    PUSH(joy_symbol(v.data.string));
+    PUSH(joy_symbol(joy_string_chars(&v)));
     joy_value_free(&v);
 }
 
-static void prim_body(JoyContext* ctx) {
+void prim_body(JoyContext* ctx) {
     /* U -> [P] : get body of user-defined symbol */
     REQUIRE(1, "body");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_SYMBOL, "body");
 
     /* Look up the symbol in the dictionary */
-    JoyWord* word = joy_dict_lookup(ctx->dictionary, v.data.symbol);
+    const JoyWord* word = joy_dict_lookup_symbol(ctx->dictionary, v.data.symbol);
     if (!word) {
         joy_value_free(&v);
         joy_error("body: undefined symbol");
@@ -4273,7 +4470,7 @@ static void prim_body(JoyContext* ctx) {
 
 /* ---------- Type Casting ---------- */
 
-static void prim_casting(JoyContext* ctx) {
+void prim_casting(JoyContext* ctx) {
     /* X T -> Y : cast value X to type T
      * Joy42 type codes (matching typeof):
      * 4 = BOOLEAN, 5 = CHAR, 6 = INTEGER, 7 = SET,
@@ -4295,8 +4492,8 @@ static void prim_casting(JoyContext* ctx) {
                 case JOY_INTEGER: result = x.data.integer != 0; break;
                 case JOY_FLOAT: result = x.data.floating != 0.0; break;
                 case JOY_CHAR: result = x.data.character != 0; break;
-                case JOY_STRING: result = x.data.string && strlen(x.data.string) > 0; break;
-                case JOY_SET: result = x.data.set != 0; break;
+                case JOY_STRING: result = joy_string_chars(&x) && joy_string_length(&x) > 0; break;
+                case JOY_SET: result = joy_value_truthy(x); break;
                 case JOY_LIST:
                 case JOY_QUOTATION: result = x.data.list && x.data.list->length > 0; break;
                 case JOY_FILE: result = x.data.file != NULL; break;
@@ -4312,8 +4509,8 @@ static void prim_casting(JoyContext* ctx) {
                 ch = x.data.character;
             } else if (x.type == JOY_INTEGER) {
                 ch = (char)(x.data.integer & 0xFF);
-            } else if (x.type == JOY_STRING && x.data.string && strlen(x.data.string) > 0) {
-                ch = x.data.string[0];
+            } else if (x.type == JOY_STRING && joy_string_chars(&x) && joy_string_length(&x) > 0) {
+                ch = joy_string_chars(&x)[0];
             }
             joy_value_free(&x);
             PUSH(joy_char(ch));
@@ -4326,7 +4523,11 @@ static void prim_casting(JoyContext* ctx) {
                 case JOY_CHAR: val = (unsigned char)x.data.character; break;
                 case JOY_FLOAT: val = (int64_t)x.data.floating; break;
                 case JOY_BOOLEAN: val = x.data.boolean ? 1 : 0; break;
-                case JOY_SET: val = (int64_t)x.data.set; break;
+                case JOY_SET: {
+                    size_t words;
+                    val = (int64_t)joy_set_words(&x, &words)[0];
+                    break;
+                }
                 default: break;
             }
             joy_value_free(&x);
@@ -4336,14 +4537,13 @@ static void prim_casting(JoyContext* ctx) {
         case 7: { /* SET */
             uint64_t set_val = 0;
             if (x.type == JOY_SET) {
-                set_val = x.data.set;
+                PUSH(x);  /* Already a set, just push back */
+                return;
             } else if (x.type == JOY_INTEGER) {
                 set_val = (uint64_t)x.data.integer;
             }
             joy_value_free(&x);
-            JoyValue set_result;
-            set_result.type = JOY_SET;
-            set_result.data.set = set_val;
+            JoyValue set_result = {.type = JOY_SET, .data.set = set_val};
             PUSH(set_result);
             break;
         }
@@ -4376,10 +4576,10 @@ static void prim_casting(JoyContext* ctx) {
                 return;
             } else if (x.type == JOY_STRING) {
                 /* Convert string to list of chars */
-                size_t len = x.data.string ? strlen(x.data.string) : 0;
+                size_t len = joy_string_chars(&x) ? joy_string_length(&x) : 0;
                 JoyList* list = joy_list_new(len);
                 for (size_t i = 0; i < len; i++) {
-                    joy_list_push(list, joy_char(x.data.string[i]));
+                    joy_list_push(list, joy_char(joy_string_chars(&x)[i]));
                 }
                 joy_value_free(&x);
                 JoyValue list_result;
@@ -4431,22 +4631,24 @@ static void prim_casting(JoyContext* ctx) {
 
 /* ---------- System Interaction ---------- */
 
-static void prim_system(JoyContext* ctx) {
+void prim_system(JoyContext* ctx) {
     /* "command" -> : execute shell command */
     REQUIRE(1, "system");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_STRING, "system");
-    int result = system(v.data.string);
+    joy_output_flush();
+    fflush(stdout);
+    int result = system(joy_string_chars(&v));
     joy_value_free(&v);
     PUSH(joy_integer(result));
 }
 
-static void prim_getenv(JoyContext* ctx) {
+void prim_getenv(JoyContext* ctx) {
     /* "variable" -> "value" : get environment variable */
     REQUIRE(1, "getenv");
     JoyValue v = POP();
     EXPECT_TYPE(v, JOY_STRING, "getenv");
-    char* value = getenv(v.data.string);
+    char* value = getenv(joy_string_chars(&v));
     joy_value_free(&v);
     if (value) {
         PUSH(joy_string(value));
@@ -4455,16 +4657,16 @@ static void prim_getenv(JoyContext* ctx) {
     }
 }
 
-static void prim_argc(JoyContext* ctx) {
+void prim_argc(JoyContext* ctx) {
     /* -> I : push argument count */
-    PUSH(joy_integer(joy_argc));
+    PUSH(joy_integer(ctx->argc));
 }
 
-static void prim_argv(JoyContext* ctx) {
+void prim_argv(JoyContext* ctx) {
     /* -> A : push command line arguments as list */
-    JoyList* list = joy_list_new(joy_argc > 0 ? (size_t)joy_argc : 1);
-    for (int i = 0; i < joy_argc; i++) {
-        joy_list_push(list, joy_string(joy_argv[i]));
+    JoyList* list = joy_list_new(ctx->argc > 0 ? (size_t)ctx->argc : 1);
+    for (int i = 0; i < ctx->argc; i++) {
+        joy_list_push(list, joy_string(ctx->argv[i]));
     }
     JoyValue v = {.type = JOY_LIST, .data.list = list};
     PUSH(v);
@@ -4472,24 +4674,58 @@ static void prim_argv(JoyContext* ctx) {
 
 /* ---------- Interpreter Control ---------- */
 
-static void prim_abort(JoyContext* ctx) {
+void prim_abort(JoyContext* ctx) {
     /* -> : abort execution with error status */
     (void)ctx;  /* unused */
-    exit(1);
+    joy_exit(1);
 }
 
-static void prim_quit(JoyContext* ctx) {
+void prim_quit(JoyContext* ctx) {
     /* -> : quit interpreter with success status */
     (void)ctx;  /* unused */
-    exit(0);
-}
-
-static void prim_gc(JoyContext* ctx) {
-    /* -> : force garbage collection (no-op in compiled code) */
-    (void)ctx;  /* no GC in compiled C code - memory is managed manually */
-}
-
-static void prim_setautoput(JoyContext* ctx) {
+    joy_exit(0);
+}
+
+void prim_gc(JoyContext* ctx) {
+    /* -> : release spare allocator memory; report stats if __settracegc is on */
+    joy_allocator_trim(ctx->allocator);
+    if (ctx->tracegc) {
+        JoyAllocStats st = joy_allocator_stats(ctx->allocator);
+        fprintf(stderr, "gc: %zu slab allocs, %zu frees, %zu bytes live (peak %zu), "
+                "%zu blocks, %zu large allocs, scratch peak %zu bytes\n",
+                st.slab_allocs, st.slab_frees, st.slab_bytes, st.slab_peak,
+                st.blocks, st.large_allocs, st.scratch_peak);
+    }
+}
+
+static JoyValue joy_memstat(const char* name, size_t value) {
+    JoyValue pair[2] = {joy_symbol(name), joy_integer((int64_t)value)};
+    return joy_list_from(pair, 2);
+}
+
+void prim_memstats(JoyContext* ctx) {
+    /* -> L : [[live N] [peak N] [allocated N] [allocations N] [limit N]
+     * [lists N] [quotations N] [strings N] [sets N] [lazy N]], in bytes
+     * and counts for this context */
+    JoyAllocStats st = joy_allocator_stats(ctx->allocator);
+    JoyValue stats[] = {
+        joy_memstat("live", st.bytes_live),
+        joy_memstat("peak", st.bytes_peak),
+        joy_memstat("allocated", st.bytes_allocated),
+        joy_memstat("allocations", st.slab_allocs + st.large_allocs),
+        joy_memstat("limit", st.limit),
+        joy_memstat("lists", st.values[JOY_LIST]),
+        joy_memstat("quotations", st.values[JOY_QUOTATION]),
+        joy_memstat("strings", st.values[JOY_STRING]),
+        joy_memstat("sets", st.values[JOY_SET]),
+        joy_memstat("lazy", st.values[JOY_LAZY]),
+    };
+    size_t count = sizeof stats / sizeof stats[0];
+    PUSH(joy_list_from(stats, count));
+    for (size_t i = 0; i < count; i++) joy_value_free(&stats[i]);
+}
+
+void prim_setautoput(JoyContext* ctx) {
     /* I -> : set autoput flag (0=off, 1=on) */
     REQUIRE(1, "setautoput");
     JoyValue v = POP();
@@ -4498,7 +4734,7 @@ static void prim_setautoput(JoyContext* ctx) {
     joy_value_free(&v);
 }
 
-static void prim_setundeferror(JoyContext* ctx) {
+void prim_setundeferror(JoyContext* ctx) {
     /* I -> : set undeferror flag (0=off, 1=on) */
     REQUIRE(1, "setundeferror");
     JoyValue v = POP();
@@ -4507,29 +4743,29 @@ static void prim_setundeferror(JoyContext* ctx) {
     joy_value_free(&v);
 }
 
-static void prim_autoput(JoyContext* ctx) {
+void prim_autoput(JoyContext* ctx) {
     /* -> I : push autoput flag value */
     PUSH(joy_integer(ctx->autoput));
 }
 
-static void prim_undeferror(JoyContext* ctx) {
+void prim_undeferror(JoyContext* ctx) {
     /* -> I : push undeferror flag value */
     PUSH(joy_integer(ctx->undeferror));
 }
 
-static void prim_echo(JoyContext* ctx) {
+void prim_echo(JoyContext* ctx) {
     /* -> I : push echo flag value (0..3) */
     PUSH(joy_integer(ctx->echo));
 }
 
-static void prim_conts(JoyContext* ctx) {
+void prim_conts(JoyContext* ctx) {
     /* -> [[P] [Q] ..] : push continuation stack (empty in compiled code) */
     /* In compiled code, there's no continuation stack - execution is direct */
     JoyValue empty = {.type = JOY_LIST, .data.list = joy_list_new(0)};
     PUSH(empty);
 }
 
-static void prim_undefs(JoyContext* ctx) {
+void prim_undefs(JoyContext* ctx) {
     /* -> [S1 S2 ..] : push list of undefined symbols (empty in compiled code) */
     /* In compiled code, all symbols are resolved at compile time */
     (void)ctx;
@@ -4537,35 +4773,35 @@ static void prim_undefs(JoyContext* ctx) {
     PUSH(empty);
 }
 
-static void prim_help(JoyContext* ctx) {
+void prim_help(JoyContext* ctx) {
     /* -> : list defined symbols and primitives */
     (void)ctx;
-    printf("Joy - compiled program\n");
-    printf("Use 'manual' for full documentation.\n");
-    printf("Help system has limited functionality in compiled code.\n");
+    joy_output_string("Joy - compiled program\n"
+                      "Use 'manual' for full documentation.\n"
+                      "Help system has limited functionality in compiled code.\n");
 }
 
-static void prim_helpdetail(JoyContext* ctx) {
+void prim_helpdetail(JoyContext* ctx) {
     /* [S1 S2 ..] -> : give brief help on symbols */
     REQUIRE(1, "helpdetail");
     JoyValue symbols = POP();
-    printf("helpdetail: limited functionality in compiled code\n");
+    joy_output_string("helpdetail: limited functionality in compiled code\n");
     joy_value_free(&symbols);
 }
 
-static void prim_manual(JoyContext* ctx) {
+void prim_manual(JoyContext* ctx) {
     /* -> : print manual of all primitives */
     (void)ctx;
-    printf("Joy Language Manual\n");
-    printf("===================\n\n");
-    printf("This is a compiled Joy program.\n");
-    printf("For full documentation, see the Joy language specification.\n");
-    printf("\nCore primitives: dup pop swap + - * / < > = etc.\n");
-    printf("Combinators: i x dip map fold linrec primrec etc.\n");
-    printf("Aggregates: first rest cons size null etc.\n");
+    joy_output_string("Joy Language Manual\n"
+                      "===================\n\n"
+                      "This is a compiled Joy program.\n"
+                      "For full documentation, see the Joy language specification.\n"
+                      "\nCore primitives: dup pop swap + - * / < > = etc.\n"
+                      "Combinators: i x dip map fold linrec primrec etc.\n"
+                      "Aggregates: first rest cons size null etc.\n");
 }
 
-static void prim_get(JoyContext* ctx) {
+void prim_get(JoyContext* ctx) {
     /* -> F : read factor from input (no-op in compiled code) */
     (void)ctx;
     /* No Joy parser available at runtime in compiled code.
@@ -4573,278 +4809,76 @@ static void prim_get(JoyContext* ctx) {
     fprintf(stderr, "Warning: 'get' is not supported in compiled code\n");
 }
 
+/* ---------- Superinstructions ---------- */
+
+/* Fused pairs the C backend's optimizer emits in place of two calls.
+ * Each behaves exactly like its pair; none is a Joy word. */
+
+void prim_dup_mul(JoyContext* ctx) {
+    REQUIRE(1, "*");
+    JoyValue v = POP();
+    if (v.type == JOY_INTEGER) {
+        PUSH(joy_integer(joy_int_mul(v.data.integer, v.data.integer, "*")));
+    } else if (v.type == JOY_FLOAT) {
+        PUSH(joy_float(v.data.floating * v.data.floating));
+    } else {
+        joy_error_type("*", "number", v.type);
+    }
+}
+
+void prim_eq_zero(JoyContext* ctx) {
+    REQUIRE(1, "=");
+    JoyValue v = POP();
+    PUSH(joy_boolean(joy_value_equal(v, joy_integer(0))));
+    joy_value_free(&v);
+}
+
+void prim_dec(JoyContext* ctx) {
+    REQUIRE(1, "-");
+    JoyValue v = POP();
+    if (v.type == JOY_INTEGER) {
+        PUSH(joy_integer(joy_int_sub(v.data.integer, 1, "-")));
+    } else if (v.type == JOY_FLOAT) {
+        PUSH(joy_float(v.data.floating - 1.0));
+    } else {
+        joy_error_type("-", "number", v.type);
+    }
+}
+
+void prim_inc(JoyContext* ctx) {
+    REQUIRE(1, "+");
+    JoyValue v = POP();
+    if (v.type == JOY_INTEGER) {
+        PUSH(joy_integer(joy_int_add(v.data.integer, 1, "+")));
+    } else if (v.type == JOY_FLOAT) {
+        PUSH(joy_float(v.data.floating + 1.0));
+    } else {
+        joy_error_type("+", "number", v.type);
+    }
+}
+
 /* ---------- Registration ---------- */
 
+/* Builtin words in JOY_PRIMITIVE_TABLE order, found through joy_builtins.h */
+#define JOY_BUILTIN_WORD(name, fn) {name, true, false, {.primitive = fn}},
+static const JoyWord joy_builtin_words[] = {
+    JOY_PRIMITIVE_TABLE(JOY_BUILTIN_WORD)
+};
+#undef JOY_BUILTIN_WORD
+
+_Static_assert(sizeof(joy_builtin_words) / sizeof(joy_builtin_words[0]) == JOY_BUILTIN_COUNT,
+               "joy_builtins.h is stale; run scripts/gen_builtins.py");
+
+const JoyWord* joy_builtin_lookup(const char* symbol) {
+    uint32_t hash = (uint32_t)joy_symbol_hash(symbol);
+    uint32_t seed = joy_builtin_seeds[hash & (JOY_BUILTIN_BUCKETS - 1)];
+    int index = joy_builtin_slots[joy_builtin_mix(hash ^ seed) & (JOY_BUILTIN_SLOTS - 1)];
+    if (index < 0 || strcmp(joy_builtin_words[index].name, symbol) != 0) {
+        return NULL;
+    }
+    return &joy_builtin_words[index];
+}
+
 void joy_register_primitives(JoyContext* ctx) {
-    JoyDict* d = ctx->dictionary;
-
-    /* Stack */
-    joy_dict_define_primitive(d, "id", prim_id);
-    joy_dict_define_primitive(d, "dup", prim_dup);
-    joy_dict_define_primitive(d, "dup2", prim_dup2);
-    joy_dict_define_primitive(d, "pop", prim_pop);
-    joy_dict_define_primitive(d, "swap", prim_swap);
-    joy_dict_define_primitive(d, "over", prim_over);
-    joy_dict_define_primitive(d, "rollup", prim_rollup);
-    joy_dict_define_primitive(d, "rolldown", prim_rolldown);
-    joy_dict_define_primitive(d, "rotate", prim_rotate);
-    joy_dict_define_primitive(d, "dupd", prim_dupd);
-    joy_dict_define_primitive(d, "swapd", prim_swapd);
-    joy_dict_define_primitive(d, "popd", prim_popd);
-    joy_dict_define_primitive(d, "rollupd", prim_rollupd);
-    joy_dict_define_primitive(d, "rolldownd", prim_rolldownd);
-    joy_dict_define_primitive(d, "rotated", prim_rotated);
-    joy_dict_define_primitive(d, "stack", prim_stack);
-    joy_dict_define_primitive(d, "unstack", prim_unstack);
-
-    /* Arithmetic */
-    joy_dict_define_primitive(d, "+", prim_add);
-    joy_dict_define_primitive(d, "-", prim_sub);
-    joy_dict_define_primitive(d, "*", prim_mul);
-    joy_dict_define_primitive(d, "/", prim_div);
-    joy_dict_define_primitive(d, "rem", prim_rem);
-    joy_dict_define_primitive(d, "succ", prim_succ);
-    joy_dict_define_primitive(d, "pred", prim_pred);
-    joy_dict_define_primitive(d, "abs", prim_abs);
-    joy_dict_define_primitive(d, "neg", prim_neg);
-    joy_dict_define_primitive(d, "sign", prim_sign);
-    joy_dict_define_primitive(d, "max", prim_max);
-    joy_dict_define_primitive(d, "min", prim_min);
-
-    /* Math */
-    joy_dict_define_primitive(d, "sin", prim_sin);
-    joy_dict_define_primitive(d, "cos", prim_cos);
-    joy_dict_define_primitive(d, "tan", prim_tan);
-    joy_dict_define_primitive(d, "sqrt", prim_sqrt);
-    joy_dict_define_primitive(d, "exp", prim_exp);
-    joy_dict_define_primitive(d, "log", prim_log);
-    joy_dict_define_primitive(d, "pow", prim_pow);
-    joy_dict_define_primitive(d, "floor", prim_floor);
-    joy_dict_define_primitive(d, "ceil", prim_ceil);
-    joy_dict_define_primitive(d, "trunc", prim_trunc);
-
-    /* Comparison */
-    joy_dict_define_primitive(d, "=", prim_eq);
-    joy_dict_define_primitive(d, "!=", prim_neq);
-    joy_dict_define_primitive(d, "<", prim_lt);
-    joy_dict_define_primitive(d, ">", prim_gt);
-    joy_dict_define_primitive(d, "<=", prim_le);
-    joy_dict_define_primitive(d, ">=", prim_ge);
-
-    /* Logical */
-    joy_dict_define_primitive(d, "and", prim_and);
-    joy_dict_define_primitive(d, "or", prim_or);
-    joy_dict_define_primitive(d, "not", prim_not);
-    joy_dict_define_primitive(d, "xor", prim_xor);
-    joy_dict_define_primitive(d, "choice", prim_choice);
-
-    /* Aggregates */
-    joy_dict_define_primitive(d, "first", prim_first);
-    joy_dict_define_primitive(d, "rest", prim_rest);
-    joy_dict_define_primitive(d, "cons", prim_cons);
-    joy_dict_define_primitive(d, "swons", prim_swons);
-    joy_dict_define_primitive(d, "uncons", prim_uncons);
-    joy_dict_define_primitive(d, "concat", prim_concat);
-    joy_dict_define_primitive(d, "swoncat", prim_swoncat);
-    joy_dict_define_primitive(d, "size", prim_size);
-    joy_dict_define_primitive(d, "at", prim_at);
-    joy_dict_define_primitive(d, "drop", prim_drop);
-    joy_dict_define_primitive(d, "take", prim_take);
-    joy_dict_define_primitive(d, "null", prim_null);
-    joy_dict_define_primitive(d, "small", prim_small);
-
-    /* Combinators */
-    joy_dict_define_primitive(d, "i", prim_i);
-    joy_dict_define_primitive(d, "x", prim_x);
-    joy_dict_define_primitive(d, "dip", prim_dip);
-    joy_dict_define_primitive(d, "ifte", prim_ifte);
-    joy_dict_define_primitive(d, "branch", prim_branch);
-    joy_dict_define_primitive(d, "times", prim_times);
-    joy_dict_define_primitive(d, "while", prim_while);
-    joy_dict_define_primitive(d, "map", prim_map);
-    joy_dict_define_primitive(d, "step", prim_step);
-    joy_dict_define_primitive(d, "fold", prim_fold);
-    joy_dict_define_primitive(d, "filter", prim_filter);
-
-    /* Recursion combinators */
-    joy_dict_define_primitive(d, "binrec", prim_binrec);
-    joy_dict_define_primitive(d, "linrec", prim_linrec);
-    joy_dict_define_primitive(d, "tailrec", prim_tailrec);
-    joy_dict_define_primitive(d, "primrec", prim_primrec);
-    joy_dict_define_primitive(d, "genrec", prim_genrec);
-
-    /* I/O */
-    joy_dict_define_primitive(d, "put", prim_put);
-    joy_dict_define_primitive(d, "putch", prim_putch);
-    joy_dict_define_primitive(d, "putchars", prim_putchars);
-    joy_dict_define_primitive(d, ".", prim_dot);
-    joy_dict_define_primitive(d, "newline", prim_newline);
-    joy_dict_define_primitive(d, "putln", prim_putln);
-
-    /* Debug commands (no-ops) */
-    joy_dict_define_primitive(d, "setecho", prim_setecho);
-    joy_dict_define_primitive(d, "__settracegc", prim_settracegc);
-
-    /* Set operations */
-    joy_dict_define_primitive(d, "has", prim_has);
-
-    /* Advanced combinators */
-    joy_dict_define_primitive(d, "cond", prim_cond);
-    joy_dict_define_primitive(d, "infra", prim_infra);
-    joy_dict_define_primitive(d, "condlinrec", prim_condlinrec);
-    joy_dict_define_primitive(d, "condnestrec", prim_condnestrec);
-
-    /* Tree combinators */
-    joy_dict_define_primitive(d, "treestep", prim_treestep);
-    joy_dict_define_primitive(d, "treerec", prim_treerec);
-    joy_dict_define_primitive(d, "treegenrec", prim_treegenrec);
-
-    /* Type predicates */
-    joy_dict_define_primitive(d, "integer", prim_integer);
-    joy_dict_define_primitive(d, "float", prim_float_p);
-    joy_dict_define_primitive(d, "logical", prim_logical);
-    joy_dict_define_primitive(d, "char", prim_char_p);
-    joy_dict_define_primitive(d, "string", prim_string_p);
-    joy_dict_define_primitive(d, "list", prim_list);
-    joy_dict_define_primitive(d, "set", prim_set_p);
-    joy_dict_define_primitive(d, "leaf", prim_leaf);
-    joy_dict_define_primitive(d, "file", prim_file_p);
-    joy_dict_define_primitive(d, "user", prim_user);
-
-    /* Type conversion */
-    joy_dict_define_primitive(d, "ord", prim_ord);
-    joy_dict_define_primitive(d, "chr", prim_chr);
-
-    /* Constants */
-    joy_dict_define_primitive(d, "true", prim_true);
-    joy_dict_define_primitive(d, "false", prim_false);
-    joy_dict_define_primitive(d, "maxint", prim_maxint);
-    joy_dict_define_primitive(d, "setsize", prim_setsize);
-
-    /* Additional aggregate operations */
-    joy_dict_define_primitive(d, "unswons", prim_unswons);
-    joy_dict_define_primitive(d, "of", prim_of);
-    joy_dict_define_primitive(d, "compare", prim_compare);
-    joy_dict_define_primitive(d, "equal", prim_equal);
-    joy_dict_define_primitive(d, "in", prim_in);
-    joy_dict_define_primitive(d, "name", prim_name);
-    joy_dict_define_primitive(d, "intern", prim_intern);
-    joy_dict_define_primitive(d, "body", prim_body);
-    joy_dict_define_primitive(d, "casting", prim_casting);
-
-    /* File I/O */
-    joy_dict_define_primitive(d, "stdin", prim_stdin);
-    joy_dict_define_primitive(d, "stdout", prim_stdout);
-    joy_dict_define_primitive(d, "stderr", prim_stderr);
-
-    /* Additional math */
-    joy_dict_define_primitive(d, "acos", prim_acos);
-    joy_dict_define_primitive(d, "asin", prim_asin);
-    joy_dict_define_primitive(d, "atan", prim_atan);
-    joy_dict_define_primitive(d, "atan2", prim_atan2);
-    joy_dict_define_primitive(d, "cosh", prim_cosh);
-    joy_dict_define_primitive(d, "sinh", prim_sinh);
-    joy_dict_define_primitive(d, "tanh", prim_tanh);
-    joy_dict_define_primitive(d, "log10", prim_log10);
-
-    /* String conversion */
-    joy_dict_define_primitive(d, "strtol", prim_strtol);
-    joy_dict_define_primitive(d, "strtod", prim_strtod);
-
-    /* Time and random */
-    joy_dict_define_primitive(d, "time", prim_time);
-    joy_dict_define_primitive(d, "clock", prim_clock);
-    joy_dict_define_primitive(d, "rand", prim_rand);
-    joy_dict_define_primitive(d, "srand", prim_srand);
-    joy_dict_define_primitive(d, "localtime", prim_localtime);
-    joy_dict_define_primitive(d, "gmtime", prim_gmtime);
-    joy_dict_define_primitive(d, "mktime", prim_mktime);
-    joy_dict_define_primitive(d, "strftime", prim_strftime);
-    joy_dict_define_primitive(d, "format", prim_format);
-    joy_dict_define_primitive(d, "formatf", prim_formatf);
-    joy_dict_define_primitive(d, "opcase", prim_opcase);
-    joy_dict_define_primitive(d, "case", prim_case);
-
-    /* Additional math */
-    joy_dict_define_primitive(d, "div", prim_divmod);
-    joy_dict_define_primitive(d, "frexp", prim_frexp);
-    joy_dict_define_primitive(d, "ldexp", prim_ldexp);
-    joy_dict_define_primitive(d, "modf", prim_modf);
-    joy_dict_define_primitive(d, "trunc", prim_trunc);
-
-    /* Aggregate combinators */
-    joy_dict_define_primitive(d, "split", prim_split);
-    joy_dict_define_primitive(d, "enconcat", prim_enconcat);
-    joy_dict_define_primitive(d, "some", prim_some);
-    joy_dict_define_primitive(d, "all", prim_all);
-
-    /* Arity combinators */
-    joy_dict_define_primitive(d, "nullary", prim_nullary);
-    joy_dict_define_primitive(d, "unary", prim_unary);
-    joy_dict_define_primitive(d, "unary2", prim_unary2);
-    joy_dict_define_primitive(d, "unary3", prim_unary3);
-    joy_dict_define_primitive(d, "unary4", prim_unary4);
-    joy_dict_define_primitive(d, "binary", prim_binary);
-    joy_dict_define_primitive(d, "ternary", prim_ternary);
-    joy_dict_define_primitive(d, "cleave", prim_cleave);
-    joy_dict_define_primitive(d, "construct", prim_construct);
-
-    /* Application combinators */
-    joy_dict_define_primitive(d, "app1", prim_app1);
-    joy_dict_define_primitive(d, "app11", prim_app11);
-    joy_dict_define_primitive(d, "app12", prim_app12);
-    joy_dict_define_primitive(d, "app2", prim_app2);
-    joy_dict_define_primitive(d, "app3", prim_app3);
-    joy_dict_define_primitive(d, "app4", prim_app4);
-
-    /* Type conditionals */
-    joy_dict_define_primitive(d, "ifinteger", prim_ifinteger);
-    joy_dict_define_primitive(d, "ifchar", prim_ifchar);
-    joy_dict_define_primitive(d, "iflogical", prim_iflogical);
-    joy_dict_define_primitive(d, "ifset", prim_ifset);
-    joy_dict_define_primitive(d, "ifstring", prim_ifstring);
-    joy_dict_define_primitive(d, "iflist", prim_iflist);
-    joy_dict_define_primitive(d, "iffloat", prim_iffloat);
-    joy_dict_define_primitive(d, "iffile", prim_iffile);
-
-    /* System interaction */
-    joy_dict_define_primitive(d, "system", prim_system);
-    joy_dict_define_primitive(d, "getenv", prim_getenv);
-    joy_dict_define_primitive(d, "argc", prim_argc);
-    joy_dict_define_primitive(d, "argv", prim_argv);
-
-    /* Interpreter control */
-    joy_dict_define_primitive(d, "abort", prim_abort);
-    joy_dict_define_primitive(d, "quit", prim_quit);
-    joy_dict_define_primitive(d, "gc", prim_gc);
-    joy_dict_define_primitive(d, "setautoput", prim_setautoput);
-    joy_dict_define_primitive(d, "setundeferror", prim_setundeferror);
-    joy_dict_define_primitive(d, "autoput", prim_autoput);
-    joy_dict_define_primitive(d, "undeferror", prim_undeferror);
-    joy_dict_define_primitive(d, "echo", prim_echo);
-    joy_dict_define_primitive(d, "conts", prim_conts);
-    joy_dict_define_primitive(d, "undefs", prim_undefs);
-    joy_dict_define_primitive(d, "help", prim_help);
-    joy_dict_define_primitive(d, "helpdetail", prim_helpdetail);
-    joy_dict_define_primitive(d, "manual", prim_manual);
-    joy_dict_define_primitive(d, "get", prim_get);
-
-    /* File I/O */
-    joy_dict_define_primitive(d, "fopen", prim_fopen);
-    joy_dict_define_primitive(d, "fclose", prim_fclose);
-    joy_dict_define_primitive(d, "fflush", prim_fflush);
-    joy_dict_define_primitive(d, "feof", prim_feof);
-    joy_dict_define_primitive(d, "ferror", prim_ferror);
-    joy_dict_define_primitive(d, "fgetch", prim_fgetch);
-    joy_dict_define_primitive(d, "fgets", prim_fgets);
-    joy_dict_define_primitive(d, "fread", prim_fread);
-    joy_dict_define_primitive(d, "fput", prim_fput);
-    joy_dict_define_primitive(d, "fputch", prim_fputch);
-    joy_dict_define_primitive(d, "fputchars", prim_fputchars);
-    joy_dict_define_primitive(d, "fputstring", prim_fputstring);
-    joy_dict_define_primitive(d, "fwrite", prim_fwrite);
-    joy_dict_define_primitive(d, "fseek", prim_fseek);
-    joy_dict_define_primitive(d, "ftell", prim_ftell);
-    joy_dict_define_primitive(d, "fremove", prim_fremove);
-    joy_dict_define_primitive(d, "frename", prim_frename);
+    joy_dict_define_builtins(ctx->dictionary);
 }
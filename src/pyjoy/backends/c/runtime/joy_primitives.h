@@ -0,0 +1,289 @@
+/**
+ * joy_primitives.h - Table of Joy primitives implemented in C
+ *
+ * JOY_PRIMITIVE_TABLE lists every builtin as X(joy_name, c_function).
+ * joy_primitives.c expands it into a read-only word table indexed by the
+ * perfect hash in joy_builtins.h (regenerate with scripts/gen_builtins.py
+ * after editing), and the C backend reads it to emit direct calls to
+ * builtins that a program never redefines.
+ */
+
+#ifndef JOY_PRIMITIVES_H
+#define JOY_PRIMITIVES_H
+
+#include "joy_runtime.h"
+
+#define JOY_PRIMITIVE_TABLE(X) \
+    /* Stack */                            \
+    X("id", prim_id)                       \
+    X("dup", prim_dup)                     \
+    X("dup2", prim_dup2)                   \
+    X("pop", prim_pop)                     \
+    X("swap", prim_swap)                   \
+    X("over", prim_over)                   \
+    X("rollup", prim_rollup)               \
+    X("rolldown", prim_rolldown)           \
+    X("rotate", prim_rotate)               \
+    X("dupd", prim_dupd)                   \
+    X("swapd", prim_swapd)                 \
+    X("popd", prim_popd)                   \
+    X("rollupd", prim_rollupd)             \
+    X("rolldownd", prim_rolldownd)         \
+    X("rotated", prim_rotated)             \
+    X("stack", prim_stack)                 \
+    X("unstack", prim_unstack)             \
+    /* Arithmetic */                       \
+    X("+", prim_add)                       \
+    X("-", prim_sub)                       \
+    X("*", prim_mul)                       \
+    X("/", prim_div)                       \
+    X("rem", prim_rem)                     \
+    X("succ", prim_succ)                   \
+    X("pred", prim_pred)                   \
+    X("abs", prim_abs)                     \
+    X("neg", prim_neg)                     \
+    X("sign", prim_sign)                   \
+    X("max", prim_max)                     \
+    X("min", prim_min)                     \
+    /* Math */                             \
+    X("sin", prim_sin)                     \
+    X("cos", prim_cos)                     \
+    X("tan", prim_tan)                     \
+    X("sqrt", prim_sqrt)                   \
+    X("exp", prim_exp)                     \
+    X("log", prim_log)                     \
+    X("pow", prim_pow)                     \
+    X("floor", prim_floor)                 \
+    X("ceil", prim_ceil)                   \
+    X("trunc", prim_trunc)                 \
+    /* Comparison */                       \
+    X("=", prim_eq)                        \
+    X("!=", prim_neq)                      \
+    X("<", prim_lt)                        \
+    X(">", prim_gt)                        \
+    X("<=", prim_le)                       \
+    X(">=", prim_ge)                       \
+    /* Logical */                          \
+    X("and", prim_and)                     \
+    X("or", prim_or)                       \
+    X("not", prim_not)                     \
+    X("xor", prim_xor)                     \
+    X("choice", prim_choice)               \
+    /* Aggregates */                       \
+    X("first", prim_first)                 \
+    X("rest", prim_rest)                   \
+    X("cons", prim_cons)                   \
+    X("swons", prim_swons)                 \
+    X("uncons", prim_uncons)               \
+    X("concat", prim_concat)               \
+    X("swoncat", prim_swoncat)             \
+    X("size", prim_size)                   \
+    X("at", prim_at)                       \
+    X("drop", prim_drop)                   \
+    X("take", prim_take)                   \
+    X("null", prim_null)                   \
+    X("small", prim_small)                 \
+    /* Combinators */                      \
+    X("i", prim_i)                         \
+    X("x", prim_x)                         \
+    X("dip", prim_dip)                     \
+    X("ifte", prim_ifte)                   \
+    X("branch", prim_branch)               \
+    X("times", prim_times)                 \
+    X("while", prim_while)                 \
+    X("map", prim_map)                     \
+    X("step", prim_step)                   \
+    X("fold", prim_fold)                   \
+    X("filter", prim_filter)               \
+    /* Recursion combinators */            \
+    X("binrec", prim_binrec)               \
+    X("linrec", prim_linrec)               \
+    X("tailrec", prim_tailrec)             \
+    X("primrec", prim_primrec)             \
+    X("genrec", prim_genrec)               \
+    /* Parallel (joy_parallel.c) */        \
+    X("pmap", prim_pmap)                   \
+    X("pfilter", prim_pfilter)             \
+    X("pbinrec", prim_pbinrec)             \
+    /* I/O */                              \
+    X("put", prim_put)                     \
+    X("putch", prim_putch)                 \
+    X("putchars", prim_putchars)           \
+    X(".", prim_dot)                       \
+    X("newline", prim_newline)             \
+    X("putln", prim_putln)                 \
+    /* Debug commands (no-ops) */          \
+    X("setecho", prim_setecho)             \
+    X("__settracegc", prim_settracegc)     \
+    /* Set operations */                   \
+    X("has", prim_has)                     \
+    /* Advanced combinators */             \
+    X("cond", prim_cond)                   \
+    X("infra", prim_infra)                 \
+    X("condlinrec", prim_condlinrec)       \
+    X("condnestrec", prim_condnestrec)     \
+    /* Tree combinators */                 \
+    X("treestep", prim_treestep)           \
+    X("treerec", prim_treerec)             \
+    X("treegenrec", prim_treegenrec)       \
+    /* Type predicates */                  \
+    X("integer", prim_integer)             \
+    X("float", prim_float_p)               \
+    X("logical", prim_logical)             \
+    X("char", prim_char_p)                 \
+    X("string", prim_string_p)             \
+    X("list", prim_list)                   \
+    X("set", prim_set_p)                   \
+    X("leaf", prim_leaf)                   \
+    X("file", prim_file_p)                 \
+    X("user", prim_user)                   \
+    /* Type conversion */                  \
+    X("ord", prim_ord)                     \
+    X("chr", prim_chr)                     \
+    /* Constants */                        \
+    X("true", prim_true)                   \
+    X("false", prim_false)                 \
+    X("maxint", prim_maxint)               \
+    X("setsize", prim_setsize)             \
+    /* Additional aggregate operations */  \
+    X("unswons", prim_unswons)             \
+    X("of", prim_of)                       \
+    X("compare", prim_compare)             \
+    X("equal", prim_equal)                 \
+    X("in", prim_in)                       \
+    X("name", prim_name)                   \
+    X("intern", prim_intern)               \
+    X("body", prim_body)                   \
+    X("casting", prim_casting)             \
+    /* File I/O */                         \
+    X("stdin", prim_stdin)                 \
+    X("stdout", prim_stdout)               \
+    X("stderr", prim_stderr)               \
+    /* Additional math */                  \
+    X("acos", prim_acos)                   \
+    X("asin", prim_asin)                   \
+    X("atan", prim_atan)                   \
+    X("atan2", prim_atan2)                 \
+    X("cosh", prim_cosh)                   \
+    X("sinh", prim_sinh)                   \
+    X("tanh", prim_tanh)                   \
+    X("log10", prim_log10)                 \
+    /* String conversion */                \
+    X("strtol", prim_strtol)               \
+    X("strtod", prim_strtod)               \
+    /* Time and random */                  \
+    X("time", prim_time)                   \
+    X("clock", prim_clock)                 \
+    X("rand", prim_rand)                   \
+    X("srand", prim_srand)                 \
+    X("localtime", prim_localtime)         \
+    X("gmtime", prim_gmtime)               \
+    X("mktime", prim_mktime)               \
+    X("strftime", prim_strftime)           \
+    X("format", prim_format)               \
+    X("formatf", prim_formatf)             \
+    X("opcase", prim_opcase)               \
+    X("case", prim_case)                   \
+    /* Additional math */                  \
+    X("div", prim_divmod)                  \
+    X("frexp", prim_frexp)                 \
+    X("ldexp", prim_ldexp)                 \
+    X("modf", prim_modf)                   \
+    /* Aggregate combinators */            \
+    X("split", prim_split)                 \
+    X("enconcat", prim_enconcat)           \
+    X("sort", prim_sort)                   \
+    X("sortby", prim_sortby)               \
+    X("merge", prim_merge)                 \
+    X("some", prim_some)                   \
+    X("all", prim_all)                     \
+    /* Arity combinators */                \
+    X("nullary", prim_nullary)             \
+    X("unary", prim_unary)                 \
+    X("memo", prim_memo)                   \
+    X("unary2", prim_unary2)               \
+    X("unary3", prim_unary3)               \
+    X("unary4", prim_unary4)               \
+    X("binary", prim_binary)               \
+    X("ternary", prim_ternary)             \
+    X("cleave", prim_cleave)               \
+    X("construct", prim_construct)         \
+    /* Application combinators */          \
+    X("app1", prim_app1)                   \
+    X("app11", prim_app11)                 \
+    X("app12", prim_app12)                 \
+    X("app2", prim_app2)                   \
+    X("app3", prim_app3)                   \
+    X("app4", prim_app4)                   \
+    /* Type conditionals */                \
+    X("ifinteger", prim_ifinteger)         \
+    X("ifchar", prim_ifchar)               \
+    X("iflogical", prim_iflogical)         \
+    X("ifset", prim_ifset)                 \
+    X("ifstring", prim_ifstring)           \
+    X("iflist", prim_iflist)               \
+    X("iffloat", prim_iffloat)             \
+    X("iffile", prim_iffile)               \
+    /* System interaction */               \
+    X("system", prim_system)               \
+    X("getenv", prim_getenv)               \
+    X("argc", prim_argc)                   \
+    X("argv", prim_argv)                   \
+    /* Interpreter control */              \
+    X("abort", prim_abort)                 \
+    X("quit", prim_quit)                   \
+    X("gc", prim_gc)                       \
+    X("memstats", prim_memstats)           \
+    X("setautoput", prim_setautoput)       \
+    X("setmemosize", prim_setmemosize)     \
+    X("setundeferror", prim_setundeferror) \
+    X("autoput", prim_autoput)             \
+    X("undeferror", prim_undeferror)       \
+    X("echo", prim_echo)                   \
+    X("conts", prim_conts)                 \
+    X("undefs", prim_undefs)               \
+    X("help", prim_help)                   \
+    X("helpdetail", prim_helpdetail)       \
+    X("manual", prim_manual)               \
+    X("get", prim_get)                     \
+    /* File I/O */                         \
+    X("fopen", prim_fopen)                 \
+    X("fclose", prim_fclose)               \
+    X("fflush", prim_fflush)               \
+    X("feof", prim_feof)                   \
+    X("ferror", prim_ferror)               \
+    X("fgetch", prim_fgetch)               \
+    X("fgets", prim_fgets)                 \
+    X("fread", prim_fread)                 \
+    X("fput", prim_fput)                   \
+    X("fputch", prim_fputch)               \
+    X("fputchars", prim_fputchars)         \
+    X("fputstring", prim_fputstring)       \
+    X("fwrite", prim_fwrite)               \
+    X("fseek", prim_fseek)                 \
+    X("ftell", prim_ftell)                 \
+    X("fremove", prim_fremove)             \
+    X("frename", prim_frename)             \
+    /* Bulk file input (joy_io.c) */       \
+    X("fmap", prim_fmap)                   \
+    X("linestep", prim_linestep)           \
+    /* Lazy sequences (joy_lazy.c) */      \
+    X("range", prim_range)                 \
+    X("iterate", prim_iterate)             \
+    X("unfold", prim_unfold)               \
+    X("force", prim_force)                 \
+    /* Profiling (joy_profile.c) */         \
+    X("profile", prim_profile)
+
+#define JOY_DECLARE_PRIMITIVE(name, fn) void fn(JoyContext* ctx);
+JOY_PRIMITIVE_TABLE(JOY_DECLARE_PRIMITIVE)
+#undef JOY_DECLARE_PRIMITIVE
+
+/* Superinstructions emitted by the C backend's optimizer (optimizer.py)
+ * for common pairs of builtins; not Joy words, so not in the table */
+void prim_dup_mul(JoyContext* ctx);   /* dup * */
+void prim_eq_zero(JoyContext* ctx);   /* 0 = */
+void prim_dec(JoyContext* ctx);       /* 1 - */
+void prim_inc(JoyContext* ctx);       /* 1 + */
+
+#endif /* JOY_PRIMITIVES_H */
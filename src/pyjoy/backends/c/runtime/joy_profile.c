@@ -0,0 +1,361 @@
+/**
+ * joy_profile.c - Per-word profiling for compiled programs
+ *
+ * A program built with profiling (-DJOY_PROFILE, CBuilder.compile's
+ * profile option) brackets every word it runs with joy_profile_enter and
+ * joy_profile_leave: the emitter wraps each definition and each direct
+ * builtin call, and the runtime wraps builtins it dispatches by name.
+ * Each thread records, per word, its calls, inclusive and exclusive time
+ * from clock_gettime, allocations and bytes allocated while it was the
+ * innermost word, and the deepest stack it saw, plus a call tree for
+ * folded stacks.
+ *
+ * The report, sorted by exclusive time, goes to stderr when the program
+ * exits and whenever it runs profile.  If JOY_PROFILE_FOLDED names a
+ * file, the call tree is also written there as folded stacks (one
+ * "main;caller;word microseconds" line per path), the input format of
+ * flamegraph.pl and speedscope.  A word whose body is a quotation rather
+ * than a C function is charged to the word that runs it.
+ */
+
+/* Enable POSIX functions like clock_gettime */
+#define _POSIX_C_SOURCE 200809L
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Call paths deeper than this are folded into their ancestor at the limit */
+#define JOY_PROFILE_TREE_DEPTH 128
+
+typedef struct {
+    const char* name;
+    uint64_t calls;
+    uint64_t inclusive_ns;
+    uint64_t exclusive_ns;
+    uint64_t allocs;        /* while this word was the innermost */
+    uint64_t bytes;
+    size_t max_depth;       /* deepest data stack seen entering or leaving */
+    size_t active;          /* activations open, so recursion counts once */
+} JoyProfileEntry;
+
+typedef struct JoyProfileNode {
+    size_t entry;
+    uint64_t ns;            /* exclusive time on this path */
+    struct JoyProfileNode* child;
+    struct JoyProfileNode* sibling;
+} JoyProfileNode;
+
+typedef struct {
+    size_t entry;
+    JoyProfileNode* node;
+    size_t level;
+    uint64_t start;
+    uint64_t child_ns;
+    uint64_t start_allocs;
+    uint64_t child_allocs;
+    uint64_t start_bytes;
+    uint64_t child_bytes;
+} JoyProfileFrame;
+
+typedef struct JoyProfile {
+    JoyProfileEntry* entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t* index;          /* open-addressed: entry + 1, 0 when empty */
+    size_t index_capacity;  /* power of two, at least twice entry_count */
+    JoyProfileFrame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+    JoyProfileNode root;
+    uint64_t start;
+    uint64_t top_ns;        /* inclusive time of outermost words */
+    size_t max_depth;
+    bool worker;
+    struct JoyProfile* next;
+} JoyProfile;
+
+static _Thread_local JoyProfile* joy_profile = NULL;
+static JoyProfile* joy_profiles = NULL;
+static pthread_mutex_t joy_profiles_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t joy_profile_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t joy_profile_allocs(uint64_t* bytes) {
+    JoyAllocStats stats = joy_allocator_stats(joy_allocator_active());
+    *bytes = stats.bytes_allocated;
+    return stats.slab_allocs + stats.large_allocs;
+}
+
+static void* joy_profile_alloc(void* old, size_t size) {
+    void* p = realloc(old, size);
+    if (!p) joy_error("Out of memory");
+    return p;
+}
+
+static void joy_profile_report_at_exit(void) {
+    joy_profile_report();
+}
+
+static JoyProfile* joy_profile_state(void) {
+    if (joy_profile) return joy_profile;
+    JoyProfile* profile = calloc(1, sizeof(JoyProfile));
+    if (!profile) joy_error("Out of memory");
+    profile->start = joy_profile_now();
+    profile->root.entry = SIZE_MAX;
+
+    pthread_mutex_lock(&joy_profiles_lock);
+    profile->worker = joy_profiles != NULL;
+    if (!joy_profiles) atexit(joy_profile_report_at_exit);
+    profile->next = joy_profiles;
+    joy_profiles = profile;
+    pthread_mutex_unlock(&joy_profiles_lock);
+
+    joy_profile = profile;
+    return profile;
+}
+
+static size_t hash_name(const char* s) {
+    size_t h = 5381;
+    while (*s) h = h * 33 + (unsigned char)*s++;
+    return h;
+}
+
+static size_t joy_profile_entry(JoyProfile* profile, const char* name) {
+    size_t mask = profile->index_capacity - 1;
+    if (profile->index_capacity) {
+        for (size_t i = hash_name(name) & mask; profile->index[i]; i = (i + 1) & mask) {
+            size_t e = profile->index[i] - 1;
+            if (profile->entries[e].name == name || strcmp(profile->entries[e].name, name) == 0) {
+                return e;
+            }
+        }
+    }
+
+    if (profile->entry_count == profile->entry_capacity) {
+        profile->entry_capacity = profile->entry_capacity ? profile->entry_capacity * 2 : 64;
+        profile->entries = joy_profile_alloc(profile->entries,
+                                             profile->entry_capacity * sizeof(JoyProfileEntry));
+    }
+    size_t e = profile->entry_count++;
+    memset(&profile->entries[e], 0, sizeof(JoyProfileEntry));
+    profile->entries[e].name = name;
+
+    /* Rebuild the index whenever it would pass half full */
+    if (profile->entry_count * 2 > profile->index_capacity) {
+        free(profile->index);
+        profile->index_capacity = profile->index_capacity ? profile->index_capacity * 2 : 128;
+        profile->index = calloc(profile->index_capacity, sizeof(size_t));
+        if (!profile->index) joy_error("Out of memory");
+        mask = profile->index_capacity - 1;
+        for (size_t k = 0; k < profile->entry_count; k++) {
+            size_t i = hash_name(profile->entries[k].name) & mask;
+            while (profile->index[i]) i = (i + 1) & mask;
+            profile->index[i] = k + 1;
+        }
+    } else {
+        size_t i = hash_name(name) & mask;
+        while (profile->index[i]) i = (i + 1) & mask;
+        profile->index[i] = e + 1;
+    }
+    return e;
+}
+
+static JoyProfileNode* joy_profile_child(JoyProfileNode* parent, size_t entry) {
+    for (JoyProfileNode* node = parent->child; node; node = node->sibling) {
+        if (node->entry == entry) return node;
+    }
+    JoyProfileNode* node = calloc(1, sizeof(JoyProfileNode));
+    if (!node) joy_error("Out of memory");
+    node->entry = entry;
+    node->sibling = parent->child;
+    parent->child = node;
+    return node;
+}
+
+static void joy_profile_depth(JoyProfile* profile, JoyProfileEntry* entry, JoyContext* ctx) {
+    size_t depth = ctx->stack->depth;
+    if (depth > entry->max_depth) entry->max_depth = depth;
+    if (depth > profile->max_depth) profile->max_depth = depth;
+}
+
+void joy_profile_enter(JoyContext* ctx, const char* name) {
+    JoyProfile* profile = joy_profile_state();
+    size_t e = joy_profile_entry(profile, name);
+    JoyProfileEntry* entry = &profile->entries[e];
+    entry->calls++;
+    entry->active++;
+    joy_profile_depth(profile, entry, ctx);
+
+    if (profile->frame_count == profile->frame_capacity) {
+        profile->frame_capacity = profile->frame_capacity ? profile->frame_capacity * 2 : 64;
+        profile->frames = joy_profile_alloc(profile->frames,
+                                            profile->frame_capacity * sizeof(JoyProfileFrame));
+    }
+    JoyProfileFrame* parent = profile->frame_count ? &profile->frames[profile->frame_count - 1] : NULL;
+    JoyProfileFrame* frame = &profile->frames[profile->frame_count++];
+    frame->entry = e;
+    frame->level = parent ? parent->level + 1 : 1;
+    JoyProfileNode* above = parent ? parent->node : &profile->root;
+    frame->node = frame->level <= JOY_PROFILE_TREE_DEPTH ? joy_profile_child(above, e) : above;
+    frame->child_ns = 0;
+    frame->child_allocs = 0;
+    frame->child_bytes = 0;
+    frame->start_allocs = joy_profile_allocs(&frame->start_bytes);
+    frame->start = joy_profile_now();
+}
+
+void joy_profile_leave(JoyContext* ctx) {
+    uint64_t now = joy_profile_now();
+    JoyProfile* profile = joy_profile;
+    if (!profile || profile->frame_count == 0) return;
+    JoyProfileFrame* frame = &profile->frames[--profile->frame_count];
+    JoyProfileEntry* entry = &profile->entries[frame->entry];
+
+    uint64_t elapsed = now - frame->start;
+    uint64_t own = elapsed > frame->child_ns ? elapsed - frame->child_ns : 0;
+    uint64_t bytes;
+    uint64_t allocs = joy_profile_allocs(&bytes);
+    allocs = allocs > frame->start_allocs ? allocs - frame->start_allocs : 0;
+    bytes = bytes > frame->start_bytes ? bytes - frame->start_bytes : 0;
+
+    entry->exclusive_ns += own;
+    entry->allocs += allocs > frame->child_allocs ? allocs - frame->child_allocs : 0;
+    entry->bytes += bytes > frame->child_bytes ? bytes - frame->child_bytes : 0;
+    if (--entry->active == 0) entry->inclusive_ns += elapsed;
+    frame->node->ns += own;
+    joy_profile_depth(profile, entry, ctx);
+
+    if (profile->frame_count > 0) {
+        JoyProfileFrame* parent = &profile->frames[profile->frame_count - 1];
+        parent->child_ns += elapsed;
+        parent->child_allocs += allocs;
+        parent->child_bytes += bytes;
+    } else {
+        profile->top_ns += elapsed;
+    }
+}
+
+/* ---------- Reports ---------- */
+
+static int joy_profile_by_exclusive(const void* a, const void* b) {
+    const JoyProfileEntry* x = a;
+    const JoyProfileEntry* y = b;
+    if (x->exclusive_ns != y->exclusive_ns) return x->exclusive_ns < y->exclusive_ns ? 1 : -1;
+    return strcmp(x->name, y->name);
+}
+
+/* Each thread's entries summed by name into one sorted array */
+static JoyProfileEntry* joy_profile_merge(size_t* count) {
+    size_t total = 0;
+    for (JoyProfile* p = joy_profiles; p; p = p->next) total += p->entry_count;
+    JoyProfileEntry* merged = malloc((total ? total : 1) * sizeof(JoyProfileEntry));
+    if (!merged) joy_error("Out of memory");
+    size_t n = 0;
+    for (JoyProfile* p = joy_profiles; p; p = p->next) {
+        for (size_t i = 0; i < p->entry_count; i++) {
+            const JoyProfileEntry* e = &p->entries[i];
+            size_t j = 0;
+            while (j < n && strcmp(merged[j].name, e->name) != 0) j++;
+            if (j == n) {
+                merged[n] = *e;
+                merged[n++].active = 0;
+                continue;
+            }
+            merged[j].calls += e->calls;
+            merged[j].inclusive_ns += e->inclusive_ns;
+            merged[j].exclusive_ns += e->exclusive_ns;
+            merged[j].allocs += e->allocs;
+            merged[j].bytes += e->bytes;
+            if (e->max_depth > merged[j].max_depth) merged[j].max_depth = e->max_depth;
+        }
+    }
+    qsort(merged, n, sizeof(JoyProfileEntry), joy_profile_by_exclusive);
+    *count = n;
+    return merged;
+}
+
+static void joy_profile_fold(FILE* out, JoyProfile* profile, JoyProfileNode* node,
+                             const char** path, size_t depth) {
+    if (node->ns >= 1000) {
+        for (size_t i = 0; i < depth; i++) {
+            fprintf(out, "%s%s", i ? ";" : "", path[i]);
+        }
+        fprintf(out, " %llu\n", (unsigned long long)(node->ns / 1000));
+    }
+    for (JoyProfileNode* child = node->child; child; child = child->sibling) {
+        path[depth] = profile->entries[child->entry].name;
+        joy_profile_fold(out, profile, child, path, depth + 1);
+    }
+}
+
+static void joy_profile_write_folded(const char* filename) {
+    FILE* out = fopen(filename, "w");
+    if (!out) {
+        fprintf(stderr, "profile: cannot write %s\n", filename);
+        return;
+    }
+    const char* path[JOY_PROFILE_TREE_DEPTH + 1];
+    uint64_t now = joy_profile_now();
+    for (JoyProfile* p = joy_profiles; p; p = p->next) {
+        /* Time outside every word belongs to the thread's root */
+        path[0] = p->worker ? "worker" : "main";
+        if (!p->worker) {
+            uint64_t elapsed = now - p->start;
+            p->root.ns = elapsed > p->top_ns ? elapsed - p->top_ns : 0;
+        }
+        joy_profile_fold(out, p, &p->root, path, 1);
+    }
+    fclose(out);
+}
+
+void joy_profile_report(void) {
+    joy_output_flush();
+    pthread_mutex_lock(&joy_profiles_lock);
+    if (!joy_profiles) {
+        pthread_mutex_unlock(&joy_profiles_lock);
+        return;
+    }
+
+    size_t count;
+    JoyProfileEntry* entries = joy_profile_merge(&count);
+    size_t max_depth = 0;
+    uint64_t elapsed = 0;
+    for (JoyProfile* p = joy_profiles; p; p = p->next) {
+        if (p->max_depth > max_depth) max_depth = p->max_depth;
+        if (!p->worker) elapsed = joy_profile_now() - p->start;
+    }
+
+    fprintf(stderr, "Profile: %.3f ms, %zu words, peak stack depth %zu\n",
+            elapsed / 1e6, count, max_depth);
+    fprintf(stderr, "%12s %12s %12s %10s %12s %6s  %s\n",
+            "calls", "incl ms", "excl ms", "allocs", "bytes", "depth", "word");
+    for (size_t i = 0; i < count; i++) {
+        const JoyProfileEntry* e = &entries[i];
+        fprintf(stderr, "%12llu %12.3f %12.3f %10llu %12llu %6zu  %s\n",
+                (unsigned long long)e->calls, e->inclusive_ns / 1e6, e->exclusive_ns / 1e6,
+                (unsigned long long)e->allocs, (unsigned long long)e->bytes,
+                e->max_depth, e->name);
+    }
+    free(entries);
+
+    const char* folded = getenv("JOY_PROFILE_FOLDED");
+    if (folded && *folded) joy_profile_write_folded(folded);
+    pthread_mutex_unlock(&joy_profiles_lock);
+}
+
+/* ---------- Primitives ---------- */
+
+void prim_profile(JoyContext* ctx) {
+    /* -> : write the profile so far (profiling builds only) */
+    (void)ctx;
+    joy_profile_report();
+}
@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 /* ---------- Memory Helpers ---------- */
 
@@ -28,32 +30,429 @@ static void* joy_realloc(void* ptr, size_t size) {
 static char* joy_strdup(const char* s) {
     if (!s) return NULL;
     size_t len = strlen(s) + 1;
+    joy_memory_charge(JOY_STRING, len);
     char* copy = joy_alloc(len);
     memcpy(copy, s, len);
     return copy;
 }
 
+/* ---------- Allocator ---------- */
+
+#define JOY_SLAB_GRAIN 16
+#define JOY_SLAB_CLASSES 16                       /* 16, 32, ... 256 bytes */
+#define JOY_SLAB_MAX (JOY_SLAB_GRAIN * JOY_SLAB_CLASSES)
+#define JOY_SLAB_BLOCK (64 * 1024)
+#define JOY_SCRATCH_CHUNK (16 * 1024)
+
+typedef struct JoySlabBlock {
+    struct JoySlabBlock* next;
+} JoySlabBlock;
+
+typedef struct JoyScratchChunk {
+    struct JoyScratchChunk* prev;
+    size_t capacity;
+} JoyScratchChunk;
+
+struct JoyAllocator {
+    void* free_lists[JOY_SLAB_CLASSES];  /* freed objects, linked through their first word */
+    char* cursor;                        /* unused tail of the newest block */
+    char* limit;
+    JoySlabBlock* blocks;
+    JoyScratchChunk* scratch;            /* newest scratch chunk */
+    size_t scratch_used;                 /* bytes used in the newest chunk */
+    size_t scratch_total;                /* bytes used across all chunks */
+    JoyAllocStats stats;
+};
+
+/* Allocations made before any context exists land here */
+static JoyAllocator joy_default_allocator;
+static _Thread_local JoyAllocator* joy_active_allocator = &joy_default_allocator;
+
+JoyAllocator* joy_allocator_new(void) {
+    JoyAllocator* alloc = joy_alloc(sizeof(JoyAllocator));
+    memset(alloc, 0, sizeof(JoyAllocator));
+    return alloc;
+}
+
+void joy_allocator_set_limit(JoyAllocator* alloc, size_t limit) {
+    alloc->stats.limit = limit;
+}
+
+/* Count bytes as live, failing first if they would pass the limit */
+static void joy_charge(JoyAllocator* alloc, size_t bytes) {
+    JoyAllocStats* st = &alloc->stats;
+    if (st->limit && bytes > st->limit - (st->bytes_live < st->limit ? st->bytes_live : st->limit)) {
+        joy_error_memory(st->bytes_live, bytes, st->limit);
+    }
+    st->bytes_live += bytes;
+    st->bytes_allocated += bytes;
+    if (st->bytes_live > st->bytes_peak) st->bytes_peak = st->bytes_live;
+}
+
+/* Values freed by another thread's context credit the wrong allocator,
+ * so bytes_live stops at zero rather than wrapping */
+static void joy_credit(JoyAllocator* alloc, size_t bytes) {
+    JoyAllocStats* st = &alloc->stats;
+    st->bytes_live = st->bytes_live > bytes ? st->bytes_live - bytes : 0;
+}
+
+void joy_memory_charge(JoyType type, size_t bytes) {
+    joy_charge(joy_active_allocator, bytes);
+    joy_active_allocator->stats.values[type]++;
+}
+
+void joy_memory_reserve(size_t bytes) {
+    joy_charge(joy_active_allocator, bytes);
+}
+
+void joy_memory_credit(size_t bytes) {
+    joy_credit(joy_active_allocator, bytes);
+}
+
+void joy_allocator_use(JoyAllocator* alloc) {
+    joy_active_allocator = alloc ? alloc : &joy_default_allocator;
+}
+
+JoyAllocator* joy_allocator_active(void) {
+    return joy_active_allocator;
+}
+
+/* Frees the slab blocks and scratch chunks, and with them every small
+ * object.  Objects over JOY_SLAB_MAX are separate mallocs that go back to
+ * the heap when their value is freed, possibly from another context, so
+ * they are not tracked here and reset leaves them alone.  The one caller
+ * is joy_allocator_free, once the context's values are gone. */
+void joy_allocator_reset(JoyAllocator* alloc) {
+    while (alloc->blocks) {
+        JoySlabBlock* next = alloc->blocks->next;
+        free(alloc->blocks);
+        alloc->blocks = next;
+    }
+    while (alloc->scratch) {
+        JoyScratchChunk* prev = alloc->scratch->prev;
+        joy_credit(alloc, JOY_SLAB_GRAIN + alloc->scratch->capacity);
+        free(alloc->scratch);
+        alloc->scratch = prev;
+    }
+    memset(alloc->free_lists, 0, sizeof(alloc->free_lists));
+    alloc->cursor = alloc->limit = NULL;
+    alloc->scratch_used = alloc->scratch_total = 0;
+    joy_credit(alloc, alloc->stats.slab_bytes);
+    alloc->stats.slab_bytes = 0;
+    alloc->stats.blocks = 0;
+}
+
+void joy_allocator_free(JoyAllocator* alloc) {
+    if (!alloc) return;
+    if (joy_active_allocator == alloc) joy_allocator_use(NULL);
+    joy_allocator_reset(alloc);
+    free(alloc);
+}
+
+void joy_allocator_trim(JoyAllocator* alloc) {
+    /* Only the oldest chunk is kept once the arena is empty */
+    if (alloc->scratch_total > 0) return;
+    while (alloc->scratch && alloc->scratch->prev) {
+        JoyScratchChunk* prev = alloc->scratch->prev;
+        joy_credit(alloc, JOY_SLAB_GRAIN + alloc->scratch->capacity);
+        free(alloc->scratch);
+        alloc->scratch = prev;
+    }
+}
+
+JoyAllocStats joy_allocator_stats(JoyAllocator* alloc) {
+    return alloc->stats;
+}
+
+void joy_memory_report(void) {
+    JoyAllocStats st = joy_active_allocator->stats;
+    joy_output_flush();
+    fflush(stdout);
+    fprintf(stderr, "memory: %zu bytes live (peak %zu), %zu allocated in %zu allocations",
+            st.bytes_live, st.bytes_peak, st.bytes_allocated,
+            st.slab_allocs + st.large_allocs);
+    if (st.limit) fprintf(stderr, ", limit %zu", st.limit);
+    fprintf(stderr, "\nmemory: %zu lists, %zu quotations, %zu strings, %zu sets, "
+            "%zu lazy created\n",
+            st.values[JOY_LIST], st.values[JOY_QUOTATION], st.values[JOY_STRING],
+            st.values[JOY_SET], st.values[JOY_LAZY]);
+}
+
+/* JOY_MEMORY_LIMIT as bytes, 0 when unset or unreadable */
+static size_t joy_memory_limit_env(void) {
+    const char* text = getenv("JOY_MEMORY_LIMIT");
+    if (!text || !*text) return 0;
+    char* end;
+    unsigned long long limit = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'G': case 'g': limit <<= 10; /* fall through */
+        case 'M': case 'm': limit <<= 10; /* fall through */
+        case 'K': case 'k': limit <<= 10; break;
+        default: break;
+    }
+    return (size_t)limit;
+}
+
+static void* joy_slab_alloc(size_t size) {
+    JoyAllocator* alloc = joy_active_allocator;
+    if (size == 0) size = 1;
+    if (size > JOY_SLAB_MAX) {
+        joy_charge(alloc, size);
+        alloc->stats.large_allocs++;
+        return joy_alloc(size);
+    }
+    size_t cls = (size - 1) / JOY_SLAB_GRAIN;
+    size_t bytes = (cls + 1) * JOY_SLAB_GRAIN;
+    joy_charge(alloc, bytes);
+    void* ptr = alloc->free_lists[cls];
+    if (ptr) {
+        alloc->free_lists[cls] = *(void**)ptr;
+    } else {
+        if (!alloc->cursor || alloc->cursor + bytes > alloc->limit) {
+            JoySlabBlock* block = joy_alloc(JOY_SLAB_BLOCK);
+            block->next = alloc->blocks;
+            alloc->blocks = block;
+            alloc->cursor = (char*)block + JOY_SLAB_GRAIN;
+            alloc->limit = (char*)block + JOY_SLAB_BLOCK;
+            alloc->stats.blocks++;
+        }
+        ptr = alloc->cursor;
+        alloc->cursor += bytes;
+    }
+    alloc->stats.slab_allocs++;
+    alloc->stats.slab_bytes += bytes;
+    if (alloc->stats.slab_bytes > alloc->stats.slab_peak) {
+        alloc->stats.slab_peak = alloc->stats.slab_bytes;
+    }
+    return ptr;
+}
+
+static void joy_slab_free(void* ptr, size_t size) {
+    if (!ptr) return;
+    if (size == 0) size = 1;
+    JoyAllocator* alloc = joy_active_allocator;
+    if (size > JOY_SLAB_MAX) {
+        joy_credit(alloc, size);
+        free(ptr);
+        return;
+    }
+    size_t cls = (size - 1) / JOY_SLAB_GRAIN;
+    *(void**)ptr = alloc->free_lists[cls];
+    alloc->free_lists[cls] = ptr;
+    alloc->stats.slab_frees++;
+    alloc->stats.slab_bytes -= (cls + 1) * JOY_SLAB_GRAIN;
+    joy_credit(alloc, (cls + 1) * JOY_SLAB_GRAIN);
+}
+
+static void* joy_slab_realloc(void* ptr, size_t old_size, size_t new_size) {
+    if (old_size > JOY_SLAB_MAX && new_size > JOY_SLAB_MAX) {
+        if (new_size > old_size) {
+            joy_charge(joy_active_allocator, new_size - old_size);
+        } else {
+            joy_credit(joy_active_allocator, old_size - new_size);
+        }
+        return joy_realloc(ptr, new_size);
+    }
+    void* moved = joy_slab_alloc(new_size);
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    joy_slab_free(ptr, old_size);
+    return moved;
+}
+
+void* joy_scratch_alloc(JoyAllocator* alloc, size_t size) {
+    size = (size + JOY_SLAB_GRAIN - 1) / JOY_SLAB_GRAIN * JOY_SLAB_GRAIN;
+    if (!alloc->scratch || alloc->scratch_used + size > alloc->scratch->capacity) {
+        size_t capacity = size > JOY_SCRATCH_CHUNK ? size : JOY_SCRATCH_CHUNK;
+        joy_charge(alloc, JOY_SLAB_GRAIN + capacity);
+        JoyScratchChunk* chunk = joy_alloc(JOY_SLAB_GRAIN + capacity);
+        chunk->prev = alloc->scratch;
+        chunk->capacity = capacity;
+        alloc->scratch = chunk;
+        alloc->scratch_used = 0;
+    }
+    void* ptr = (char*)alloc->scratch + JOY_SLAB_GRAIN + alloc->scratch_used;
+    alloc->scratch_used += size;
+    alloc->scratch_total += size;
+    if (alloc->scratch_total > alloc->stats.scratch_peak) {
+        alloc->stats.scratch_peak = alloc->scratch_total;
+    }
+    return ptr;
+}
+
+JoyScratchMark joy_scratch_mark(JoyAllocator* alloc) {
+    JoyScratchMark mark = {alloc->scratch, alloc->scratch_used, alloc->scratch_total};
+    return mark;
+}
+
+void joy_scratch_release(JoyAllocator* alloc, JoyScratchMark mark) {
+    /* Chunks opened after the mark are dropped unless the mark had none */
+    while (alloc->scratch != mark.chunk && alloc->scratch->prev) {
+        JoyScratchChunk* prev = alloc->scratch->prev;
+        joy_credit(alloc, JOY_SLAB_GRAIN + alloc->scratch->capacity);
+        free(alloc->scratch);
+        alloc->scratch = prev;
+    }
+    alloc->scratch_used = alloc->scratch == mark.chunk ? mark.used : 0;
+    alloc->scratch_total = mark.total;
+}
+
 /* ---------- Error Handling ---------- */
 
+static _Thread_local JoyErrorTrap* joy_error_trap = NULL;
+
+JoyErrorTrap* joy_error_trap_set(JoyErrorTrap* trap) {
+    JoyErrorTrap* outer = joy_error_trap;
+    joy_error_trap = trap;
+    return outer;
+}
+
+/* Each flushes buffered output first so it appears before the message */
+
+#define JOY_FAIL(...) JOY_FAIL_AS(false, __VA_ARGS__)
+
+#define JOY_FAIL_AS(overflow, ...)                                          \
+    do {                                                                    \
+        joy_output_flush();                                                 \
+        if (joy_error_trap) {                                               \
+            JoyErrorTrap* trap = joy_error_trap;                            \
+            joy_error_trap = NULL;                                          \
+            snprintf(trap->message, sizeof trap->message, __VA_ARGS__);     \
+            trap->status = 1;                                               \
+            trap->exited = false;                                           \
+            trap->overflowed = (overflow);                                  \
+            longjmp(trap->env, 1);                                          \
+        }                                                                   \
+        joy_output_flush_all();                                             \
+        fprintf(stderr, __VA_ARGS__);                                       \
+        fputc('\n', stderr);                                                \
+        exit(1);                                                            \
+    } while (0)
+
 void joy_error(const char* message) {
-    fprintf(stderr, "Joy error: %s\n", message);
-    exit(1);
+    JOY_FAIL("Joy error: %s", message);
 }
 
 void joy_error_type(const char* op, const char* expected, JoyType got) {
     const char* type_names[] = {
         "INTEGER", "FLOAT", "BOOLEAN", "CHAR", "STRING",
-        "LIST", "SET", "QUOTATION", "SYMBOL", "FILE"
+        "LIST", "SET", "QUOTATION", "SYMBOL", "FILE", "LAZY"
     };
-    fprintf(stderr, "Joy type error in '%s': expected %s, got %s\n",
-            op, expected, type_names[got]);
-    exit(1);
+    JOY_FAIL("Joy type error in '%s': expected %s, got %s",
+             op, expected, type_names[got]);
 }
 
 void joy_error_underflow(const char* op, size_t required, size_t actual) {
-    fprintf(stderr, "Joy stack underflow in '%s': need %zu, have %zu\n",
-            op, required, actual);
-    exit(1);
+    JOY_FAIL("Joy stack underflow in '%s': need %zu, have %zu",
+             op, required, actual);
+}
+
+void joy_error_memory(size_t live, size_t request, size_t limit) {
+    JOY_FAIL("Joy error: memory limit of %zu bytes reached (%zu live, %zu more requested)",
+             limit, live, request);
+}
+
+bool joy_overflow_checked = false;
+
+void joy_error_overflow(const char* op) {
+    JOY_FAIL_AS(true, "Joy error: integer overflow in '%s'", op);
+}
+
+void joy_exit(int status) {
+    joy_output_flush();
+    if (joy_error_trap) {
+        JoyErrorTrap* trap = joy_error_trap;
+        joy_error_trap = NULL;
+        snprintf(trap->message, sizeof trap->message, "Joy exit: status %d", status);
+        trap->status = status;
+        trap->exited = true;
+        trap->overflowed = false;
+        longjmp(trap->env, 1);
+    }
+    joy_output_flush_all();
+    exit(status);
+}
+
+void joy_error_rethrow(const JoyErrorTrap* caught) {
+    if (caught->exited) joy_exit(caught->status);
+    JOY_FAIL_AS(caught->overflowed, "%s", caught->message);
+}
+
+/* ---------- Symbols ---------- */
+
+static size_t hash_string(const char* s) {
+    size_t hash = 5381;
+    int c;
+    while ((c = *s++)) {
+        hash = ((hash << 5) + hash) + c;
+    }
+    return hash;
+}
+
+/* An interned name, stored after its hash so joy_symbol_hash is O(1) */
+typedef struct {
+    size_t hash;
+    char name[];
+} JoySymbol;
+
+/* Open-addressed table of every interned name; entries live forever.
+ * Shared by all threads, so lookups and inserts hold joy_symbols_lock.
+ * Nothing that can raise runs with the lock held: a longjmp out would
+ * leave it locked for good, so failures unlock before joy_error. */
+static JoySymbol** joy_symbols = NULL;
+static size_t joy_symbol_capacity = 0;
+static size_t joy_symbol_count = 0;
+static pthread_mutex_t joy_symbols_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool joy_symbols_grow(void) {
+    size_t capacity = joy_symbol_capacity ? joy_symbol_capacity * 2 : 1024;
+    JoySymbol** table = calloc(capacity, sizeof(JoySymbol*));
+    if (!table) return false;
+    for (size_t i = 0; i < joy_symbol_capacity; i++) {
+        JoySymbol* sym = joy_symbols[i];
+        if (!sym) continue;
+        size_t slot = sym->hash & (capacity - 1);
+        while (table[slot]) slot = (slot + 1) & (capacity - 1);
+        table[slot] = sym;
+    }
+    free(joy_symbols);
+    joy_symbols = table;
+    joy_symbol_capacity = capacity;
+    return true;
+}
+
+const char* joy_intern(const char* name) {
+    size_t hash = hash_string(name);
+    pthread_mutex_lock(&joy_symbols_lock);
+    if ((joy_symbol_count + 1) * 2 > joy_symbol_capacity && !joy_symbols_grow()) {
+        pthread_mutex_unlock(&joy_symbols_lock);
+        joy_error("Out of memory");
+    }
+    size_t mask = joy_symbol_capacity - 1;
+    size_t slot = hash & mask;
+    while (joy_symbols[slot]) {
+        JoySymbol* sym = joy_symbols[slot];
+        if (sym->hash == hash && strcmp(sym->name, name) == 0) {
+            pthread_mutex_unlock(&joy_symbols_lock);
+            return sym->name;
+        }
+        slot = (slot + 1) & mask;
+    }
+    size_t len = strlen(name) + 1;
+    JoySymbol* sym = malloc(sizeof(JoySymbol) + len);
+    if (!sym) {
+        pthread_mutex_unlock(&joy_symbols_lock);
+        joy_error("Out of memory");
+    }
+    sym->hash = hash;
+    memcpy(sym->name, name, len);
+    joy_symbols[slot] = sym;
+    joy_symbol_count++;
+    pthread_mutex_unlock(&joy_symbols_lock);
+    return sym->name;
+}
+
+size_t joy_symbol_hash(const char* symbol) {
+    return ((const JoySymbol*)(symbol - offsetof(JoySymbol, name)))->hash;
 }
 
 /* ---------- Value Constructors ---------- */
@@ -84,16 +483,71 @@ JoyValue joy_char(char value) {
 
 JoyValue joy_string(const char* value) {
     JoyValue v = {.type = JOY_STRING};
-    v.data.string = joy_strdup(value);
+    size_t len = strlen(value);
+    if (len <= JOY_SMALL_STRING) {
+        v.small_string = true;
+        memcpy(v.data.small, value, len + 1);
+    } else {
+        v.data.string = joy_strdup(value);
+    }
     return v;
 }
 
 JoyValue joy_string_owned(char* value) {
     JoyValue v = {.type = JOY_STRING};
+    joy_memory_charge(JOY_STRING, strlen(value) + 1);
     v.data.string = value;
     return v;
 }
 
+JoyValue joy_string_span(const char* chars, size_t length) {
+    JoyValue v = {.type = JOY_STRING};
+    char* dest = v.data.small;
+    if (length <= JOY_SMALL_STRING) {
+        v.small_string = true;
+    } else {
+        joy_memory_charge(JOY_STRING, length + 1);
+        dest = v.data.string = joy_alloc(length + 1);
+    }
+    memcpy(dest, chars, length);
+    dest[length] = '\0';
+    return v;
+}
+
+void joy_string_append(JoyValue* value, const char* chars, size_t length) {
+    size_t old = joy_string_length(value);
+    size_t need = old + length + 1;
+    JoyStringHeader* header;
+    if (value->built_string) {
+        header = (JoyStringHeader*)value->data.string - 1;
+        if (need > header->capacity) {
+            /* Doubling keeps a loop of appends linear overall */
+            size_t capacity = header->capacity * 2 > need ? header->capacity * 2 : need;
+            joy_charge(joy_active_allocator, capacity - header->capacity);
+            header = joy_realloc(header, sizeof(JoyStringHeader) + capacity);
+            header->capacity = capacity;
+        }
+    } else if (value->small_string && need <= JOY_SMALL_STRING + 1) {
+        memcpy(value->data.small + old, chars, length);
+        value->data.small[old + length] = '\0';
+        return;
+    } else {
+        /* The first append sizes exactly, so a one-off concat wastes nothing */
+        joy_memory_charge(JOY_STRING, sizeof(JoyStringHeader) + need);
+        header = joy_alloc(sizeof(JoyStringHeader) + need);
+        header->capacity = need;
+        memcpy(header + 1, joy_string_chars(value), old);
+        joy_value_free(value);
+        value->small_string = false;
+        value->mapped_string = false;
+        value->built_string = true;
+    }
+    value->data.string = (char*)(header + 1);
+    memcpy(value->data.string + old, chars, length);
+    value->data.string[old + length] = '\0';
+    header->length = old + length;
+}
+
 JoyValue joy_list_empty(void) {
     JoyValue v = {.type = JOY_LIST};
     v.data.list = joy_list_new(8);
@@ -109,23 +563,6 @@ JoyValue joy_list_from(JoyValue* items, size_t count) {
     return v;
 }
 
-JoyValue joy_set_empty(void) {
-    JoyValue v = {.type = JOY_SET};
-    v.data.set = 0;
-    return v;
-}
-
-JoyValue joy_set_from(int* members, size_t count) {
-    JoyValue v = {.type = JOY_SET};
-    v.data.set = 0;
-    for (size_t i = 0; i < count; i++) {
-        if (members[i] >= 0 && members[i] < 64) {
-            v.data.set |= (1ULL << members[i]);
-        }
-    }
-    return v;
-}
-
 JoyValue joy_quotation_empty(void) {
     JoyValue v = {.type = JOY_QUOTATION};
     v.data.quotation = joy_quotation_new(8);
@@ -143,7 +580,7 @@ JoyValue joy_quotation_from(JoyValue* terms, size_t count) {
 
 JoyValue joy_symbol(const char* name) {
     JoyValue v = {.type = JOY_SYMBOL};
-    v.data.symbol = joy_strdup(name);
+    v.data.symbol = joy_intern(name);
     return v;
 }
 
@@ -155,20 +592,33 @@ JoyValue joy_file(FILE* file) {
 
 /* ---------- Value Operations ---------- */
 
+static JoyBitset* joy_bitset_new(size_t words);
+static void joy_bitset_release(JoyBitset* set);
+
 JoyValue joy_value_copy(JoyValue value) {
     JoyValue copy = value;
     switch (value.type) {
         case JOY_STRING:
-            copy.data.string = joy_strdup(value.data.string);
-            break;
-        case JOY_SYMBOL:
-            copy.data.symbol = joy_strdup(value.data.symbol);
+            if (value.mapped_string) {
+                joy_mapping_retain(value.data.string);
+            } else if (!value.small_string) {
+                copy.data.string = joy_strdup(value.data.string);
+                copy.built_string = false;
+            }
             break;
         case JOY_LIST:
-            copy.data.list = joy_list_copy(value.data.list);
+            copy.data.list = joy_list_retain(value.data.list);
+            break;
+        case JOY_SET:
+            if (value.wide_set) {
+                value.data.bitset->refcount++;
+            }
             break;
         case JOY_QUOTATION:
-            copy.data.quotation = joy_quotation_copy(value.data.quotation);
+            copy.data.quotation = joy_quotation_retain(value.data.quotation);
+            break;
+        case JOY_LAZY:
+            copy.data.lazy = joy_lazy_retain(value.data.lazy);
             break;
         default:
             break;  /* primitives are copied by value */
@@ -176,24 +626,85 @@ JoyValue joy_value_copy(JoyValue value) {
     return copy;
 }
 
+/* Unlike joy_value_copy, shares no storage with value and never touches
+ * its reference counts, so value may belong to another thread's context */
+JoyValue joy_value_clone(JoyValue value) {
+    JoyValue clone = value;
+    switch (value.type) {
+        case JOY_STRING:
+            if (!value.small_string) {
+                clone.data.string = joy_strdup(value.data.string);
+                clone.mapped_string = false;
+                clone.built_string = false;
+            }
+            break;
+        case JOY_LIST: {
+            JoyList* list = value.data.list;
+            clone.data.list = joy_list_new(list->length);
+            for (size_t i = 0; i < list->length; i++) {
+                joy_list_push(clone.data.list, joy_value_clone(list->items[i]));
+            }
+            break;
+        }
+        case JOY_QUOTATION: {
+            JoyQuotation* quot = value.data.quotation;
+            clone.data.quotation = joy_quotation_new(quot->length);
+            for (size_t i = 0; i < quot->length; i++) {
+                joy_quotation_push(clone.data.quotation, joy_value_clone(quot->terms[i]));
+            }
+            break;
+        }
+        case JOY_SET:
+            if (value.wide_set) {
+                JoyBitset* set = value.data.bitset;
+                clone.data.bitset = joy_bitset_new(set->words);
+                memcpy(clone.data.bitset->bits, set->bits, set->words * sizeof(uint64_t));
+            }
+            break;
+        case JOY_LAZY:
+            clone.data.lazy = joy_lazy_clone(value.data.lazy);
+            break;
+        default:
+            break;  /* symbols are interned, files are not owned */
+    }
+    return clone;
+}
+
 void joy_value_free(JoyValue* value) {
     switch (value->type) {
         case JOY_STRING:
-            free(value->data.string);
-            value->data.string = NULL;
-            break;
-        case JOY_SYMBOL:
-            free(value->data.symbol);
-            value->data.symbol = NULL;
+            if (value->mapped_string) {
+                joy_mapping_release(value->data.string);
+                value->data.string = NULL;
+            } else if (value->built_string) {
+                JoyStringHeader* header = (JoyStringHeader*)value->data.string - 1;
+                joy_memory_credit(sizeof(JoyStringHeader) + header->capacity);
+                free(header);
+                value->data.string = NULL;
+            } else if (!value->small_string) {
+                joy_memory_credit(strlen(value->data.string) + 1);
+                free(value->data.string);
+                value->data.string = NULL;
+            }
             break;
         case JOY_LIST:
             joy_list_free(value->data.list);
             value->data.list = NULL;
             break;
+        case JOY_SET:
+            if (value->wide_set) {
+                joy_bitset_release(value->data.bitset);
+                value->data.bitset = NULL;
+            }
+            break;
         case JOY_QUOTATION:
             joy_quotation_free(value->data.quotation);
             value->data.quotation = NULL;
             break;
+        case JOY_LAZY:
+            joy_lazy_release(value->data.lazy);
+            value->data.lazy = NULL;
+            break;
         default:
             break;
     }
@@ -204,7 +715,7 @@ void joy_value_free(JoyValue* value) {
  * - INTEGER/FLOAT: direct value
  * - CHAR: ordinal value
  * - BOOLEAN: 1 for true, 0 for false
- * - SET: bitset integer (the set bits directly)
+ * - SET: bitset integer (the set bits directly); wide sets are not numeric
  * - LIST/QUOTATION: 0 if empty, otherwise not numeric
  * - STRING: 0 if empty, otherwise not numeric
  * - FILE: 0 if NULL (failed open), otherwise not numeric
@@ -224,6 +735,7 @@ bool joy_numeric_value(JoyValue v, double* result) {
             *result = v.data.boolean ? 1.0 : 0.0;
             return true;
         case JOY_SET:
+            if (v.wide_set) return false;
             *result = (double)v.data.set;
             return true;
         case JOY_LIST:
@@ -239,7 +751,7 @@ bool joy_numeric_value(JoyValue v, double* result) {
             }
             return false;
         case JOY_STRING:
-            if (v.data.string[0] == '\0') {
+            if (joy_string_chars(&v)[0] == '\0') {
                 *result = 0.0;
                 return true;
             }
@@ -269,27 +781,31 @@ bool joy_value_equal(JoyValue a, JoyValue b) {
 
     /* Symbol comparison */
     if (a.type == JOY_SYMBOL && b.type == JOY_SYMBOL) {
-        return strcmp(a.data.symbol, b.data.symbol) == 0;
+        return a.data.symbol == b.data.symbol;
     }
     /* Symbol vs String */
     if (a.type == JOY_SYMBOL && b.type == JOY_STRING) {
-        return strcmp(a.data.symbol, b.data.string) == 0;
+        return strcmp(a.data.symbol, joy_string_chars(&b)) == 0;
     }
     if (a.type == JOY_STRING && b.type == JOY_SYMBOL) {
-        return strcmp(a.data.string, b.data.symbol) == 0;
+        return strcmp(joy_string_chars(&a), b.data.symbol) == 0;
     }
     /* String vs String */
     if (a.type == JOY_STRING && b.type == JOY_STRING) {
-        return strcmp(a.data.string, b.data.string) == 0;
+        return strcmp(joy_string_chars(&a), joy_string_chars(&b)) == 0;
+    }
+
+    if (a.type == JOY_SET && b.type == JOY_SET) {
+        return joy_set_equal(&a, &b);
     }
 
     /* FLOAT vs SET: compare IEEE 754 bit representation */
-    if (a.type == JOY_FLOAT && b.type == JOY_SET) {
+    if (a.type == JOY_FLOAT && b.type == JOY_SET && !b.wide_set) {
         uint64_t float_bits;
         memcpy(&float_bits, &a.data.floating, sizeof(double));
         return float_bits == b.data.set;
     }
-    if (a.type == JOY_SET && b.type == JOY_FLOAT) {
+    if (a.type == JOY_SET && b.type == JOY_FLOAT && !a.wide_set) {
         uint64_t float_bits;
         memcpy(&float_bits, &b.data.floating, sizeof(double));
         return a.data.set == float_bits;
@@ -300,6 +816,11 @@ bool joy_value_equal(JoyValue a, JoyValue b) {
         return a.data.file == b.data.file;
     }
 
+    /* Lazy sequences: equal only if the same generator */
+    if (a.type == JOY_LAZY && b.type == JOY_LAZY) {
+        return a.data.lazy == b.data.lazy;
+    }
+
     /* Try numeric comparison */
     double av, bv;
     if (joy_numeric_value(a, &av) && joy_numeric_value(b, &bv)) {
@@ -309,6 +830,125 @@ bool joy_value_equal(JoyValue a, JoyValue b) {
     return false;
 }
 
+/* ---------- Hashing ---------- */
+
+static inline uint32_t joy_hash_mix(uint32_t h, uint64_t word) {
+    word *= 0x9E3779B97F4A7C15ULL;
+    h ^= (uint32_t)(word >> 32) ^ (uint32_t)word;
+    return h * 0x01000193u;
+}
+
+static uint32_t joy_hash_bytes(uint32_t h, const char* bytes, size_t length) {
+    for (size_t i = 0; i < length; i++) h = (h ^ (unsigned char)bytes[i]) * 0x01000193u;
+    return h;
+}
+
+static uint32_t joy_hash_items(JoyType type, const JoyValue* items, size_t length) {
+    uint32_t h = joy_hash_mix(0x811C9DC5u, (uint64_t)type << 32 | length);
+    for (size_t i = 0; i < length; i++) h = joy_hash_mix(h, joy_value_hash(&items[i]));
+    /* 0 marks an aggregate not yet hashed */
+    return h ? h : 1;
+}
+
+uint32_t joy_value_hash(const JoyValue* value) {
+    uint32_t h = joy_hash_mix(0x811C9DC5u, value->type);
+    switch (value->type) {
+        case JOY_INTEGER:
+            return joy_hash_mix(h, (uint64_t)value->data.integer);
+        case JOY_FLOAT: {
+            /* -0.0 and 0.0 are the same value */
+            double x = value->data.floating == 0.0 ? 0.0 : value->data.floating;
+            uint64_t bits;
+            memcpy(&bits, &x, sizeof bits);
+            return joy_hash_mix(h, bits);
+        }
+        case JOY_BOOLEAN:
+            return joy_hash_mix(h, value->data.boolean);
+        case JOY_CHAR:
+            return joy_hash_mix(h, (unsigned char)value->data.character);
+        case JOY_STRING:
+            return joy_hash_bytes(h, joy_string_chars(value), joy_string_length(value));
+        case JOY_SET: {
+            size_t words;
+            const uint64_t* bits = joy_set_words(value, &words);
+            for (size_t i = 0; i < words; i++) h = joy_hash_mix(h, bits[i]);
+            return h;
+        }
+        case JOY_LIST: {
+            JoyList* list = value->data.list;
+            if (!list->hash) list->hash = joy_hash_items(JOY_LIST, list->items, list->length);
+            return list->hash;
+        }
+        case JOY_QUOTATION: {
+            JoyQuotation* quot = value->data.quotation;
+            if (!quot->hash) quot->hash = joy_hash_items(JOY_QUOTATION, quot->terms, quot->length);
+            return quot->hash;
+        }
+        case JOY_SYMBOL:
+            return joy_hash_mix(h, (uint64_t)(uintptr_t)value->data.symbol);
+        case JOY_FILE:
+            return joy_hash_mix(h, (uint64_t)(uintptr_t)value->data.file);
+        case JOY_LAZY:
+            return joy_hash_mix(h, (uint64_t)(uintptr_t)value->data.lazy);
+    }
+    return h;
+}
+
+static bool joy_items_same(const JoyValue* a, const JoyValue* b, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!joy_value_same(&a[i], &b[i])) return false;
+    }
+    return true;
+}
+
+bool joy_value_same(const JoyValue* a, const JoyValue* b) {
+    if (a->type != b->type) return false;
+    switch (a->type) {
+        case JOY_INTEGER:
+            return a->data.integer == b->data.integer;
+        case JOY_FLOAT:
+            return a->data.floating == b->data.floating ||
+                   (a->data.floating != a->data.floating &&
+                    b->data.floating != b->data.floating);
+        case JOY_BOOLEAN:
+            return a->data.boolean == b->data.boolean;
+        case JOY_CHAR:
+            return a->data.character == b->data.character;
+        case JOY_STRING: {
+            size_t length = joy_string_length(a);
+            return length == joy_string_length(b) &&
+                   memcmp(joy_string_chars(a), joy_string_chars(b), length) == 0;
+        }
+        case JOY_SET:
+            return joy_set_equal(a, b);
+        case JOY_LIST: {
+            JoyList* x = a->data.list;
+            JoyList* y = b->data.list;
+            if (x == y) return true;
+            if (x->length != y->length || (x->hash && y->hash && x->hash != y->hash)) {
+                return false;
+            }
+            return x->items == y->items || joy_items_same(x->items, y->items, x->length);
+        }
+        case JOY_QUOTATION: {
+            JoyQuotation* x = a->data.quotation;
+            JoyQuotation* y = b->data.quotation;
+            if (x == y) return true;
+            if (x->length != y->length || (x->hash && y->hash && x->hash != y->hash)) {
+                return false;
+            }
+            return x->terms == y->terms || joy_items_same(x->terms, y->terms, x->length);
+        }
+        case JOY_SYMBOL:
+            return a->data.symbol == b->data.symbol;
+        case JOY_FILE:
+            return a->data.file == b->data.file;
+        case JOY_LAZY:
+            return a->data.lazy == b->data.lazy;
+    }
+    return false;
+}
+
 bool joy_value_truthy(JoyValue value) {
     switch (value.type) {
         case JOY_BOOLEAN:
@@ -318,11 +958,11 @@ bool joy_value_truthy(JoyValue value) {
         case JOY_FLOAT:
             return value.data.floating != 0.0;
         case JOY_STRING:
-            return value.data.string[0] != '\0';
+            return joy_string_chars(&value)[0] != '\0';
         case JOY_LIST:
             return value.data.list->length > 0;
         case JOY_SET:
-            return value.data.set != 0;
+            return value.wide_set || value.data.set != 0;
         case JOY_QUOTATION:
             return value.data.quotation->length > 0;
         default:
@@ -333,96 +973,313 @@ bool joy_value_truthy(JoyValue value) {
 void joy_value_print(JoyValue value) {
     switch (value.type) {
         case JOY_INTEGER:
-            printf("%lld", (long long)value.data.integer);
+            joy_output_integer(value.data.integer);
             break;
         case JOY_FLOAT:
-            printf("%g", value.data.floating);
+            joy_output_float(value.data.floating);
             break;
         case JOY_BOOLEAN:
-            printf("%s", value.data.boolean ? "true" : "false");
+            joy_output_string(value.data.boolean ? "true" : "false");
             break;
         case JOY_CHAR:
-            printf("'%c'", value.data.character);
+            joy_output_char('\'');
+            joy_output_char(value.data.character);
+            joy_output_char('\'');
             break;
         case JOY_STRING:
-            printf("\"%s\"", value.data.string);
+            joy_output_char('"');
+            joy_output_string(joy_string_chars(&value));
+            joy_output_char('"');
             break;
         case JOY_LIST:
-            printf("[");
+            joy_output_char('[');
             for (size_t i = 0; i < value.data.list->length; i++) {
-                if (i > 0) printf(" ");
+                if (i > 0) joy_output_char(' ');
                 joy_value_print(value.data.list->items[i]);
             }
-            printf("]");
+            joy_output_char(']');
             break;
         case JOY_SET:
-            printf("{");
-            bool first = true;
-            for (int i = 0; i < 64; i++) {
-                if (value.data.set & (1ULL << i)) {
-                    if (!first) printf(" ");
-                    printf("%d", i);
-                    first = false;
-                }
+            joy_output_char('{');
+            for (int64_t i = joy_set_next(&value, 0); i >= 0; ) {
+                joy_output_integer(i);
+                i = joy_set_next(&value, i + 1);
+                if (i >= 0) joy_output_char(' ');
             }
-            printf("}");
+            joy_output_char('}');
             break;
         case JOY_QUOTATION:
-            printf("[");
+            joy_output_char('[');
             for (size_t i = 0; i < value.data.quotation->length; i++) {
-                if (i > 0) printf(" ");
+                if (i > 0) joy_output_char(' ');
                 joy_value_print(value.data.quotation->terms[i]);
             }
-            printf("]");
+            joy_output_char(']');
             break;
         case JOY_SYMBOL:
-            printf("%s", value.data.symbol);
+            joy_output_string(value.data.symbol);
             break;
         case JOY_FILE:
             if (value.data.file == stdin)
-                printf("<stdin>");
+                joy_output_string("<stdin>");
             else if (value.data.file == stdout)
-                printf("<stdout>");
+                joy_output_string("<stdout>");
             else if (value.data.file == stderr)
-                printf("<stderr>");
-            else
-                printf("<file:%p>", (void*)value.data.file);
+                joy_output_string("<stderr>");
+            else {
+                char buf[32];
+                int length = snprintf(buf, sizeof(buf), "<file:%p>", (void*)value.data.file);
+                joy_output_write(buf, (size_t)length);
+            }
             break;
+        case JOY_LAZY:
+            /* Printing cannot run the quotations that produce elements */
+            joy_output_string("<lazy>");
+            break;
+    }
+}
+
+/* ---------- Shared Buffers ---------- */
+
+/* Lists and quotations are immutable views onto a reference-counted
+ * JoyBuffer.  The view helpers below are shared by both types; they take
+ * the view fields by pointer so JoyList and JoyQuotation stay distinct. */
+
+static JoyBuffer* joy_buffer_new(size_t capacity, size_t head) {
+    JoyBuffer* buf = joy_slab_alloc(sizeof(JoyBuffer));
+    buf->capacity = capacity > 0 ? capacity : 8;
+    buf->data = joy_slab_alloc(buf->capacity * sizeof(JoyValue));
+    buf->head = head;
+    buf->tail = head;
+    buf->refcount = 1;
+    buf->ops = NULL;
+    return buf;
+}
+
+/* Drop the lowered terms before the buffer's data moves or grows */
+static void joy_buffer_drop_ops(JoyBuffer* buf) {
+    joy_slab_free(buf->ops, buf->capacity * sizeof(JoyOp));
+    buf->ops = NULL;
+}
+
+/* Note a newly claimed slot so its old lowered term is not reused */
+static inline void joy_buffer_claimed(JoyBuffer* buf, size_t slot) {
+    if (buf->ops) buf->ops[slot].code = JOY_OP_LOWER;
+}
+
+static void joy_buffer_release(JoyBuffer* buf) {
+    if (!buf || --buf->refcount > 0) return;
+    for (size_t i = buf->head; i < buf->tail; i++) {
+        joy_value_free(&buf->data[i]);
+    }
+    joy_buffer_drop_ops(buf);
+    joy_slab_free(buf->data, buf->capacity * sizeof(JoyValue));
+    joy_slab_free(buf, sizeof(JoyBuffer));
+}
+
+/* Copy a view's items into a private buffer with `headroom` free slots in
+ * front and `tailroom` free slots behind. */
+static JoyBuffer* joy_buffer_from_view(JoyValue* items, size_t length,
+                                       size_t headroom, size_t tailroom) {
+    JoyBuffer* buf = joy_buffer_new(headroom + length + tailroom, headroom);
+    for (size_t i = 0; i < length; i++) {
+        buf->data[buf->tail++] = joy_value_copy(items[i]);
+    }
+    return buf;
+}
+
+/* Release the slots outside [start, end) of a buffer that has a single
+ * view, so that view can claim them again. */
+static void joy_buffer_trim(JoyBuffer* buf, size_t start, size_t end) {
+    for (size_t i = buf->head; i < start; i++) {
+        joy_value_free(&buf->data[i]);
+    }
+    for (size_t i = end; i < buf->tail; i++) {
+        joy_value_free(&buf->data[i]);
+    }
+    buf->head = start;
+    buf->tail = end;
+}
+
+/* Append to a view in place.  Claims the buffer's next free slot when the
+ * view ends at the buffer tail; grows the buffer only when nothing else can
+ * hold a pointer into it; otherwise detaches into a private buffer. */
+static void joy_view_push(JoyValue** items, size_t* length, JoyBuffer** buffer,
+                          size_t refcount, JoyValue value) {
+    JoyBuffer* buf = *buffer;
+    size_t start = (size_t)(*items - buf->data);
+    size_t end = start + *length;
+
+    if (buf->refcount == 1 && refcount == 1) {
+        joy_buffer_trim(buf, start, end);
+    }
+    if (end != buf->tail || (buf->tail == buf->capacity &&
+                             (buf->refcount > 1 || refcount > 1))) {
+        JoyBuffer* copy = joy_buffer_from_view(*items, *length, 0, *length + 8);
+        joy_buffer_release(buf);
+        buf = copy;
+        *buffer = buf;
+        *items = buf->data;
+        start = 0;
+    } else if (buf->tail == buf->capacity) {
+        joy_buffer_drop_ops(buf);
+        buf->data = joy_slab_realloc(buf->data, buf->capacity * sizeof(JoyValue),
+                                     buf->capacity * 2 * sizeof(JoyValue));
+        buf->capacity *= 2;
+        *items = buf->data + start;
+    }
+    joy_buffer_claimed(buf, buf->tail);
+    buf->data[buf->tail++] = value;
+    (*length)++;
+}
+
+/* Remove and return the last item of a uniquely-owned view */
+static JoyValue joy_view_pop(JoyValue* items, size_t* length, JoyBuffer* buffer) {
+    JoyValue* slot = &items[--(*length)];
+    if (buffer->refcount == 1 && slot == &buffer->data[buffer->tail - 1]) {
+        buffer->tail--;
+        return *slot;
+    }
+    return joy_value_copy(*slot);
+}
+
+/* Prepend a term to a view, returning the new view's first item.  The new
+ * view shares the source buffer when the slot in front of it is free. */
+static JoyValue* joy_view_cons(JoyValue** items, size_t length, JoyBuffer* buf,
+                               size_t refcount, JoyValue value, JoyBuffer** out) {
+    size_t start = (size_t)(*items - buf->data);
+
+    if (buf->refcount == 1 && refcount == 1) {
+        joy_buffer_trim(buf, start, start + length);
+    }
+    if (start == 0 && buf->refcount == 1 && refcount == 1) {
+        /* Sole owner: grow headroom in place */
+        size_t shift = buf->capacity > 8 ? buf->capacity : 8;
+        JoyValue* data = joy_slab_alloc((buf->capacity + shift) * sizeof(JoyValue));
+        memcpy(data + shift + buf->head, buf->data + buf->head,
+               (buf->tail - buf->head) * sizeof(JoyValue));
+        joy_buffer_drop_ops(buf);
+        joy_slab_free(buf->data, buf->capacity * sizeof(JoyValue));
+        buf->data = data;
+        buf->capacity += shift;
+        buf->head += shift;
+        buf->tail += shift;
+        start += shift;
+        *items = buf->data + start;
+    }
+
+    if (start == buf->head && start > 0) {
+        joy_buffer_claimed(buf, buf->head - 1);
+        buf->data[--buf->head] = joy_value_copy(value);
+        buf->refcount++;
+        *out = buf;
+        return &buf->data[buf->head];
+    }
+
+    /* Shared prefix slot already claimed: copy into a buffer with headroom */
+    size_t headroom = length + 8;
+    JoyBuffer* copy = joy_buffer_from_view(*items, length, headroom, 0);
+    copy->data[--copy->head] = joy_value_copy(value);
+    *out = copy;
+    return &copy->data[copy->head];
+}
+
+/* Concatenate two views.  The result extends a's buffer in place when a
+ * ends at its buffer tail and there is room (or a is the sole owner). */
+static JoyValue* joy_view_concat(JoyValue** a_items, size_t a_length, JoyBuffer* a_buf,
+                                 size_t a_refcount, JoyValue* b_items, size_t b_length,
+                                 JoyBuffer** out) {
+    size_t start = (size_t)(*a_items - a_buf->data);
+    size_t end = start + a_length;
+
+    if (a_buf->refcount == 1 && a_refcount == 1) {
+        joy_buffer_trim(a_buf, start, end);
+    }
+    if (end == a_buf->tail) {
+        if (a_buf->tail + b_length > a_buf->capacity &&
+            a_buf->refcount == 1 && a_refcount == 1) {
+            /* b may be a view of the same storage (e.g. `dup concat`) */
+            bool aliased = b_items >= a_buf->data && b_items < a_buf->data + a_buf->capacity;
+            size_t b_offset = aliased ? (size_t)(b_items - a_buf->data) : 0;
+            size_t needed = a_buf->tail + b_length;
+            size_t capacity = needed > a_buf->capacity * 2 ? needed : a_buf->capacity * 2;
+            joy_buffer_drop_ops(a_buf);
+            a_buf->data = joy_slab_realloc(a_buf->data, a_buf->capacity * sizeof(JoyValue),
+                                           capacity * sizeof(JoyValue));
+            a_buf->capacity = capacity;
+            *a_items = a_buf->data + start;
+            if (aliased) b_items = a_buf->data + b_offset;
+        }
+        if (a_buf->tail + b_length <= a_buf->capacity) {
+            for (size_t i = 0; i < b_length; i++) {
+                joy_buffer_claimed(a_buf, a_buf->tail);
+                a_buf->data[a_buf->tail++] = joy_value_copy(b_items[i]);
+            }
+            a_buf->refcount++;
+            *out = a_buf;
+            return *a_items;
+        }
+    }
+
+    JoyBuffer* buf = joy_buffer_from_view(*a_items, a_length, 0, b_length + 8);
+    for (size_t i = 0; i < b_length; i++) {
+        buf->data[buf->tail++] = joy_value_copy(b_items[i]);
     }
+    *out = buf;
+    return buf->data;
 }
 
 /* ---------- List Operations ---------- */
 
-JoyList* joy_list_new(size_t initial_capacity) {
-    JoyList* list = joy_alloc(sizeof(JoyList));
-    list->capacity = initial_capacity > 0 ? initial_capacity : 8;
-    list->items = joy_alloc(list->capacity * sizeof(JoyValue));
-    list->length = 0;
+static JoyList* joy_list_view(JoyValue* items, size_t length, JoyBuffer* buffer) {
+    JoyList* list = joy_slab_alloc(sizeof(JoyList));
+    joy_active_allocator->stats.values[JOY_LIST]++;
+    list->items = items;
+    list->length = length;
+    list->refcount = 1;
+    list->hash = 0;
+    list->buffer = buffer;
     return list;
 }
 
+JoyList* joy_list_new(size_t initial_capacity) {
+    JoyBuffer* buf = joy_buffer_new(initial_capacity, 0);
+    return joy_list_view(buf->data, 0, buf);
+}
+
 void joy_list_free(JoyList* list) {
-    if (!list) return;
-    for (size_t i = 0; i < list->length; i++) {
-        joy_value_free(&list->items[i]);
+    if (!list || --list->refcount > 0) return;
+    joy_buffer_release(list->buffer);
+    joy_slab_free(list, sizeof(JoyList));
+}
+
+JoyList* joy_list_retain(JoyList* list) {
+    list->refcount++;
+    return list;
+}
+
+JoyList* joy_list_unique(JoyList* list) {
+    if (list->refcount == 1 && list->buffer->refcount == 1) {
+        list->hash = 0;     /* the caller is about to change it */
+        return list;
     }
-    free(list->items);
-    free(list);
+    JoyBuffer* buf = joy_buffer_from_view(list->items, list->length, 0, 8);
+    JoyList* copy = joy_list_view(buf->data, list->length, buf);
+    joy_list_free(list);
+    return copy;
 }
 
 void joy_list_push(JoyList* list, JoyValue value) {
-    if (list->length >= list->capacity) {
-        list->capacity *= 2;
-        list->items = joy_realloc(list->items, list->capacity * sizeof(JoyValue));
-    }
-    list->items[list->length++] = value;
+    list->hash = 0;
+    joy_view_push(&list->items, &list->length, &list->buffer, list->refcount, value);
 }
 
 JoyValue joy_list_pop(JoyList* list) {
     if (list->length == 0) {
         joy_error("Cannot pop from empty list");
     }
-    return list->items[--list->length];
+    list->hash = 0;
+    return joy_view_pop(list->items, &list->length, list->buffer);
 }
 
 JoyValue joy_list_first(JoyList* list) {
@@ -433,19 +1290,23 @@ JoyValue joy_list_first(JoyList* list) {
 }
 
 JoyList* joy_list_rest(JoyList* list) {
-    JoyList* rest = joy_list_new(list->length > 1 ? list->length - 1 : 8);
-    for (size_t i = 1; i < list->length; i++) {
-        joy_list_push(rest, joy_value_copy(list->items[i]));
-    }
-    return rest;
+    return joy_list_drop(list, 1);
+}
+
+JoyList* joy_list_take(JoyList* list, size_t count) {
+    if (count > list->length) count = list->length;
+    list->buffer->refcount++;
+    return joy_list_view(list->items, count, list->buffer);
+}
+
+JoyList* joy_list_drop(JoyList* list, size_t count) {
+    if (count > list->length) count = list->length;
+    list->buffer->refcount++;
+    return joy_list_view(list->items + count, list->length - count, list->buffer);
 }
 
 JoyList* joy_list_copy(JoyList* list) {
-    JoyList* copy = joy_list_new(list->capacity);
-    for (size_t i = 0; i < list->length; i++) {
-        joy_list_push(copy, joy_value_copy(list->items[i]));
-    }
-    return copy;
+    return joy_list_retain(list);
 }
 
 size_t joy_list_length(JoyList* list) {
@@ -457,107 +1318,406 @@ bool joy_list_null(JoyList* list) {
 }
 
 JoyList* joy_list_concat(JoyList* a, JoyList* b) {
-    JoyList* result = joy_list_new(a->length + b->length);
-    for (size_t i = 0; i < a->length; i++) {
-        joy_list_push(result, joy_value_copy(a->items[i]));
-    }
-    for (size_t i = 0; i < b->length; i++) {
-        joy_list_push(result, joy_value_copy(b->items[i]));
-    }
-    return result;
+    if (b->length == 0) return joy_list_retain(a);
+    if (a->length == 0) return joy_list_retain(b);
+    JoyBuffer* buf;
+    JoyValue* items = joy_view_concat(&a->items, a->length, a->buffer, a->refcount,
+                                      b->items, b->length, &buf);
+    return joy_list_view(items, a->length + b->length, buf);
 }
 
 JoyList* joy_list_cons(JoyValue value, JoyList* list) {
-    JoyList* result = joy_list_new(list->length + 1);
-    joy_list_push(result, joy_value_copy(value));
-    for (size_t i = 0; i < list->length; i++) {
-        joy_list_push(result, joy_value_copy(list->items[i]));
-    }
-    return result;
+    JoyBuffer* buf;
+    JoyValue* items = joy_view_cons(&list->items, list->length, list->buffer,
+                                    list->refcount, value, &buf);
+    return joy_list_view(items, list->length + 1, buf);
 }
 
 /* ---------- Quotation Operations ---------- */
 
-JoyQuotation* joy_quotation_new(size_t initial_capacity) {
-    JoyQuotation* quot = joy_alloc(sizeof(JoyQuotation));
-    quot->capacity = initial_capacity > 0 ? initial_capacity : 8;
-    quot->terms = joy_alloc(quot->capacity * sizeof(JoyValue));
-    quot->length = 0;
+static JoyQuotation* joy_quotation_view(JoyValue* terms, size_t length, JoyBuffer* buffer) {
+    JoyQuotation* quot = joy_slab_alloc(sizeof(JoyQuotation));
+    joy_active_allocator->stats.values[JOY_QUOTATION]++;
+    quot->terms = terms;
+    quot->length = length;
+    quot->refcount = 1;
+    quot->hash = 0;
+    quot->buffer = buffer;
     return quot;
 }
 
+JoyQuotation* joy_quotation_new(size_t initial_capacity) {
+    JoyBuffer* buf = joy_buffer_new(initial_capacity, 0);
+    return joy_quotation_view(buf->data, 0, buf);
+}
+
 void joy_quotation_free(JoyQuotation* quotation) {
-    if (!quotation) return;
-    for (size_t i = 0; i < quotation->length; i++) {
-        joy_value_free(&quotation->terms[i]);
-    }
-    free(quotation->terms);
-    free(quotation);
+    if (!quotation || --quotation->refcount > 0) return;
+    joy_buffer_release(quotation->buffer);
+    joy_slab_free(quotation, sizeof(JoyQuotation));
+}
+
+JoyQuotation* joy_quotation_retain(JoyQuotation* quotation) {
+    quotation->refcount++;
+    return quotation;
 }
 
 void joy_quotation_push(JoyQuotation* quotation, JoyValue term) {
-    if (quotation->length >= quotation->capacity) {
-        quotation->capacity *= 2;
-        quotation->terms = joy_realloc(quotation->terms, quotation->capacity * sizeof(JoyValue));
-    }
-    quotation->terms[quotation->length++] = term;
+    quotation->hash = 0;
+    joy_view_push(&quotation->terms, &quotation->length, &quotation->buffer,
+                  quotation->refcount, term);
 }
 
 JoyQuotation* joy_quotation_copy(JoyQuotation* quotation) {
-    JoyQuotation* copy = joy_quotation_new(quotation->capacity);
-    for (size_t i = 0; i < quotation->length; i++) {
-        joy_quotation_push(copy, joy_value_copy(quotation->terms[i]));
-    }
-    return copy;
+    return joy_quotation_retain(quotation);
+}
+
+JoyQuotation* joy_quotation_rest(JoyQuotation* quotation) {
+    return joy_quotation_drop(quotation, 1);
+}
+
+JoyQuotation* joy_quotation_take(JoyQuotation* quotation, size_t count) {
+    if (count > quotation->length) count = quotation->length;
+    quotation->buffer->refcount++;
+    return joy_quotation_view(quotation->terms, count, quotation->buffer);
+}
+
+JoyQuotation* joy_quotation_drop(JoyQuotation* quotation, size_t count) {
+    if (count > quotation->length) count = quotation->length;
+    quotation->buffer->refcount++;
+    return joy_quotation_view(quotation->terms + count, quotation->length - count,
+                              quotation->buffer);
+}
+
+JoyQuotation* joy_quotation_cons(JoyValue term, JoyQuotation* quotation) {
+    JoyBuffer* buf;
+    JoyValue* terms = joy_view_cons(&quotation->terms, quotation->length,
+                                    quotation->buffer, quotation->refcount, term, &buf);
+    return joy_quotation_view(terms, quotation->length + 1, buf);
 }
 
 JoyQuotation* joy_quotation_concat(JoyQuotation* a, JoyQuotation* b) {
-    JoyQuotation* result = joy_quotation_new(a->length + b->length);
-    for (size_t i = 0; i < a->length; i++) {
-        joy_quotation_push(result, joy_value_copy(a->terms[i]));
+    if (b->length == 0) return joy_quotation_retain(a);
+    if (a->length == 0) return joy_quotation_retain(b);
+    JoyBuffer* buf;
+    JoyValue* terms = joy_view_concat(&a->terms, a->length, a->buffer, a->refcount,
+                                      b->terms, b->length, &buf);
+    return joy_quotation_view(terms, a->length + b->length, buf);
+}
+
+/* ---------- Set Operations ---------- */
+
+/* Sets work a 64-bit word at a time: set algebra runs on vector registers
+ * and counting uses the hardware popcount instruction where the CPU has one. */
+
+#if defined(__GNUC__)
+#define joy_popcount64(w) ((size_t)__builtin_popcountll(w))
+#define joy_ctz64(w) ((int)__builtin_ctzll(w))
+#else
+static inline size_t joy_popcount64(uint64_t w) {
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (size_t)((w * 0x0101010101010101ULL) >> 56);
+}
+
+static inline int joy_ctz64(uint64_t w) {
+    return (int)joy_popcount64((w & (0 - w)) - 1);
+}
+#endif
+
+static size_t joy_popcount_words(const uint64_t* bits, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += joy_popcount64(bits[i]);
     }
-    for (size_t i = 0; i < b->length; i++) {
-        joy_quotation_push(result, joy_value_copy(b->terms[i]));
+    return count;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+/* The x86-64 baseline has no popcnt; use it when the CPU does */
+__attribute__((target("popcnt")))
+static size_t joy_popcount_words_hw(const uint64_t* bits, size_t words) {
+    size_t count = 0;
+    for (size_t i = 0; i < words; i++) {
+        count += joy_popcount64(bits[i]);
     }
-    return result;
+    return count;
 }
+#endif
 
-/* ---------- Set Operations ---------- */
+static size_t joy_popcount(const uint64_t* bits, size_t words) {
+#if defined(__GNUC__) && defined(__x86_64__)
+    if (__builtin_cpu_supports("popcnt")) {
+        return joy_popcount_words_hw(bits, words);
+    }
+#endif
+    return joy_popcount_words(bits, words);
+}
+
+/* out[i] = a[i] OP b[i], four words per vector operation where the
+ * compiler has vector extensions (SSE2 or NEON on common targets) */
+#if defined(__GNUC__)
+typedef uint64_t JoyWordVec __attribute__((vector_size(32)));
+
+#define JOY_WORDS_OP(name, expr)                                              \
+    static void name(uint64_t* restrict out, const uint64_t* restrict a,      \
+                     const uint64_t* restrict b, size_t n) {                  \
+        size_t i = 0;                                                         \
+        for (; i + 4 <= n; i += 4) {                                          \
+            JoyWordVec x, y, r;                                               \
+            memcpy(&x, a + i, sizeof x);                                      \
+            memcpy(&y, b + i, sizeof y);                                      \
+            r = expr;                                                         \
+            memcpy(out + i, &r, sizeof r);                                    \
+        }                                                                     \
+        for (; i < n; i++) {                                                  \
+            uint64_t x = a[i], y = b[i];                                      \
+            out[i] = expr;                                                    \
+        }                                                                     \
+    }
+#else
+#define JOY_WORDS_OP(name, expr)                                              \
+    static void name(uint64_t* restrict out, const uint64_t* restrict a,      \
+                     const uint64_t* restrict b, size_t n) {                  \
+        for (size_t i = 0; i < n; i++) {                                      \
+            uint64_t x = a[i], y = b[i];                                      \
+            out[i] = expr;                                                    \
+        }                                                                     \
+    }
+#endif
 
-bool joy_set_member(uint64_t set, int member) {
-    if (member < 0 || member >= 64) return false;
-    return (set & (1ULL << member)) != 0;
+JOY_WORDS_OP(joy_words_or, x | y)
+JOY_WORDS_OP(joy_words_and, x & y)
+JOY_WORDS_OP(joy_words_andnot, x & ~y)
+JOY_WORDS_OP(joy_words_xor, x ^ y)
+
+static size_t joy_bitset_bytes(size_t words) {
+    return sizeof(JoyBitset) + words * sizeof(uint64_t);
+}
+
+static JoyBitset* joy_bitset_new(size_t words) {
+    JoyBitset* set = joy_slab_alloc(joy_bitset_bytes(words));
+    joy_active_allocator->stats.values[JOY_SET]++;
+    set->refcount = 1;
+    set->words = words;
+    memset(set->bits, 0, words * sizeof(uint64_t));
+    return set;
 }
 
-uint64_t joy_set_insert(uint64_t set, int member) {
-    if (member < 0 || member >= 64) return set;
-    return set | (1ULL << member);
+static void joy_bitset_release(JoyBitset* set) {
+    if (set && --set->refcount == 0) {
+        joy_slab_free(set, joy_bitset_bytes(set->words));
+    }
 }
 
-uint64_t joy_set_remove(uint64_t set, int member) {
-    if (member < 0 || member >= 64) return set;
-    return set & ~(1ULL << member);
+/* Zeroed result words for a set operation: the inline word when one word
+ * is enough (no allocation), otherwise a fresh bitset in *wide */
+static uint64_t* joy_set_begin(JoyBitset** wide, uint64_t* word, size_t words) {
+    *word = 0;
+    if (words <= 1) {
+        *wide = NULL;
+        return word;
+    }
+    *wide = joy_bitset_new(words);
+    return (*wide)->bits;
+}
+
+/* Turn joy_set_begin's words into a value, trimmed to canonical form */
+static JoyValue joy_set_end(JoyBitset* wide, uint64_t word) {
+    JoyValue v = {.type = JOY_SET};
+    if (!wide) {
+        v.data.set = word;
+        return v;
+    }
+    size_t words = wide->words;
+    while (words > 1 && wide->bits[words - 1] == 0) words--;
+    if (words == 1) {
+        v.data.set = wide->bits[0];
+        joy_bitset_release(wide);
+        return v;
+    }
+    if (words < wide->words) {
+        wide = joy_slab_realloc(wide, joy_bitset_bytes(wide->words), joy_bitset_bytes(words));
+        wide->words = words;
+    }
+    v.wide_set = true;
+    v.data.bitset = wide;
+    return v;
 }
 
-uint64_t joy_set_union(uint64_t a, uint64_t b) {
-    return a | b;
+JoyValue joy_set_empty(void) {
+    JoyValue v = {.type = JOY_SET};
+    v.data.set = 0;
+    return v;
 }
 
-uint64_t joy_set_intersection(uint64_t a, uint64_t b) {
-    return a & b;
+JoyValue joy_set_from(int* members, size_t count) {
+    int top = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (members[i] > top && members[i] < JOY_SET_LIMIT) top = members[i];
+    }
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* bits = joy_set_begin(&wide, &word, (size_t)top / 64 + 1);
+    for (size_t i = 0; i < count; i++) {
+        if (members[i] >= 0 && members[i] < JOY_SET_LIMIT) {
+            bits[members[i] / 64] |= 1ULL << (members[i] % 64);
+        }
+    }
+    return joy_set_end(wide, word);
 }
 
-uint64_t joy_set_difference(uint64_t a, uint64_t b) {
-    return a & ~b;
+bool joy_set_member(const JoyValue* set, int64_t member) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    if (member < 0 || (uint64_t)member / 64 >= words) return false;
+    return (bits[member / 64] >> (member % 64)) & 1;
 }
 
-size_t joy_set_size(uint64_t set) {
-    size_t count = 0;
-    while (set) {
-        count += set & 1;
-        set >>= 1;
+JoyValue joy_set_insert(const JoyValue* set, int64_t member) {
+    if (member < 0 || member >= JOY_SET_LIMIT) {
+        joy_error("set member out of range");
     }
-    return count;
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    size_t index = (size_t)member / 64;
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, index < words ? words : index + 1);
+    memcpy(out, bits, words * sizeof(uint64_t));
+    out[index] |= 1ULL << (member % 64);
+    return joy_set_end(wide, word);
+}
+
+JoyValue joy_set_remove(const JoyValue* set, int64_t member) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, words);
+    memcpy(out, bits, words * sizeof(uint64_t));
+    if (member >= 0 && (uint64_t)member / 64 < words) {
+        out[member / 64] &= ~(1ULL << (member % 64));
+    }
+    return joy_set_end(wide, word);
+}
+
+JoyValue joy_set_union(const JoyValue* a, const JoyValue* b) {
+    size_t a_words, b_words;
+    const uint64_t* a_bits = joy_set_words(a, &a_words);
+    const uint64_t* b_bits = joy_set_words(b, &b_words);
+    if (a_words < b_words) {
+        return joy_set_union(b, a);
+    }
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, a_words);
+    joy_words_or(out, a_bits, b_bits, b_words);
+    memcpy(out + b_words, a_bits + b_words, (a_words - b_words) * sizeof(uint64_t));
+    return joy_set_end(wide, word);
+}
+
+JoyValue joy_set_intersection(const JoyValue* a, const JoyValue* b) {
+    size_t a_words, b_words;
+    const uint64_t* a_bits = joy_set_words(a, &a_words);
+    const uint64_t* b_bits = joy_set_words(b, &b_words);
+    size_t words = a_words < b_words ? a_words : b_words;
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, words);
+    joy_words_and(out, a_bits, b_bits, words);
+    return joy_set_end(wide, word);
+}
+
+JoyValue joy_set_difference(const JoyValue* a, const JoyValue* b) {
+    size_t a_words, b_words;
+    const uint64_t* a_bits = joy_set_words(a, &a_words);
+    const uint64_t* b_bits = joy_set_words(b, &b_words);
+    size_t shared = a_words < b_words ? a_words : b_words;
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, a_words);
+    joy_words_andnot(out, a_bits, b_bits, shared);
+    memcpy(out + shared, a_bits + shared, (a_words - shared) * sizeof(uint64_t));
+    return joy_set_end(wide, word);
+}
+
+JoyValue joy_set_xor(const JoyValue* a, const JoyValue* b) {
+    size_t a_words, b_words;
+    const uint64_t* a_bits = joy_set_words(a, &a_words);
+    const uint64_t* b_bits = joy_set_words(b, &b_words);
+    if (a_words < b_words) {
+        return joy_set_xor(b, a);
+    }
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, a_words);
+    joy_words_xor(out, a_bits, b_bits, b_words);
+    memcpy(out + b_words, a_bits + b_words, (a_words - b_words) * sizeof(uint64_t));
+    return joy_set_end(wide, word);
+}
+
+/* Complement within 0-63 (setsize), like the evaluator: members past 63
+ * have no place in the universe and drop out, however wide the set is */
+JoyValue joy_set_complement(const JoyValue* set) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    JoyValue v = {.type = JOY_SET};
+    v.data.set = ~bits[0];
+    return v;
+}
+
+/* Members whose rank (position in ascending order) is in [start, end) */
+JoyValue joy_set_range(const JoyValue* set, size_t start, size_t end) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    JoyBitset* wide;
+    uint64_t word;
+    uint64_t* out = joy_set_begin(&wide, &word, words);
+    size_t rank = 0;
+    for (size_t i = 0; i < words && rank < end; i++) {
+        uint64_t w = bits[i];
+        size_t n = joy_popcount64(w);
+        if (rank + n <= start) {
+            rank += n;
+        } else if (rank >= start && rank + n <= end) {
+            out[i] = w;
+            rank += n;
+        } else {
+            for (; w; w &= w - 1, rank++) {
+                if (rank >= start && rank < end) out[i] |= w & (0 - w);
+            }
+        }
+    }
+    return joy_set_end(wide, word);
+}
+
+bool joy_set_equal(const JoyValue* a, const JoyValue* b) {
+    size_t a_words, b_words;
+    const uint64_t* a_bits = joy_set_words(a, &a_words);
+    const uint64_t* b_bits = joy_set_words(b, &b_words);
+    return a_words == b_words && memcmp(a_bits, b_bits, a_words * sizeof(uint64_t)) == 0;
+}
+
+size_t joy_set_size(const JoyValue* set) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    return words == 1 ? joy_popcount64(bits[0]) : joy_popcount(bits, words);
+}
+
+int64_t joy_set_next(const JoyValue* set, int64_t from) {
+    size_t words;
+    const uint64_t* bits = joy_set_words(set, &words);
+    if (from < 0) from = 0;
+    size_t index = (size_t)from / 64;
+    if (index >= words) return -1;
+    uint64_t w = bits[index] & (~0ULL << (from % 64));
+    while (!w) {
+        if (++index == words) return -1;
+        w = bits[index];
+    }
+    return (int64_t)(index * 64) + joy_ctz64(w);
 }
 
 /* ---------- Stack Operations ---------- */
@@ -565,8 +1725,13 @@ size_t joy_set_size(uint64_t set) {
 JoyStack* joy_stack_new(size_t initial_capacity) {
     JoyStack* stack = joy_alloc(sizeof(JoyStack));
     stack->capacity = initial_capacity > 0 ? initial_capacity : 64;
+    joy_charge(joy_active_allocator, stack->capacity * sizeof(JoyValue));
     stack->items = joy_alloc(stack->capacity * sizeof(JoyValue));
     stack->depth = 0;
+    stack->low = 0;
+    stack->undo = NULL;
+    stack->undo_length = 0;
+    stack->undo_capacity = 0;
     return stack;
 }
 
@@ -575,12 +1740,36 @@ void joy_stack_free(JoyStack* stack) {
     for (size_t i = 0; i < stack->depth; i++) {
         joy_value_free(&stack->items[i]);
     }
+    for (size_t i = 0; i < stack->undo_length; i++) {
+        joy_value_free(&stack->undo[i]);
+    }
+    joy_credit(joy_active_allocator, stack->capacity * sizeof(JoyValue));
     free(stack->items);
+    free(stack->undo);
     free(stack);
 }
 
+/* Record the original value of the slot just below the watermark and
+ * lower the watermark over it.  Takes ownership of `value`. */
+static void joy_stack_log(JoyStack* stack, JoyValue value) {
+    if (stack->undo_length >= stack->undo_capacity) {
+        stack->undo_capacity = stack->undo_capacity ? stack->undo_capacity * 2 : 16;
+        stack->undo = joy_realloc(stack->undo, stack->undo_capacity * sizeof(JoyValue));
+    }
+    stack->undo[stack->undo_length++] = value;
+    stack->low--;
+}
+
+/* Make the top n slots safe to modify in place under a checkpoint */
+static void joy_stack_expose(JoyStack* stack, size_t n) {
+    while (stack->low > stack->depth - n) {
+        joy_stack_log(stack, joy_value_copy(stack->items[stack->low - 1]));
+    }
+}
+
 void joy_stack_push(JoyStack* stack, JoyValue value) {
     if (stack->depth >= stack->capacity) {
+        joy_charge(joy_active_allocator, stack->capacity * sizeof(JoyValue));
         stack->capacity *= 2;
         stack->items = joy_realloc(stack->items, stack->capacity * sizeof(JoyValue));
     }
@@ -591,6 +1780,9 @@ JoyValue joy_stack_pop(JoyStack* stack) {
     if (stack->depth == 0) {
         joy_error("Stack underflow");
     }
+    if (stack->depth == stack->low) {
+        joy_stack_log(stack, joy_value_copy(stack->items[stack->depth - 1]));
+    }
     return stack->items[--stack->depth];
 }
 
@@ -619,6 +1811,7 @@ void joy_stack_swap(JoyStack* stack) {
     if (stack->depth < 2) {
         joy_error_underflow("swap", 2, stack->depth);
     }
+    joy_stack_expose(stack, 2);
     JoyValue tmp = stack->items[stack->depth - 1];
     stack->items[stack->depth - 1] = stack->items[stack->depth - 2];
     stack->items[stack->depth - 2] = tmp;
@@ -628,7 +1821,12 @@ void joy_stack_pop_free(JoyStack* stack) {
     if (stack->depth == 0) {
         joy_error("Stack underflow");
     }
-    joy_value_free(&stack->items[--stack->depth]);
+    stack->depth--;
+    if (stack->depth < stack->low) {
+        joy_stack_log(stack, stack->items[stack->depth]);
+    } else {
+        joy_value_free(&stack->items[stack->depth]);
+    }
 }
 
 size_t joy_stack_depth(JoyStack* stack) {
@@ -637,7 +1835,7 @@ size_t joy_stack_depth(JoyStack* stack) {
 
 void joy_stack_clear(JoyStack* stack) {
     while (stack->depth > 0) {
-        joy_value_free(&stack->items[--stack->depth]);
+        joy_stack_pop_free(stack);
     }
 }
 
@@ -649,86 +1847,171 @@ JoyStack* joy_stack_copy(JoyStack* stack) {
     return copy;
 }
 
+void joy_stack_checkpoint(JoyStack* stack, JoyCheckpoint* cp) {
+    cp->depth = stack->depth;
+    cp->low = stack->low;
+    cp->undo_length = stack->undo_length;
+    stack->low = stack->depth;
+}
+
+void joy_stack_rollback(JoyStack* stack, JoyCheckpoint* cp) {
+    /* Slots at or above the watermark were pushed by the run */
+    while (stack->depth > stack->low) {
+        joy_value_free(&stack->items[--stack->depth]);
+    }
+    /* Put back the originals it popped, deepest last in the log */
+    while (stack->undo_length > cp->undo_length) {
+        joy_stack_push(stack, stack->undo[--stack->undo_length]);
+    }
+    stack->low = stack->depth;
+}
+
+void joy_stack_release(JoyStack* stack, JoyCheckpoint* cp) {
+    /* Log entry k holds slot cp->depth - 1 - k.  The enclosing checkpoint
+     * still needs the originals of slots below its own watermark. */
+    size_t count = stack->undo_length - cp->undo_length;
+    size_t drop = cp->depth - cp->low;
+    if (drop > count) drop = count;
+    if (cp->low < stack->low) {
+        stack->low = cp->low;
+    }
+    if (count == 0) return;
+    JoyValue* log = stack->undo + cp->undo_length;
+    for (size_t k = 0; k < drop; k++) {
+        joy_value_free(&log[k]);
+    }
+    memmove(log, log + drop, (count - drop) * sizeof(JoyValue));
+    stack->undo_length -= drop;
+}
+
+void joy_stack_restore(JoyStack* stack, JoyCheckpoint* cp) {
+    joy_stack_rollback(stack, cp);
+    joy_stack_release(stack, cp);
+}
+
+bool joy_stack_pop_truthy(JoyStack* stack) {
+    JoyValue v = joy_stack_pop(stack);
+    bool result = joy_value_truthy(v);
+    joy_value_free(&v);
+    return result;
+}
+
+JoyValue* joy_aggregate_items(JoyValue* agg, size_t* length, const char* op) {
+    if (agg->type == JOY_LIST) {
+        *length = agg->data.list->length;
+        return agg->data.list->items;
+    }
+    if (agg->type == JOY_QUOTATION) {
+        *length = agg->data.quotation->length;
+        return agg->data.quotation->terms;
+    }
+    joy_error_type(op, "aggregate", agg->type);
+    return NULL;
+}
+
 void joy_stack_print(JoyStack* stack) {
-    printf("Stack(%zu): ", stack->depth);
+    joy_output_string("Stack(");
+    joy_output_integer((int64_t)stack->depth);
+    joy_output_string("): ");
     for (size_t i = 0; i < stack->depth; i++) {
-        if (i > 0) printf(" ");
+        if (i > 0) joy_output_char(' ');
         joy_value_print(stack->items[i]);
     }
-    printf("\n");
+    joy_output_char('\n');
 }
 
 /* ---------- Dictionary Operations ---------- */
 
-static size_t hash_string(const char* s) {
-    size_t hash = 5381;
-    int c;
-    while ((c = *s++)) {
-        hash = ((hash << 5) + hash) + c;
-    }
-    return hash;
+/* Source of dictionary epochs; unique across all dictionaries so a call
+ * site can never mistake a new dictionary for one it has already seen */
+static atomic_uint_fast64_t joy_dict_generation = 0;
+
+static uint64_t joy_dict_next_epoch(void) {
+    return atomic_fetch_add(&joy_dict_generation, 1) + 1;
 }
 
+#define JOY_DICT_INITIAL_CAPACITY 64
+
 JoyDict* joy_dict_new(void) {
     JoyDict* dict = joy_alloc(sizeof(JoyDict));
-    dict->bucket_count = 256;
-    dict->buckets = joy_alloc(dict->bucket_count * sizeof(JoyDictEntry*));
-    memset(dict->buckets, 0, dict->bucket_count * sizeof(JoyDictEntry*));
+    dict->capacity = JOY_DICT_INITIAL_CAPACITY;
+    dict->entries = joy_alloc(dict->capacity * sizeof(JoyDictEntry));
+    memset(dict->entries, 0, dict->capacity * sizeof(JoyDictEntry));
     dict->count = 0;
+    dict->builtins = false;
+    dict->epoch = joy_dict_next_epoch();
     return dict;
 }
 
+static void joy_word_free(JoyWord* word) {
+    if (!word->is_primitive && word->body.quotation) {
+        joy_quotation_free(word->body.quotation);
+    }
+    free(word);
+}
+
 void joy_dict_free(JoyDict* dict) {
     if (!dict) return;
-    for (size_t i = 0; i < dict->bucket_count; i++) {
-        JoyDictEntry* entry = dict->buckets[i];
-        while (entry) {
-            JoyDictEntry* next = entry->next;
-            free(entry->key);
-            if (!entry->word->is_primitive && entry->word->body.quotation) {
-                joy_quotation_free(entry->word->body.quotation);
-            }
-            free(entry->word->name);
-            free(entry->word);
-            free(entry);
-            entry = next;
+    for (size_t i = 0; i < dict->capacity; i++) {
+        if (dict->entries[i].key) {
+            joy_word_free(dict->entries[i].word);
         }
     }
-    free(dict->buckets);
+    free(dict->entries);
     free(dict);
 }
 
-static void joy_dict_set(JoyDict* dict, const char* name, JoyWord* word) {
-    size_t bucket = hash_string(name) % dict->bucket_count;
-
-    /* Check if exists */
-    JoyDictEntry* entry = dict->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->key, name) == 0) {
-            /* Replace existing */
-            if (!entry->word->is_primitive && entry->word->body.quotation) {
-                joy_quotation_free(entry->word->body.quotation);
-            }
-            free(entry->word->name);
-            free(entry->word);
-            entry->word = word;
-            return;
+/* Slot holding key, or the empty slot where it belongs */
+static JoyDictEntry* joy_dict_slot(JoyDict* dict, const char* key) {
+    size_t mask = dict->capacity - 1;
+    size_t slot = joy_symbol_hash(key) & mask;
+    while (dict->entries[slot].key && dict->entries[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &dict->entries[slot];
+}
+
+static void joy_dict_grow(JoyDict* dict) {
+    JoyDictEntry* old = dict->entries;
+    size_t old_capacity = dict->capacity;
+    dict->capacity *= 2;
+    dict->entries = joy_alloc(dict->capacity * sizeof(JoyDictEntry));
+    memset(dict->entries, 0, dict->capacity * sizeof(JoyDictEntry));
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].key) {
+            *joy_dict_slot(dict, old[i].key) = old[i];
         }
-        entry = entry->next;
     }
+    free(old);
+}
 
-    /* Add new */
-    entry = joy_alloc(sizeof(JoyDictEntry));
-    entry->key = joy_strdup(name);
+static void joy_dict_set(JoyDict* dict, const char* name, JoyWord* word) {
+    const char* key = joy_intern(name);
+    word->name = key;
+
+    /* Invalidate every cached call site */
+    dict->epoch = joy_dict_next_epoch();
+
+    JoyDictEntry* entry = joy_dict_slot(dict, key);
+    if (entry->key) {
+        /* Replace existing */
+        joy_word_free(entry->word);
+        entry->word = word;
+        return;
+    }
+
+    /* Add new, keeping the table at most half full */
+    if ((dict->count + 1) * 2 > dict->capacity) {
+        joy_dict_grow(dict);
+        entry = joy_dict_slot(dict, key);
+    }
+    entry->key = key;
     entry->word = word;
-    entry->next = dict->buckets[bucket];
-    dict->buckets[bucket] = entry;
     dict->count++;
 }
 
 void joy_dict_define_primitive(JoyDict* dict, const char* name, JoyPrimitive fn) {
     JoyWord* word = joy_alloc(sizeof(JoyWord));
-    word->name = joy_strdup(name);
     word->is_primitive = true;
     word->is_user = false;  /* Built-in primitive */
     word->body.primitive = fn;
@@ -740,7 +2023,6 @@ void joy_dict_define_user(JoyDict* dict, const char* name, JoyPrimitive fn) {
      * Used for compiled user definitions that execute as C functions but should
      * be recognized as user-defined words by the 'user' predicate. */
     JoyWord* word = joy_alloc(sizeof(JoyWord));
-    word->name = joy_strdup(name);
     word->is_primitive = true;   /* Body is a function pointer */
     word->is_user = true;        /* Mark as user-defined for 'user' predicate */
     word->body.primitive = fn;
@@ -749,56 +2031,158 @@ void joy_dict_define_user(JoyDict* dict, const char* name, JoyPrimitive fn) {
 
 void joy_dict_define_quotation(JoyDict* dict, const char* name, JoyQuotation* quot) {
     JoyWord* word = joy_alloc(sizeof(JoyWord));
-    word->name = joy_strdup(name);
     word->is_primitive = false;  /* Body is a quotation */
     word->is_user = true;        /* User-defined via quotation */
     word->body.quotation = quot;
     joy_dict_set(dict, name, word);
 }
 
-JoyWord* joy_dict_lookup(JoyDict* dict, const char* name) {
-    size_t bucket = hash_string(name) % dict->bucket_count;
-    JoyDictEntry* entry = dict->buckets[bucket];
-    while (entry) {
-        if (strcmp(entry->key, name) == 0) {
-            return entry->word;
+void joy_dict_define_builtins(JoyDict* dict) {
+    dict->builtins = true;
+    dict->epoch = joy_dict_next_epoch();
+}
+
+JoyDict* joy_dict_clone(JoyDict* dict) {
+    JoyDict* clone = joy_alloc(sizeof(JoyDict));
+    clone->capacity = dict->capacity;
+    clone->entries = joy_alloc(clone->capacity * sizeof(JoyDictEntry));
+    for (size_t i = 0; i < dict->capacity; i++) {
+        clone->entries[i].key = dict->entries[i].key;
+        clone->entries[i].word = NULL;
+        if (!dict->entries[i].key) continue;
+        JoyWord* word = joy_alloc(sizeof(JoyWord));
+        *word = *dict->entries[i].word;
+        if (!word->is_primitive && word->body.quotation) {
+            JoyValue body = {.type = JOY_QUOTATION, .data.quotation = word->body.quotation};
+            word->body.quotation = joy_value_clone(body).data.quotation;
         }
-        entry = entry->next;
+        clone->entries[i].word = word;
     }
-    return NULL;
+    clone->count = dict->count;
+    clone->builtins = dict->builtins;
+    clone->epoch = joy_dict_next_epoch();
+    return clone;
+}
+
+const JoyWord* joy_dict_lookup_symbol(JoyDict* dict, const char* symbol) {
+    JoyDictEntry* entry = joy_dict_slot(dict, symbol);
+    if (entry->key) {
+        return entry->word;
+    }
+    return dict->builtins ? joy_builtin_lookup(symbol) : NULL;
+}
+
+const JoyWord* joy_dict_lookup(JoyDict* dict, const char* name) {
+    return joy_dict_lookup_symbol(dict, joy_intern(name));
 }
 
 /* ---------- Execution ---------- */
 
+#define JOY_FRAMES_INITIAL 32
+
 JoyContext* joy_context_new(void) {
     JoyContext* ctx = joy_alloc(sizeof(JoyContext));
+    ctx->allocator = joy_allocator_new();
+    joy_allocator_use(ctx->allocator);
+    ctx->output = joy_output_new(stdout);
+    joy_output_use(ctx->output);
     ctx->stack = joy_stack_new(64);
     ctx->dictionary = joy_dict_new();
+    ctx->frame_capacity = JOY_FRAMES_INITIAL;
+    ctx->frames = joy_alloc(ctx->frame_capacity * sizeof(JoyFrame));
+    ctx->frame_depth = 0;
+    ctx->tail_pending = false;
     ctx->trace_enabled = false;
     ctx->autoput = 1;      /* on by default (matches Joy42) */
     ctx->undeferror = 0;   /* undefined symbols are errors by default */
     ctx->echo = 0;         /* no echo by default */
+    ctx->tracegc = 0;
+    ctx->rand_state = 1;
+    ctx->argc = 0;
+    ctx->argv = NULL;
+    ctx->memo = NULL;
+    joy_allocator_set_limit(ctx->allocator, joy_memory_limit_env());
+    return ctx;
+}
+
+JoyContext* joy_context_clone(JoyContext* parent) {
+    JoyContext* ctx = joy_context_new();
+    joy_dict_free(ctx->dictionary);
+    ctx->dictionary = joy_dict_clone(parent->dictionary);
+    ctx->trace_enabled = parent->trace_enabled;
+    ctx->autoput = parent->autoput;
+    ctx->undeferror = parent->undeferror;
+    ctx->echo = parent->echo;
+    ctx->tracegc = parent->tracegc;
+    ctx->rand_state = parent->rand_state;
+    ctx->argc = parent->argc;
+    ctx->argv = parent->argv;
     return ctx;
 }
 
+void joy_context_reset(JoyContext* ctx) {
+    joy_allocator_use(ctx->allocator);
+    joy_output_use(ctx->output);
+    while (ctx->frame_depth > 0) {
+        JoyFrame* frame = &ctx->frames[--ctx->frame_depth];
+        if (frame->owned) joy_value_free(&frame->hold);
+    }
+    if (ctx->tail_pending) joy_value_free(&ctx->tail);
+    ctx->tail_pending = false;
+    while (ctx->stack->depth > 0) {
+        JoyValue v = joy_stack_pop(ctx->stack);
+        joy_value_free(&v);
+    }
+    joy_memo_free(ctx->memo);
+    ctx->memo = NULL;
+    ctx->trace_enabled = false;
+    ctx->autoput = 1;
+    ctx->undeferror = 0;
+    ctx->echo = 0;
+    ctx->tracegc = 0;
+    ctx->rand_state = 1;
+}
+
 void joy_context_free(JoyContext* ctx) {
     if (!ctx) return;
+    /* Values go back to the allocator they came from */
+    joy_allocator_use(ctx->allocator);
+    while (ctx->frame_depth > 0) {
+        JoyFrame* frame = &ctx->frames[--ctx->frame_depth];
+        if (frame->owned) joy_value_free(&frame->hold);
+    }
+    free(ctx->frames);
+    if (ctx->tail_pending) joy_value_free(&ctx->tail);
     joy_stack_free(ctx->stack);
     joy_dict_free(ctx->dictionary);
+    joy_memo_free(ctx->memo);
+    joy_allocator_free(ctx->allocator);
+    joy_output_free(ctx->output);
     free(ctx);
 }
 
+static void joy_error_undefined(const char* name) {
+    joy_output_flush();
+    fprintf(stderr, "Undefined word: %s\n", name);
+    joy_error("Undefined word");
+}
+
 void joy_execute_value(JoyContext* ctx, JoyValue value) {
     if (ctx->trace_enabled) {
-        printf("  exec: ");
+        joy_output_string("  exec: ");
         joy_value_print(value);
-        printf("\n");
+        joy_output_char('\n');
     }
 
     switch (value.type) {
-        case JOY_SYMBOL:
-            joy_execute_symbol(ctx, value.data.symbol);
+        case JOY_SYMBOL: {
+            const JoyWord* word = joy_dict_lookup_symbol(ctx->dictionary, value.data.symbol);
+            if (!word) {
+                joy_error_undefined(value.data.symbol);
+            }
+            joy_execute_word(ctx, word);
             break;
+        }
         default:
             /* Push literals onto the stack */
             joy_stack_push(ctx->stack, joy_value_copy(value));
@@ -806,23 +2190,260 @@ void joy_execute_value(JoyContext* ctx, JoyValue value) {
     }
 }
 
+/* Call a word's C function.  Profiling builds time builtins here;
+ * compiled definitions time themselves. */
+static inline void joy_call_function(JoyContext* ctx, const JoyWord* word) {
+#ifdef JOY_PROFILE
+    if (!word->is_user) {
+        joy_profile_enter(ctx, word->name);
+        word->body.primitive(ctx);
+        joy_profile_leave(ctx);
+        return;
+    }
+#endif
+    word->body.primitive(ctx);
+}
+
+void joy_execute_word(JoyContext* ctx, const JoyWord* word) {
+    if (word->is_primitive) {
+        joy_call_function(ctx, word);
+        joy_run_tail(ctx);
+    } else {
+        /* Hold the body in case the word is redefined while it runs */
+        JoyQuotation* body = joy_quotation_retain(word->body.quotation);
+        joy_execute_quotation(ctx, body);
+        joy_quotation_free(body);
+    }
+}
+
+/* Resolve a call site, looking the interned name up only when the cache is stale */
+static inline const JoyWord* joy_resolve_site(JoyContext* ctx, JoyCallSite* site, const char* name) {
+    JoyDict* dict = ctx->dictionary;
+    if (site->dict != dict || site->epoch != dict->epoch) {
+        site->word = joy_dict_lookup_symbol(dict, name);
+        site->dict = dict;
+        site->epoch = dict->epoch;
+    }
+    if (!site->word) {
+        joy_error_undefined(name);
+    }
+    return site->word;
+}
+
+/* Point a frame at terms.  They run through lowered ops kept alongside
+ * the buffer slots, so every view of a buffer shares one lowering. */
+static void joy_frame_init(JoyFrame* frame, JoyValue* terms, size_t length,
+                           JoyBuffer* buffer) {
+    frame->terms = terms;
+    frame->length = length;
+    frame->pc = 0;
+    frame->owned = false;
+    if (length == 0) return;
+    if (!buffer->ops) {
+        buffer->ops = joy_slab_alloc(buffer->capacity * sizeof(JoyOp));
+        memset(buffer->ops, 0, buffer->capacity * sizeof(JoyOp));
+    }
+    frame->ops = buffer->ops + (terms - buffer->data);
+}
+
+/* Point a frame at an owned quotation or list, which it frees when done */
+static void joy_frame_load(JoyFrame* frame, JoyValue quot) {
+    if (quot.type == JOY_QUOTATION) {
+        JoyQuotation* q = quot.data.quotation;
+        joy_frame_init(frame, q->terms, q->length, q->buffer);
+    } else if (quot.type == JOY_LIST) {
+        JoyList* l = quot.data.list;
+        joy_frame_init(frame, l->items, l->length, l->buffer);
+    } else {
+        frame->length = 0;
+        frame->pc = 0;
+    }
+    frame->hold = quot;
+    frame->owned = true;
+}
+
+static void joy_frame_release(JoyFrame* frame) {
+    if (frame->owned) {
+        joy_value_free(&frame->hold);
+    }
+}
+
+/* Lower one term for the dispatch loop.  Literals that own no storage
+ * (numbers, chars, symbols, small strings, narrow sets, file handles)
+ * are pushed bit for bit; words are resolved against the dictionary. */
+static void joy_lower_term(JoyContext* ctx, JoyOp* op, const JoyValue* term) {
+    switch (term->type) {
+        case JOY_SYMBOL: {
+            JoyDict* dict = ctx->dictionary;
+            const JoyWord* word = joy_dict_lookup_symbol(dict, term->data.symbol);
+            if (!word) {
+                joy_error_undefined(term->data.symbol);
+            }
+            op->word = word;
+            op->dict = dict;
+            op->epoch = dict->epoch;
+            op->code = word->is_primitive ? JOY_OP_CALL : JOY_OP_ENTER;
+            return;
+        }
+        case JOY_STRING:
+            op->code = term->small_string ? JOY_OP_PUSH_FLAT : JOY_OP_PUSH;
+            return;
+        case JOY_SET:
+            op->code = term->wide_set ? JOY_OP_PUSH : JOY_OP_PUSH_FLAT;
+            return;
+        case JOY_LIST:
+        case JOY_QUOTATION:
+        case JOY_LAZY:
+            op->code = JOY_OP_PUSH;
+            return;
+        default:
+            op->code = JOY_OP_PUSH_FLAT;
+            return;
+    }
+}
+
+/* Direct threading: each op jumps straight to the next op's handler
+ * (GCC and Clang's labels as values), or through a switch elsewhere. */
+#if defined(__GNUC__)
+#define JOY_DISPATCH(code) goto *joy_op_labels[code]
+#else
+#define JOY_DISPATCH(code)                          \
+    switch (code) {                                 \
+        case JOY_OP_PUSH: goto op_push;             \
+        case JOY_OP_PUSH_FLAT: goto op_push_flat;   \
+        case JOY_OP_CALL: goto op_call;             \
+        case JOY_OP_ENTER: goto op_enter;           \
+        default: goto op_lower;                     \
+    }
+#endif
+
+/* Run terms to completion.  The running frame lives in locals; a word
+ * with a quotation body, or a tail a primitive left with joy_execute_tail,
+ * replaces it when in tail position and otherwise suspends it on
+ * ctx->frames.  Joy recursion is therefore bounded by the heap, not the
+ * C stack. */
+static void joy_execute_terms(JoyContext* ctx, JoyValue* terms, size_t length,
+                              JoyBuffer* buffer) {
+    if (length == 0) return;
+#if defined(__GNUC__)
+    static const void* const joy_op_labels[] = {
+        [JOY_OP_LOWER] = &&op_lower,
+        [JOY_OP_PUSH] = &&op_push,
+        [JOY_OP_PUSH_FLAT] = &&op_push_flat,
+        [JOY_OP_CALL] = &&op_call,
+        [JOY_OP_ENTER] = &&op_enter,
+    };
+#endif
+    size_t base = ctx->frame_depth;
+    JoyFrame frame;
+    JoyValue* term;
+    JoyOp* op;
+    JoyValue next;
+    joy_frame_init(&frame, terms, length, buffer);
+
+op_next:
+    if (frame.pc == frame.length) goto frame_done;
+    term = &frame.terms[frame.pc];
+    op = &frame.ops[frame.pc];
+    frame.pc++;
+    if (ctx->trace_enabled) {
+        joy_output_string("  exec: ");
+        joy_value_print(*term);
+        joy_output_char('\n');
+    }
+    JOY_DISPATCH(op->code);
+
+op_lower:
+    joy_lower_term(ctx, op, term);
+    JOY_DISPATCH(op->code);
+
+op_push_flat:
+    joy_stack_push(ctx->stack, *term);
+    goto op_next;
+
+op_push:
+    joy_stack_push(ctx->stack, joy_value_copy(*term));
+    goto op_next;
+
+op_call:
+    if (op->dict != ctx->dictionary || op->epoch != ctx->dictionary->epoch) goto op_lower;
+    joy_call_function(ctx, op->word);
+    if (!ctx->tail_pending) goto op_next;
+    ctx->tail_pending = false;
+    next = ctx->tail;
+    goto frame_switch;
+
+op_enter:
+    if (op->dict != ctx->dictionary || op->epoch != ctx->dictionary->epoch) goto op_lower;
+    next = (JoyValue){.type = JOY_QUOTATION,
+                      .data.quotation = joy_quotation_retain(op->word->body.quotation)};
+    goto frame_switch;
+
+frame_switch:
+    if (frame.pc == frame.length) {
+        joy_frame_release(&frame);
+    } else {
+        if (ctx->frame_depth == ctx->frame_capacity) {
+            joy_charge(joy_active_allocator, ctx->frame_capacity * sizeof(JoyFrame));
+            ctx->frame_capacity *= 2;
+            ctx->frames = joy_realloc(ctx->frames, ctx->frame_capacity * sizeof(JoyFrame));
+        }
+        ctx->frames[ctx->frame_depth++] = frame;
+    }
+    joy_frame_load(&frame, next);
+    goto op_next;
+
+frame_done:
+    joy_frame_release(&frame);
+    if (ctx->frame_depth == base) return;
+    frame = ctx->frames[--ctx->frame_depth];
+    goto op_next;
+}
+
+#undef JOY_DISPATCH
+
 void joy_execute_quotation(JoyContext* ctx, JoyQuotation* quotation) {
-    for (size_t i = 0; i < quotation->length; i++) {
-        joy_execute_value(ctx, quotation->terms[i]);
+    joy_execute_terms(ctx, quotation->terms, quotation->length, quotation->buffer);
+}
+
+void joy_execute_list(JoyContext* ctx, JoyList* list) {
+    joy_execute_terms(ctx, list->items, list->length, list->buffer);
+}
+
+void joy_execute_tail(JoyContext* ctx, JoyValue quot) {
+    ctx->tail = quot;
+    ctx->tail_pending = true;
+}
+
+void joy_execute_pending(JoyContext* ctx) {
+    JoyValue quot = ctx->tail;
+    ctx->tail_pending = false;
+    if (quot.type == JOY_QUOTATION) {
+        joy_execute_quotation(ctx, quot.data.quotation);
+    } else if (quot.type == JOY_LIST) {
+        joy_execute_list(ctx, quot.data.list);
     }
+    joy_value_free(&quot);
 }
 
 void joy_execute_symbol(JoyContext* ctx, const char* name) {
-    JoyWord* word = joy_dict_lookup(ctx->dictionary, name);
+    const JoyWord* word = joy_dict_lookup(ctx->dictionary, name);
     if (!word) {
-        fprintf(stderr, "Undefined word: %s\n", name);
-        joy_error("Undefined word");
+        joy_error_undefined(name);
     }
+    joy_execute_word(ctx, word);
+}
 
+void joy_execute_site(JoyContext* ctx, JoyCallSite* site) {
+    if (!site->dict) {
+        site->name = joy_intern(site->name);
+    }
+    const JoyWord* word = joy_resolve_site(ctx, site, site->name);
     if (word->is_primitive) {
-        word->body.primitive(ctx);
+        /* Like a direct call, this may leave a tail for the caller */
+        joy_call_function(ctx, word);
     } else {
-        joy_execute_quotation(ctx, word->body.quotation);
+        joy_execute_word(ctx, word);
     }
 }
 
@@ -8,10 +8,12 @@
 #ifndef JOY_RUNTIME_H
 #define JOY_RUNTIME_H
 
+#include <setjmp.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ---------- Joy Type System ---------- */
 
@@ -25,7 +27,8 @@ typedef enum {
     JOY_SET,
     JOY_QUOTATION,
     JOY_SYMBOL,
-    JOY_FILE
+    JOY_FILE,
+    JOY_LAZY
 } JoyType;
 
 /* Forward declarations */
@@ -33,45 +36,137 @@ typedef struct JoyValue JoyValue;
 typedef struct JoyList JoyList;
 typedef struct JoyQuotation JoyQuotation;
 typedef struct JoyStack JoyStack;
-
-/* Joy List - dynamic array of JoyValues */
+typedef struct JoyCallSite JoyCallSite;
+typedef struct JoyOp JoyOp;
+typedef struct JoyBitset JoyBitset;
+typedef struct JoyLazy JoyLazy;
+typedef struct JoyMemo JoyMemo;
+
+/* Shared item storage for lists and quotations.
+ * Slots in [head, tail) are claimed and owned by the buffer; views may
+ * claim free slots on either side (cons prepends, push appends) without
+ * disturbing other views of the same buffer. */
+typedef struct JoyBuffer {
+    JoyValue* data;
+    size_t capacity;
+    size_t head;        /* first claimed slot */
+    size_t tail;        /* one past the last claimed slot */
+    size_t refcount;    /* number of views sharing this buffer */
+    JoyOp* ops;         /* lazily lowered terms, one per slot (see joy_execute_terms) */
+} JoyBuffer;
+
+/* Joy List - reference-counted, immutable view onto a JoyBuffer.
+ * Lists are shared by joy_value_copy; only a uniquely-owned list
+ * (refcount == 1) may be mutated with joy_list_push/joy_list_pop. */
 struct JoyList {
-    JoyValue* items;
+    JoyValue* items;    /* first visible item (points into buffer->data) */
     size_t length;
-    size_t capacity;
+    uint32_t refcount;
+    uint32_t hash;      /* joy_value_hash once computed, else 0 */
+    JoyBuffer* buffer;
 };
 
-/* Joy Quotation - executable code block */
+/* Joy Quotation - executable code block, shared like JoyList */
 struct JoyQuotation {
-    JoyValue* terms;
+    JoyValue* terms;    /* first visible term (points into buffer->data) */
     size_t length;
-    size_t capacity;
+    uint32_t refcount;
+    uint32_t hash;
+    JoyBuffer* buffer;
 };
 
-/* Joy Value - tagged union for all Joy types */
+/* Joy Set storage past member 63 - reference-counted, never mutated once
+ * built.  A set spills here only when it has a member above 63, and
+ * words is trimmed so bits[words - 1] is never zero. */
+struct JoyBitset {
+    size_t refcount;
+    size_t words;
+    uint64_t bits[];
+};
+
+/* Longest string stored inline in a JoyValue (plus the terminator) */
+#define JOY_SMALL_STRING 7
+
+/* Joy Value - tagged union for all Joy types (16 bytes) */
 struct JoyValue {
     JoyType type;
+    bool small_string;      /* JOY_STRING held in data.small, not data.string */
+    bool wide_set;          /* JOY_SET held in data.bitset, not data.set */
+    bool mapped_string;     /* JOY_STRING data.string is in a shared file mapping or line block */
+    bool built_string;      /* JOY_STRING data.string follows a JoyStringHeader */
     union {
         int64_t integer;
         double floating;
         bool boolean;
         char character;
-        char* string;       /* owned, null-terminated */
-        JoyList* list;      /* owned */
+        char* string;       /* owned, null-terminated; read via joy_string_chars */
+        char small[JOY_SMALL_STRING + 1];
+        JoyList* list;      /* reference-counted */
         uint64_t set;       /* bitset for 0-63 */
-        JoyQuotation* quotation;  /* owned */
-        char* symbol;       /* owned, null-terminated */
+        JoyBitset* bitset;  /* reference-counted; members above 63 */
+        JoyQuotation* quotation;  /* reference-counted */
+        const char* symbol; /* interned by joy_intern: compare by pointer, never freed */
         FILE* file;         /* NOT owned - external file handle */
+        JoyLazy* lazy;      /* reference-counted generator (joy_lazy.c) */
     } data;
 };
 
+/* Characters of a JOY_STRING value, wherever they are stored */
+static inline const char* joy_string_chars(const JoyValue* value) {
+    return value->small_string ? value->data.small : value->data.string;
+}
+
+/* A string grown by joy_string_append keeps its length and spare room
+ * just before its characters, so appending to it again is amortized O(1) */
+typedef struct {
+    size_t length;
+    size_t capacity;    /* bytes for characters, terminator included */
+} JoyStringHeader;
+
+static inline size_t joy_string_length(const JoyValue* value) {
+    if (value->built_string) return ((const JoyStringHeader*)value->data.string - 1)->length;
+    return strlen(joy_string_chars(value));
+}
+
+/* Bitset words of a JOY_SET value, wherever they are stored */
+static inline const uint64_t* joy_set_words(const JoyValue* value, size_t* count) {
+    if (value->wide_set) {
+        *count = value->data.bitset->words;
+        return value->data.bitset->bits;
+    }
+    *count = 1;
+    return &value->data.set;
+}
+
 /* Joy Stack - the main data stack */
 struct JoyStack {
     JoyValue* items;
     size_t depth;
     size_t capacity;
+    /* Checkpoint undo log: slots below `low` are untouched since the
+     * innermost checkpoint; `undo` holds the original values of slots
+     * [low, checkpoint depth), topmost first. */
+    size_t low;
+    JoyValue* undo;
+    size_t undo_length;
+    size_t undo_capacity;
 };
 
+/* Saved stack state for a speculative run (a predicate, a nullary body).
+ * Rolling back costs only the slots the run popped, not the whole stack. */
+typedef struct {
+    size_t depth;        /* depth when the checkpoint was taken */
+    size_t low;          /* enclosing checkpoint's watermark */
+    size_t undo_length;  /* enclosing checkpoint's undo log length */
+} JoyCheckpoint;
+
+/* ---------- Symbols ---------- */
+
+/* Return the canonical copy of a symbol name.  Equal names intern to the
+ * same pointer, so symbols compare and hash by address. */
+const char* joy_intern(const char* name);
+size_t joy_symbol_hash(const char* symbol);  /* symbol must be interned */
+
 /* ---------- Value Constructors ---------- */
 
 JoyValue joy_integer(int64_t value);
@@ -80,6 +175,9 @@ JoyValue joy_boolean(bool value);
 JoyValue joy_char(char value);
 JoyValue joy_string(const char* value);
 JoyValue joy_string_owned(char* value);  /* takes ownership */
+JoyValue joy_string_span(const char* chars, size_t length);  /* copies length bytes */
+/* Append to the JOY_STRING *value, which the caller owns, in place */
+void joy_string_append(JoyValue* value, const char* chars, size_t length);
 JoyValue joy_list_empty(void);
 JoyValue joy_list_from(JoyValue* items, size_t count);
 JoyValue joy_set_empty(void);
@@ -92,20 +190,33 @@ JoyValue joy_file(FILE* file);
 /* ---------- Value Operations ---------- */
 
 JoyValue joy_value_copy(JoyValue value);
+JoyValue joy_value_clone(JoyValue value);  /* deep copy into the active allocator */
 void joy_value_free(JoyValue* value);
 bool joy_value_equal(JoyValue a, JoyValue b);
+/* Structural hash and identity, for tables keyed by values: unlike =,
+ * 1 and 1.0 or a list and a quotation with the same items differ.  An
+ * aggregate's hash is computed once and kept in it. */
+uint32_t joy_value_hash(const JoyValue* value);
+bool joy_value_same(const JoyValue* a, const JoyValue* b);
 bool joy_numeric_value(JoyValue v, double* result);
 bool joy_value_truthy(JoyValue value);
 void joy_value_print(JoyValue value);
 
 /* ---------- List Operations ---------- */
 
+/* joy_list_free releases one reference; storage is freed with the last one.
+ * joy_list_copy returns a shared reference (O(1)); joy_list_rest, joy_list_cons,
+ * joy_list_take and joy_list_drop return views that share storage where possible. */
 JoyList* joy_list_new(size_t initial_capacity);
 void joy_list_free(JoyList* list);
+JoyList* joy_list_retain(JoyList* list);
+JoyList* joy_list_unique(JoyList* list);
 void joy_list_push(JoyList* list, JoyValue value);
 JoyValue joy_list_pop(JoyList* list);
 JoyValue joy_list_first(JoyList* list);
 JoyList* joy_list_rest(JoyList* list);
+JoyList* joy_list_take(JoyList* list, size_t count);
+JoyList* joy_list_drop(JoyList* list, size_t count);
 JoyList* joy_list_copy(JoyList* list);
 size_t joy_list_length(JoyList* list);
 bool joy_list_null(JoyList* list);
@@ -116,19 +227,36 @@ JoyList* joy_list_cons(JoyValue value, JoyList* list);
 
 JoyQuotation* joy_quotation_new(size_t initial_capacity);
 void joy_quotation_free(JoyQuotation* quotation);
+JoyQuotation* joy_quotation_retain(JoyQuotation* quotation);
 void joy_quotation_push(JoyQuotation* quotation, JoyValue term);
 JoyQuotation* joy_quotation_copy(JoyQuotation* quotation);
+JoyQuotation* joy_quotation_rest(JoyQuotation* quotation);
+JoyQuotation* joy_quotation_take(JoyQuotation* quotation, size_t count);
+JoyQuotation* joy_quotation_drop(JoyQuotation* quotation, size_t count);
+JoyQuotation* joy_quotation_cons(JoyValue term, JoyQuotation* quotation);
 JoyQuotation* joy_quotation_concat(JoyQuotation* a, JoyQuotation* b);
 
 /* ---------- Set Operations ---------- */
 
-bool joy_set_member(uint64_t set, int member);
-uint64_t joy_set_insert(uint64_t set, int member);
-uint64_t joy_set_remove(uint64_t set, int member);
-uint64_t joy_set_union(uint64_t a, uint64_t b);
-uint64_t joy_set_intersection(uint64_t a, uint64_t b);
-uint64_t joy_set_difference(uint64_t a, uint64_t b);
-size_t joy_set_size(uint64_t set);
+/* Members are integers in [0, JOY_SET_LIMIT).  Sets of members 0-63 stay
+ * inline in data.set; every operation returns a new owned value that is
+ * inline whenever it fits, so equal sets always have the same form.
+ * joy_set_complement is taken within 0-63, Joy's setsize, whatever the
+ * set's width, so its result is always inline. */
+#define JOY_SET_LIMIT ((int64_t)1 << 24)
+
+bool joy_set_member(const JoyValue* set, int64_t member);
+JoyValue joy_set_insert(const JoyValue* set, int64_t member);
+JoyValue joy_set_remove(const JoyValue* set, int64_t member);
+JoyValue joy_set_union(const JoyValue* a, const JoyValue* b);
+JoyValue joy_set_intersection(const JoyValue* a, const JoyValue* b);
+JoyValue joy_set_difference(const JoyValue* a, const JoyValue* b);
+JoyValue joy_set_xor(const JoyValue* a, const JoyValue* b);
+JoyValue joy_set_complement(const JoyValue* set);
+JoyValue joy_set_range(const JoyValue* set, size_t start, size_t end);  /* by rank */
+bool joy_set_equal(const JoyValue* a, const JoyValue* b);
+size_t joy_set_size(const JoyValue* set);
+int64_t joy_set_next(const JoyValue* set, int64_t from);  /* -1 past the last member */
 
 /* ---------- Stack Operations ---------- */
 
@@ -144,8 +272,27 @@ void joy_stack_pop_free(JoyStack* stack);
 size_t joy_stack_depth(JoyStack* stack);
 void joy_stack_clear(JoyStack* stack);
 JoyStack* joy_stack_copy(JoyStack* stack);
+void joy_stack_checkpoint(JoyStack* stack, JoyCheckpoint* cp);
+void joy_stack_rollback(JoyStack* stack, JoyCheckpoint* cp);   /* restore, stay active */
+void joy_stack_release(JoyStack* stack, JoyCheckpoint* cp);    /* keep contents, end */
+void joy_stack_restore(JoyStack* stack, JoyCheckpoint* cp);    /* rollback + release */
 void joy_stack_print(JoyStack* stack);
 
+/* Helpers for the control flow the C backend emits in place of
+ * combinators applied to literal quotations */
+bool joy_stack_pop_truthy(JoyStack* stack);
+JoyValue* joy_aggregate_items(JoyValue* agg, size_t* length, const char* op);
+
+/* True when the top n items all have the given type.  Guards the unboxed
+ * kernels the C backend emits for numeric definitions. */
+static inline bool joy_stack_top_are(JoyStack* stack, size_t n, JoyType type) {
+    if (stack->depth < n) return false;
+    for (size_t i = stack->depth - n; i < stack->depth; i++) {
+        if (stack->items[i].type != type) return false;
+    }
+    return true;
+}
+
 /* ---------- Execution Context ---------- */
 
 typedef struct JoyContext JoyContext;
@@ -153,7 +300,7 @@ typedef void (*JoyPrimitive)(JoyContext* ctx);
 
 /* Word definition */
 typedef struct {
-    char* name;
+    const char* name;
     bool is_primitive;  /* true = body.primitive is a function ptr, false = body.quotation */
     bool is_user;       /* true = user-defined word (for 'user' primitive), false = builtin */
     union {
@@ -162,28 +309,155 @@ typedef struct {
     } body;
 } JoyWord;
 
-/* Dictionary entry */
-typedef struct JoyDictEntry {
-    char* key;
+/* Dictionary slot; key is NULL when the slot is empty */
+typedef struct {
+    const char* key;    /* interned */
     JoyWord* word;
-    struct JoyDictEntry* next;
 } JoyDictEntry;
 
-/* Dictionary for word definitions */
+/* Dictionary for word definitions.  Definitions live in an open-addressed
+ * table; builtins, once registered, come from the read-only perfect hash
+ * in joy_builtins.h and are only shadowed, never copied, by definitions. */
 typedef struct {
-    JoyDictEntry** buckets;
-    size_t bucket_count;
+    JoyDictEntry* entries;
+    size_t capacity;    /* power of two */
     size_t count;
+    bool builtins;      /* fall back to joy_builtin_lookup */
+    uint64_t epoch;     /* changes whenever a word is (re)defined */
 } JoyDict;
 
+/* Cached word resolution for one call site.  A site is valid while its
+ * dictionary and epoch match; any definition invalidates every site. */
+struct JoyCallSite {
+    const char* name;
+    const JoyWord* word;
+    JoyDict* dict;
+    uint64_t epoch;
+};
+
+/* A quotation term lowered for the engine's dispatch loop.  Terms are
+ * lowered the first time they run and stay lowered until their buffer
+ * slot is claimed again or the buffer moves; a word op is valid while
+ * its dictionary and epoch match, like a JoyCallSite. */
+enum {
+    JOY_OP_LOWER,       /* not lowered yet (zeroed) */
+    JOY_OP_PUSH,        /* literal that owns storage: push a copy */
+    JOY_OP_PUSH_FLAT,   /* literal that owns nothing: push its bits */
+    JOY_OP_CALL,        /* word with a C function body */
+    JOY_OP_ENTER,       /* word with a quotation body */
+};
+
+struct JoyOp {
+    const JoyWord* word;
+    JoyDict* dict;
+    uint64_t epoch;
+    uint8_t code;       /* JOY_OP_* */
+};
+
+/* Execute a named word through a per-call-site cache (used by generated code).
+ * Each thread keeps its own cache, since worker contexts have their own
+ * dictionaries (see joy_context_clone). */
+#define JOY_CALL(ctx, name) \
+    do { \
+        static _Thread_local JoyCallSite joy_site_ = {name, NULL, NULL, 0}; \
+        joy_execute_site(ctx, &joy_site_); \
+    } while (0)
+
+/* ---------- Allocator ---------- */
+
+/* Size-class slabs for list/quotation headers, shared buffers and small
+ * item arrays, plus a scratch arena for temporaries that live only inside
+ * one primitive.  Each context owns an allocator; runtime allocations use
+ * the calling thread's active one (its most recently created context's). */
+typedef struct JoyAllocator JoyAllocator;
+
+typedef struct {
+    size_t slab_allocs;   /* objects served from size-class slabs */
+    size_t slab_frees;
+    size_t slab_bytes;    /* bytes held by live slab objects */
+    size_t slab_peak;     /* high-water mark of slab_bytes */
+    size_t large_allocs;  /* requests too big for a size class */
+    size_t blocks;        /* slab blocks obtained from malloc */
+    size_t scratch_peak;  /* most scratch bytes in use at once */
+    /* Every byte the runtime holds for values: slab and large objects,
+     * heap strings, lazy sequences, scratch chunks, stack and frame growth */
+    size_t bytes_live;
+    size_t bytes_peak;
+    size_t bytes_allocated;  /* total ever charged */
+    size_t limit;            /* ceiling on bytes_live, 0 for none */
+    size_t values[JOY_LAZY + 1];  /* heap-backed values created, by type */
+} JoyAllocStats;
+
+/* Position in the scratch arena, for releasing everything allocated since */
+typedef struct {
+    void* chunk;
+    size_t used;
+    size_t total;
+} JoyScratchMark;
+
+JoyAllocator* joy_allocator_new(void);
+void joy_allocator_free(JoyAllocator* alloc);
+void joy_allocator_use(JoyAllocator* alloc);
+JoyAllocator* joy_allocator_active(void);
+void joy_allocator_reset(JoyAllocator* alloc);  /* drop slab blocks and scratch chunks */
+void joy_allocator_trim(JoyAllocator* alloc);   /* release spare scratch chunks */
+JoyAllocStats joy_allocator_stats(JoyAllocator* alloc);
+
+/* Cap bytes_live at limit bytes (0: no cap).  A charge that would pass it
+ * fails with joy_error_memory before anything is allocated, so a runaway
+ * program stops with an error rather than meeting the OOM killer.
+ * joy_context_new reads the cap from JOY_MEMORY_LIMIT (bytes, or with a
+ * K, M or G suffix); each context, worker clones included, has its own. */
+void joy_allocator_set_limit(JoyAllocator* alloc, size_t limit);
+
+/* Account for memory obtained outside the allocator (lazy sequences):
+ * charge counts a value of type, and bytes against the limit; reserve
+ * only the bytes (memo entries) */
+void joy_memory_charge(JoyType type, size_t bytes);
+void joy_memory_reserve(size_t bytes);
+void joy_memory_credit(size_t bytes);
+
+/* Write the active allocator's counters to stderr (JOY_MEMSTATS at exit) */
+void joy_memory_report(void);
+
+void* joy_scratch_alloc(JoyAllocator* alloc, size_t size);
+JoyScratchMark joy_scratch_mark(JoyAllocator* alloc);
+void joy_scratch_release(JoyAllocator* alloc, JoyScratchMark mark);
+
+/* A quotation the engine is running; hold, when owned, keeps the terms
+ * alive (a word body or a deferred tail) and is freed when the frame ends */
+typedef struct {
+    JoyValue* terms;
+    size_t length;
+    size_t pc;          /* next term */
+    JoyOp* ops;
+    JoyValue hold;
+    bool owned;
+} JoyFrame;
+
+/* Buffered standard output (joy_output.c) */
+typedef struct JoyOutput JoyOutput;
+
 /* Execution context */
 struct JoyContext {
     JoyStack* stack;
     JoyDict* dictionary;
+    JoyAllocator* allocator;
+    JoyOutput* output;  /* stdout buffer, active while the allocator is */
+    JoyFrame* frames;   /* engine return stack, replacing C recursion */
+    size_t frame_depth;
+    size_t frame_capacity;
+    JoyValue tail;      /* quotation deferred by joy_execute_tail */
+    bool tail_pending;
     bool trace_enabled;
     int autoput;      /* 0=off, 1=on (auto-print stack after each line) */
     int undeferror;   /* 0=off (undefined symbols are errors), 1=on (allow undefined) */
     int echo;         /* 0=none, 1=echo input, 2=echo output, 3=echo both */
+    int tracegc;      /* 0=off, non-zero: gc reports allocator stats on stderr */
+    uint64_t rand_state;  /* rand/srand generator, per context so workers never share it */
+    int argc;             /* command line read by argc/argv (joy_set_argv) */
+    char** argv;
+    JoyMemo* memo; /* memo's results, NULL until first used (joy_memo.c) */
 };
 
 /* ---------- Dictionary Operations ---------- */
@@ -193,28 +467,261 @@ void joy_dict_free(JoyDict* dict);
 void joy_dict_define_primitive(JoyDict* dict, const char* name, JoyPrimitive fn);
 void joy_dict_define_user(JoyDict* dict, const char* name, JoyPrimitive fn);
 void joy_dict_define_quotation(JoyDict* dict, const char* name, JoyQuotation* quot);
-JoyWord* joy_dict_lookup(JoyDict* dict, const char* name);
+void joy_dict_define_builtins(JoyDict* dict);
+JoyDict* joy_dict_clone(JoyDict* dict);  /* bodies deep-copied (joy_value_clone) */
+const JoyWord* joy_dict_lookup(JoyDict* dict, const char* name);
+const JoyWord* joy_dict_lookup_symbol(JoyDict* dict, const char* symbol);  /* interned */
+const JoyWord* joy_builtin_lookup(const char* symbol);  /* interned */
 
 /* ---------- Execution ---------- */
 
 JoyContext* joy_context_new(void);
 void joy_context_free(JoyContext* ctx);
+
+/* A context for another thread: a fresh allocator (made active on the
+ * calling thread), stack and frames, the parent's flags, and a clone of
+ * its dictionary.  It shares nothing mutable with the parent, so values
+ * must cross between them with joy_value_clone while the other side is
+ * not running. */
+JoyContext* joy_context_clone(JoyContext* parent);
+
+/* Ready a context to run its program again: an empty stack and engine,
+ * and the flags and generator a new context starts with.  The dictionary
+ * is kept, as a generated run_program registers its definitions anew. */
+void joy_context_reset(JoyContext* ctx);
 void joy_execute_value(JoyContext* ctx, JoyValue value);
 void joy_execute_quotation(JoyContext* ctx, JoyQuotation* quotation);
+void joy_execute_list(JoyContext* ctx, JoyList* list);
+void joy_execute_word(JoyContext* ctx, const JoyWord* word);
 void joy_execute_symbol(JoyContext* ctx, const char* name);
+void joy_execute_site(JoyContext* ctx, JoyCallSite* site);
+
+/* Tail calls.  A primitive whose last act is to run a quotation hands it
+ * (owned) to joy_execute_tail and returns; the engine then runs it in the
+ * caller's frame.  Calling a primitive, user function or JOY_CALL site
+ * directly may therefore leave a tail pending, and a caller with more
+ * work to do must finish it with joy_run_tail first.  The joy_execute_*
+ * entry points above always finish their tails. */
+void joy_execute_tail(JoyContext* ctx, JoyValue quot);
+void joy_execute_pending(JoyContext* ctx);
+
+static inline void joy_run_tail(JoyContext* ctx) {
+    if (ctx->tail_pending) {
+        joy_execute_pending(ctx);
+    }
+}
 
 /* ---------- Error Handling ---------- */
 
 void joy_error(const char* message);
 void joy_error_type(const char* op, const char* expected, JoyType got);
 void joy_error_underflow(const char* op, size_t required, size_t actual);
+void joy_error_memory(size_t live, size_t request, size_t limit);
+void joy_error_overflow(const char* op);
+
+/* End the program with status (quit, abort); trapped like an error */
+void joy_exit(int status);
+
+/* While a trap is set on the calling thread, the errors above record
+ * their message and exit status in it and longjmp to env instead of
+ * ending the process (see joy_embed_call).  Returns the trap it
+ * replaces. */
+typedef struct {
+    jmp_buf env;
+    char message[256];
+    int status;
+    bool exited;    /* by joy_exit rather than an error */
+    bool overflowed;    /* by joy_error_overflow */
+} JoyErrorTrap;
+
+JoyErrorTrap* joy_error_trap_set(JoyErrorTrap* trap);
+
+/* Raise on the calling thread what caught recorded on another (a
+ * parallel worker's error), as the original error or exit would have */
+void joy_error_rethrow(const JoyErrorTrap* caught);
+
+/* Integer arithmetic wraps around on overflow, as two's complement,
+ * unless joy_overflow_checked is set: then it raises joy_error_overflow,
+ * so a host with unbounded integers can redo the work itself (see
+ * joy_embed_call).  Set before any context runs. */
+extern bool joy_overflow_checked;
+
+static inline int64_t joy_int_add(int64_t a, int64_t b, const char* op) {
+    int64_t r;
+    if (__builtin_add_overflow(a, b, &r) && joy_overflow_checked) joy_error_overflow(op);
+    return r;
+}
+
+static inline int64_t joy_int_sub(int64_t a, int64_t b, const char* op) {
+    int64_t r;
+    if (__builtin_sub_overflow(a, b, &r) && joy_overflow_checked) joy_error_overflow(op);
+    return r;
+}
+
+static inline int64_t joy_int_mul(int64_t a, int64_t b, const char* op) {
+    int64_t r;
+    if (__builtin_mul_overflow(a, b, &r) && joy_overflow_checked) joy_error_overflow(op);
+    return r;
+}
+
+/* b is not zero; INT64_MIN / -1 is the one quotient that overflows */
+static inline int64_t joy_int_div(int64_t a, int64_t b, const char* op) {
+    return b == -1 ? joy_int_sub(0, a, op) : a / b;
+}
+
+static inline int64_t joy_int_rem(int64_t a, int64_t b) {
+    return b == -1 ? 0 : a % b;
+}
 
 /* ---------- Runtime Initialization ---------- */
 
 void joy_runtime_init(JoyContext* ctx);
 void joy_register_primitives(JoyContext* ctx);
 
-/* Command line argument support */
-void joy_set_argv(int argc, char** argv);
+/* Command line argument support.  The arguments belong to the context
+ * (parallel workers inherit them through joy_context_clone) and must
+ * outlive it. */
+void joy_set_argv(JoyContext* ctx, int argc, char** argv);
+
+/* ---------- Numeric Fast Paths (joy_vector.c) ---------- */
+
+/* Builtins the kernels implement; comparisons come last */
+typedef enum {
+    JOY_OP_ADD, JOY_OP_SUB, JOY_OP_MUL, JOY_OP_DIV, JOY_OP_MAX, JOY_OP_MIN,
+    JOY_OP_LT, JOY_OP_GT, JOY_OP_LE, JOY_OP_GE, JOY_OP_EQ, JOY_OP_NE
+} JoyNumericOp;
+
+/* Whether quot is [op] or [N op] for a builtin op that ctx still resolves
+ * to; operand is N, or a JOY_SYMBOL value for [op] */
+bool joy_numeric_quotation(JoyContext* ctx, JoyValue quot, JoyNumericOp* op,
+                           JoyValue* operand);
+
+/* A init [op] fold, A [N op] map and A [N cmp] filter with the quotation
+ * already consumed.  Each runs only when every item of A is a number,
+ * and otherwise returns false with the stack untouched. */
+bool joy_vector_fold(JoyContext* ctx, JoyNumericOp op);
+bool joy_vector_map(JoyContext* ctx, JoyNumericOp op, JoyValue operand);
+bool joy_vector_filter(JoyContext* ctx, JoyNumericOp op, JoyValue operand);
+
+/* ---------- Bulk File Input (joy_io.c) ---------- */
+
+/* The contents of the file at path as a string read straight from a
+ * private mapping of the file, with no copy.  joy_value_copy shares the
+ * mapping and the last joy_value_free unmaps it.  Returns false if the
+ * file cannot be opened or mapped. */
+bool joy_string_mapped(const char* path, JoyValue* out);
+void joy_mapping_retain(const char* chars);
+void joy_mapping_release(const char* chars);
+
+/* ---------- Lazy Sequences (joy_lazy.c) ---------- */
+
+/* Built by range, iterate and unfold; map, filter and take over one
+ * stack another node on it instead of walking it */
+JoyLazy* joy_lazy_retain(JoyLazy* lazy);
+void joy_lazy_release(JoyLazy* lazy);
+JoyLazy* joy_lazy_clone(JoyLazy* lazy);
+
+/* Produce the first element of the JOY_LAZY value *seq into *item and
+ * leave the rest of the sequence in *seq.  Returns false, with *seq
+ * still to be freed, once the sequence is empty. */
+bool joy_lazy_next(JoyContext* ctx, JoyValue* seq, JoyValue* item);
+
+/* Each takes over seq (and quot) */
+JoyValue joy_lazy_map(JoyValue seq, JoyValue quot);
+JoyValue joy_lazy_filter(JoyValue seq, JoyValue quot);
+JoyValue joy_lazy_take(JoyValue seq, int64_t count);
+
+/* ---------- Memoization (joy_memo.c) ---------- */
+
+/* The results memo keeps on a context; joy_context_reset and
+ * joy_context_free drop them */
+void joy_memo_free(JoyMemo* memo);
+
+/* ---------- Embedding (joy_embed.c) ---------- */
+
+/* A program built as a shared library exports
+ *     JoyContext* joy_library_open(void);
+ *     void joy_library_close(JoyContext* ctx);
+ * and a host drives the context through these.  Readers look at the top
+ * value without popping it; joy_embed_drop pops it. */
+void joy_embed_push_integer(JoyContext* ctx, int64_t value);
+void joy_embed_push_float(JoyContext* ctx, double value);
+void joy_embed_push_boolean(JoyContext* ctx, int value);
+void joy_embed_push_char(JoyContext* ctx, int value);
+void joy_embed_push_string(JoyContext* ctx, const char* chars, size_t length);
+void joy_embed_push_symbol(JoyContext* ctx, const char* name);
+void joy_embed_push_set(JoyContext* ctx, const int64_t* members, size_t count);
+void joy_embed_wrap(JoyContext* ctx, size_t count, int quotation);
+bool joy_embed_call(JoyContext* ctx, const char* name);
+const char* joy_embed_error(void);
+bool joy_embed_overflowed(void);
+size_t joy_embed_depth(JoyContext* ctx);
+int joy_embed_type(JoyContext* ctx);
+void joy_embed_drop(JoyContext* ctx);
+int64_t joy_embed_integer(JoyContext* ctx);
+double joy_embed_float(JoyContext* ctx);
+int joy_embed_boolean(JoyContext* ctx);
+int joy_embed_char(JoyContext* ctx);
+const char* joy_embed_chars(JoyContext* ctx);
+size_t joy_embed_set(JoyContext* ctx, int64_t* members, size_t capacity);
+size_t joy_embed_unwrap(JoyContext* ctx);
+
+/* ---------- Batch Runs (joy_batch.c) ---------- */
+
+/* The generated main hands `--batch[=N] [FILE [ARGS...]]` to
+ * joy_batch_main, which runs the program once per line of FILE (or
+ * stdin) on N worker threads; init and fini, if given, build and free
+ * the program's quotation globals on each worker. */
+int joy_batch_main(int argc, char** argv, void (*run)(JoyContext* ctx),
+                   void (*init)(void), void (*fini)(void));
+
+/* ---------- Profiling (joy_profile.c) ---------- */
+
+/* Bracket one run of a word.  Profiling builds (JOY_PROFILE) call these
+ * around every compiled definition and builtin call; joy_profile_report
+ * writes what the threads recorded so far to stderr, and the call tree
+ * as folded stacks to the file named by JOY_PROFILE_FOLDED, if set. */
+void joy_profile_enter(JoyContext* ctx, const char* name);
+void joy_profile_leave(JoyContext* ctx);
+void joy_profile_report(void);
+
+/* ---------- Buffered Output (joy_output.c) ---------- */
+
+/* Each context owns an output buffer for stdout and, like its allocator,
+ * makes it the thread's active one.  Writes collect in the active buffer
+ * (straight to stdout if there is none) and reach stdio at a newline when
+ * stdout is a terminal, when the buffer fills, or on joy_output_flush,
+ * which anything else touching stdin or stdout must call first. */
+JoyOutput* joy_output_new(FILE* file);
+void joy_output_free(JoyOutput* out);      /* flushes first */
+void joy_output_redirect(JoyOutput* out, FILE* file);  /* flushes first */
+void joy_output_use(JoyOutput* out);
+JoyOutput* joy_output_active(void);
+void joy_output_flush(void);
+
+/* Write out every live buffer, whichever thread's, and stdio's own.
+ * Only for a process about to exit: other threads may still be writing. */
+void joy_output_flush_all(void);
+
+void joy_output_write(const char* bytes, size_t length);
+void joy_output_string(const char* s);
+void joy_output_char(char c);
+void joy_output_integer(int64_t n);
+void joy_output_float(double f);        /* as printf("%g") */
+
+/* ---------- Parallel Execution (joy_parallel.c) ---------- */
+
+/* Generated programs keep their quotation literals in thread-local
+ * globals; a worker thread runs init before each job to build its own
+ * and fini after it. */
+void joy_set_worker_hooks(void (*init)(void), void (*fini)(void));
+
+/* Worker threads used by pmap, pfilter and pbinrec: JOY_THREADS from the
+ * environment if set, else the number of online processors */
+size_t joy_parallel_threads(void);
+
+/* Run parallel words on the calling thread sequentially, for threads
+ * that are already one of many (batch workers) */
+void joy_parallel_serial(void);
 
 #endif /* JOY_RUNTIME_H */
@@ -0,0 +1,352 @@
+/**
+ * joy_vector.c - Fast paths for fold, map and filter over numbers
+ *
+ * fold with [+] [-] [*] [/] [max] [min], map with [N op] and filter with
+ * [N cmp] normally push, dispatch and pop once per item.  When every item
+ * is a number and the quotation is one of these shapes over the builtin
+ * word, the kernels below run the whole aggregate in one C loop instead.
+ * Integer-only and float-only aggregates take tight loops over the
+ * items' payloads; mixed ones promote item by item exactly as the
+ * builtins do.  Items stay tagged JoyValues, so each call checks their
+ * types first and boxes what it produces.  Anything else returns false
+ * and the caller runs the quotation as usual.
+ */
+
+#include "joy_runtime.h"
+#include "joy_primitives.h"
+#include <stdlib.h>
+
+/* Builtin words the kernels implement, indexed by JoyNumericOp */
+static const JoyPrimitive joy_numeric_words[] = {
+    [JOY_OP_ADD] = prim_add,
+    [JOY_OP_SUB] = prim_sub,
+    [JOY_OP_MUL] = prim_mul,
+    [JOY_OP_DIV] = prim_div,
+    [JOY_OP_MAX] = prim_max,
+    [JOY_OP_MIN] = prim_min,
+    [JOY_OP_LT] = prim_lt,
+    [JOY_OP_GT] = prim_gt,
+    [JOY_OP_LE] = prim_le,
+    [JOY_OP_GE] = prim_ge,
+    [JOY_OP_EQ] = prim_eq,
+    [JOY_OP_NE] = prim_neq,
+};
+
+#define JOY_NUMERIC_OPS (sizeof(joy_numeric_words) / sizeof(joy_numeric_words[0]))
+
+static bool joy_op_is_comparison(JoyNumericOp op) {
+    return op >= JOY_OP_LT;
+}
+
+static bool joy_is_number(const JoyValue* v) {
+    return v->type == JOY_INTEGER || v->type == JOY_FLOAT;
+}
+
+/* The type every item shares (JOY_INTEGER or JOY_FLOAT), JOY_LIST for a
+ * mix of the two, or JOY_SYMBOL if some item is not a number */
+static JoyType joy_numeric_kind(const JoyValue* items, size_t length) {
+    size_t ints = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (!joy_is_number(&items[i])) return JOY_SYMBOL;
+        ints += items[i].type == JOY_INTEGER;
+    }
+    if (ints == length) return JOY_INTEGER;
+    return ints == 0 ? JOY_FLOAT : JOY_LIST;
+}
+
+static double joy_as_double(JoyValue v) {
+    return v.type == JOY_FLOAT ? v.data.floating : (double)v.data.integer;
+}
+
+/* a op b on two numbers, with the builtins' promotion rules */
+static JoyValue joy_numeric_apply(JoyNumericOp op, JoyValue a, JoyValue b) {
+    if (joy_op_is_comparison(op)) {
+        double x = joy_as_double(a), y = joy_as_double(b);
+        switch (op) {
+            case JOY_OP_LT: return joy_boolean(x < y);
+            case JOY_OP_GT: return joy_boolean(x > y);
+            case JOY_OP_LE: return joy_boolean(x <= y);
+            case JOY_OP_GE: return joy_boolean(x >= y);
+            case JOY_OP_EQ: return joy_boolean(x == y);
+            default: return joy_boolean(x != y);
+        }
+    }
+    if (a.type == JOY_INTEGER && b.type == JOY_INTEGER) {
+        int64_t x = a.data.integer, y = b.data.integer;
+        switch (op) {
+            case JOY_OP_ADD: return joy_integer(joy_int_add(x, y, "+"));
+            case JOY_OP_SUB: return joy_integer(joy_int_sub(x, y, "-"));
+            case JOY_OP_MUL: return joy_integer(joy_int_mul(x, y, "*"));
+            case JOY_OP_DIV:
+                if (y == 0) joy_error("Division by zero");
+                return joy_integer(joy_int_div(x, y, "/"));
+            case JOY_OP_MAX: return joy_integer(x > y ? x : y);
+            default: return joy_integer(x < y ? x : y);
+        }
+    }
+    double x = joy_as_double(a), y = joy_as_double(b);
+    switch (op) {
+        case JOY_OP_ADD: return joy_float(x + y);
+        case JOY_OP_SUB: return joy_float(x - y);
+        case JOY_OP_MUL: return joy_float(x * y);
+        case JOY_OP_DIV:
+            if (y == 0.0) joy_error("Division by zero");
+            return joy_float(x / y);
+        case JOY_OP_MAX: return joy_float(x > y ? x : y);
+        default: return joy_float(x < y ? x : y);
+    }
+}
+
+bool joy_numeric_quotation(JoyContext* ctx, JoyValue quot, JoyNumericOp* op,
+                           JoyValue* operand) {
+    if (quot.type != JOY_QUOTATION && quot.type != JOY_LIST) return false;
+    size_t length;
+    JoyValue* terms = joy_aggregate_items(&quot, &length, "quotation");
+    if (length == 0 || length > 2 || terms[length - 1].type != JOY_SYMBOL) return false;
+
+    if (length == 2) {
+        if (!joy_is_number(&terms[0])) return false;
+        *operand = terms[0];
+    } else {
+        operand->type = JOY_SYMBOL;  /* no operand */
+    }
+
+    /* Only the builtin word, not a redefinition of its name */
+    const JoyWord* word = joy_dict_lookup_symbol(ctx->dictionary, terms[length - 1].data.symbol);
+    if (!word || !word->is_primitive || word->is_user) return false;
+    for (size_t i = 0; i < JOY_NUMERIC_OPS; i++) {
+        if (word->body.primitive == joy_numeric_words[i]) {
+            *op = (JoyNumericOp)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ---------- fold ---------- */
+
+static int64_t joy_fold_integers(JoyNumericOp op, int64_t acc, const JoyValue* items,
+                                 size_t length) {
+    switch (op) {
+        case JOY_OP_ADD:
+            for (size_t i = 0; i < length; i++) acc = joy_int_add(acc, items[i].data.integer, "+");
+            break;
+        case JOY_OP_SUB:
+            for (size_t i = 0; i < length; i++) acc = joy_int_sub(acc, items[i].data.integer, "-");
+            break;
+        case JOY_OP_MUL:
+            for (size_t i = 0; i < length; i++) acc = joy_int_mul(acc, items[i].data.integer, "*");
+            break;
+        case JOY_OP_MAX:
+            for (size_t i = 0; i < length; i++) {
+                int64_t x = items[i].data.integer;
+                acc = acc > x ? acc : x;
+            }
+            break;
+        case JOY_OP_MIN:
+            for (size_t i = 0; i < length; i++) {
+                int64_t x = items[i].data.integer;
+                acc = acc < x ? acc : x;
+            }
+            break;
+        default:
+            for (size_t i = 0; i < length; i++) {
+                if (items[i].data.integer == 0) joy_error("Division by zero");
+                acc = joy_int_div(acc, items[i].data.integer, "/");
+            }
+            break;
+    }
+    return acc;
+}
+
+static double joy_fold_floats(JoyNumericOp op, double acc, const JoyValue* items,
+                              size_t length) {
+    switch (op) {
+        case JOY_OP_ADD:
+            for (size_t i = 0; i < length; i++) acc += items[i].data.floating;
+            break;
+        case JOY_OP_SUB:
+            for (size_t i = 0; i < length; i++) acc -= items[i].data.floating;
+            break;
+        case JOY_OP_MUL:
+            for (size_t i = 0; i < length; i++) acc *= items[i].data.floating;
+            break;
+        case JOY_OP_MAX:
+            for (size_t i = 0; i < length; i++) {
+                double x = items[i].data.floating;
+                acc = acc > x ? acc : x;
+            }
+            break;
+        case JOY_OP_MIN:
+            for (size_t i = 0; i < length; i++) {
+                double x = items[i].data.floating;
+                acc = acc < x ? acc : x;
+            }
+            break;
+        default:
+            for (size_t i = 0; i < length; i++) {
+                if (items[i].data.floating == 0.0) joy_error("Division by zero");
+                acc /= items[i].data.floating;
+            }
+            break;
+    }
+    return acc;
+}
+
+bool joy_vector_fold(JoyContext* ctx, JoyNumericOp op) {
+    JoyStack* stack = ctx->stack;
+    if (joy_op_is_comparison(op) || stack->depth < 2) return false;
+    JoyValue* agg = &stack->items[stack->depth - 2];
+    JoyValue init = stack->items[stack->depth - 1];
+    if ((agg->type != JOY_LIST && agg->type != JOY_QUOTATION) || !joy_is_number(&init)) {
+        return false;
+    }
+    size_t length;
+    JoyValue* items = joy_aggregate_items(agg, &length, "fold");
+    JoyType kind = joy_numeric_kind(items, length);
+    if (kind == JOY_SYMBOL) return false;
+
+    JoyValue result;
+    if (kind == JOY_INTEGER && init.type == JOY_INTEGER) {
+        result = joy_integer(joy_fold_integers(op, init.data.integer, items, length));
+    } else if (kind == JOY_FLOAT && length > 0) {
+        /* Once one side is a float every step is a float */
+        result = joy_float(joy_fold_floats(op, joy_as_double(init), items, length));
+    } else {
+        result = init;
+        for (size_t i = 0; i < length; i++) {
+            result = joy_numeric_apply(op, result, items[i]);
+        }
+    }
+
+    joy_stack_pop(stack);
+    joy_stack_pop_free(stack);
+    joy_stack_push(stack, result);
+    return true;
+}
+
+/* ---------- map and filter ---------- */
+
+/* A new list of length items for a kernel to fill in place */
+static JoyList* joy_vector_list(size_t length, JoyValue** items) {
+    JoyList* list = joy_list_new(length);
+    list->buffer->tail = list->buffer->head + length;
+    list->length = length;
+    *items = list->items;
+    return list;
+}
+
+static void joy_map_integers(JoyNumericOp op, int64_t n, const JoyValue* items,
+                             JoyValue* out, size_t length) {
+    switch (op) {
+        case JOY_OP_ADD:
+            for (size_t i = 0; i < length; i++) {
+                out[i] = joy_integer(joy_int_add(items[i].data.integer, n, "+"));
+            }
+            break;
+        case JOY_OP_SUB:
+            for (size_t i = 0; i < length; i++) {
+                out[i] = joy_integer(joy_int_sub(items[i].data.integer, n, "-"));
+            }
+            break;
+        case JOY_OP_MUL:
+            for (size_t i = 0; i < length; i++) {
+                out[i] = joy_integer(joy_int_mul(items[i].data.integer, n, "*"));
+            }
+            break;
+        default:
+            for (size_t i = 0; i < length; i++) {
+                out[i] = joy_numeric_apply(op, items[i], joy_integer(n));
+            }
+            break;
+    }
+}
+
+static void joy_map_floats(JoyNumericOp op, double n, const JoyValue* items,
+                           JoyValue* out, size_t length) {
+    switch (op) {
+        case JOY_OP_ADD:
+            for (size_t i = 0; i < length; i++) out[i] = joy_float(items[i].data.floating + n);
+            break;
+        case JOY_OP_SUB:
+            for (size_t i = 0; i < length; i++) out[i] = joy_float(items[i].data.floating - n);
+            break;
+        case JOY_OP_MUL:
+            for (size_t i = 0; i < length; i++) out[i] = joy_float(items[i].data.floating * n);
+            break;
+        default:
+            for (size_t i = 0; i < length; i++) {
+                out[i] = joy_numeric_apply(op, items[i], joy_float(n));
+            }
+            break;
+    }
+}
+
+bool joy_vector_map(JoyContext* ctx, JoyNumericOp op, JoyValue operand) {
+    JoyStack* stack = ctx->stack;
+    if (!joy_is_number(&operand) || stack->depth < 1) return false;
+    JoyValue* agg = &stack->items[stack->depth - 1];
+    if (agg->type != JOY_LIST && agg->type != JOY_QUOTATION) return false;
+    size_t length;
+    JoyValue* items = joy_aggregate_items(agg, &length, "map");
+    JoyType kind = joy_numeric_kind(items, length);
+    if (kind == JOY_SYMBOL || length == 0) return false;
+
+    /* Checked up front so a failing kernel leaves the stack as it was */
+    if (op == JOY_OP_DIV && joy_as_double(operand) == 0.0) joy_error("Division by zero");
+
+    JoyValue* out;
+    JoyList* result = joy_vector_list(length, &out);
+    if (kind == JOY_INTEGER && operand.type == JOY_INTEGER) {
+        joy_map_integers(op, operand.data.integer, items, out, length);
+    } else if (kind == JOY_FLOAT && operand.type == JOY_FLOAT) {
+        joy_map_floats(op, operand.data.floating, items, out, length);
+    } else {
+        for (size_t i = 0; i < length; i++) {
+            out[i] = joy_numeric_apply(op, items[i], operand);
+        }
+    }
+
+    joy_stack_pop_free(stack);
+    joy_stack_push(stack, (JoyValue){.type = JOY_LIST, .data.list = result});
+    return true;
+}
+
+bool joy_vector_filter(JoyContext* ctx, JoyNumericOp op, JoyValue operand) {
+    JoyStack* stack = ctx->stack;
+    if (!joy_op_is_comparison(op) || !joy_is_number(&operand) || stack->depth < 1) {
+        return false;
+    }
+    JoyValue* agg = &stack->items[stack->depth - 1];
+    if (agg->type != JOY_LIST && agg->type != JOY_QUOTATION) return false;
+    size_t length;
+    JoyValue* items = joy_aggregate_items(agg, &length, "filter");
+    JoyType kind = joy_numeric_kind(items, length);
+    if (kind == JOY_SYMBOL || length == 0) return false;
+
+    /* The builtins compare numbers as doubles */
+    double n = joy_as_double(operand);
+    JoyValue* out;
+    JoyList* result = joy_vector_list(length, &out);
+    size_t kept = 0;
+    for (size_t i = 0; i < length; i++) {
+        double x = joy_as_double(items[i]);
+        bool keep;
+        switch (op) {
+            case JOY_OP_LT: keep = x < n; break;
+            case JOY_OP_GT: keep = x > n; break;
+            case JOY_OP_LE: keep = x <= n; break;
+            case JOY_OP_GE: keep = x >= n; break;
+            case JOY_OP_EQ: keep = x == n; break;
+            default: keep = x != n; break;
+        }
+        out[kept] = items[i];
+        kept += keep;
+    }
+    result->buffer->tail = result->buffer->head + kept;
+    result->length = kept;
+
+    joy_stack_pop_free(stack);
+    joy_stack_push(stack, (JoyValue){.type = JOY_LIST, .data.list = result});
+    return true;
+}
@@ -0,0 +1,36 @@
+"""
+pyjoy.cache - The on-disk cache behind pyjoy's builds.
+
+Entries are named by a hash of everything that went into them, so a
+stale entry is never found, and they appear by rename, so a process
+never sees one half-written.  The cache lives in $PYJOY_CACHE_DIR, else
+$XDG_CACHE_HOME/pyjoy, else ~/.cache/pyjoy, and is always safe to
+delete.  Setting PYJOY_NO_CACHE turns it off.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import os
+from pathlib import Path
+
+
+def cache_dir() -> Path | None:
+    """The cache directory, or None if caching is turned off."""
+    if os.environ.get("PYJOY_NO_CACHE"):
+        return None
+    if os.environ.get("PYJOY_CACHE_DIR"):
+        return Path(os.environ["PYJOY_CACHE_DIR"])
+    base = os.environ.get("XDG_CACHE_HOME") or Path.home() / ".cache"
+    return Path(base) / "pyjoy"
+
+
+def content_key(*parts: str | bytes) -> str:
+    """A hex digest naming the cache entry built from parts."""
+    digest = hashlib.sha256()
+    for part in parts:
+        data = part.encode() if isinstance(part, str) else part
+        # Length-prefixed, so ("ab", "c") and ("a", "bc") differ
+        digest.update(len(data).to_bytes(8, "little"))
+        digest.update(data)
+    return digest.hexdigest()
@@ -2,18 +2,21 @@
 pyjoy.evaluator.aggregate - List, string, and set operations.
 
 Contains: cons, swons, first, rest, uncons, unswons, null, small, size,
-concat, reverse, at, of, drop, take, in, has, enconcat, swoncat
+concat, reverse, at, of, drop, take, in, has, enconcat, swoncat, sort,
+sortby, merge
 """
 
 from __future__ import annotations
 
+from functools import cmp_to_key
 from typing import Any
 
 from pyjoy.errors import JoyEmptyAggregate, JoyTypeError
 from pyjoy.stack import ExecutionContext
-from pyjoy.types import JoyQuotation, JoyType, JoyValue
+from pyjoy.types import JoyQuotation, JoyRope, JoyType, JoyValue
 
-from .core import is_joy_value, joy_word
+from .core import expect_quotation, is_joy_value, joy_word
+from .logic import _joy_compare, _numeric_value
 
 
 def _term_to_value(term) -> JoyValue:
@@ -361,7 +364,11 @@ def small(ctx: ExecutionContext) -> None:
 def size(ctx: ExecutionContext) -> None:
     """Get size of aggregate."""
     agg = ctx.stack.pop()
-    items = _get_aggregate(agg, "size")
+    if isinstance(agg, JoyRope):
+        _push_integer(ctx, agg.length)
+        return
+    text = _string_text(agg)
+    items = _get_aggregate(agg, "size") if text is None else text
     _push_integer(ctx, len(items))
 
 
@@ -370,10 +377,42 @@ def size(ctx: ExecutionContext) -> None:
 # -----------------------------------------------------------------------------
 
 
+def _is_string(v: Any) -> bool:
+    """Check for a string without reading it, which would join a JoyRope."""
+    if is_joy_value(v):
+        return v.type == JoyType.STRING
+    return isinstance(v, str)
+
+
+def _string_text(v: Any) -> str | None:
+    """The characters of a string value, or None for any other value."""
+    if is_joy_value(v):
+        return v.value if v.type == JoyType.STRING else None
+    return v if isinstance(v, str) else None
+
+
+def _push_joined(ctx: ExecutionContext, first: Any, *rest: Any) -> bool:
+    """Push the strings first and rest joined and return True, if they all
+    are strings; the result is a JoyRope, so repeated concats stay linear."""
+    texts = [_string_text(part) for part in rest]
+    if not _is_string(first) or None in texts:
+        return False
+    if not ctx.strict:
+        _push_result(ctx, _string_text(first) + "".join(texts))
+        return True
+    result = first
+    for text in texts:
+        result = JoyRope.concat(result, text)
+    ctx.stack.push_value(result)
+    return True
+
+
 @joy_word(name="concat", params=2, doc="A1 A2 -> A")
 def concat(ctx: ExecutionContext) -> None:
     """Concatenate two aggregates."""
     b, a = ctx.stack.pop_n(2)
+    if _push_joined(ctx, a, b):
+        return
     items_a = _get_aggregate(a, "concat")
     items_b = _get_aggregate(b, "concat")
     new_items = items_a + items_b
@@ -385,6 +424,8 @@ def concat(ctx: ExecutionContext) -> None:
 def swoncat(ctx: ExecutionContext) -> None:
     """Swap and concatenate: A1 A2 -> (A2 ++ A1)."""
     a2, a1 = ctx.stack.pop_n(2)  # a2 is TOS, a1 is below
+    if _push_joined(ctx, a2, a1):
+        return
     items_a2 = _get_aggregate(a2, "swoncat")
     items_a1 = _get_aggregate(a1, "swoncat")
     # swoncat = swap concat, so result is A2 ++ A1
@@ -397,6 +438,14 @@ def swoncat(ctx: ExecutionContext) -> None:
 def enconcat(ctx: ExecutionContext) -> None:
     """Concatenate A1, [X], A2."""
     a2, a1, x = ctx.stack.pop_n(3)
+    # A character is a one-character str in pythonic mode
+    if is_joy_value(x):
+        char = x.value if x.type == JoyType.CHAR else None
+    else:
+        char = x if isinstance(x, str) and len(x) == 1 else None
+    if char is not None and _is_string(a1):
+        if _push_joined(ctx, a1, char, a2):
+            return
     items1 = _get_aggregate(a1, "enconcat")
     items2 = _get_aggregate(a2, "enconcat")
     new_items = items1 + (x,) + items2
@@ -677,3 +726,107 @@ def has_(ctx: ExecutionContext) -> None:
             raise JoyTypeError("has", "aggregate", type(agg).__name__)
 
     _push_boolean(ctx, result)
+
+
+# -----------------------------------------------------------------------------
+# Sorting
+# -----------------------------------------------------------------------------
+
+
+def _compare_key(ctx: ExecutionContext):
+    """Sort key ordering by compare; quotation terms compare as values."""
+    if ctx.strict:
+        return cmp_to_key(
+            lambda a, b: _joy_compare(_term_to_value(a), _term_to_value(b))
+        )
+    return cmp_to_key(lambda a, b: _joy_compare(a, b, False))
+
+
+def _compare_keys(ctx: ExecutionContext, values: tuple | list) -> list:
+    """Sort keys for values ordering them by compare.
+
+    When every value is a number (or char or boolean), or every value is
+    a string, the keys are the plain Python values, which order the same
+    way and sort far faster than calls to compare.
+    """
+    numbers = [_numeric_value(v) for v in values]
+    if all(n is not None for n in numbers):
+        return numbers
+    raw = [_get_raw_value(v) for v in values]
+    if all(isinstance(r, str) for r in raw) and (
+        not ctx.strict or all(v.type == JoyType.STRING for v in values)
+    ):
+        return raw
+    key = _compare_key(ctx)
+    return [key(v) for v in values]
+
+
+def _is_set(v: Any) -> bool:
+    return v.type == JoyType.SET if is_joy_value(v) else isinstance(v, frozenset)
+
+
+@joy_word(name="sort", params=1, doc="A -> B")
+def sort(ctx: ExecutionContext) -> None:
+    """A in ascending order by compare; equal elements keep their order."""
+    agg = ctx.stack.pop()
+    if _is_set(agg):
+        _push_result(ctx, agg)
+        return
+    items = _get_aggregate(agg, "sort")
+    keys = _compare_keys(ctx, items)
+    order = sorted(range(len(items)), key=keys.__getitem__)
+    result = tuple(items[i] for i in order)
+    result = _make_aggregate(result, _get_original_type(agg), ctx.strict)
+    _push_result(ctx, result)
+
+
+@joy_word(name="sortby", params=2, doc="A [K] -> B")
+def sortby(ctx: ExecutionContext) -> None:
+    """A in ascending order of the keys K maps its elements to (once each)."""
+    quot, agg = ctx.stack.pop_n(2)
+    q = expect_quotation(quot, "sortby")
+    if _is_set(agg):
+        _push_result(ctx, agg)
+        return
+    items = _get_aggregate(agg, "sortby")
+
+    keys = []
+    for item in items:
+        ctx.stack.push_value(_term_to_value(item))
+        ctx.evaluator.execute(q)
+        keys.append(ctx.stack.pop())
+
+    keys = _compare_keys(ctx, keys)
+    order = sorted(range(len(items)), key=keys.__getitem__)
+    result = tuple(items[i] for i in order)
+    _push_result(ctx, _make_aggregate(result, _get_original_type(agg), ctx.strict))
+
+
+@joy_word(name="merge", params=2, doc="A1 A2 -> A")
+def merge(ctx: ExecutionContext) -> None:
+    """Merge sorted A1 and A2, taking from A1 first on ties."""
+    b, a = ctx.stack.pop_n(2)
+    if _is_set(a) and _is_set(b):
+        union = (a.value if is_joy_value(a) else a) | (
+            b.value if is_joy_value(b) else b
+        )
+        _push_result(ctx, JoyValue.joy_set(union) if ctx.strict else union)
+        return
+    xs = _get_aggregate(a, "merge")
+    ys = _get_aggregate(b, "merge")
+    key = _compare_key(ctx)
+
+    merged = []
+    i = j = 0
+    while i < len(xs) and j < len(ys):
+        if key(ys[j]) < key(xs[i]):
+            merged.append(ys[j])
+            j += 1
+        else:
+            merged.append(xs[i])
+            i += 1
+    merged.extend(xs[i:])
+    merged.extend(ys[j:])
+    result = _make_aggregate(tuple(merged), _get_original_type(a), ctx.strict)
+    _push_result(ctx, result)
+
@@ -2,8 +2,8 @@
 pyjoy.evaluator.combinators - Higher-order combinators.
 
 Contains: i, x, dip, dipd, dipdd, keep, nullary, unary, binary, ternary,
-ifte, branch, cond, step, map, filter, fold, each, any, all, some, split,
-times, while, loop, bi, tri, cleave, spread, infra, app1-4, compose,
+memo, ifte, branch, cond, step, linestep, map, filter, fold, each, any, all, some,
+split, times, while, loop, bi, tri, cleave, spread, infra, app1-4, compose,
 primrec, linrec, binrec, tailrec, genrec, condlinrec, condnestrec, construct,
 unary2, unary3, unary4, opcase, treestep, treerec, treegenrec
 """
@@ -192,6 +192,41 @@ def unary(ctx: ExecutionContext) -> None:
     ctx.stack.push_value(result)
 
 
+@joy_word(name="memo", params=2, doc="X [P] -> R")
+def memo(ctx: ExecutionContext) -> None:
+    """As unary, on a stack holding only X, computing R once per X and P."""
+    quot, x = ctx.stack.pop_n(2)
+    q = expect_quotation(quot, "memo")
+    evaluator = ctx.evaluator
+    if evaluator.memo_epoch is not evaluator.definitions.epoch:
+        # A redefinition may change what P computes
+        evaluator.memo.clear()
+        evaluator.memo_epoch = evaluator.definitions.epoch
+    key = (quot, x)
+    try:
+        result = evaluator.memo.get(key)
+    except TypeError:  # a Python object without a hash (strict=False)
+        key = result = None
+    if result is not None:
+        evaluator.memo.move_to_end(key)
+        ctx.stack.push_value(result)
+        return
+
+    saved = ctx.stack._items
+    ctx.stack._items = []
+    ctx.stack.push_value(x)
+    try:
+        evaluator.execute(q)
+        result = ctx.stack.pop()
+    finally:
+        ctx.stack._items = saved
+    if key is not None:
+        evaluator.memo[key] = result
+        if evaluator.memo_limit and len(evaluator.memo) > evaluator.memo_limit:
+            evaluator.memo.popitem(last=False)
+    ctx.stack.push_value(result)
+
+
 @joy_word(name="unary2", params=3, doc="X1 X2 [P] -> R1 R2")
 def unary2(ctx: ExecutionContext) -> None:
     """Apply P to X1 and X2 separately."""
@@ -525,6 +560,22 @@ def step(ctx: ExecutionContext) -> None:
         ctx.evaluator.execute(q)
 
 
+@joy_word(name="linestep", params=2, doc="S [P] -> ...")
+def linestep(ctx: ExecutionContext) -> None:
+    """Execute P for each line of string S, pushing the line without its newline."""
+    quot, text = ctx.stack.pop_n(2)
+    q = expect_quotation(quot, "linestep")
+    if text.type != JoyType.STRING:
+        raise JoyTypeError("linestep", "string", text.type.name)
+
+    lines = text.value.split("\n")
+    if lines[-1] == "":
+        lines.pop()
+    for line in lines:
+        ctx.stack.push_value(JoyValue.string(line))
+        ctx.evaluator.execute(q)
+
+
 @joy_word(name="map", params=2, doc="A [P] -> A'")
 def map_combinator(ctx: ExecutionContext) -> None:
     """Apply P to each element of A, collecting results."""
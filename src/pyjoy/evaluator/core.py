@@ -34,11 +34,12 @@ Use @python_word when you have:
 from __future__ import annotations
 
 import inspect
-from functools import wraps
-from typing import Any, Callable, Dict, Optional, Union
+from collections import OrderedDict
+from functools import partial, wraps
+from typing import Any, Callable, Dict, Iterable, List, Optional, Union
 
 from pyjoy.errors import JoyStackUnderflow, JoyTypeError, JoyUndefinedWord
-from pyjoy.parser import Definition, Parser, PythonExpr, PythonStmt
+from pyjoy.parser import Definition, Parser, PythonExpr, PythonStmt, parse_file
 from pyjoy.stack import ExecutionContext
 from pyjoy.types import JoyQuotation, JoyType, JoyValue, python_to_joy
 
@@ -338,6 +339,53 @@ def list_primitives() -> list[str]:
     return sorted(_primitives.keys())
 
 
+class Definitions(Dict[str, JoyQuotation]):
+    """
+    User definitions by name.
+
+    Every change replaces `epoch`, which compiled quotations are checked
+    against, so a define or unassign invalidates them all.
+    """
+
+    __slots__ = ("epoch",)
+
+    def __init__(self) -> None:
+        super().__init__()
+        self.epoch = object()
+
+    def __setitem__(self, name: str, body: JoyQuotation) -> None:
+        super().__setitem__(name, body)
+        self.epoch = object()
+
+    def __delitem__(self, name: str) -> None:
+        super().__delitem__(name)
+        self.epoch = object()
+
+    def pop(self, name: str, *default: Any) -> Any:
+        self.epoch = object()
+        return super().pop(name, *default)
+
+    def popitem(self) -> Any:
+        self.epoch = object()
+        return super().popitem()
+
+    def setdefault(self, name: str, body: Any = None) -> Any:
+        self.epoch = object()
+        return super().setdefault(name, body)
+
+    def update(self, *args: Any, **kwargs: Any) -> None:
+        super().update(*args, **kwargs)
+        self.epoch = object()
+
+    def clear(self) -> None:
+        super().clear()
+        self.epoch = object()
+
+    def touch(self) -> None:
+        """Invalidate compiled quotations without changing a definition."""
+        self.epoch = object()
+
+
 class Evaluator:
     """
     Joy evaluator: executes programs on a stack.
@@ -358,10 +406,18 @@ class Evaluator:
         self.strict = strict
         self.ctx = ExecutionContext(strict=strict)
         self.ctx.set_evaluator(self)
-        self.definitions: Dict[str, JoyQuotation] = {}
+        self.definitions = Definitions()
+        # Definitions running as compiled C (see accelerate)
+        self.native: Dict[str, Callable[[], None]] = {}
+        self.accelerator: Any = None
         self.undeferror: bool = True  # If True, undefined words raise error
         self.echo_mode: int = 0  # Echo mode for setecho/echo
         self.autoput_mode: int = 1  # Autoput mode for setautoput/autoput (default=1)
+        # memo's results by (quotation, argument), least recently used first,
+        # valid while definitions.epoch is memo_epoch
+        self.memo: OrderedDict[Any, Any] = OrderedDict()
+        self.memo_epoch: object = None
+        self.memo_limit: int = 0  # setmemosize; 0 keeps every result
         self.joy_argv: list[str] = []  # Joy-specific argv (set when running a file)
 
         # Python namespace for interop (strict=False mode)
@@ -404,11 +460,80 @@ class Evaluator:
         """
         Execute a Joy program (quotation).
 
+        The quotation is compiled on first use into a list of pre-bound
+        callables (see _compile), kept on the quotation until the
+        definitions change.
+
         Args:
             program: JoyQuotation to execute
         """
-        for term in program.terms:
-            self._execute_term(term)
+        compiled = program.compiled
+        if compiled is None or compiled[0] is not self.definitions.epoch:
+            compiled = self._compile(program)
+        for op in compiled[1]:
+            op()
+
+    def _compile(self, program: JoyQuotation) -> tuple[object, List[Callable[[], Any]]]:
+        """
+        Compile a quotation's terms into one callable per term.
+
+        Primitives are bound to their functions and literals are wrapped
+        once.  A user word runs its body directly while the definitions
+        are unchanged since compiling; otherwise, as for a word not yet
+        defined, it is looked up when it runs.
+        """
+        ops = [self._compile_term(term) for term in program.terms]
+        compiled = (self.definitions.epoch, ops)
+        program.compiled = compiled
+        return compiled
+
+    def _compile_term(self, term: Any) -> Callable[[], Any]:
+        """Compile a single term (see _execute_term for the cases)."""
+        if isinstance(term, Definition):
+            return partial(self.define, term.name, term.body)
+        if isinstance(term, PythonExpr):
+            return partial(self._execute_python_expr, term.code)
+        if isinstance(term, PythonStmt):
+            return partial(self._execute_python_stmt, term.code)
+        if isinstance(term, JoyValue):
+            if term.type == JoyType.SYMBOL:
+                return self._compile_symbol(term.value)
+            if self.strict:
+                return partial(self.ctx.stack.push_value, term)
+            return partial(self.ctx.stack.push, term.value)
+        if isinstance(term, JoyQuotation):
+            return partial(self.ctx.stack.push_value, JoyValue.quotation(term))
+        if isinstance(term, str):
+            return self._compile_symbol(term)
+        return partial(self.ctx.stack.push, term)
+
+    def _compile_symbol(self, name: str) -> Callable[[], Any]:
+        primitive = get_primitive(name)
+        if primitive is not None:
+            return partial(primitive, self.ctx)
+        native = self.native.get(name)
+        if native is not None:
+            return native
+        body = self.definitions.get(name)
+        if body is None:
+            return partial(self._execute_symbol, name)
+
+        definitions = self.definitions
+        epoch = definitions.epoch
+        accelerator = self.accelerator
+        if accelerator is not None and accelerator.hot is None:
+            accelerator = None
+
+        def run_definition() -> None:
+            # A define earlier in the running quotation may have replaced it
+            if definitions.epoch is epoch:
+                if accelerator is not None:
+                    accelerator.called(name)
+                self.execute(body)
+            else:
+                self._execute_symbol(name)
+
+        return run_definition
 
     def run(self, source: str) -> None:
         """
@@ -527,8 +652,15 @@ class Evaluator:
             primitive(self.ctx)
             return
 
+        native = self.native.get(name)
+        if native is not None:
+            native()
+            return
+
         # Check user definitions
         if name in self.definitions:
+            if self.accelerator is not None and self.accelerator.hot is not None:
+                self.accelerator.called(name)
             self.execute(self.definitions[name])
             return
 
@@ -548,6 +680,37 @@ class Evaluator:
         """
         self.definitions[name] = body
 
+    def accelerate(
+        self, names: Iterable[str] = (), hot: Optional[int] = None, optimize: int = 2
+    ) -> Any:
+        """
+        Run definitions as compiled C, in-process (needs a C compiler).
+
+        Args:
+            names: Definitions to compile now, with everything they call
+            hot: If set, also compile any definition once it has been
+                called this many times
+            optimize: Optimization level, as for compile_joy_to_c
+
+        Returns:
+            The Accelerator (pyjoy.backends.c.native); close() it to
+            return every word to Python
+
+        Raises:
+            NativeError: If a named word cannot be compiled
+        """
+        from pyjoy.backends.c.native import Accelerator
+
+        if self.accelerator is None:
+            self.accelerator = Accelerator(self, hot, optimize)
+        else:
+            self.accelerator.hot = hot
+        self.definitions.touch()
+        names = list(names)
+        if names:
+            self.accelerator.compile(names)
+        return self.accelerator
+
     def execute_quotation(self, quot: JoyValue) -> None:
         """
         Execute a quotation value from the stack.
@@ -586,10 +749,8 @@ class Evaluator:
             for lib in libs:
                 lib_path = os.path.join(stdlib_path, lib)
                 if os.path.exists(lib_path):
-                    with open(lib_path, "r") as f:
-                        source = f.read()
-                    parser = Parser()
-                    result = parser.parse_full(source)
+                    # Parsed once, then loaded from the cache (see parse_file)
+                    result = parse_file(lib_path)
                     # Execute (definitions are processed inline)
                     self.execute(result.program)
         finally:
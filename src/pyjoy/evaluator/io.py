@@ -3,7 +3,7 @@ pyjoy.evaluator.io - Input/output primitives.
 
 Contains: put, putch, putchars, putln, get, getch, getline, stdin, stdout,
 stderr, fopen, fclose, fread, fwrite, fflush, feof, ftell, fseek, fputch,
-fgetch, fputchars, fgets, ., newline
+fgetch, fputchars, fgets, fmap, ., newline
 """
 
 from __future__ import annotations
@@ -11,7 +11,7 @@ from __future__ import annotations
 import io as io_module
 import sys
 
-from pyjoy.errors import JoyTypeError
+from pyjoy.errors import JoyError, JoyTypeError
 from pyjoy.parser import parse
 from pyjoy.stack import ExecutionContext
 from pyjoy.types import JoyType, JoyValue
@@ -364,6 +364,20 @@ def fgets(ctx: ExecutionContext) -> None:
     ctx.stack.push_value(JoyValue.string(line))
 
 
+@joy_word(name="fmap", params=1, doc="P -> S")
+def fmap(ctx: ExecutionContext) -> None:
+    """Push the contents of the file at path P as a string."""
+    path = ctx.stack.pop()
+    if path.type != JoyType.STRING:
+        raise JoyTypeError("fmap", "string", path.type.name)
+    try:
+        with open(path.value, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+    except OSError as e:
+        raise JoyError(f"fmap: cannot map file {path.value}") from e
+    ctx.stack.push_value(JoyValue.string(text))
+
+
 @joy_word(name="fremove", params=1, doc="P -> B")
 def fremove(ctx: ExecutionContext) -> None:
     """Remove file at path P, return success."""
@@ -450,13 +464,9 @@ def finclude(ctx: ExecutionContext) -> None:
     if file_path is None:
         return
 
-    with open(file_path, "r") as f:
-        source = f.read()
-
-    from pyjoy.parser import Parser
+    from pyjoy.parser import parse_file
 
-    parser = Parser()
-    result = parser.parse_full(source)
+    result = parse_file(file_path)
 
     # Execute the program
     ctx.evaluator.execute(result.program)
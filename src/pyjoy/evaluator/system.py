@@ -3,7 +3,7 @@ pyjoy.evaluator.system - System operations and miscellaneous primitives.
 
 Contains: time, clock, getenv, system, argc, argv, abort, quit, format,
 formatf, strtol, strtod, intern, name, include, body, chr, ord, localtime,
-gmtime, mktime, strftime, maxint, setautoput, setundeferror, gc,
+gmtime, mktime, strftime, maxint, setautoput, setmemosize, setundeferror, gc,
 autoput, undeferror, echo, conts, undefs, help, helpdetail, manual, assign
 """
 
@@ -450,13 +450,9 @@ def include_(ctx: ExecutionContext) -> None:
     if file_path is None:
         raise JoyUndefinedWord(f"include: file not found: {path}")
 
-    with open(file_path, "r") as f:
-        source = f.read()
+    from pyjoy.parser import parse_file
 
-    from pyjoy.parser import Parser
-
-    parser = Parser()
-    result = parser.parse_full(source)
+    result = parse_file(file_path)
 
     # Execute the program (definitions are inlined and processed as encountered)
     ctx.evaluator.execute(result.program)
@@ -571,6 +567,18 @@ def setautoput_(ctx: ExecutionContext) -> None:
     ctx.evaluator.autoput_mode = val.value
 
 
+@joy_word(name="setmemosize", params=1, doc="I ->")
+def setmemosize_(ctx: ExecutionContext) -> None:
+    """Keep at most I memo results, dropping the least recently used (0: all)."""
+    val = ctx.stack.pop()
+    if val.type != JoyType.INTEGER:
+        raise JoyTypeError("setmemosize", "integer", val.type.name)
+    evaluator = ctx.evaluator
+    evaluator.memo_limit = max(val.value, 0)
+    while evaluator.memo_limit and len(evaluator.memo) > evaluator.memo_limit:
+        evaluator.memo.popitem(last=False)
+
+
 @joy_word(name="setecho", params=1, doc="I ->")
 def setecho_(ctx: ExecutionContext) -> None:
     """Set echo mode."""
@@ -725,3 +733,36 @@ def memorymax_(ctx: ExecutionContext) -> None:
 
     # Return a large value that memory index should typically be less than
     ctx.stack.push_value(JoyValue.integer(len(gc.get_objects()) * 2))
+
+
+_MEMSTAT_NAMES = (
+    "live",
+    "peak",
+    "allocated",
+    "allocations",
+    "limit",
+    "lists",
+    "quotations",
+    "strings",
+    "sets",
+    "lazy",
+)
+
+
+@joy_word(name="memstats", params=0, doc="-> L")
+def memstats_(ctx: ExecutionContext) -> None:
+    """Push [[live N] [peak N] ...] as the C runtime does (bytes from
+    tracemalloc when it is tracing, zero otherwise)."""
+    import tracemalloc
+
+    stats = dict.fromkeys(_MEMSTAT_NAMES, 0)
+    if tracemalloc.is_tracing():
+        stats["live"], stats["peak"] = tracemalloc.get_traced_memory()
+    ctx.stack.push_value(
+        JoyValue.list(
+            tuple(
+                JoyValue.list((JoyValue.symbol(name), JoyValue.integer(value)))
+                for name, value in stats.items()
+            )
+        )
+    )
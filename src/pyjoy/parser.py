@@ -10,7 +10,11 @@ Supports Python interop syntax (when python_interop=True):
 
 from __future__ import annotations
 
+import os
+import pickle
+import sys
 from dataclasses import dataclass
+from pathlib import Path
 from typing import Any, List, Optional, Set
 
 from pyjoy.errors import JoySetMemberError, JoySyntaxError
@@ -522,3 +526,51 @@ def parse(source: str, python_interop: bool = False) -> JoyQuotation:
     """
     parser = Parser(python_interop=python_interop)
     return parser.parse(source)
+
+
+# Bump when the parsed form changes so older cache entries are not loaded
+PARSE_CACHE_FORMAT = 1
+
+
+def parse_file(path: str | Path) -> ParseResult:
+    """
+    Parse a Joy source file, through the on-disk cache (pyjoy.cache).
+
+    The parsed form is pickled under a key made from the file's contents,
+    the pyjoy and Python versions and PARSE_CACHE_FORMAT, so the library
+    files loaded on every start are parsed once.  A missing or unreadable
+    entry is parsed afresh and rewritten.
+
+    Args:
+        path: Joy source file
+
+    Returns:
+        ParseResult with definitions inlined in program
+    """
+    from pyjoy import __version__
+    from pyjoy.cache import cache_dir, content_key
+
+    data = Path(path).read_bytes()
+    directory = cache_dir()
+    if directory is None:
+        return Parser().parse_full(data.decode())
+
+    key = content_key(str(PARSE_CACHE_FORMAT), __version__, sys.version, data)
+    entry = directory / "parsed" / f"{key[:32]}.pickle"
+    try:
+        with open(entry, "rb") as f:
+            result = pickle.load(f)
+        if isinstance(result, ParseResult):
+            return result
+    except Exception:
+        pass  # Not there yet, or written by something else: parse again
+
+    result = Parser().parse_full(data.decode())
+    try:
+        entry.parent.mkdir(parents=True, exist_ok=True)
+        partial = entry.with_name(f".{entry.name}.{os.getpid()}")
+        partial.write_bytes(pickle.dumps(result, pickle.HIGHEST_PROTOCOL))
+        os.replace(partial, entry)
+    except OSError:
+        pass  # A read-only cache only costs the next start a parse
+    return result
@@ -1525,6 +1525,30 @@ EXTENSIONS: Dict[str, Dict] = {
         "description": "Conditional nested recursion. Each clause [Ci] is [[B] [T]] or [[B] [R1] [R2] ...].",
         "section": "extension",
     },
+    "fmap": {
+        "name": "fmap",
+        "signature": "P -> S",
+        "description": "S is the contents of the file with pathname P (memory-mapped in compiled code).",
+        "section": "extension",
+    },
+    "linestep": {
+        "name": "linestep",
+        "signature": "S [P] -> ...",
+        "description": "Sequentially putting each line of string S, without its newline, onto the stack, executes P.",
+        "section": "extension",
+    },
+    "memo": {
+        "name": "memo",
+        "signature": "X [P] -> R",
+        "description": "As unary, with P seeing only X, remembering R for X and P.",
+        "section": "extension",
+    },
+    "setmemosize": {
+        "name": "setmemosize",
+        "signature": "I ->",
+        "description": "Keeps at most I memo results, the most recently used (0: all).",
+        "section": "extension",
+    },
     "__settracegc": {
         "name": "__settracegc",
         "signature": "I ->",
@@ -173,19 +173,78 @@ class JoyValue:
             return True
 
 
+_TYPE_SLOT = JoyValue.__dict__["type"]
+_VALUE_SLOT = JoyValue.__dict__["value"]
+
+
+class JoyRope(JoyValue):
+    """
+    A STRING built by concatenation, joined into one str on first read.
+
+    Values are shared freely (dup pushes the same object), so a rope
+    never changes: it reads the first `count` pieces of a list that later
+    ropes may extend.  concat onto the newest rope on a list appends to
+    it, which makes a loop of concats linear rather than quadratic; onto
+    any other string it starts a new list.
+    """
+
+    __slots__ = ("_pieces", "_count", "length")
+
+    def __init__(self, pieces: list[str], count: int, length: int):
+        _TYPE_SLOT.__set__(self, JoyType.STRING)
+        object.__setattr__(self, "_pieces", pieces)
+        object.__setattr__(self, "_count", count)
+        object.__setattr__(self, "length", length)
+
+    @classmethod
+    def concat(cls, left: JoyValue, right: str) -> JoyRope:
+        """The STRING left followed by right."""
+        if isinstance(left, JoyRope) and len(left._pieces) == left._count:
+            pieces = left._pieces
+            length = left.length
+        else:
+            text = left.value
+            pieces = [text]
+            length = len(text)
+        pieces.append(right)
+        return cls(pieces, len(pieces), length + len(right))
+
+    @property  # type: ignore[override]
+    def value(self) -> str:
+        try:
+            return _VALUE_SLOT.__get__(self)
+        except AttributeError:
+            text = "".join(self._pieces[: self._count])
+            _VALUE_SLOT.__set__(self, text)
+            return text
+
+    def __eq__(self, other: object) -> bool:
+        if isinstance(other, JoyValue):
+            return other.type == JoyType.STRING and other.value == self.value
+        return NotImplemented
+
+    def __hash__(self) -> int:
+        return hash((JoyType.STRING, self.value))
+
+    def __reduce__(self) -> tuple:
+        return (JoyValue.string, (self.value,))
+
+
 class JoyQuotation:
     """
     Represents unevaluated Joy code: [...]
 
     A quotation is a sequence of terms that can be executed later.
     Terms can be JoyValues, symbols (strings), or nested JoyQuotations.
+    The evaluator caches its compiled form of the terms in `compiled`.
     """
 
-    __slots__ = ("terms",)
+    __slots__ = ("terms", "compiled")
 
     def __init__(self, terms: Tuple[Any, ...]):
         """Create a quotation from a tuple of terms."""
         self.terms = terms
+        self.compiled: Any = None
 
     def __repr__(self) -> str:
         inner = " ".join(_term_repr(t) for t in self.terms)
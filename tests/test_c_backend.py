@@ -2,6 +2,7 @@
 Tests for the C code generation backend.
 """
 
+import os
 import shutil
 import subprocess
 import sys
@@ -11,8 +12,16 @@ from tempfile import TemporaryDirectory
 import pytest
 
 from pyjoy.backends.c.builder import CBuilder, compile_joy_to_c
-from pyjoy.backends.c.converter import CValue, JoyToCConverter
+from pyjoy.backends.c.builtins import (
+    BUILTINS_HEADER,
+    build_table,
+    builtins_header,
+    mix32,
+    symbol_hash,
+)
+from pyjoy.backends.c.converter import CValue, JoyToCConverter, primitive_functions
 from pyjoy.backends.c.emitter import CEmitter
+from pyjoy.backends.c.optimizer import optimize_program
 from pyjoy.backends.c.preprocessor import (
     IncludeError,
     preprocess_includes,
@@ -130,6 +139,42 @@ class TestJoyToCConverter:
         assert converter._sanitize_name(">=") == "_gt_eq"
         assert converter._sanitize_name("123") == "_123"
 
+    def test_unreachable_definitions_dropped(self):
+        """Definitions and quotations nothing can run are not converted."""
+        source = """DEFINE used == helper [inner] i ; helper == 1 ; inner == 2 ;
+                  unused == [3 4] [orphan] ; orphan == 5 . used"""
+        program = JoyToCConverter().convert_source(source)
+
+        names = sorted(d.name for d in program.definitions)
+        assert names == ["helper", "inner", "used"]
+        defines = [t.value.name for t in program.main_body.terms if t.type == "define"]
+        assert sorted(defines) == names
+        assert len(program.quotations) == 1
+
+    def test_reachability_follows_data(self):
+        """Words named inside list and quotation literals stay live."""
+        source = "DEFINE a == 1 ; b == 2 ; c == 3 . [[a] b] first i"
+        program = JoyToCConverter().convert_source(source)
+
+        assert sorted(d.name for d in program.definitions) == ["a", "b"]
+
+    def test_reflection_keeps_everything(self):
+        """intern can reach any definition, so none is dropped."""
+        source = 'DEFINE a == 1 ; b == 2 . "a" intern'
+        program = JoyToCConverter().convert_source(source)
+
+        assert sorted(d.name for d in program.definitions) == ["a", "b"]
+
+    def test_roots_kept(self):
+        """Roots survive without any caller."""
+        from pyjoy.parser import parse
+
+        program = JoyToCConverter().convert(
+            parse("DEFINE a == 1 ; b == a ; c == 3 ."), roots=["b"]
+        )
+
+        assert sorted(d.name for d in program.definitions) == ["a", "b"]
+
 
 class TestCEmitter:
     """Tests for C code emission."""
@@ -181,6 +226,198 @@ class TestCEmitter:
         assert "joy_context_new()" in code
         assert "joy_runtime_init(ctx)" in code
 
+    def test_emit_cached_call_site(self):
+        """Redefined words are emitted as cached call sites."""
+        source = "DEFINE f == 1. DEFINE f == 2. f"
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert 'JOY_CALL(ctx, "f");' in code
+
+    def test_emit_direct_calls(self):
+        """Builtins and single-definition words are called directly."""
+        source = "DEFINE sq == dup *. 3 sq"
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert "prim_dup(ctx);" in code
+        assert "prim_mul(ctx);" in code
+        assert "joy_word_sq(ctx);" in code
+        assert "JOY_CALL" not in code
+
+    def test_emit_call_before_definition(self):
+        """A word used before its definition is registered stays late-bound."""
+        source = "sq DEFINE sq == dup *."
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert 'JOY_CALL(ctx, "sq");' in code
+
+    def test_emit_definition_tail_call(self):
+        """A definition leaves its final call's tail to the caller."""
+        source = "DEFINE f == [1] i. f 4"
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        body = code.split("static void joy_word_f(JoyContext* ctx) {")[1]
+        body = body.split("\n}\n")[0]
+        assert "prim_i(ctx);" in body
+        assert "joy_run_tail" not in body
+        assert "joy_word_f(ctx);\n    joy_run_tail(ctx);" in code
+
+
+    def test_emit_numeric_kernels(self):
+        """Numeric definitions get guarded unboxed kernels."""
+        source = "DEFINE sq == dup *. DEFINE sumsq == sq swap sq +. DEFINE f == 1 +."
+        source += " 3 4 sumsq f"
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        sumsq = program.definitions[1]
+        assert [k.input_type for k in sumsq.kernels] == ["int", "float"]
+        assert sumsq.kernels[0].arity == 2
+        assert len(sumsq.kernels[0].outputs) == 1
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert "joy_stack_top_are(ctx->stack, 2, JOY_INTEGER)" in code
+        assert 'int64_t t2 = joy_int_add(t0, t1, "+");' in code
+        assert "double t0 = a0 * a0;" in code
+
+    def test_no_kernel_outside_numeric_subset(self):
+        """Bodies using non-numeric words or recursion keep only the boxed path."""
+        source = """
+        DEFINE len == size 1 +.
+        DEFINE count == [0 =] [] [1 - count] ifte.
+        DEFINE odd == 1.5 rem.
+        "ab" len 3 count 2 odd
+        """
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        len_, count, odd = program.definitions
+        assert len_.kernels == []
+        assert count.kernels == []
+        assert odd.kernels == []
+
+    def test_emit_vector_kernels(self):
+        """Numeric fold/map try the fast paths before the item loop."""
+        source = "[1 2 3] 0 [+] fold [1 2 3] [10 *] map [1 2 3] [dup *] map"
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert "if (!joy_vector_fold(ctx, JOY_OP_ADD)) {" in code
+        assert "joy_vector_map(ctx, JOY_OP_MUL, joy_integer(10))" in code
+        assert code.count("joy_vector_map(") == 1
+
+    def test_emit_native_combinators(self):
+        """Combinators over literal quotations become C control flow."""
+        source = """
+        DEFINE sumto == 0 swap [0 >] [dup rollup + swap 1 -] while pop.
+        DEFINE fact == [0 =] [pop 1] [dup 1 - fact *] ifte.
+        [1 2 3] [dup *] map 3 [1] times [0 <] [neg] [] ifte
+        5 sumto 5 fact
+        """
+        converter = JoyToCConverter()
+        program = converter.convert_source(source)
+
+        emitter = CEmitter()
+        code = emitter.emit(program)
+
+        assert "prim_while" not in code
+        assert "prim_map" not in code
+        assert "prim_times" not in code
+        assert "{ /* while */" in code
+        assert "if (cond_" in code
+        assert "prim_gt(ctx);" in code
+        # fact recurses through its ifte, so it keeps the runtime tail call
+        fact = code.split("static void joy_word_fact(JoyContext* ctx) {")[1]
+        assert "prim_ifte(ctx);" in fact.split("\n}\n")[0]
+
+class TestOptimizer:
+    """Tests for the peephole optimizer."""
+
+    def optimized(self, source, level=2):
+        converter = JoyToCConverter()
+        program = optimize_program(converter.convert_source(source), level)
+        return [(t.type, t.value) for t in program.main_body.terms]
+
+    def test_fold_arithmetic(self):
+        """Literal arithmetic and comparisons fold to one literal."""
+        assert self.optimized("2 3 + 4 *") == [("integer", 20)]
+        assert self.optimized("-7 2 rem 7 2 /") == [("integer", -1), ("integer", 3)]
+        assert self.optimized("1.5 2 <") == [("boolean", True)]
+        assert self.optimized("3 dup * swap") == [("integer", 9), ("symbol", "swap")]
+
+    def test_unsafe_folds_left_to_runtime(self):
+        """Division by zero and int64 overflow are not folded."""
+        terms = self.optimized("1 0 / 9223372036854775807 1 +")
+        assert ("symbol", "/") in terms
+        assert ("symbol", "1 +") in terms
+
+    def test_cancel_no_ops(self):
+        """swap swap, dup pop and [] concat disappear."""
+        assert self.optimized("swap swap dup pop [] concat size") == [("symbol", "size")]
+
+    def test_superinstructions(self):
+        """Common pairs become fused calls."""
+        converter = JoyToCConverter()
+        program = optimize_program(
+            converter.convert_source("dup * swap cons 0 = 1 - 1 +")
+        )
+        terms = [(t.value, t.c_name) for t in program.main_body.terms]
+        assert terms == [
+            ("dup *", "prim_dup_mul"),
+            ("swons", "prim_swons"),
+            ("0 =", "prim_eq_zero"),
+            ("1 -", "prim_dec"),
+            ("1 +", "prim_inc"),
+        ]
+
+    def test_inline_small_definitions(self):
+        """Small non-recursive words are inlined at level 2 only."""
+        source = """
+        DEFINE sq == dup *.
+        DEFINE loop == [0 =] [] [1 - loop] ifte.
+        DEFINE f == g.
+        DEFINE g == 1 +.
+        4 sq loop
+        """
+        terms = self.optimized(source)
+        assert ("integer", 16) in terms
+        assert ("symbol", "loop") not in terms
+        assert ("symbol", "ifte") in terms
+        assert ("symbol", "sq") in self.optimized(source, level=1)
+
+    def test_recursive_definition_not_inlined(self):
+        """A word that calls itself stays a call."""
+        source = "DEFINE r == [0 =] [] [1 - r] ifte 1 - r. 3 r"
+        assert ("symbol", "r") in self.optimized(source)
+
+    def test_late_bound_words_untouched(self):
+        """Redefined words are not folded or fused."""
+        source = "DEFINE + == *. DEFINE + == -. 2 3 +"
+        assert self.optimized(source)[-3:] == [
+            ("integer", 2),
+            ("integer", 3),
+            ("symbol", "+"),
+        ]
 
 class TestCBuilder:
     """Tests for C compilation."""
@@ -214,6 +451,87 @@ class TestCBuilder:
         assert "TARGET = myprogram" in makefile
         assert "SRCS = program.c" in makefile
         assert "-Wall" in makefile
+        assert "-O2" in makefile
+
+    def test_build_flags_one_level(self):
+        """optimize is the only source of the -O flag."""
+        builder = CBuilder()
+        for level in range(4):
+            flags = builder.build_flags(optimize=level)
+            assert [f for f in flags if f.startswith("-O")] == [f"-O{level}"]
+
+    def test_builtins_header_current(self):
+        """joy_builtins.h matches JOY_PRIMITIVE_TABLE and places every word."""
+        names = list(primitive_functions())
+        seeds, slots = build_table(names)
+
+        assert BUILTINS_HEADER.read_text() == builtins_header()
+        assert sorted(i for i in slots if i >= 0) == list(range(len(names)))
+        for index, name in enumerate(names):
+            h = symbol_hash(name)
+            slot = mix32(h ^ seeds[h & (len(seeds) - 1)]) & (len(slots) - 1)
+            assert slots[slot] == index
+
+    def test_runtime_library_cached(self):
+        """The runtime is archived once per flags and reused."""
+        with TemporaryDirectory() as tmpdir:
+            builder = CBuilder(cache_dir=tmpdir)
+            flags = builder.build_flags(optimize=1)
+            library = builder.runtime_library(flags)
+            if library is None:
+                pytest.skip("no archiver")
+            assert library.name == "libjoyrt.a"
+            assert list(library.parent.glob("joy_runtime.o"))
+            built = library.stat().st_mtime_ns
+            assert builder.runtime_library(flags) == library
+            assert library.stat().st_mtime_ns == built
+            other = builder.runtime_library(builder.build_flags(optimize=0))
+            assert other != library
+
+    def test_unchanged_program_not_recompiled(self):
+        """A program compiled before is copied out of the cache."""
+        result = compile_joy_to_c("6 7 *", compile_executable=False)
+        with TemporaryDirectory() as tmpdir:
+            builder = CBuilder(cache_dir=Path(tmpdir) / "cache")
+            c_file = Path(tmpdir) / "prog.c"
+            c_file.write_text(result["c_source"])
+            first = builder.compile(c_file, Path(tmpdir) / "first")
+            if builder.runtime_library(builder.build_flags()) is None:
+                pytest.skip("no archiver")
+
+            def no_compiler(cmd, cwd=None):
+                raise AssertionError(f"ran {cmd}")
+
+            builder._run = no_compiler
+            second = builder.compile(c_file, Path(tmpdir) / "second")
+            assert first.read_bytes() == second.read_bytes()
+            proc = subprocess.run([str(second)], capture_output=True, text=True)
+            assert "42" in proc.stdout
+
+    def test_uncached_build(self):
+        """With caching off the runtime sources are compiled directly."""
+        result = compile_joy_to_c("1 2 +", compile_executable=False)
+        with TemporaryDirectory() as tmpdir:
+            builder = CBuilder(cache=False)
+            assert builder.runtime_library(builder.build_flags()) is None
+            c_file = Path(tmpdir) / "prog.c"
+            c_file.write_text(result["c_source"])
+            executable = builder.compile(c_file)
+            proc = subprocess.run([str(executable)], capture_output=True, text=True)
+            assert "3" in proc.stdout
+
+    def test_lto_build(self):
+        """An LTO build of the runtime and program runs correctly."""
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                "DEFINE sq == dup * . 12 sq", output_dir=tmpdir, lto=True
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+            assert "144" in proc.stdout
+            assert "-flto" in result["makefile"].read_text()
+
 
 
 class TestCompilation:
@@ -480,6 +798,962 @@ class TestCompilation:
             assert proc.returncode == 0
             assert "15" in proc.stdout  # 1+2+3+4+5 = 15
 
+    def test_compile_shared_list_views(self):
+        """rest/cons views share storage without aliasing the original."""
+        source = "[1 2 3] dup rest 0 swap cons swap 9 swap cons"
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_views",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "[0 2 3] [9 1 2 3]" in proc.stdout
+
+    def test_compile_long_list_recursion(self):
+        """first/rest recursion over a long list completes quickly."""
+        source = """
+DEFINE build == [] swap dup [dup rollup swons swap 1 -] times pop.
+DEFINE len == [null] [pop 0] [rest len 1 +] ifte.
+20000 build dup len swap dup concat size
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_long_list",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                timeout=10,
+            )
+
+            assert proc.returncode == 0
+            assert "20000 40000" in proc.stdout
+
+    def test_compile_redefinition_invalidates_call_sites(self):
+        """Redefining a word is seen by cached call sites and quotations."""
+        source = """
+DEFINE f == 10.
+[f] dup i
+DEFINE f == 20.
+swap i f
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_redefine",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "10 20 20" in proc.stdout
+
+    def test_compile_built_quotation_relowers_claimed_slots(self):
+        """Quotations built at runtime run correctly as their buffer grows."""
+        source = """
+DEFINE inc == 1 + ; step == [+] 1 swons [dup 2 rem pop inc] concat.
+0 step 1000 [dup [i] dip] times pop
+[inc] 5 swons i
+DEFINE inc == 10 + .
+[inc] 5 swons i
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_built_quotation",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "2000 6 15" in proc.stdout
+
+    def test_compile_batch_mode(self):
+        """--batch runs the program once per line, in order, past failures."""
+        source = """
+[dup "boom" =] [pop 5 first] [size argc] ifte
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_batch",
+                compile_executable=True,
+            )
+            records = ["a", "bb", "boom"] + ["x" * n for n in range(3, 40)]
+
+            proc = subprocess.run(
+                [str(result["executable"]), "--batch=4", "-", "extra"],
+                input="\n".join(records) + "\n",
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 1
+            expected = [f"Stack(2): {n} 2" for n in [1, 2] + list(range(3, 40))]
+            assert proc.stdout.split("\n")[:-1] == expected
+            assert "record 3: " in proc.stderr
+
+    def test_compile_batch_oversized_record(self):
+        """A record over the memory limit fails alone; later records still run."""
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                "size",
+                output_dir=tmpdir,
+                target_name="test_batch_limit",
+                compile_executable=True,
+            )
+            records = ["a", "x" * 200_000, "bbb"]
+
+            proc = subprocess.run(
+                [str(result["executable"]), "--batch=1"],
+                input="\n".join(records) + "\n",
+                capture_output=True,
+                text=True,
+                env=dict(os.environ, JOY_MEMORY_LIMIT="150K"),
+            )
+
+            assert proc.returncode == 1
+            assert proc.stdout.split("\n")[:-1] == ["Stack(1): 1", "Stack(1): 3"]
+            assert "record 2: Joy error: memory limit" in proc.stderr
+
+    def test_compile_sort_words(self):
+        """sort, sortby and merge match the interpreter, stably."""
+        source = """
+[3 1 2.5 -4 1] sort
+"joy lang" sort
+[[2 "b"] [1 "x"] [2 "a"] [1 "y"]] [first] sortby [rest first] map
+[1 4 9] [2 4 10] merge
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_sort",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert (
+                '[-4 1 1 2.5 3] " agjlnoy" ["x" "y" "b" "a"] [1 2 4 4 9 10]'
+                in proc.stdout
+            )
+
+    def test_compile_shadowed_builtin(self):
+        """A redefined builtin is late-bound, in definitions and the main body."""
+        source = """
+DEFINE twice == dup +.
+3 twice
+DEFINE dup == 100.
+dup twice
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_shadow",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "6 200" in proc.stdout
+
+    def test_compile_predicate_checkpoints(self):
+        """Predicates that pop below their starting depth are rolled back."""
+        source = """
+1 2 3 [pop pop pop true] [10] [20] ifte
+[4 5] "s" 6 [[pop pop size 2 =] [dup 0 >] [false] ifte] [1 -] while
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_checkpoints",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert '1 2 3 10 [4 5] "s" 0' in proc.stdout
+
+    def test_compile_while_deep_stack(self):
+        """A while loop over a deep stack does not copy it per iteration."""
+        source = '20000 [dup 0 >] ["item" swap 1 -] while pop'
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_deep_while",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                timeout=10,
+            )
+
+            assert proc.returncode == 0
+            assert "Stack(20000):" in proc.stdout
+
+    def test_compile_gc_reports_allocator_stats(self):
+        """gc reports allocator stats on stderr once tracing is enabled."""
+        source = "[1 2 3] dup concat gc 1 __settracegc gc size"
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_gc",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "6" in proc.stdout
+            assert proc.stderr.count("gc:") == 1
+            assert "slab allocs" in proc.stderr
+
+    def test_compile_memstats_and_memory_limit(self):
+        """memstats pushes the counters; JOY_MEMORY_LIMIT stops a runaway copy."""
+        source = """
+[1 2 3] [size 1000000 <] [dup concat] while size
+memstats [first] map
+memstats 2 at rest first 0 >
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_memstats",
+                compile_executable=True,
+            )
+            env = dict(os.environ, JOY_MEMSTATS="1")
+            env.pop("JOY_MEMORY_LIMIT", None)
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                env=env,
+            )
+
+            assert proc.returncode == 0
+            assert proc.stdout == (
+                "Stack(3): 1572864 [live peak allocated allocations limit "
+                "lists quotations strings sets lazy] true\n"
+            )
+            assert "bytes live (peak" in proc.stderr
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                env=dict(env, JOY_MEMORY_LIMIT="4M"),
+            )
+
+            assert proc.returncode == 1
+            assert "memory limit of 4194304 bytes reached" in proc.stderr
+
+    def test_compile_small_strings_and_symbols(self):
+        """Inline short strings and interned symbols behave like heap values."""
+        source = """
+"ab" "ab" =
+[foo] first [foo] first =
+[foo] first "foo" =
+"abcdefg" "h" concat dup size
+"abc" dup concat
+"key" intern name
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_small_values",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert 'true true true "abcdefgh" 8 "abcabc" "key"' in proc.stdout
+
+    def test_compile_string_append(self):
+        """Strings grown by concat keep their own characters and lengths."""
+        source = """
+"" 100000 ["line of report text\\n" concat] times size
+"ab" "cdefgh" concat dup "ij" concat swap "kl" concat
+'-' swap "mnopqrstu" enconcat "vw" swoncat dup size swap dup 3 at
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_string_append",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                timeout=10,
+            )
+
+            assert proc.returncode == 0
+            assert proc.stdout == (
+                'Stack(5): 2000000 "abcdefghij" 22 "vwabcdefghkl-mnopqrstu" \'b\'\n'
+            )
+
+    def test_compile_memo(self):
+        """memo makes a binrec-style fib linear and tells keys apart by type."""
+        source = """
+DEFINE fib == [[small] [] [pred dup pred [fib] dip fib +] ifte] memo.
+90 fib
+10 5 [pop stack] memo
+1 [dup +] memo float 1.0 [dup +] memo float
+[1 2] [size] memo [1 2 3] [size] memo
+3 setmemosize 20 fib
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_memo",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                timeout=10,
+            )
+
+            assert proc.returncode == 0
+            assert proc.stdout == (
+                "Stack(8): 2880067194370816120 10 [] false true 2 3 6765\n"
+            )
+
+    def test_compile_memo_redefine(self):
+        """Redefining a word empties the memo table."""
+        source = """
+DEFINE f == 1 +.
+5 [f] memo .
+DEFINE f == 2 +.
+5 [f] memo .
+"""
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_memo_redefine",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                timeout=10,
+            )
+
+            assert proc.returncode == 0
+            assert proc.stdout == "6\n7\nStack(0): \n"
+
+    def test_compile_dictionary_growth(self):
+        """Definitions outgrow the initial table and shadow builtins."""
+        defines = "; ".join(f"w{i} == {i}" for i in range(200))
+        source = f"""
+        DEFINE {defines}.
+        DEFINE dup == 7.
+        w0 w199 + w123 + dup [w5] first user [pop] first user
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_dict_growth",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "322 7 true false" in proc.stdout
+
+    def test_compile_deep_recursion(self):
+        """Deep Joy recursion runs on the heap, not the C stack."""
+        source = """
+        DEFINE count == [0 =] [pop 0] [1 - count 1 +] ifte.
+        DEFINE loop == [0 =] [] [1 - loop] ifte.
+        1000000 [0 =] [pop 0] [1 -] [1 +] linrec
+        200000 count
+        1000000 loop
+        100000 [0] [+] primrec
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_deep_recursion",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "1000000 200000 0 5000050000" in proc.stdout
+
+    def test_compile_numeric_kernels(self):
+        """Kernels agree with the boxed path, which handles other types."""
+        source = """
+        DEFINE sq == dup *.
+        DEFINE sumsq == sq swap sq +.
+        DEFINE avg == + 2 /.
+        DEFINE cmp == over over < rollup max.
+        DEFINE neg3 == -3.5 neg -.
+        3 4 sumsq 2.5 sq 1.5 2 sumsq
+        7 8 avg 7.0 8.0 avg
+        3 9 cmp 5.0 neg3 [1 2] size sq
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_numeric_kernels",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "25 6.25 6.25 7 7.5 true 9 1.5 4" in proc.stdout
+
+    def test_compile_kernel_comparisons_as_doubles(self):
+        """Kernels compare integers past 2**53 as doubles, like the runtime."""
+        source = """
+        DEFINE gt == >.
+        DEFINE eq == =.
+        9007199254740993 9007199254740992 gt
+        9007199254740993 9007199254740992 eq
+        """
+        outputs = []
+        for level in range(3):
+            with TemporaryDirectory() as tmpdir:
+                result = compile_joy_to_c(
+                    source,
+                    output_dir=tmpdir,
+                    target_name="test_kernel_compare",
+                    compile_executable=True,
+                    optimize=level,
+                )
+
+                proc = subprocess.run(
+                    [str(result["executable"])],
+                    capture_output=True,
+                    text=True,
+                )
+
+                assert proc.returncode == 0
+                outputs.append(proc.stdout)
+
+        assert outputs == ["Stack(2): false true\n"] * 3
+
+    def test_compile_optimization_levels_agree(self):
+        """Every optimization level prints the same stack."""
+        source = """
+        DEFINE sq == dup *.
+        DEFINE dec == 1 -.
+        DEFINE down == [0 =] [] [dec down] ifte.
+        2 3 + 4 * sq 10 3 / -7 2 rem 1.5 2 < 5 dec 3.5 dec
+        [1 2] [] concat 8 9 swap swap 3 7 max 0 =
+        "a" "b" swap 10 down [3] [4] swap cons
+        """
+        outputs = []
+        for level in range(3):
+            with TemporaryDirectory() as tmpdir:
+                result = compile_joy_to_c(
+                    source,
+                    output_dir=tmpdir,
+                    target_name="test_optimize",
+                    compile_executable=True,
+                    optimize=level,
+                )
+
+                proc = subprocess.run(
+                    [str(result["executable"])],
+                    capture_output=True,
+                    text=True,
+                )
+
+                assert proc.returncode == 0
+                outputs.append(proc.stdout)
+
+        assert outputs[0] == outputs[1] == outputs[2]
+        assert '400 3 -1 true 4 2.5 [1 2] 8 9 false "b" "a" 0 [[4] 3]' in outputs[0]
+
+    def test_compile_native_combinators(self):
+        """Native ifte/branch/times/while/step/map/fold match the runtime."""
+        source = """
+        DEFINE sumto == 0 swap [0 >] [dup rollup + swap 1 -] while pop.
+        DEFINE sgn == [0 <] [pop -1] [[0 >] [pop 1] [pop 0] ifte] ifte.
+        100 sumto -5 sgn 0 sgn
+        [1 2 3] [dup *] map [1 2 3] 0 [+] fold 0 [1 2 3] [+] step
+        1 5 [2 *] times true [1] [2] branch
+        [[1 2] [3]] [[10 *] map] map
+        0 [1 2 3] [[dup 2 >] [+] [pop] ifte] step
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_native_combinators",
+                compile_executable=True,
+            )
+
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+            )
+
+            assert proc.returncode == 0
+            assert "5050 -1 0 [1 4 9] 6 6 32 1 [[10 20] [30]] 3" in proc.stdout
+
+    def test_compile_parallel_combinators(self):
+        """pmap/pfilter/pbinrec match map/filter/binrec on any pool size."""
+        source = """
+        DEFINE fib == [small] [] [pred dup pred] [+] binrec.
+        [10 11 12 13 14 15 16 17] [fib] pmap
+        [1 2 3 4 5 6 7 8 9 10] [2 rem 0 =] pfilter
+        [[1 2 3 4] [5 6 7 8]] [[fib] pmap] pmap
+        15 [small] [] [pred dup pred 100 rollup] [+ +] pbinrec
+        [1 2] [fib] pmap
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_parallel",
+                compile_executable=True,
+            )
+
+            outputs = []
+            for threads in ("1", "4"):
+                proc = subprocess.run(
+                    [str(result["executable"])],
+                    capture_output=True,
+                    text=True,
+                    env={**os.environ, "JOY_THREADS": threads},
+                )
+                assert proc.returncode == 0
+                outputs.append(proc.stdout)
+
+        assert outputs[0] == outputs[1]
+        assert (
+            "[55 89 144 233 377 610 987 1597] [2 4 6 8 10] "
+            "[[1 1 2 3] [5 8 13 21]] 99210 [1 1]" in outputs[0]
+        )
+
+    def test_compile_parallel_errors(self):
+        """An error on a worker is raised on the caller, as map would raise it."""
+        programs = {
+            "divide": '1 . "hello" putchars [1 2 0 4 5 6 7 8] [10 swap /] pmap .',
+            "underflow": "[1 2 3 4 5 6 7 8] [pop] pmap .",
+            "pbinrec": "20 [small] [0 /] [pred dup pred] [+] pbinrec .",
+        }
+
+        with TemporaryDirectory() as tmpdir:
+            for name, source in programs.items():
+                result = compile_joy_to_c(
+                    source,
+                    output_dir=tmpdir,
+                    target_name=f"test_parallel_{name}",
+                    compile_executable=True,
+                )
+
+                runs = []
+                for threads in ("1", "4"):
+                    proc = subprocess.run(
+                        [str(result["executable"])],
+                        capture_output=True,
+                        text=True,
+                        env={**os.environ, "JOY_THREADS": threads},
+                    )
+                    assert proc.returncode == 1
+                    runs.append((proc.stdout, proc.stderr))
+
+                assert runs[0] == runs[1]
+                if name == "divide":
+                    assert runs[0] == ("1\nhello", "Joy error: Division by zero\n")
+                elif name == "pbinrec":
+                    assert runs[0] == ("", "Joy error: Division by zero\n")
+                else:
+                    assert runs[0] == ("", "Joy error: Stack underflow\n")
+
+    def test_compile_vector_kernels(self):
+        """Kernel results match the generic fold/map/filter, fallbacks included."""
+        source = """
+        [1 2 3 4 5] 0 [+] fold .
+        [1 2 3 4 5] 1 [*] fold .
+        [1.5 2 3] 0 [+] fold .
+        [1 2 3] 0.5 [+] fold .
+        [3 1 4 1 5] 0 [max] fold .
+        [] 7 [+] fold .
+        [1 2 3] [10 *] map .
+        [1 2.5 3] [2 /] map .
+        [1 2 3] [2 <] map .
+        [5 1 4 2 3] [3 >=] filter .
+        [5 1.5 4 2 3] [2 >] filter .
+        [1 "a" 3] [10 >] filter .
+        [1 2 3] [dup *] map .
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_vector",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+
+        assert proc.returncode == 0
+        assert " ".join(proc.stdout.split()).startswith(
+            "15 120 6.5 6.5 5 7 [10 20 30] [0 1.25 1] [true false false] "
+            "[5 4 3] [5 4 3] [] [1 4 9]"
+        )
+
+    def test_compile_wide_sets(self):
+        """Sets grow past 63 through cons; not still complements within 0-63."""
+        source = """
+        DEFINE wide == [5000 64 3 200 63] {} [swons] fold.
+        wide . wide size . wide 200 has . 201 wide in .
+        wide [64 3 7 5000] {} [swons] fold xor .
+        wide {3 7} or . wide 2 drop . 3 wide of .
+        wide [63 64 200 3 5000] {} [swons] fold = .
+        [5000 64 3] {} [swons] fold [5000 64] {} [swons] fold xor .
+        {} not size . [100] {} [swons] fold not size .
+        wide not {1 3 63} and . wide not not .
+        """
+
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_sets",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+
+        assert proc.returncode == 0
+        assert proc.stdout.splitlines()[:14] == [
+            "{3 63 64 200 5000}",
+            "5",
+            "true",
+            "false",
+            "{7 63 200}",
+            "{3 7 63 64 200 5000}",
+            "{64 200 5000}",
+            "200",
+            "true",
+            "{3}",
+            "64",
+            "64",
+            "{1}",
+            "{3 63}",
+        ]
+
+    def test_compile_bulk_file_input(self):
+        """fmap, linestep, fgets and fread agree on the same file."""
+        with TemporaryDirectory() as tmpdir:
+            path = Path(tmpdir) / "input.txt"
+            # 4096 bytes: the file ends exactly on a page boundary
+            path.write_text("alpha\nbe\n\n" + "x" * 4085 + "\n")
+            source = f"""
+            "{path}" fmap size .
+            0 "{path}" fmap [size +] linestep .
+            "{path}" fmap [] linestep size . . . .
+            "{path}" "r" fopen fgets . 3 fread . 100000 fread size . fclose
+            """
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_bulk_io",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+
+        assert proc.returncode == 0
+        assert proc.stdout.splitlines()[:10] == [
+            "4096",
+            "4092",
+            "4085",
+            '""',
+            '"be"',
+            '"alpha"',
+            '"alpha',
+            '"',
+            "['b' 'e' '",
+            "']",
+        ]
+        assert proc.stdout.splitlines()[10] == "4087"
+
+    def test_compile_linestep_blocks(self):
+        """linestep's lines in shared line blocks stay right while kept or dropped."""
+        with TemporaryDirectory() as tmpdir:
+            path = Path(tmpdir) / "input.txt"
+            lines = [f"line {i} " + "y" * (i % 50) for i in range(20000)]
+            path.write_text("\n".join(lines) + "\n")
+            source = f"""
+            0 "{path}" fmap [size +] linestep .
+            "{path}" fmap [dup 10 take "line 1999 " = [] [pop] branch] linestep .
+            "{path}" fmap dup 0 swap [size +] linestep . size .
+            "{path}" fmap [] linestep 19999 [pop] times .
+            """
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_linestep",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+            bad = compile_joy_to_c(
+                f'"{path}" fmap 3 linestep',
+                output_dir=tmpdir,
+                target_name="test_linestep_type",
+                compile_executable=True,
+            )
+            bad_proc = subprocess.run(
+                [str(bad["executable"])], capture_output=True, text=True
+            )
+
+        total = sum(len(line) for line in lines)
+        assert proc.returncode == 0
+        assert proc.stdout.splitlines()[:5] == [
+            str(total),
+            f'"{lines[1999]}"',
+            str(total),
+            str(total + len(lines)),
+            f'"{lines[0]}"',
+        ]
+        assert bad_proc.returncode == 1
+        assert "linestep" in bad_proc.stderr
+
+    def test_compile_buffered_output(self):
+        """Buffered printing keeps its order around stdio and %g formatting."""
+        source = """
+        [1 [2.5 'a] "s" {3 7}] . 0.1 0.2 + . 123456.7 . -0.00012345 . 0.00001 .
+        "x" putchars stdout "y" fputchars pop 10 putch
+        0 setautoput 42
+        """
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_output",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+
+        assert proc.returncode == 0
+        # autoput off: no final stack line
+        assert proc.stdout.splitlines() == [
+            "[1 [2.5 'a'] \"s\" {3 7}]",
+            "0.3",
+            "123457",
+            "-0.00012345",
+            "1e-05",
+            "xy",
+        ]
+
+    def test_compile_buffered_output_on_error(self):
+        """An error exit writes out buffered output, a worker's error included."""
+        programs = {
+            "serial": '1 . "hello" putchars 1 0 / .',
+            "worker": '1 . "hello" putchars [1 2 0 4 5 6 7 8] [10 swap /] pmap .',
+        }
+        with TemporaryDirectory() as tmpdir:
+            for name, source in programs.items():
+                result = compile_joy_to_c(
+                    source,
+                    output_dir=tmpdir,
+                    target_name=f"test_output_{name}",
+                    compile_executable=True,
+                )
+                proc = subprocess.run(
+                    [str(result["executable"])],
+                    stdout=subprocess.PIPE,
+                    stderr=subprocess.STDOUT,
+                    text=True,
+                    env={**os.environ, "JOY_THREADS": "4"},
+                )
+
+                assert proc.returncode == 1
+                assert proc.stdout == "1\nhelloJoy error: Division by zero\n"
+
+    def test_compile_lazy_sequences(self):
+        """range, iterate and unfold stay lazy through map, filter and take."""
+        source = """
+        1 5 range force .
+        1 [2 *] iterate 6 take force .
+        1 [4 >] [dup *] [succ] unfold force .
+        0 [succ] iterate [dup *] map [2 rem 0 =] filter 4 take force .
+        1 3 range uncons force . . 1 0 range null .
+        0 1 1000000 range [+] step .
+        """
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_lazy",
+                compile_executable=True,
+            )
+            proc = subprocess.run(
+                [str(result["executable"])], capture_output=True, text=True
+            )
+
+        assert proc.returncode == 0
+        assert proc.stdout.splitlines()[:9] == [
+            "[1 2 3 4 5]",
+            "[1 2 4 8 16 32]",
+            "[1 4 9 16]",
+            "[0 4 16 36]",
+            "[2 3]",
+            "1",
+            "true",
+            "500000500000",
+            "Stack(0): ",
+        ]
+
+    def test_compile_profile(self):
+        """A profiling build reports each word and writes folded stacks."""
+        source = """
+        DEFINE sq == dup * ; sumsq == [sq] map 0 [+] fold .
+        [1 2 3] sumsq . 10 [small] [] [pred dup pred] [+] binrec .
+        """
+        with TemporaryDirectory() as tmpdir:
+            result = compile_joy_to_c(
+                source,
+                output_dir=tmpdir,
+                target_name="test_profile",
+                compile_executable=True,
+                profile=True,
+            )
+            folded = Path(tmpdir) / "folded.txt"
+            proc = subprocess.run(
+                [str(result["executable"])],
+                capture_output=True,
+                text=True,
+                env={**os.environ, "JOY_PROFILE_FOLDED": str(folded)},
+            )
+            stacks = folded.read_text().splitlines()
+
+        assert proc.returncode == 0
+        assert proc.stdout.splitlines()[:2] == ["14", "55"]
+        report = proc.stderr.splitlines()
+        assert report[0].startswith("Profile:")
+        words = {line.split()[-1]: line.split() for line in report[2:]}
+        assert words["sq"][0] == "3"
+        assert words["sumsq"][0] == "1"
+        assert "binrec" in words
+        assert any(line.startswith("main;binrec") for line in stacks)
+
     def test_runtime_files_copied(self):
         """Runtime files are copied to output directory."""
         source = "42"
@@ -522,6 +1796,108 @@ class TestCompilation:
             assert (Path(tmpdir) / exe_name).exists()
 
 
+class TestNative:
+    """Tests for running definitions in-process as compiled C."""
+
+    def test_accelerated_word_matches_python(self):
+        """A compiled definition leaves the same stack as the evaluator."""
+        from pyjoy import Evaluator
+
+        source = "DEFINE fib == [small] [] [pred dup pred] [+] binrec ."
+        python, native = Evaluator(), Evaluator()
+        python.run(source)
+        native.run(source)
+        accelerator = native.accelerate(["fib"])
+        try:
+            assert "fib" in native.native
+            program = '"s" [1 2.5 [x y] {1 3}] \'c true 18 fib'
+            python.run(program)
+            native.run(program)
+            assert native.stack.items() == python.stack.items()
+        finally:
+            accelerator.close()
+
+    def test_native_error_keeps_stack(self):
+        """A runtime error raises NativeError and leaves the stack as it was."""
+        from pyjoy import Evaluator
+        from pyjoy.backends.c.native import NativeError
+
+        evaluator = Evaluator()
+        evaluator.run('DEFINE bad == "x" + . 1 2')
+        accelerator = evaluator.accelerate(["bad"])
+        try:
+            with pytest.raises(NativeError, match="'\\+'"):
+                evaluator.run("bad")
+            assert [v.value for v in evaluator.stack.items()] == [1, 2]
+            evaluator.run("pop")
+            assert [v.value for v in evaluator.stack.items()] == [1]
+        finally:
+            accelerator.close()
+
+    def test_redefinition_falls_back(self):
+        """Redefining a word a native word was built from returns to Python."""
+        from pyjoy import Evaluator
+
+        evaluator = Evaluator()
+        evaluator.run("DEFINE double == 2 * ; quad == double double .")
+        accelerator = evaluator.accelerate(["quad"])
+        try:
+            evaluator.run("3 quad")
+            evaluator.run("DEFINE double == 3 * .")
+            evaluator.run("quad")
+            assert evaluator.stack.items()[-1].value == 12 * 9
+            assert "quad" not in evaluator.native
+        finally:
+            accelerator.close()
+
+    def test_hot_words_compiled(self):
+        """With hot set, a definition is compiled once called that often."""
+        from pyjoy import Evaluator
+
+        evaluator = Evaluator()
+        evaluator.run("DEFINE sq == dup * ; once == 1 .")
+        accelerator = evaluator.accelerate(hot=3)
+        try:
+            evaluator.run("once 2 sq sq sq sq")
+            assert evaluator.stack.items()[-1].value == 65536
+            assert list(evaluator.native) == ["sq"]
+        finally:
+            accelerator.close()
+        assert evaluator.native == {}
+
+    def test_overflow_runs_in_python(self):
+        """A call that needs more than 64 bits is rerun by the evaluator."""
+        import math
+
+        from pyjoy import Evaluator
+
+        evaluator = Evaluator()
+        evaluator.run("DEFINE fact == [null] [succ] [dup pred fact *] ifte .")
+        accelerator = evaluator.accelerate(hot=3)
+        try:
+            # fact turns native partway down the recursion
+            evaluator.run("25 fact 20 fact")
+            assert "fact" in evaluator.native
+            assert [v.value for v in evaluator.stack.items()] == [
+                math.factorial(25),
+                math.factorial(20),
+            ]
+            evaluator.run("pop pop 9223372036854775808 3 fact")
+            assert [v.value for v in evaluator.stack.items()] == [2**63, 6]
+        finally:
+            accelerator.close()
+
+    def test_unsupported_word_rejected(self):
+        """Words that use Python-only builtins stay in Python."""
+        from pyjoy import Evaluator
+        from pyjoy.backends.c.native import NativeError
+
+        evaluator = Evaluator(strict=False)
+        evaluator.run("DEFINE py == `1 + 1` .")
+        with pytest.raises(NativeError, match="Python interop"):
+            evaluator.accelerate(["py"])
+
+
 class TestIncludePreprocessor:
     """Tests for compile-time include expansion."""
 
@@ -73,6 +73,25 @@ class TestExecutionCombinators:
         assert evaluator.stack.peek(0).value == 7
         assert evaluator.stack.peek(1).value == 100
 
+    def test_memo(self, evaluator):
+        """memo runs P on X alone, once per X and P."""
+        evaluator.run("10 5 [pop stack] memo 3 [dup *] memo 3 [dup *] memo")
+        assert evaluator.stack.depth == 4
+        assert evaluator.stack.peek(0).value == 9
+        assert evaluator.stack.peek(2).value == ()
+        assert len(evaluator.memo) == 2
+
+    def test_memo_recursion(self, evaluator):
+        """A memoized binrec-style fib takes linear time."""
+        evaluator.run(
+            "DEFINE fib == [[small] [] [pred dup pred [fib] dip fib +] ifte] memo. "
+            "60 fib"
+        )
+        assert evaluator.stack.peek().value == 1548008755920
+        evaluator.run("3 setmemosize 10 fib")
+        assert evaluator.stack.peek().value == 55
+        assert len(evaluator.memo) == 3
+
 
 class TestConditionalCombinators:
     """Tests for conditional combinators."""
@@ -417,6 +417,20 @@ class TestDualModeStrings:
         strict_evaluator.run('"hello" size')
         assert strict_evaluator.stack.pop().value == 5
 
+    def test_string_concat_boxed(self, dual_evaluator):
+        # In pythonic mode a string taken out of a list is still a JoyValue
+        programs = [
+            '["ab"] first "c" concat',
+            '"ab" ["c"] first concat',
+            '"c" ["ab"] first swoncat',
+            "'c [\"ab\"] first \"de\" enconcat",
+            "'c \"ab\" [\"de\"] first enconcat",
+        ]
+        expected = ["abc", "abc", "abc", "abcde", "abcde"]
+        for source, text in zip(programs, expected):
+            dual_evaluator.run(source)
+            assert get_stack_value(dual_evaluator) == text
+
 
 class TestDualModeDefinitions:
     """User definitions should work in both modes."""
@@ -121,6 +121,29 @@ class TestUserDefinitions:
         evaluator.run("answer")
         assert evaluator.stack.peek().value == 42
 
+    def test_compiled_quotation_reused(self, evaluator):
+        body = JoyQuotation(("dup", "*"))
+        evaluator.define("sq", body)
+        evaluator.run("3 sq")
+        compiled = body.compiled
+        evaluator.run("sq")
+        assert body.compiled is compiled
+        assert evaluator.stack.peek().value == 81
+
+    def test_redefinition_invalidates_compiled(self, evaluator):
+        evaluator.run("DEFINE f == 1. [f] DEFINE f == 2.")
+        evaluator.run("i f")
+        assert [v.value for v in evaluator.stack.items()] == [2, 2]
+
+    def test_redefinition_within_running_program(self, evaluator):
+        evaluator.run("DEFINE f == 1. f DEFINE f == 2. f")
+        assert [v.value for v in evaluator.stack.items()] == [1, 2]
+
+    def test_unassign_invalidates_compiled(self, evaluator):
+        evaluator.run("DEFINE f == 1. [f] dup i pop [f] first unassign")
+        with pytest.raises(JoyUndefinedWord):
+            evaluator.run("i")
+
 
 class TestPrimitiveRegistry:
     """Tests for primitive registration."""
@@ -140,6 +140,24 @@ class TestFileOperations:
         finally:
             os.unlink(fname)
 
+    def test_fmap_linestep(self, evaluator):
+        """fmap pushes a file's contents; linestep runs P on each line."""
+        with tempfile.NamedTemporaryFile(mode="w", delete=False, suffix=".txt") as f:
+            f.write("one\n\nthree\nfour")
+            fname = f.name
+
+        try:
+            evaluator.run(f'"{fname}" fmap')
+            result = evaluator.stack.peek()
+            assert result.type == JoyType.STRING
+            assert result.value == "one\n\nthree\nfour"
+
+            evaluator.run("[] linestep")
+            lines = [evaluator.stack.pop().value for _ in range(4)]
+            assert lines == ["four", "three", "", "one"]
+        finally:
+            os.unlink(fname)
+
     def test_ftell_fseek(self, evaluator):
         """ftell and fseek work correctly."""
         with tempfile.NamedTemporaryFile(mode="w", delete=False, suffix=".txt") as f:
@@ -2,10 +2,14 @@
 Tests for pyjoy.parser module.
 """
 
+import os
+from pathlib import Path
+from tempfile import TemporaryDirectory
+
 import pytest
 
 from pyjoy.errors import JoySetMemberError, JoySyntaxError
-from pyjoy.parser import parse
+from pyjoy.parser import Definition, parse, parse_file
 from pyjoy.types import JoyQuotation, JoyType
 
 
@@ -144,3 +148,46 @@ class TestParser:
 
         # Symbol: map
         assert prog.terms[2] == "map"
+
+
+class TestParseFile:
+    """Tests for parse_file and its on-disk cache."""
+
+    def parse_in(self, cache: Path, path: Path):
+        old = os.environ.get("PYJOY_CACHE_DIR")
+        os.environ["PYJOY_CACHE_DIR"] = str(cache)
+        try:
+            return parse_file(path)
+        finally:
+            if old is None:
+                del os.environ["PYJOY_CACHE_DIR"]
+            else:
+                os.environ["PYJOY_CACHE_DIR"] = old
+
+    def test_cached_parse_matches(self):
+        with TemporaryDirectory() as tmpdir:
+            source = Path(tmpdir) / "lib.joy"
+            source.write_text("DEFINE sq == dup * . [1 {2 3} 'c] 2.5 sq")
+            cache = Path(tmpdir) / "cache"
+            first = self.parse_in(cache, source)
+            assert len(list((cache / "parsed").glob("*.pickle"))) == 1
+            second = self.parse_in(cache, source)
+            assert second.program == first.program == parse(source.read_text())
+            assert isinstance(second.program.terms[0], Definition)
+            assert second.program.terms[0].body.compiled is None
+
+            # A changed file is parsed again, under a new entry
+            source.write_text("1 2 +")
+            assert self.parse_in(cache, source).program == parse("1 2 +")
+            assert len(list((cache / "parsed").glob("*.pickle"))) == 2
+
+    def test_unreadable_entry_reparsed(self):
+        with TemporaryDirectory() as tmpdir:
+            source = Path(tmpdir) / "lib.joy"
+            source.write_text("[a b] i")
+            cache = Path(tmpdir) / "cache"
+            self.parse_in(cache, source)
+            [entry] = (cache / "parsed").glob("*.pickle")
+            entry.write_bytes(b"not a pickle")
+            assert self.parse_in(cache, source).program == parse("[a b] i")
+            assert entry.read_bytes() != b"not a pickle"
@@ -333,6 +333,17 @@ class TestListOperations:
         result = evaluator.stack.peek()
         assert len(result.value) == 4
 
+    def test_concat_strings_share_nothing_visible(self, evaluator):
+        # Both extensions of one string keep their own characters
+        evaluator.run('"ab" "c" concat dup "d" concat swap "e" concat')
+        evaluator.run('"x" swap concat "q" swoncat')
+        assert [v.value for v in evaluator.stack.items()] == ["abcd", "qxabce"]
+
+    def test_concat_strings_in_loop(self, evaluator):
+        evaluator.run('"" 1000 ["ab" concat] times \'-\' swap "end" enconcat dup size')
+        assert evaluator.stack.pop().value == 2004
+        assert evaluator.stack.peek().value == "ab" * 1000 + "-end"
+
     def test_reverse(self, evaluator):
         evaluator.run("[1 2 3] reverse")
         result = evaluator.stack.peek()
@@ -349,6 +360,38 @@ class TestListOperations:
         evaluator.run("1 [10 20 30] of")
         assert evaluator.stack.peek().value == 20
 
+    def test_sort(self, evaluator):
+        evaluator.run("[3 1 2.5 -4 1] sort")
+        result = evaluator.stack.peek()
+        assert result.type == JoyType.QUOTATION
+        assert [t.value for t in result.value.terms] == [-4, 1, 1, 2.5, 3]
+
+    def test_sort_string(self, evaluator):
+        evaluator.run('"joy lang" sort')
+        assert evaluator.stack.peek().value == " agjlnoy"
+
+    def test_sortby_is_stable(self, evaluator):
+        evaluator.run('[[2 "b"] [1 "x"] [2 "a"] [1 "y"]] [first] sortby')
+        evaluator.run("[rest first] map")
+        assert [t.value for t in evaluator.stack.peek().value] == ["x", "y", "b", "a"]
+
+    def test_merge(self, evaluator):
+        evaluator.run("[1 4 9] [2 4 10] merge")
+        result = evaluator.stack.peek()
+        assert [t.value for t in result.value.terms] == [1, 2, 4, 4, 9, 10]
+
+    def test_seqlib_qsort(self, evaluator_with_stdlib):
+        """seqlib's sorts are the native ones: ascending, ties kept in order."""
+        evaluator = evaluator_with_stdlib
+        evaluator.run('"seqlib" libload')
+        evaluator.run("[3 1 2 1 5 0 -2] qsort")
+        assert [t.value for t in evaluator.stack.pop().value] == [-2, 0, 1, 1, 2, 3, 5]
+        pairs = "[[2 'a] [1 'b] [2 'c] [1 'd] [3 'e]]"
+        for word in ("qsort1", "[first] mk_qsort"):
+            evaluator.run(f"{pairs} {word} [rest first] map")
+            result = evaluator.stack.pop()
+            assert [t.value for t in result.value] == ["b", "d", "a", "c", "e"]
+
 
 class TestTypePredicates:
     """Tests for type predicate primitives."""